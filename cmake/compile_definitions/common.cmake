@@ -107,8 +107,20 @@ set(SUNSHINE_TARGET_FILES
         "${CMAKE_SOURCE_DIR}/src/video.h"
         "${CMAKE_SOURCE_DIR}/src/video_colorspace.cpp"
         "${CMAKE_SOURCE_DIR}/src/video_colorspace.h"
+        "${CMAKE_SOURCE_DIR}/src/video_broadcast.cpp"
+        "${CMAKE_SOURCE_DIR}/src/video_broadcast.h"
+        "${CMAKE_SOURCE_DIR}/src/frame_ring.cpp"
+        "${CMAKE_SOURCE_DIR}/src/frame_ring.h"
+        "${CMAKE_SOURCE_DIR}/src/image_pool.cpp"
+        "${CMAKE_SOURCE_DIR}/src/image_pool.h"
+        "${CMAKE_SOURCE_DIR}/src/packet_pool.cpp"
+        "${CMAKE_SOURCE_DIR}/src/packet_pool.h"
+        "${CMAKE_SOURCE_DIR}/src/encoder_probe_cache.cpp"
+        "${CMAKE_SOURCE_DIR}/src/encoder_probe_cache.h"
         "${CMAKE_SOURCE_DIR}/src/input.cpp"
         "${CMAKE_SOURCE_DIR}/src/input.h"
+        "${CMAKE_SOURCE_DIR}/src/input_replay.cpp"
+        "${CMAKE_SOURCE_DIR}/src/input_replay.h"
         "${CMAKE_SOURCE_DIR}/src/audio.cpp"
         "${CMAKE_SOURCE_DIR}/src/audio.h"
         "${CMAKE_SOURCE_DIR}/src/platform/common.h"
@@ -123,6 +135,8 @@ set(SUNSHINE_TARGET_FILES
         "${CMAKE_SOURCE_DIR}/src/system_tray_i18n.h"
         "${CMAKE_SOURCE_DIR}/src/task_pool.h"
         "${CMAKE_SOURCE_DIR}/src/thread_pool.h"
+        "${CMAKE_SOURCE_DIR}/src/thread_placement.cpp"
+        "${CMAKE_SOURCE_DIR}/src/thread_placement.h"
         "${CMAKE_SOURCE_DIR}/src/thread_safe.h"
         "${CMAKE_SOURCE_DIR}/src/sync.h"
         "${CMAKE_SOURCE_DIR}/src/round_robin.h"
@@ -130,6 +144,14 @@ set(SUNSHINE_TARGET_FILES
         "${CMAKE_SOURCE_DIR}/src/stat_trackers.cpp"
         "${CMAKE_SOURCE_DIR}/src/rswrapper.h"
         "${CMAKE_SOURCE_DIR}/src/rswrapper.c"
+        "${CMAKE_SOURCE_DIR}/src/cursor_blend.cpp"
+        "${CMAKE_SOURCE_DIR}/src/cursor_blend.h"
+        "${CMAKE_SOURCE_DIR}/src/color_convert.cpp"
+        "${CMAKE_SOURCE_DIR}/src/color_convert.h"
+        "${CMAKE_SOURCE_DIR}/src/shared_convert.cpp"
+        "${CMAKE_SOURCE_DIR}/src/shared_convert.h"
+        "${CMAKE_SOURCE_DIR}/src/tile_hash.cpp"
+        "${CMAKE_SOURCE_DIR}/src/tile_hash.h"
         ${PLATFORM_TARGET_FILES})
 
 if(NOT SUNSHINE_ASSETS_DIR_DEF)
@@ -229,10 +229,15 @@ endif()
 
 list(APPEND PLATFORM_TARGET_FILES
         "${CMAKE_SOURCE_DIR}/src/platform/linux/publish.cpp"
+        "${CMAKE_SOURCE_DIR}/src/platform/linux/capture_scheduler.h"
+        "${CMAKE_SOURCE_DIR}/src/platform/linux/capture_scheduler.cpp"
         "${CMAKE_SOURCE_DIR}/src/platform/linux/graphics.h"
         "${CMAKE_SOURCE_DIR}/src/platform/linux/graphics.cpp"
         "${CMAKE_SOURCE_DIR}/src/platform/linux/misc.h"
         "${CMAKE_SOURCE_DIR}/src/platform/linux/misc.cpp"
+        "${CMAKE_SOURCE_DIR}/src/platform/linux/synthetic.h"
+        "${CMAKE_SOURCE_DIR}/src/platform/linux/synthetic.cpp"
+        "${CMAKE_SOURCE_DIR}/src/platform/linux/synthgrab.cpp"
         "${CMAKE_SOURCE_DIR}/src/platform/linux/audio.cpp"
         "${CMAKE_SOURCE_DIR}/src/platform/linux/display_device.cpp"
         "${CMAKE_SOURCE_DIR}/src/platform/linux/input.cpp"
@@ -108,6 +108,7 @@ function add_debain_based_deps() {
     "libssl-dev"
     "libwayland-dev"  # Wayland
     "libx11-dev"  # X11
+    "libxcb-damage0-dev"  # X11
     "libxcb-shm0-dev"  # X11
     "libxcb-xfixes0-dev"  # X11
     "libxcb1-dev"  # X11
@@ -14,13 +14,14 @@
 #include "globals.h"
 #include "logging.h"
 #include "platform/common.h"
+#include "thread_placement.h"
 #include "thread_safe.h"
 #include "utility.h"
 
 namespace audio {
   using namespace std::literals;
   using opus_t = util::safe_ptr<OpusMSEncoder, opus_multistream_encoder_destroy>;
-  using sample_queue_t = std::shared_ptr<safe::queue_t<std::vector<float>>>;
+  using sample_queue_t = std::shared_ptr<safe::ring_queue_t<std::vector<float>>>;
 
   static int start_audio_control(audio_ctx_t &ctx);
   static void stop_audio_control(audio_ctx_t &);
@@ -91,7 +92,7 @@ namespace audio {
     }
 
     // Encoding takes place on this thread
-    platf::adjust_thread_priority(platf::thread_priority_e::high);
+    thread_placement::apply(thread_placement::thread_e::audio_encode, platf::thread_priority_e::high);
 
     opus_t opus {opus_multistream_encoder_create(
       stream.sampleRate,
@@ -209,15 +210,20 @@ namespace audio {
     BOOST_LOG(info) << "Audio capture initialized successfully, entering sampling loop";
 
     // Capture takes place on this thread
-    platf::adjust_thread_priority(platf::thread_priority_e::critical);
+    thread_placement::apply(thread_placement::thread_e::audio_capture, platf::thread_priority_e::critical);
 
-    auto samples = std::make_shared<sample_queue_t::element_type>(30);
+    // If the encoder falls behind, only drop the stalest frame instead of the whole backlog
+    auto samples = std::make_shared<sample_queue_t::element_type>(30, safe::overflow_e::drop_oldest);
     std::thread thread {encodeThread, samples, config, channel_data};
 
     auto fg = util::fail_guard([&]() {
       samples->stop();
       thread.join();
 
+      if (auto stats = samples->stats(); stats.dropped) {
+        BOOST_LOG(info) << "Audio sample queue: dropped "sv << stats.dropped << " frames, high-water mark "sv << stats.high_water << '/' << stats.capacity;
+      }
+
       shutdown_event->view();
     });
 
@@ -0,0 +1,419 @@
+/**
+ * @file src/color_convert.cpp
+ * @brief Definitions for the vectorized BGR0 to YUV converter of the software encode path.
+ */
+// standard includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <optional>
+
+// local includes
+#include "color_convert.h"
+#include "platform/common.h"
+
+#ifdef SUNSHINE_COLOR_CONVERT_X86
+  #include <immintrin.h>
+#endif
+
+namespace color_convert {
+  coefficients_t
+  coefficients(const video::sunshine_colorspace_t &colorspace) {
+    // The vectors expect RGB in [0, 1] and already include the rounding offset
+    auto vectors = video::color_vectors_from_colorspace(colorspace, false);
+
+    auto fixed = [](float x) {
+      return (std::int32_t) std::lround(x * (1 << shift));
+    };
+    auto row = [&](std::int16_t (&k)[4], const float (&vec)[4]) {
+      k[0] = (std::int16_t) fixed(vec[2] / 255);
+      k[1] = (std::int16_t) fixed(vec[1] / 255);
+      k[2] = (std::int16_t) fixed(vec[0] / 255);
+      k[3] = 0;
+    };
+
+    coefficients_t k;
+    row(k.y, vectors->color_vec_y);
+    row(k.u, vectors->color_vec_u);
+    row(k.v, vectors->color_vec_v);
+
+    // U and V share the same offset
+    k.y_offset = fixed(vectors->color_vec_y[3]);
+    k.uv_offset = fixed(vectors->color_vec_u[3]);
+    k.uv420_offset = fixed(vectors->color_vec_u[3] * 4);
+
+    return k;
+  }
+
+  namespace {
+    std::uint16_t
+    clamp_u16(std::int32_t x) {
+      return (std::uint16_t) std::clamp(x, 0, 0xFFFF);
+    }
+
+    std::int32_t
+    dot(const std::int16_t (&k)[4], std::int32_t b, std::int32_t g, std::int32_t r) {
+      return k[0] * b + k[1] * g + k[2] * r;
+    }
+
+    void
+    luma_row_scalar(const coefficients_t &k, const std::uint8_t *bgr0, int width, std::uint16_t *y) {
+      for (int x = 0; x < width; ++x) {
+        auto p = bgr0 + x * 4;
+        y[x] = clamp_u16((dot(k.y, p[0], p[1], p[2]) + k.y_offset) >> shift);
+      }
+    }
+
+    void
+    chroma444_row_scalar(const coefficients_t &k, const std::uint8_t *bgr0, int width, std::uint16_t *u, std::uint16_t *v) {
+      for (int x = 0; x < width; ++x) {
+        auto p = bgr0 + x * 4;
+        u[x] = clamp_u16((dot(k.u, p[0], p[1], p[2]) + k.uv_offset) >> shift);
+        v[x] = clamp_u16((dot(k.v, p[0], p[1], p[2]) + k.uv_offset) >> shift);
+      }
+    }
+
+    void
+    chroma420_row_scalar(const coefficients_t &k, const std::uint8_t *row0, const std::uint8_t *row1, int width, std::uint16_t *u, std::uint16_t *v) {
+      for (int x = 0; x < width; x += 2) {
+        auto a = row0 + x * 4;
+        auto c = row1 + x * 4;
+
+        // A trailing odd column is paired with itself
+        auto b = x + 1 < width ? a + 4 : a;
+        auto d = x + 1 < width ? c + 4 : c;
+
+        std::int32_t sum_b = a[0] + b[0] + c[0] + d[0];
+        std::int32_t sum_g = a[1] + b[1] + c[1] + d[1];
+        std::int32_t sum_r = a[2] + b[2] + c[2] + d[2];
+
+        u[x / 2] = clamp_u16((dot(k.u, sum_b, sum_g, sum_r) + k.uv420_offset) >> (shift + 2));
+        v[x / 2] = clamp_u16((dot(k.v, sum_b, sum_g, sum_r) + k.uv420_offset) >> (shift + 2));
+      }
+    }
+  }  // namespace
+
+  const kernels_t scalar_kernels {
+    "scalar",
+    luma_row_scalar,
+    chroma444_row_scalar,
+    chroma420_row_scalar,
+  };
+
+#ifdef SUNSHINE_COLOR_CONVERT_X86
+  namespace {
+  // Compile the AVX2 kernels without raising the baseline of the rest of the binary
+  #if defined(__clang__)
+    #pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+  #else
+    #pragma GCC push_options
+    #pragma GCC target("avx2")
+  #endif
+
+    __m256i
+    broadcast(const std::int16_t (&k)[4]) {
+      std::int64_t bits;
+      std::memcpy(&bits, k, sizeof(bits));
+      return _mm256_set1_epi64x(bits);
+    }
+
+    /**
+     * @brief Weighted sums of 8 pixels widened to 16 bits, in pixel order.
+     *
+     * `lo` holds pixels 0, 1, 4 and 5, `hi` holds pixels 2, 3, 6 and 7, as unpacked from a single load.
+     */
+    __m256i
+    dot8(__m256i lo, __m256i hi, __m256i k) {
+      return _mm256_hadd_epi32(_mm256_madd_epi16(lo, k), _mm256_madd_epi16(hi, k));
+    }
+
+    /**
+     * @brief Narrow 16 values to 16 bits, in order. Packing works within 128-bit lanes.
+     */
+    __m256i
+    pack16(__m256i first, __m256i second) {
+      return _mm256_permute4x64_epi64(_mm256_packus_epi32(first, second), 0xD8);
+    }
+
+    void
+    luma_row_avx2(const coefficients_t &k, const std::uint8_t *bgr0, int width, std::uint16_t *y) {
+      const auto zero = _mm256_setzero_si256();
+      const auto ky = broadcast(k.y);
+      const auto offset = _mm256_set1_epi32(k.y_offset);
+
+      int x = 0;
+      for (; x + 16 <= width; x += 16) {
+        auto p0 = _mm256_loadu_si256((const __m256i *) (bgr0 + x * 4));
+        auto p1 = _mm256_loadu_si256((const __m256i *) (bgr0 + x * 4 + 32));
+
+        auto y0 = dot8(_mm256_unpacklo_epi8(p0, zero), _mm256_unpackhi_epi8(p0, zero), ky);
+        auto y1 = dot8(_mm256_unpacklo_epi8(p1, zero), _mm256_unpackhi_epi8(p1, zero), ky);
+
+        y0 = _mm256_srai_epi32(_mm256_add_epi32(y0, offset), shift);
+        y1 = _mm256_srai_epi32(_mm256_add_epi32(y1, offset), shift);
+
+        _mm256_storeu_si256((__m256i *) (y + x), pack16(y0, y1));
+      }
+
+      luma_row_scalar(k, bgr0 + x * 4, width - x, y + x);
+    }
+
+    void
+    chroma444_row_avx2(const coefficients_t &k, const std::uint8_t *bgr0, int width, std::uint16_t *u, std::uint16_t *v) {
+      const auto zero = _mm256_setzero_si256();
+      const auto ku = broadcast(k.u);
+      const auto kv = broadcast(k.v);
+      const auto offset = _mm256_set1_epi32(k.uv_offset);
+
+      int x = 0;
+      for (; x + 16 <= width; x += 16) {
+        auto p0 = _mm256_loadu_si256((const __m256i *) (bgr0 + x * 4));
+        auto p1 = _mm256_loadu_si256((const __m256i *) (bgr0 + x * 4 + 32));
+
+        auto lo0 = _mm256_unpacklo_epi8(p0, zero);
+        auto hi0 = _mm256_unpackhi_epi8(p0, zero);
+        auto lo1 = _mm256_unpacklo_epi8(p1, zero);
+        auto hi1 = _mm256_unpackhi_epi8(p1, zero);
+
+        auto u0 = _mm256_srai_epi32(_mm256_add_epi32(dot8(lo0, hi0, ku), offset), shift);
+        auto u1 = _mm256_srai_epi32(_mm256_add_epi32(dot8(lo1, hi1, ku), offset), shift);
+        auto v0 = _mm256_srai_epi32(_mm256_add_epi32(dot8(lo0, hi0, kv), offset), shift);
+        auto v1 = _mm256_srai_epi32(_mm256_add_epi32(dot8(lo1, hi1, kv), offset), shift);
+
+        _mm256_storeu_si256((__m256i *) (u + x), pack16(u0, u1));
+        _mm256_storeu_si256((__m256i *) (v + x), pack16(v0, v1));
+      }
+
+      chroma444_row_scalar(k, bgr0 + x * 4, width - x, u + x, v + x);
+    }
+
+    void
+    chroma420_row_avx2(const coefficients_t &k, const std::uint8_t *row0, const std::uint8_t *row1, int width, std::uint16_t *u, std::uint16_t *v) {
+      const auto zero = _mm256_setzero_si256();
+      const auto ku = broadcast(k.u);
+      const auto kv = broadcast(k.v);
+      const auto offset = _mm256_set1_epi32(k.uv420_offset);
+
+      int x = 0;
+      for (; x + 16 <= width; x += 16) {
+        auto a0 = _mm256_loadu_si256((const __m256i *) (row0 + x * 4));
+        auto a1 = _mm256_loadu_si256((const __m256i *) (row0 + x * 4 + 32));
+        auto b0 = _mm256_loadu_si256((const __m256i *) (row1 + x * 4));
+        auto b1 = _mm256_loadu_si256((const __m256i *) (row1 + x * 4 + 32));
+
+        // Sum the rows vertically
+        auto lo0 = _mm256_add_epi16(_mm256_unpacklo_epi8(a0, zero), _mm256_unpacklo_epi8(b0, zero));
+        auto hi0 = _mm256_add_epi16(_mm256_unpackhi_epi8(a0, zero), _mm256_unpackhi_epi8(b0, zero));
+        auto lo1 = _mm256_add_epi16(_mm256_unpacklo_epi8(a1, zero), _mm256_unpacklo_epi8(b1, zero));
+        auto hi1 = _mm256_add_epi16(_mm256_unpackhi_epi8(a1, zero), _mm256_unpackhi_epi8(b1, zero));
+
+        // Then horizontally, the weighted sums are linear, so adjacent pixels can be added afterwards.
+        // hadd interleaves the halves of its operands per lane, the permutation restores the order.
+        auto su = _mm256_hadd_epi32(dot8(lo0, hi0, ku), dot8(lo1, hi1, ku));
+        auto sv = _mm256_hadd_epi32(dot8(lo0, hi0, kv), dot8(lo1, hi1, kv));
+        su = _mm256_permute4x64_epi64(su, 0xD8);
+        sv = _mm256_permute4x64_epi64(sv, 0xD8);
+
+        su = _mm256_srai_epi32(_mm256_add_epi32(su, offset), shift + 2);
+        sv = _mm256_srai_epi32(_mm256_add_epi32(sv, offset), shift + 2);
+
+        _mm_storeu_si128((__m128i *) (u + x / 2), _mm256_castsi256_si128(pack16(su, su)));
+        _mm_storeu_si128((__m128i *) (v + x / 2), _mm256_castsi256_si128(pack16(sv, sv)));
+      }
+
+      chroma420_row_scalar(k, row0 + x * 4, row1 + x * 4, width - x, u + x / 2, v + x / 2);
+    }
+
+  #if defined(__clang__)
+    #pragma clang attribute pop
+  #else
+    #pragma GCC pop_options
+  #endif
+  }  // namespace
+
+  const kernels_t avx2_kernels {
+    "avx2",
+    luma_row_avx2,
+    chroma444_row_avx2,
+    chroma420_row_avx2,
+  };
+#endif
+
+  kernels_t kernels = scalar_kernels;
+
+  const char *
+  init() {
+#ifdef SUNSHINE_COLOR_CONVERT_X86
+    if (__builtin_cpu_supports("avx2")) {
+      kernels = avx2_kernels;
+      return kernels.name;
+    }
+#endif
+
+    // Left to the auto-vectorizer elsewhere, e.g. NEON is part of the aarch64 baseline
+    kernels = scalar_kernels;
+    return kernels.name;
+  }
+
+  namespace {
+    struct layout_t {
+      bool subsampled;
+      bool semi_planar;
+      int bit_depth;
+
+      // P010 keeps its samples in the high bits
+      int msb_shift;
+    };
+
+    std::optional<layout_t>
+    layout(AVPixelFormat format) {
+      switch (format) {
+        case AV_PIX_FMT_NV12:
+          return layout_t { true, true, 8, 0 };
+        case AV_PIX_FMT_P010:
+          return layout_t { true, true, 10, 6 };
+        case AV_PIX_FMT_YUV420P:
+          return layout_t { true, false, 8, 0 };
+        case AV_PIX_FMT_YUV420P10:
+          return layout_t { true, false, 10, 0 };
+        case AV_PIX_FMT_YUV444P:
+          return layout_t { false, false, 8, 0 };
+        case AV_PIX_FMT_YUV444P10:
+          return layout_t { false, false, 10, 0 };
+        default:
+          return std::nullopt;
+      }
+    }
+
+    void
+    store(const layout_t &layout, const std::uint16_t *in, int count, std::uint8_t *out) {
+      auto max = (std::uint16_t) ((1 << layout.bit_depth) - 1);
+
+      if (layout.bit_depth == 8) {
+        for (int x = 0; x < count; ++x) {
+          out[x] = (std::uint8_t) std::min(in[x], max);
+        }
+      }
+      else {
+        auto out16 = (std::uint16_t *) out;
+        for (int x = 0; x < count; ++x) {
+          out16[x] = (std::uint16_t) (std::min(in[x], max) << layout.msb_shift);
+        }
+      }
+    }
+
+    void
+    store_interleaved(const layout_t &layout, const std::uint16_t *u, const std::uint16_t *v, int count, std::uint8_t *out) {
+      auto max = (std::uint16_t) ((1 << layout.bit_depth) - 1);
+
+      if (layout.bit_depth == 8) {
+        for (int x = 0; x < count; ++x) {
+          out[x * 2] = (std::uint8_t) std::min(u[x], max);
+          out[x * 2 + 1] = (std::uint8_t) std::min(v[x], max);
+        }
+      }
+      else {
+        auto out16 = (std::uint16_t *) out;
+        for (int x = 0; x < count; ++x) {
+          out16[x * 2] = (std::uint16_t) (std::min(u[x], max) << layout.msb_shift);
+          out16[x * 2 + 1] = (std::uint16_t) (std::min(v[x], max) << layout.msb_shift);
+        }
+      }
+    }
+  }  // namespace
+
+  bool
+  converter_t::supported(AVPixelFormat format) {
+    return layout(format).has_value();
+  }
+
+  converter_t::converter_t(AVPixelFormat format, const video::sunshine_colorspace_t &colorspace, int width, int height, int threads):
+      _format { format }, _width { width }, _height { height } {
+    auto colorspace_out = colorspace;
+    colorspace_out.bit_depth = layout(format)->bit_depth;
+    _k = coefficients(colorspace_out);
+
+    // Bands start on an even row, so 4:2:0 chroma rows are never split between bands
+    auto bands = std::clamp(threads, 1, std::max((height + 1) / 2, 1));
+    _band_height = ((height + bands - 1) / bands + 1) & ~1;
+    bands = (height + _band_height - 1) / _band_height;
+
+    // Two rows of luma, then a row of each chroma
+    _scratch.resize(bands);
+    for (auto &scratch : _scratch) {
+      scratch.resize((std::size_t) width * 4);
+    }
+
+    if (bands > 1) {
+      _pool.start(bands - 1, [](std::size_t) {
+        platf::set_thread_name("convert");
+        platf::adjust_thread_priority(platf::thread_priority_e::high);
+      });
+    }
+  }
+
+  void
+  converter_t::convert(const std::uint8_t *src, int src_pitch, std::uint8_t *const *dst, const int *dst_pitch) {
+    auto bands = (int) _scratch.size();
+
+    _pending.clear();
+    for (int band = 1; band < bands; ++band) {
+      auto first = band * _band_height;
+      auto last = std::min(first + _band_height, _height);
+
+      _pending.emplace_back(_pool.push([this, band, first, last, src, src_pitch, dst, dst_pitch]() {
+        convert_rows(band, first, last, src, src_pitch, dst, dst_pitch);
+      }));
+    }
+
+    convert_rows(0, 0, std::min(_band_height, _height), src, src_pitch, dst, dst_pitch);
+
+    for (auto &pending : _pending) {
+      pending.get();
+    }
+  }
+
+  void
+  converter_t::convert_rows(int band, int first, int last, const std::uint8_t *src, int src_pitch, std::uint8_t *const *dst, const int *dst_pitch) {
+    auto layout = *color_convert::layout(_format);
+    auto &k = _k;
+    auto kernels = color_convert::kernels;
+
+    auto y_buf = _scratch[band].data();
+    auto u_buf = y_buf + _width * 2;
+    auto v_buf = u_buf + _width;
+
+    auto chroma_width = layout.subsampled ? (_width + 1) / 2 : _width;
+    auto row_step = layout.subsampled ? 2 : 1;
+
+    for (int y = first; y < last; y += row_step) {
+      auto row0 = src + (std::size_t) y * src_pitch;
+      auto rows = std::min(row_step, _height - y);
+
+      kernels.luma(k, row0, _width, y_buf);
+      store(layout, y_buf, _width, dst[0] + (std::size_t) y * dst_pitch[0]);
+
+      if (rows > 1) {
+        kernels.luma(k, row0 + src_pitch, _width, y_buf + _width);
+        store(layout, y_buf + _width, _width, dst[0] + (std::size_t) (y + 1) * dst_pitch[0]);
+      }
+
+      if (layout.subsampled) {
+        // A trailing odd row is subsampled with itself
+        kernels.chroma420(k, row0, rows > 1 ? row0 + src_pitch : row0, _width, u_buf, v_buf);
+      }
+      else {
+        kernels.chroma444(k, row0, _width, u_buf, v_buf);
+      }
+
+      auto chroma_row = y / row_step;
+      if (layout.semi_planar) {
+        store_interleaved(layout, u_buf, v_buf, chroma_width, dst[1] + (std::size_t) chroma_row * dst_pitch[1]);
+      }
+      else {
+        store(layout, u_buf, chroma_width, dst[1] + (std::size_t) chroma_row * dst_pitch[1]);
+        store(layout, v_buf, chroma_width, dst[2] + (std::size_t) chroma_row * dst_pitch[2]);
+      }
+    }
+  }
+}  // namespace color_convert
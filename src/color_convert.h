@@ -0,0 +1,139 @@
+/**
+ * @file src/color_convert.h
+ * @brief Declarations for the vectorized BGR0 to YUV converter of the software encode path.
+ */
+#pragma once
+
+// standard includes
+#include <cstdint>
+#include <future>
+#include <vector>
+
+// local includes
+#include "thread_pool.h"
+#include "video_colorspace.h"
+
+namespace color_convert {
+  /**
+   * @brief Fractional bits of the fixed point coefficients.
+   */
+  constexpr int shift = 13;
+
+  /**
+   * @brief Fixed point RGB to YUV coefficients for 8-bit BGR0 pixels.
+   *
+   * A component of a pixel is `(k[0] * B + k[1] * G + k[2] * R + offset) >> shift`,
+   * rounded and scaled to the bit depth and range of the colorspace.
+   */
+  struct coefficients_t {
+    std::int16_t y[4];
+    std::int16_t u[4];
+    std::int16_t v[4];
+
+    std::int32_t y_offset;
+    std::int32_t uv_offset;
+
+    // Chroma of 4:2:0 is computed from the sum of 2x2 pixels, shifted by 2 more bits
+    std::int32_t uv420_offset;
+  };
+
+  coefficients_t
+  coefficients(const video::sunshine_colorspace_t &colorspace);
+
+  /**
+   * @brief Convert a row of BGR0 pixels to luma.
+   */
+  using luma_row_t = void (*)(const coefficients_t &k, const std::uint8_t *bgr0, int width, std::uint16_t *y);
+
+  /**
+   * @brief Convert a row of BGR0 pixels to full resolution chroma.
+   */
+  using chroma444_row_t = void (*)(const coefficients_t &k, const std::uint8_t *bgr0, int width, std::uint16_t *u, std::uint16_t *v);
+
+  /**
+   * @brief Convert two rows of BGR0 pixels to chroma subsampled in both directions.
+   *
+   * Produces `(width + 1) / 2` samples, a trailing odd column is subsampled with itself.
+   */
+  using chroma420_row_t = void (*)(const coefficients_t &k, const std::uint8_t *row0, const std::uint8_t *row1, int width, std::uint16_t *u, std::uint16_t *v);
+
+  struct kernels_t {
+    const char *name;
+    luma_row_t luma;
+    chroma444_row_t chroma444;
+    chroma420_row_t chroma420;
+  };
+
+  /**
+   * @brief The reference implementation, the vectorized kernels match it bit for bit.
+   */
+  extern const kernels_t scalar_kernels;
+
+#if defined(__x86_64) || defined(__x86_64__) || defined(__amd64) || defined(__amd64__) || defined(_M_AMD64)
+  #define SUNSHINE_COLOR_CONVERT_X86
+
+  extern const kernels_t avx2_kernels;
+#endif
+
+  /**
+   * @brief The best kernels for this CPU, selected by init(). Defaults to the scalar kernels.
+   */
+  extern kernels_t kernels;
+
+  /**
+   * @brief Select the best kernels available on this CPU.
+   * @return The name of the selected kernels.
+   */
+  const char *
+  init();
+
+  /**
+   * @brief Converts BGR0 images to YUV without scaling, splitting the rows between threads.
+   *
+   * Supports NV12, P010, YUV420P, YUV420P10, YUV444P and YUV444P10.
+   */
+  class converter_t {
+  public:
+    /**
+     * @return `true` if `format` can be converted to.
+     */
+    static bool
+    supported(AVPixelFormat format);
+
+    /**
+     * @param format The output format, must be supported().
+     * @param colorspace The output colorspace, its bit depth is taken from `format`.
+     * @param width The width of the images.
+     * @param height The height of the images.
+     * @param threads The number of threads converting a frame, including the caller of convert().
+     */
+    converter_t(AVPixelFormat format, const video::sunshine_colorspace_t &colorspace, int width, int height, int threads);
+
+    /**
+     * @brief Convert an image.
+     * @param src The BGR0 image.
+     * @param src_pitch The number of bytes between two rows of `src`.
+     * @param dst The planes of the output, in the layout of the output format.
+     * @param dst_pitch The number of bytes between two rows of each plane.
+     */
+    void
+    convert(const std::uint8_t *src, int src_pitch, std::uint8_t *const *dst, const int *dst_pitch);
+
+  private:
+    void
+    convert_rows(int band, int first, int last, const std::uint8_t *src, int src_pitch, std::uint8_t *const *dst, const int *dst_pitch);
+
+    AVPixelFormat _format;
+    coefficients_t _k;
+    int _width;
+    int _height;
+    int _band_height;
+
+    // Intermediate rows of each band
+    std::vector<std::vector<std::uint16_t>> _scratch;
+
+    // Runs every band but the first, which runs on the caller
+    thread_pool_util::WorkStealingPool _pool;
+    std::vector<std::future<void>> _pending;
+  };
+}  // namespace color_convert
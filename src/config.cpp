@@ -23,6 +23,7 @@
 #include "logging.h"
 #include "nvhttp.h"
 #include "rtsp.h"
+#include "thread_placement.h"
 #include "utility.h"
 #include "globals.h"
 
@@ -383,10 +384,16 @@ namespace config {
 
     0,  // max_bitrate
     2,  // min_threads
+    false,  // shared_encoder
+    false,  // shared_conversion
+    true,  // prewarm_encoder
+    false,  // skip_static_frames
     {
       "superfast"s,  // preset
       "zerolatency"s,  // tune
       11,  // superfast
+      false,  // sw_pipeline
+      0,  // sw_intra_refresh
     },  // software
 
     {},  // nv
@@ -430,8 +437,18 @@ namespace config {
     },  // vaapi
 
     {},  // capture
+
+    {
+      "scroll",  // pattern
+      {},  // resolution
+      {},  // file
+    },  // synthetic
+
     {},  // encoder
     {},  // adapter_name
+    true,  // encoder_probe_cache
+    true,  // encoder_probe_revalidate
+    true,  // encoder_probe_lazy
     {},  // output_name
     {},  // capture_target (default: empty, will be set to "display" in apply_config)
     {},  // window_title
@@ -496,6 +513,12 @@ namespace config {
     1000ms, // timeout
   };
 
+  threads_t threads {
+    {},  // placement
+    {},  // sched_policy
+    10,  // rt_priority
+  };
+
   input_t input {
     {
       { 0x10, 0xA0 },
@@ -1095,6 +1118,10 @@ namespace config {
 
     int_f(vars, "qp", video.qp);
     int_f(vars, "min_threads", video.min_threads);
+    bool_f(vars, "shared_encoder", video.shared_encoder);
+    bool_f(vars, "shared_conversion", video.shared_conversion);
+    bool_f(vars, "prewarm_encoder", video.prewarm_encoder);
+    bool_f(vars, "skip_static_frames", video.skip_static_frames);
     int_between_f(vars, "hevc_mode", video.hevc_mode, { 0, 3 });
     int_between_f(vars, "av1_mode", video.av1_mode, { 0, 3 });
     string_f(vars, "sw_preset", video.sw.sw_preset);
@@ -1102,6 +1129,8 @@ namespace config {
       video.sw.svtav1_preset = sw::svtav1_preset_from_view(video.sw.sw_preset);
     }
     string_f(vars, "sw_tune", video.sw.sw_tune);
+    bool_f(vars, "sw_pipeline", video.sw.sw_pipeline);
+    int_between_f(vars, "sw_intra_refresh", video.sw.sw_intra_refresh, { 0, 600 });
 
     int_between_f(vars, "nvenc_preset", video.nv.quality_preset, { 1, 7 });
     int_between_f(vars, "nvenc_vbv_increase", video.nv.vbv_percentage_increase, { 0, 400 });
@@ -1182,8 +1211,15 @@ namespace config {
     }
 #endif
     
+    string_restricted_f(vars, "synthetic_pattern", video.synthetic.pattern, { "static"sv, "scroll"sv, "noise"sv, "file"sv });
+    string_f(vars, "synthetic_resolution", video.synthetic.resolution);
+    string_f(vars, "synthetic_file", video.synthetic.file);
+
     string_f(vars, "encoder", video.encoder);
     string_f(vars, "adapter_name", video.adapter_name);
+    bool_f(vars, "encoder_probe_cache", video.encoder_probe_cache);
+    bool_f(vars, "encoder_probe_revalidate", video.encoder_probe_revalidate);
+    bool_f(vars, "encoder_probe_lazy", video.encoder_probe_lazy);
     string_f(vars, "output_name", video.output_name);
     
 #ifdef _WIN32
@@ -1254,6 +1290,18 @@ namespace config {
     path_f(vars, "file_apps", stream.file_apps);
     int_between_f(vars, "fec_percentage", stream.fec_percentage, { 1, 255 });
 
+    for (auto name : thread_placement::thread_names) {
+      threads_t::placement_t placement { {}, -1 };
+      string_f(vars, "thread_affinity_"s + std::string { name }, placement.cpus);
+      int_between_f(vars, "thread_numa_node_"s + std::string { name }, placement.numa_node, { -1, 1023 });
+
+      if (!placement.cpus.empty() || placement.numa_node >= 0) {
+        threads.placement.insert_or_assign(std::string { name }, std::move(placement));
+      }
+    }
+    string_restricted_f(vars, "thread_sched_policy", threads.sched_policy, { ""sv, "nice"sv, "fifo"sv, "rr"sv });
+    int_between_f(vars, "thread_rt_priority", threads.rt_priority, { 2, 99 });
+
     map_int_int_f(vars, "keybindings"s, input.keybindings);
 
     // This config option will only be used by the UI
@@ -1304,6 +1352,7 @@ namespace config {
     bool_f(vars, "high_resolution_scrolling", input.high_resolution_scrolling);
     bool_f(vars, "native_pen_touch", input.native_pen_touch);
     bool_f(vars, "amf_draw_mouse_cursor", input.amf_draw_mouse_cursor);
+    string_f(vars, "input_record_file", input.record_file);
 
     bool_f(vars, "notify_pre_releases", sunshine.notify_pre_releases);
 
@@ -26,10 +26,16 @@ namespace config {
 
     int max_bitrate;  // Maximum bitrate, sets ceiling in kbps for bitrate requested from client
     int min_threads;  // Minimum number of threads/slices for CPU encoding
+    bool shared_encoder;  // Sessions with identical stream settings share one encoder
+    bool shared_conversion;  // Software encoded sessions share the color conversion of the captured images
+    bool prewarm_encoder;  // Build the encoder of a stream while the client is still connecting
+    bool skip_static_frames;  // Hash the tiles of images captured in main memory to skip those that didn't change
     struct {
       std::string sw_preset;
       std::string sw_tune;
       std::optional<int> svtav1_preset;
+      bool sw_pipeline;  // Convert the next frame on another thread while the current one is encoded
+      int sw_intra_refresh;  // Frames per intra refresh cycle of libx264, 0 for IDR frames on loss
     } sw;
 
     nvenc::nvenc_config nv;
@@ -80,8 +86,18 @@ namespace config {
     } vaapi;
 
     std::string capture;
+
+    struct {
+      std::string pattern;  // static|scroll|noise|file
+      std::string resolution;  // Empty to match the resolution requested by the client
+      std::string file;  // Raw BGR0 frames for the file pattern
+    } synthetic;
+
     std::string encoder;
     std::string adapter_name;
+    bool encoder_probe_cache;  // Reuse the encoder probe results saved for the same GPUs, drivers and settings
+    bool encoder_probe_revalidate;  // Probe again in the background after using cached results
+    bool encoder_probe_lazy;  // At startup, only wait for H.264 and probe the other codecs in the background
 
     struct display_mode_remapping_t {
       std::string type;
@@ -153,6 +169,19 @@ namespace config {
     std::chrono::milliseconds timeout;
   };
 
+  struct threads_t {
+    struct placement_t {
+      std::string cpus;  // CPU list, e.g. "2-3,6", empty to let the OS decide
+      int numa_node;  // Restrict to the CPUs of this NUMA node, -1 for any node
+    };
+
+    // Keyed by pipeline thread name, see thread_placement::thread_names
+    std::unordered_map<std::string, placement_t> placement;
+
+    std::string sched_policy;  // Linux only: empty to leave priorities alone, "nice", or "fifo"/"rr" for critical and high priority threads
+    int rt_priority;  // Real-time priority of critical threads, high priority threads get one less
+  };
+
   struct input_t {
     std::unordered_map<int, int> keybindings;
 
@@ -177,6 +206,8 @@ namespace config {
     bool high_resolution_scrolling;
     bool native_pen_touch;
     bool amf_draw_mouse_cursor;
+
+    std::string record_file;
   };
 
   namespace flag {
@@ -236,6 +267,7 @@ namespace config {
   extern stream_t stream;
   extern nvhttp_t nvhttp;
   extern webhook_t webhook;
+  extern threads_t threads;
   extern input_t input;
   extern sunshine_t sunshine;
 
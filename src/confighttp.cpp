@@ -47,6 +47,7 @@
 #include "src/display_device/display_device.h"
 #include "src/display_device/to_string.h"
 #include "stream.h"
+#include "thread_placement.h"
 #include "utility.h"
 #include "uuid.h"
 #include "video.h"
@@ -1201,6 +1202,37 @@ namespace confighttp {
     }
   }
 
+  /**
+   * @brief Get the effective CPU placement and scheduling of the streaming pipeline threads.
+   * @param response The HTTP response object.
+   * @param request The HTTP request object.
+   */
+  void
+  getRuntimeThreads(resp_https_t response, req_https_t request) {
+    if (!authenticate(response, request)) return;
+
+    print_req(request);
+
+    json threads_array = json::array();
+    for (const auto &status : thread_placement::current()) {
+      json thread_obj;
+      thread_obj["name"] = status.name;
+      thread_obj["thread_id"] = status.thread_id;
+      thread_obj["requested_cpus"] = thread_placement::to_cpu_list(status.requested_cpus);
+      thread_obj["cpus"] = thread_placement::to_cpu_list(status.cpus);
+      thread_obj["scheduling"] = status.scheduling;
+
+      threads_array.push_back(thread_obj);
+    }
+
+    json response_json;
+    response_json["success"] = true;
+    response_json["threads"] = threads_array;
+
+    response->write(response_json.dump());
+    response->close_connection_after_response = true;
+  }
+
   void
   changeRuntimeBitrate(resp_https_t response, req_https_t request) {
     if (!authenticate(response, request)) return;
@@ -1730,6 +1762,7 @@ namespace confighttp {
     server.resource["^/api/apps/test-menu-cmd$"]["POST"] = testMenuCmd;
     server.resource["^/api/runtime/sessions$"]["GET"] = getRuntimeSessions;
     server.resource["^/api/runtime/bitrate$"]["GET"] = changeRuntimeBitrate;
+    server.resource["^/api/runtime/threads$"]["GET"] = getRuntimeThreads;
     server.resource["^/steam-api/.+$"]["GET"] = proxySteamApi;
     server.resource["^/steam-store/.+$"]["GET"] = proxySteamStore;
     server.resource["^/images/sunshine.ico$"]["GET"] = getFaviconImage;
@@ -0,0 +1,173 @@
+/**
+ * @file src/cursor_blend.cpp
+ * @brief Definitions for the vectorized cursor blending kernels.
+ */
+// standard includes
+#include <algorithm>
+
+// local includes
+#include "cursor_blend.h"
+#include "platform/common.h"
+
+#ifdef SUNSHINE_CURSOR_BLEND_X86
+  #include <immintrin.h>
+#endif
+
+namespace cursor_blend {
+  blend_row_t blend_row = blend_row_scalar;
+
+  void
+  blend_row_scalar(std::uint32_t *dst, const std::uint32_t *src, std::size_t count) {
+    for (std::size_t x = 0; x < count; ++x) {
+      auto alpha = src[x] >> 24;
+      if (alpha == 255) {
+        dst[x] = src[x];
+        continue;
+      }
+
+      auto colors_in = (std::uint8_t *) &dst[x];
+      auto colors_out = (const std::uint8_t *) &src[x];
+      colors_in[0] = colors_out[0] + (colors_in[0] * (255 - alpha) + 255 / 2) / 255;
+      colors_in[1] = colors_out[1] + (colors_in[1] * (255 - alpha) + 255 / 2) / 255;
+      colors_in[2] = colors_out[2] + (colors_in[2] * (255 - alpha) + 255 / 2) / 255;
+    }
+  }
+
+#ifdef SUNSHINE_CURSOR_BLEND_X86
+  // The kernels divide exactly: for 0 <= p <= 255 * 255,
+  // (p + 127) / 255 == (p + 128 + ((p + 128) >> 8)) >> 8, without overflowing 16 bits.
+
+  static inline __m128i
+  div255_sse2(__m128i product) {
+    auto biased = _mm_add_epi16(product, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(biased, _mm_srli_epi16(biased, 8)), 8);
+  }
+
+  void
+  blend_row_sse2(std::uint32_t *dst, const std::uint32_t *src, std::size_t count) {
+    const auto zero = _mm_setzero_si128();
+    const auto opaque = _mm_set1_epi32(255);
+    const auto alpha_mask = _mm_set1_epi32((int) 0xFF000000);
+
+    std::size_t x = 0;
+    for (; x + 4 <= count; x += 4) {
+      auto s = _mm_loadu_si128((const __m128i *) (src + x));
+
+      // Most of a cursor image is fully transparent, which leaves the destination as is
+      if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xFFFF) {
+        continue;
+      }
+
+      auto d = _mm_loadu_si128((const __m128i *) (dst + x));
+
+      // 255 - alpha in both 16-bit halves of each pixel
+      auto alpha = _mm_srli_epi32(s, 24);
+      auto inv_alpha = _mm_sub_epi32(opaque, alpha);
+      inv_alpha = _mm_or_si128(inv_alpha, _mm_slli_epi32(inv_alpha, 16));
+
+      auto lo = div255_sse2(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi32(inv_alpha, inv_alpha)));
+      auto hi = div255_sse2(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi32(inv_alpha, inv_alpha)));
+
+      auto blended = _mm_add_epi8(s, _mm_packus_epi16(lo, hi));
+      blended = _mm_or_si128(_mm_andnot_si128(alpha_mask, blended), _mm_and_si128(alpha_mask, d));
+
+      auto is_opaque = _mm_cmpeq_epi32(alpha, opaque);
+      blended = _mm_or_si128(_mm_and_si128(is_opaque, s), _mm_andnot_si128(is_opaque, blended));
+
+      _mm_storeu_si128((__m128i *) (dst + x), blended);
+    }
+
+    blend_row_scalar(dst + x, src + x, count - x);
+  }
+
+  // Compile the AVX2 kernel without raising the baseline of the rest of the binary
+  #if defined(__clang__)
+    #pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+  #else
+    #pragma GCC push_options
+    #pragma GCC target("avx2")
+  #endif
+
+  static inline __m256i
+  div255_avx2(__m256i product) {
+    auto biased = _mm256_add_epi16(product, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(biased, _mm256_srli_epi16(biased, 8)), 8);
+  }
+
+  void
+  blend_row_avx2(std::uint32_t *dst, const std::uint32_t *src, std::size_t count) {
+    const auto zero = _mm256_setzero_si256();
+    const auto opaque = _mm256_set1_epi32(255);
+    const auto alpha_mask = _mm256_set1_epi32((int) 0xFF000000);
+
+    // Unpacking and packing both work within 128-bit lanes, so the pixel order is preserved
+    std::size_t x = 0;
+    for (; x + 8 <= count; x += 8) {
+      auto s = _mm256_loadu_si256((const __m256i *) (src + x));
+
+      if (_mm256_testz_si256(s, s)) {
+        continue;
+      }
+
+      auto d = _mm256_loadu_si256((const __m256i *) (dst + x));
+
+      auto alpha = _mm256_srli_epi32(s, 24);
+      auto inv_alpha = _mm256_sub_epi32(opaque, alpha);
+      inv_alpha = _mm256_or_si256(inv_alpha, _mm256_slli_epi32(inv_alpha, 16));
+
+      auto lo = div255_avx2(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi32(inv_alpha, inv_alpha)));
+      auto hi = div255_avx2(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi32(inv_alpha, inv_alpha)));
+
+      auto blended = _mm256_add_epi8(s, _mm256_packus_epi16(lo, hi));
+      blended = _mm256_blendv_epi8(blended, d, alpha_mask);
+
+      auto is_opaque = _mm256_cmpeq_epi32(alpha, opaque);
+      blended = _mm256_blendv_epi8(blended, s, is_opaque);
+
+      _mm256_storeu_si256((__m256i *) (dst + x), blended);
+    }
+
+    blend_row_sse2(dst + x, src + x, count - x);
+  }
+
+  #if defined(__clang__)
+    #pragma clang attribute pop
+  #else
+    #pragma GCC pop_options
+  #endif
+#endif
+
+  const char *
+  init() {
+#ifdef SUNSHINE_CURSOR_BLEND_X86
+    if (__builtin_cpu_supports("avx2")) {
+      blend_row = blend_row_avx2;
+      return "avx2";
+    }
+
+    // SSE2 is part of the x86-64 baseline
+    blend_row = blend_row_sse2;
+    return "sse2";
+#else
+    blend_row = blend_row_scalar;
+    return "scalar";
+#endif
+  }
+
+  void
+  blend(platf::img_t &img, const std::uint32_t *pixels, int x, int y, int width, int height) {
+    auto left = std::max(x, 0);
+    auto top = std::max(y, 0);
+    auto right = std::min(x + width, img.width);
+    auto bottom = std::min(y + height, img.height);
+
+    if (left >= right) {
+      return;
+    }
+
+    for (auto row = top; row < bottom; ++row) {
+      auto dst = (std::uint32_t *) (img.data + row * img.row_pitch) + left;
+      blend_row(dst, pixels + (row - y) * width + (left - x), right - left);
+    }
+  }
+}  // namespace cursor_blend
@@ -0,0 +1,66 @@
+/**
+ * @file src/cursor_blend.h
+ * @brief Declarations for the vectorized cursor blending kernels.
+ */
+#pragma once
+
+// standard includes
+#include <cstddef>
+#include <cstdint>
+
+namespace platf {
+  struct img_t;
+}
+
+namespace cursor_blend {
+  /**
+   * @brief Blend a row of premultiplied BGRA cursor pixels over BGRX pixels.
+   *
+   * Fully opaque cursor pixels replace the destination, alpha byte included.
+   * Otherwise each color channel becomes `src + (dst * (255 - alpha) + 127) / 255`,
+   * wrapping on overflow, and the alpha byte of the destination is left untouched.
+   * @param dst The destination pixels.
+   * @param src The cursor pixels.
+   * @param count The number of pixels.
+   */
+  using blend_row_t = void (*)(std::uint32_t *dst, const std::uint32_t *src, std::size_t count);
+
+  /**
+   * @brief The best kernel for this CPU, selected by init(). Defaults to the scalar kernel.
+   */
+  extern blend_row_t blend_row;
+
+  /**
+   * @brief The reference implementation, the vectorized kernels match it bit for bit.
+   */
+  void
+  blend_row_scalar(std::uint32_t *dst, const std::uint32_t *src, std::size_t count);
+
+#if defined(__x86_64) || defined(__x86_64__) || defined(__amd64) || defined(__amd64__) || defined(_M_AMD64)
+  #define SUNSHINE_CURSOR_BLEND_X86
+
+  void
+  blend_row_sse2(std::uint32_t *dst, const std::uint32_t *src, std::size_t count);
+  void
+  blend_row_avx2(std::uint32_t *dst, const std::uint32_t *src, std::size_t count);
+#endif
+
+  /**
+   * @brief Select the best kernel available on this CPU.
+   * @return The name of the selected kernel.
+   */
+  const char *
+  init();
+
+  /**
+   * @brief Blend a cursor into an image, skipping the parts of the cursor outside of the image.
+   * @param img The 32-bit image to draw into.
+   * @param pixels The premultiplied BGRA cursor, `width * height` pixels without padding.
+   * @param x The left edge of the cursor relative to the image, may be negative.
+   * @param y The top edge of the cursor relative to the image, may be negative.
+   * @param width The width of the cursor.
+   * @param height The height of the cursor.
+   */
+  void
+  blend(platf::img_t &img, const std::uint32_t *pixels, int x, int y, int width, int height);
+}  // namespace cursor_blend
@@ -0,0 +1,74 @@
+/**
+ * @file src/encoder_probe_cache.cpp
+ * @brief Definitions for persisting the results of the encoder probe.
+ */
+// standard includes
+#include <filesystem>
+
+// lib includes
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+// local includes
+#include "encoder_probe_cache.h"
+#include "logging.h"
+
+using namespace std::literals;
+
+namespace video {
+  namespace fs = std::filesystem;
+  namespace pt = boost::property_tree;
+
+  std::optional<probe_result_t>
+  load_probe_result(const std::string &path, const std::string &key) {
+    if (!fs::exists(path)) {
+      BOOST_LOG(debug) << "File "sv << path << " doesn't exist"sv;
+      return std::nullopt;
+    }
+
+    try {
+      pt::ptree tree;
+      pt::read_json(path, tree);
+
+      if (tree.get<std::string>("root.key") != key) {
+        BOOST_LOG(info) << "Encoder probe cache doesn't match the current GPUs, drivers or settings"sv;
+        return std::nullopt;
+      }
+
+      return probe_result_t {
+        tree.get<std::string>("root.encoder"),
+        tree.get<unsigned long>("root.h264"),
+        tree.get<unsigned long>("root.hevc"),
+        tree.get<unsigned long>("root.av1"),
+        tree.get<int>("root.hevc_mode"),
+        tree.get<int>("root.av1_mode"),
+      };
+    }
+    catch (std::exception &e) {
+      BOOST_LOG(warning) << "Couldn't read "sv << path << ": "sv << e.what();
+      return std::nullopt;
+    }
+  }
+
+  bool
+  save_probe_result(const std::string &path, const std::string &key, const probe_result_t &result) {
+    pt::ptree tree;
+    tree.put("root.key", key);
+    tree.put("root.encoder", result.encoder);
+    tree.put("root.h264", result.h264);
+    tree.put("root.hevc", result.hevc);
+    tree.put("root.av1", result.av1);
+    tree.put("root.hevc_mode", result.hevc_mode);
+    tree.put("root.av1_mode", result.av1_mode);
+
+    try {
+      pt::write_json(path, tree);
+    }
+    catch (std::exception &e) {
+      BOOST_LOG(error) << "Couldn't write "sv << path << ": "sv << e.what();
+      return false;
+    }
+
+    return true;
+  }
+}  // namespace video
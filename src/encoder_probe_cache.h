@@ -0,0 +1,45 @@
+/**
+ * @file src/encoder_probe_cache.h
+ * @brief Declarations for persisting the results of the encoder probe.
+ */
+#pragma once
+
+// standard includes
+#include <optional>
+#include <string>
+
+namespace video {
+  /**
+   * @brief The outcome of an encoder probe, enough to skip the next one.
+   */
+  struct probe_result_t {
+    std::string encoder;  ///< Name of the chosen encoder
+
+    // Capability flags of each codec of the chosen encoder, as encoder_t::codec_t::capabilities
+    unsigned long h264;
+    unsigned long hevc;
+    unsigned long av1;
+
+    int hevc_mode;  ///< HEVC support, as determined for `hevc_mode`
+    int av1_mode;  ///< AV1 support, as determined for `av1_mode`
+
+    bool
+    operator==(const probe_result_t &) const = default;
+  };
+
+  /**
+   * @brief Read the probe result saved in a file.
+   * @param path The cache file.
+   * @param key Identifies the hardware, drivers and settings the result is valid for.
+   * @return The result, or `std::nullopt` if the file is missing, unreadable or was saved under another key.
+   */
+  std::optional<probe_result_t>
+  load_probe_result(const std::string &path, const std::string &key);
+
+  /**
+   * @brief Save a probe result to a file, replacing the previous one.
+   * @return `true` on success.
+   */
+  bool
+  save_probe_result(const std::string &path, const std::string &key, const probe_result_t &result);
+}  // namespace video
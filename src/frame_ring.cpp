@@ -0,0 +1,88 @@
+/**
+ * @file src/frame_ring.cpp
+ * @brief Definitions for the hand-off of converted frames between the conversion and encoding threads.
+ */
+// local includes
+#include "frame_ring.h"
+
+namespace video {
+  frame_ring_t::frame_ring_t(int held):
+      _held { held } {}
+
+  int
+  frame_ring_t::acquire() {
+    std::lock_guard lg { _lock };
+
+    for (int slot = 0; slot < slots; ++slot) {
+      if (slot != _held && (!_ready || slot != _ready->slot)) {
+        return slot;
+      }
+    }
+
+    // Unreachable, at most two slots are taken
+    return -1;
+  }
+
+  void
+  frame_ring_t::publish(int slot, std::optional<std::chrono::steady_clock::time_point> frame_timestamp) {
+    {
+      std::lock_guard lg { _lock };
+
+      if (_ready) {
+        ++_dropped;
+      }
+      _ready = entry_t { slot, frame_timestamp };
+    }
+
+    _cv.notify_one();
+  }
+
+  void
+  frame_ring_t::close() {
+    {
+      std::lock_guard lg { _lock };
+      _closed = true;
+    }
+
+    _cv.notify_all();
+  }
+
+  std::optional<frame_ring_t::entry_t>
+  frame_ring_t::take(std::chrono::steady_clock::duration timeout) {
+    std::unique_lock ul { _lock };
+
+    if (!_cv.wait_for(ul, timeout, [this]() { return _ready || _closed; }) || !_ready) {
+      return std::nullopt;
+    }
+
+    auto entry = *_ready;
+    _ready.reset();
+    _held = entry.slot;
+
+    return entry;
+  }
+
+  bool
+  frame_ring_t::ready() {
+    std::lock_guard lg { _lock };
+    return (bool) _ready;
+  }
+
+  bool
+  frame_ring_t::closed() {
+    std::lock_guard lg { _lock };
+    return _closed;
+  }
+
+  int
+  frame_ring_t::held() {
+    std::lock_guard lg { _lock };
+    return _held;
+  }
+
+  std::uint64_t
+  frame_ring_t::dropped() {
+    std::lock_guard lg { _lock };
+    return _dropped;
+  }
+}  // namespace video
@@ -0,0 +1,98 @@
+/**
+ * @file src/frame_ring.h
+ * @brief Declarations for the hand-off of converted frames between the conversion and encoding threads.
+ */
+#pragma once
+
+// standard includes
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+namespace video {
+  /**
+   * @brief Hands frames converted on one thread over to the thread encoding them.
+   *
+   * The ring has three slots: the one the encoder holds, the one waiting to be taken and
+   * the one being converted, so the converter never waits for the encoder.
+   * Like the capture image events, the latest frame wins: a frame that is still waiting
+   * when a newer one is published is dropped, and its slot is converted into again.
+   */
+  class frame_ring_t {
+  public:
+    static constexpr int slots = 3;
+
+    struct entry_t {
+      int slot;
+      std::optional<std::chrono::steady_clock::time_point> frame_timestamp;
+    };
+
+    /**
+     * @param held The slot the encoder starts out with.
+     */
+    explicit frame_ring_t(int held = 0);
+
+    /**
+     * @brief Get a slot to convert into, neither held by the encoder nor waiting to be taken.
+     */
+    int
+    acquire();
+
+    /**
+     * @brief Make a converted slot the next one to be taken by the encoder.
+     */
+    void
+    publish(int slot, std::optional<std::chrono::steady_clock::time_point> frame_timestamp);
+
+    /**
+     * @brief Stop waiting for frames, take() returns immediately from now on.
+     *
+     * A frame published before is still handed out.
+     */
+    void
+    close();
+
+    /**
+     * @brief Take the latest converted frame, releasing the slot held until now.
+     * @param timeout How long to wait for a frame.
+     * @return The frame, or `std::nullopt` if none was published in time or the ring was closed meanwhile.
+     */
+    std::optional<entry_t>
+    take(std::chrono::steady_clock::duration timeout);
+
+    /**
+     * @return `true` if a frame is waiting to be taken.
+     */
+    bool
+    ready();
+
+    /**
+     * @return `true` once close() has been called.
+     */
+    bool
+    closed();
+
+    /**
+     * @return The slot held by the encoder.
+     */
+    int
+    held();
+
+    /**
+     * @return The number of frames that were replaced before the encoder took them.
+     */
+    std::uint64_t
+    dropped();
+
+  private:
+    std::mutex _lock;
+    std::condition_variable _cv;
+
+    int _held;
+    std::optional<entry_t> _ready;
+    bool _closed {};
+    std::uint64_t _dropped {};
+  };
+}  // namespace video
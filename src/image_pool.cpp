@@ -0,0 +1,160 @@
+/**
+ * @file src/image_pool.cpp
+ * @brief Definitions for the pool of capture images.
+ */
+// standard includes
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// local includes
+#include "image_pool.h"
+#include "platform/common.h"
+
+using namespace std::literals;
+
+namespace video {
+  struct image_pool_t::state_t {
+    struct entry_t {
+      std::shared_ptr<platf::img_t> img;
+      std::chrono::steady_clock::time_point released;
+    };
+
+    state_t(std::size_t capacity, std::chrono::steady_clock::duration trim_timeout):
+        capacity { capacity }, trim_timeout { trim_timeout } {}
+
+    /**
+     * @brief Called by the deleter of the last reference handed out for an image.
+     */
+    void
+    release(std::shared_ptr<platf::img_t> &&img, std::uint64_t img_generation) {
+      std::lock_guard lg { lock };
+
+      // The pool was cleared while the image was in use
+      if (img_generation != generation) {
+        return;
+      }
+
+      // Someone kept a reference from shared_from_this() past the lease, it's theirs now
+      if (img.use_count() > 1) {
+        --allocated;
+        cv.notify_one();
+        return;
+      }
+
+      free.push_back({ std::move(img), std::chrono::steady_clock::now() });
+      cv.notify_one();
+    }
+
+    const std::size_t capacity;
+    const std::chrono::steady_clock::duration trim_timeout;
+
+    std::mutex lock;
+    std::condition_variable cv;
+
+    // The back holds the most recently released image
+    std::deque<entry_t> free;
+    std::size_t allocated {};
+    std::uint64_t generation {};
+  };
+
+  /**
+   * @brief Holds the pool's reference to an image for as long as it's leased out.
+   */
+  struct image_pool_t::lease_t {
+    lease_t(std::shared_ptr<state_t> state, std::shared_ptr<platf::img_t> &&img, std::uint64_t generation):
+        state { std::move(state) }, img { std::move(img) }, generation { generation } {}
+
+    ~lease_t() {
+      state->release(std::move(img), generation);
+    }
+
+    std::shared_ptr<state_t> state;
+    std::shared_ptr<platf::img_t> img;
+    std::uint64_t generation;
+  };
+
+  image_pool_t::image_pool_t(std::size_t capacity, std::chrono::steady_clock::duration trim_timeout):
+      _state { std::make_shared<state_t>(capacity, trim_timeout) } {}
+
+  image_pool_t::~image_pool_t() {
+    clear();
+  }
+
+  std::shared_ptr<platf::img_t>
+  image_pool_t::acquire(const alloc_t &alloc, const running_t &running) {
+    // Trimmed images are destroyed after the lock is released
+    std::vector<std::shared_ptr<platf::img_t>> trimmed;
+    std::shared_ptr<platf::img_t> img;
+
+    std::unique_lock ul { _state->lock };
+    while (!img) {
+      if (!running()) {
+        return nullptr;
+      }
+
+      if (!_state->free.empty()) {
+        img = std::move(_state->free.back().img);
+        _state->free.pop_back();
+      }
+      else if (_state->allocated < _state->capacity) {
+        ++_state->allocated;
+
+        // Allocation may be slow, don't hold up encoders releasing their images meanwhile
+        ul.unlock();
+        img = alloc();
+        ul.lock();
+
+        if (!img) {
+          --_state->allocated;
+          return nullptr;
+        }
+      }
+      else {
+        // The timeout only bounds how long it takes to notice running() turned false
+        _state->cv.wait_for(ul, 100ms);
+      }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    while (!_state->free.empty() && now - _state->free.front().released > _state->trim_timeout) {
+      trimmed.emplace_back(std::move(_state->free.front().img));
+      _state->free.pop_front();
+      --_state->allocated;
+    }
+
+    auto generation = _state->generation;
+    ul.unlock();
+
+    // The copies handed out share the control block of the lease, so their use_count() counts the holders of the lease
+    auto raw = img.get();
+    auto lease = std::make_shared<lease_t>(_state, std::move(img), generation);
+    return std::shared_ptr<platf::img_t> { std::move(lease), raw };
+  }
+
+  void
+  image_pool_t::clear() {
+    std::deque<state_t::entry_t> idle;
+
+    std::lock_guard lg { _state->lock };
+    ++_state->generation;
+    _state->allocated = 0;
+    idle.swap(_state->free);
+
+    // The images are destroyed after the lock is released
+  }
+
+  std::size_t
+  image_pool_t::allocated() const {
+    std::lock_guard lg { _state->lock };
+    return _state->allocated;
+  }
+
+  std::size_t
+  image_pool_t::free() const {
+    std::lock_guard lg { _state->lock };
+    return _state->free.size();
+  }
+}  // namespace video
@@ -0,0 +1,83 @@
+/**
+ * @file src/image_pool.h
+ * @brief Declarations for the pool of capture images.
+ */
+#pragma once
+
+// standard includes
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace platf {
+  struct img_t;
+}
+
+namespace video {
+  /**
+   * @brief Recycles capture images between the capture thread and the encoders.
+   *
+   * Images are handed out as shared_ptr's aliasing a lease, whose destruction puts them back on the free list,
+   * so acquiring and releasing are O(1), and a capture thread waiting for an image
+   * is woken up as soon as an encoder drops one.
+   * A reference taken with shared_from_this() bypasses the lease: if one is still alive when the lease ends,
+   * the image leaves the pool instead of being reused.
+   * The free list is kept in release order: the most recently released image is reused first,
+   * and the least recently released ones are destroyed once they have been idle for the trim timeout.
+   */
+  class image_pool_t {
+  public:
+    using alloc_t = std::function<std::shared_ptr<platf::img_t>()>;
+    using running_t = std::function<bool()>;
+
+    /**
+     * @param capacity The maximum number of images alive at once.
+     * @param trim_timeout How long a free image is kept around before it's destroyed.
+     */
+    image_pool_t(std::size_t capacity, std::chrono::steady_clock::duration trim_timeout);
+
+    image_pool_t(const image_pool_t &) = delete;
+    image_pool_t &
+    operator=(const image_pool_t &) = delete;
+
+    ~image_pool_t();
+
+    /**
+     * @brief Get a free image, allocating a new one while the pool is below capacity.
+     *
+     * If all images are in use, this blocks until one is released.
+     * @param alloc Allocates a new image.
+     * @param running Checked while waiting, acquire() gives up once it returns false.
+     * @return The image, or nullptr if the allocation failed or running() returned false.
+     */
+    std::shared_ptr<platf::img_t>
+    acquire(const alloc_t &alloc, const running_t &running);
+
+    /**
+     * @brief Destroy the free images.
+     *
+     * Images still in use are destroyed instead of being returned to the pool when released.
+     */
+    void
+    clear();
+
+    /**
+     * @brief The number of images owned by the pool, free or in use.
+     */
+    std::size_t
+    allocated() const;
+
+    /**
+     * @brief The number of images waiting on the free list.
+     */
+    std::size_t
+    free() const;
+
+  private:
+    struct state_t;
+    struct lease_t;
+
+    std::shared_ptr<state_t> _state;
+  };
+}  // namespace video
@@ -9,16 +9,19 @@ extern "C" {
 #include <moonlight-common-c/src/Limelight.h>
 }
 
+#include <atomic>
 #include <bitset>
 #include <chrono>
 #include <cmath>
 #include <list>
+#include <mutex>
 #include <thread>
 #include <unordered_map>
 
 #include "config.h"
 #include "globals.h"
 #include "input.h"
+#include "input_replay.h"
 #include "logging.h"
 #include "platform/common.h"
 #include "display_device/session.h"
@@ -117,6 +120,10 @@ namespace input {
   static platf::input_t platf_input;
   static std::bitset<platf::MAX_GAMEPADS> gamepadMask {};
 
+  // Set from the replay harness while input is dispatched on the task pool
+  static std::mutex dispatch_hook_lock;
+  static std::shared_ptr<dispatch_hook_t> dispatch_hook;
+
   void
   free_gamepad(platf::input_t &platf_input, int id) {
     platf::gamepad_update(platf_input, id, platf::gamepad_state_t {});
@@ -159,11 +166,13 @@ namespace input {
 
     input_t(
       safe::mail_raw_t::event_t<input::touch_port_t> touch_port_event,
+      safe::mail_raw_t::event_t<int> switch_display_event,
       platf::feedback_queue_t feedback_queue):
         shortcutFlags {},
         gamepads(MAX_GAMEPADS),
         client_context { platf::allocate_client_input_context(platf_input) },
         touch_port_event { std::move(touch_port_event) },
+        switch_display_event { std::move(switch_display_event) },
         feedback_queue { std::move(feedback_queue) },
         mouse_left_button_timeout {},
         touch_port { { 0, 0, 0, 0 }, 0, 0, 1.0f },
@@ -177,11 +186,20 @@ namespace input {
     std::unique_ptr<platf::client_input_t> client_context;
 
     safe::mail_raw_t::event_t<input::touch_port_t> touch_port_event;
+    safe::mail_raw_t::event_t<int> switch_display_event;
     platf::feedback_queue_t feedback_queue;
 
-    std::list<std::vector<uint8_t>> input_queue;
+    struct queued_input_t {
+      std::chrono::steady_clock::time_point queued;
+      std::vector<uint8_t> data;
+    };
+
+    std::list<queued_input_t> input_queue;
     std::mutex input_queue_lock;
 
+    // Only set when input_record_file is configured
+    std::unique_ptr<replay::recorder_t> recorder;
+
     thread_pool_util::ThreadPool::task_id_t mouse_left_button_timeout;
 
     input::touch_port_t touch_port;
@@ -192,18 +210,20 @@ namespace input {
 
   /**
    * @brief Apply shortcut based on VKEY
+   * @param input The input context of the session the shortcut was pressed in.
    * @param keyCode The VKEY code
    * @return 0 if no shortcut applied, > 0 if shortcut applied.
    */
   inline int
-  apply_shortcut(short keyCode) {
+  apply_shortcut(input_t &input, short keyCode) {
     constexpr auto SUNSHINE_VK_F1 = 0x70;
     constexpr auto SUNSHINE_VK_F13 = 0x7C;
 
     BOOST_LOG(debug) << "Apply Shortcut: 0x"sv << util::hex((std::uint8_t) keyCode).to_string_view();
 
     if (keyCode >= SUNSHINE_VK_F1 && keyCode <= SUNSHINE_VK_F13) {
-      mail::man->event<int>(mail::switch_display)->raise(keyCode - SUNSHINE_VK_F1);
+      // Only the video stream of this session switches to the display
+      input.switch_display_event->raise(keyCode - SUNSHINE_VK_F1);
       return 1;
     }
 
@@ -773,7 +793,7 @@ namespace input {
       if (!release) {
         // A new key has been pressed down, we need to check for key combo's
         // If a key-combo has been pressed down, don't pass it through
-        if (input->shortcutFlags == input_t::SHORTCUT && apply_shortcut(keyCode) > 0) {
+        if (input->shortcutFlags == input_t::SHORTCUT && apply_shortcut(*input, keyCode) > 0) {
           return;
         }
 
@@ -1535,6 +1555,7 @@ namespace input {
     // 'entry' backs the 'payload' pointer, so they must remain in scope together
     std::vector<uint8_t> entry;
     PNV_INPUT_HEADER payload;
+    dispatch_info_t info;
 
     // Lock the input queue while batching, but release it before sending
     // the input to the OS. This avoids potentially lengthy lock contention
@@ -1548,15 +1569,16 @@ namespace input {
       }
 
       // Pop off the first entry, which we will send
-      entry = input->input_queue.front();
+      info.queued = input->input_queue.front().queued;
+      info.batched = 1;
+      entry = std::move(input->input_queue.front().data);
       payload = (PNV_INPUT_HEADER) entry.data();
       input->input_queue.pop_front();
 
       // Try to batch with remaining items on the queue
       auto i = input->input_queue.begin();
       while (i != input->input_queue.end()) {
-        auto batchable_entry = *i;
-        auto batchable_payload = (PNV_INPUT_HEADER) batchable_entry.data();
+        auto batchable_payload = (PNV_INPUT_HEADER) i->data.data();
 
         auto batch_result = batch(payload, batchable_payload);
         if (batch_result == batch_result_e::terminate_batch) {
@@ -1566,17 +1588,32 @@ namespace input {
         else if (batch_result == batch_result_e::batched) {
           // Erase this entry since it was batched
           i = input->input_queue.erase(i);
+          ++info.batched;
         }
         else {
           // We couldn't batch this entry, but try to batch later entries.
           i++;
         }
       }
+
+      info.queue_depth = input->input_queue.size();
     }
 
     // Print the final input packet
     input::print((void *) payload);
 
+    std::shared_ptr<dispatch_hook_t> hook;
+    {
+      std::lock_guard lg { dispatch_hook_lock };
+      hook = dispatch_hook;
+    }
+
+    if (hook) {
+      info.dispatched = std::chrono::steady_clock::now();
+      (*hook)(entry, info);
+      return;
+    }
+
     // Send the batched input to the OS
     switch (util::endian::little(payload->magic)) {
       case MOUSE_MOVE_REL_MAGIC_GEN5:
@@ -1633,13 +1670,25 @@ namespace input {
    */
   void
   passthrough(std::shared_ptr<input_t> &input, std::vector<std::uint8_t> &&input_data) {
+    if (input->recorder) {
+      input->recorder->record(input_data);
+    }
+
     {
       std::lock_guard<std::mutex> lg(input->input_queue_lock);
-      input->input_queue.push_back(std::move(input_data));
+      input->input_queue.push_back({ std::chrono::steady_clock::now(), std::move(input_data) });
     }
     task_pool.push(passthrough_next_message, input);
   }
 
+  void
+  set_dispatch_hook(dispatch_hook_t hook) {
+    auto new_hook = hook ? std::make_shared<dispatch_hook_t>(std::move(hook)) : nullptr;
+
+    std::lock_guard lg { dispatch_hook_lock };
+    dispatch_hook = std::move(new_hook);
+  }
+
   void
   reset(std::shared_ptr<input_t> &input) {
     task_pool.cancel(key_press_repeat_id);
@@ -1695,10 +1744,20 @@ namespace input {
   alloc(safe::mail_t mail) {
     auto input = std::make_shared<input_t>(
       mail->event<input::touch_port_t>(mail::touch_port),
+      mail->event<int>(mail::switch_display),
       mail->queue<platf::gamepad_feedback_msg_t>(mail::gamepad_feedback));
 
+    if (!config::input.record_file.empty()) {
+      static std::atomic<std::uint32_t> sessions_recorded;
+      input->recorder = replay::recorder_t::open(replay::session_path(config::input.record_file, ++sessions_recorded));
+    }
+
     // Workaround to ensure new frames will be captured when a client connects
     task_pool.pushDelayed([]() {
+      if (!platf_input) {
+        return;
+      }
+
       platf::move_mouse(platf_input, 1, 1);
       platf::move_mouse(platf_input, -1, -1);
     },
@@ -4,6 +4,7 @@
  */
 #pragma once
 
+#include <chrono>
 #include <functional>
 
 #include "platform/common.h"
@@ -19,6 +20,26 @@ namespace input {
   void
   passthrough(std::shared_ptr<input_t> &input, std::vector<std::uint8_t> &&input_data);
 
+  /**
+   * @brief Describes an input message after batching, right before it is injected.
+   */
+  struct dispatch_info_t {
+    std::chrono::steady_clock::time_point queued;  ///< When the oldest packet of the message was queued
+    std::chrono::steady_clock::time_point dispatched;  ///< When batching completed
+    std::size_t batched;  ///< Number of packets merged into this message
+    std::size_t queue_depth;  ///< Packets still queued after batching
+  };
+
+  using dispatch_hook_t = std::function<void(const std::vector<std::uint8_t> &message, const dispatch_info_t &info)>;
+
+  /**
+   * @brief Divert batched input messages away from the platform.
+   * @param hook Called instead of injecting into the OS, or an empty function to restore injection.
+   * @note This is meant for benchmarks and tests, see input::replay.
+   */
+  void
+  set_dispatch_hook(dispatch_hook_t hook);
+
   [[nodiscard]] std::unique_ptr<platf::deinit_t>
   init();
 
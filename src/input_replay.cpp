@@ -0,0 +1,251 @@
+/**
+ * @file src/input_replay.cpp
+ * @brief Definitions for recording and replaying input streams.
+ */
+// standard includes
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+// local includes
+#include "globals.h"
+#include "input.h"
+#include "input_replay.h"
+#include "logging.h"
+#include "utility.h"
+
+using namespace std::literals;
+
+namespace input::replay {
+  namespace {
+    constexpr char magic[8] { 'S', 'U', 'N', 'I', 'N', 'P', 'T', '1' };
+
+    template <class T>
+    void
+    write_le(std::ostream &out, T value) {
+      value = util::endian::little(value);
+      out.write((const char *) &value, sizeof(value));
+    }
+
+    template <class T>
+    bool
+    read_le(std::istream &in, T &value) {
+      if (!in.read((char *) &value, sizeof(value))) {
+        return false;
+      }
+
+      value = util::endian::little(value);
+      return true;
+    }
+
+    std::chrono::nanoseconds
+    percentile(const std::vector<std::chrono::nanoseconds> &sorted, double p) {
+      if (sorted.empty()) {
+        return 0ns;
+      }
+
+      auto index = (std::size_t) (p * (double) (sorted.size() - 1) + 0.5);
+      return sorted[std::min(index, sorted.size() - 1)];
+    }
+  }  // namespace
+
+  recorder_t::recorder_t(std::ofstream &&file):
+      _file { std::move(file) }, _start { std::chrono::steady_clock::now() } {
+    _writer = std::thread { &recorder_t::write_pending, this };
+  }
+
+  recorder_t::~recorder_t() {
+    {
+      std::lock_guard lg { _lock };
+      _stop = true;
+    }
+    _cv.notify_one();
+
+    _writer.join();
+  }
+
+  std::unique_ptr<recorder_t>
+  recorder_t::open(const std::string &path) {
+    std::ofstream file { path, std::ios::binary | std::ios::trunc };
+    if (!file) {
+      BOOST_LOG(error) << "Couldn't open input recording ["sv << path << ']';
+      return nullptr;
+    }
+
+    file.write(magic, sizeof(magic));
+
+    BOOST_LOG(info) << "Recording input to ["sv << path << ']';
+    return std::unique_ptr<recorder_t> { new recorder_t { std::move(file) } };
+  }
+
+  void
+  recorder_t::record(const std::vector<std::uint8_t> &data) {
+    record(std::chrono::steady_clock::now() - _start, data);
+  }
+
+  void
+  recorder_t::record(std::chrono::nanoseconds timestamp, const std::vector<std::uint8_t> &data) {
+    if (data.size() > std::numeric_limits<std::uint16_t>::max()) {
+      BOOST_LOG(warning) << "Input packet too large to record: "sv << data.size() << " bytes"sv;
+      return;
+    }
+
+    {
+      std::lock_guard lg { _lock };
+      _pending.emplace_back(packet_t { timestamp, data });
+    }
+    _cv.notify_one();
+  }
+
+  void
+  recorder_t::write_pending() {
+    std::vector<packet_t> packets;
+
+    std::unique_lock ul { _lock };
+    while (true) {
+      _cv.wait(ul, [this]() { return _stop || !_pending.empty(); });
+      if (_pending.empty()) {
+        // Stopped, and everything recorded so far was written
+        break;
+      }
+
+      std::swap(packets, _pending);
+      ul.unlock();
+
+      for (auto &packet : packets) {
+        write_le(_file, (std::uint64_t) packet.timestamp.count());
+        write_le(_file, (std::uint16_t) packet.data.size());
+        _file.write((const char *) packet.data.data(), packet.data.size());
+      }
+      _file.flush();
+      packets.clear();
+
+      ul.lock();
+    }
+  }
+
+  std::string
+  session_path(const std::string &path, std::uint32_t session) {
+    std::filesystem::path session_path { path };
+
+    auto file_name = session_path.stem().string() + '-' + std::to_string(session) + session_path.extension().string();
+    session_path.replace_filename(file_name);
+
+    return session_path.string();
+  }
+
+  std::optional<std::vector<packet_t>>
+  load(const std::string &path) {
+    std::ifstream file { path, std::ios::binary };
+    if (!file) {
+      BOOST_LOG(error) << "Couldn't open input recording ["sv << path << ']';
+      return std::nullopt;
+    }
+
+    char file_magic[sizeof(magic)];
+    if (!file.read(file_magic, sizeof(file_magic)) || !std::equal(std::begin(magic), std::end(magic), file_magic)) {
+      BOOST_LOG(error) << "Not an input recording ["sv << path << ']';
+      return std::nullopt;
+    }
+
+    std::vector<packet_t> packets;
+    while (true) {
+      std::uint64_t timestamp;
+      std::uint16_t size;
+      if (!read_le(file, timestamp)) {
+        break;
+      }
+
+      packet_t packet { std::chrono::nanoseconds { timestamp }, std::vector<std::uint8_t>(0) };
+      packet.data.resize(read_le(file, size) ? size : 0);
+      if (!file || !file.read((char *) packet.data.data(), packet.data.size()) || packet.data.empty()) {
+        BOOST_LOG(error) << "Truncated input recording ["sv << path << "] after "sv << packets.size() << " packets"sv;
+        return std::nullopt;
+      }
+
+      packets.emplace_back(std::move(packet));
+    }
+
+    return packets;
+  }
+
+  report_t
+  run(const std::vector<packet_t> &packets, double speed) {
+    std::mutex lock;
+    std::condition_variable cv;
+    std::vector<dispatch_info_t> dispatched;
+    std::size_t packets_dispatched = 0;
+
+    set_dispatch_hook([&](const std::vector<std::uint8_t> &, const dispatch_info_t &info) {
+      std::lock_guard lg { lock };
+      dispatched.emplace_back(info);
+      packets_dispatched += info.batched;
+      cv.notify_all();
+    });
+    auto fg = util::fail_guard([]() {
+      set_dispatch_hook(nullptr);
+    });
+
+    auto input = alloc(std::make_shared<safe::mail_raw_t>());
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto &packet : packets) {
+      if (speed > 0) {
+        std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::nanoseconds>(packet.timestamp / speed));
+      }
+
+      auto data = packet.data;
+      passthrough(input, std::move(data));
+    }
+
+    std::unique_lock ul { lock };
+    if (!cv.wait_for(ul, 10s, [&]() { return packets_dispatched >= packets.size(); })) {
+      BOOST_LOG(warning) << "Input replay timed out: "sv << packets_dispatched << '/' << packets.size() << " packets dispatched"sv;
+    }
+    ul.unlock();
+
+    // Make sure the worker has left the hook before it is reset
+    task_pool.push([]() {}).wait();
+
+    report_t report {};
+    report.duration = std::chrono::steady_clock::now() - start;
+    report.packets = packets_dispatched;
+    report.messages = dispatched.size();
+    report.batching_ratio = dispatched.empty() ? 0.0 : (double) packets_dispatched / (double) dispatched.size();
+
+    std::vector<std::chrono::nanoseconds> latencies;
+    latencies.reserve(dispatched.size());
+
+    double total_depth = 0;
+    for (auto &info : dispatched) {
+      latencies.emplace_back(info.dispatched - info.queued);
+      report.max_queue_depth = std::max(report.max_queue_depth, info.queue_depth);
+      total_depth += (double) info.queue_depth;
+    }
+    report.mean_queue_depth = dispatched.empty() ? 0.0 : total_depth / (double) dispatched.size();
+
+    std::sort(std::begin(latencies), std::end(latencies));
+    report.latency_p50 = percentile(latencies, 0.50);
+    report.latency_p90 = percentile(latencies, 0.90);
+    report.latency_p99 = percentile(latencies, 0.99);
+    report.latency_max = latencies.empty() ? 0ns : latencies.back();
+
+    return report;
+  }
+
+  void
+  log(const report_t &report) {
+    auto us = [](std::chrono::nanoseconds ns) {
+      return std::chrono::duration_cast<std::chrono::microseconds>(ns).count();
+    };
+
+    BOOST_LOG(info) << "Input replay: "sv << report.packets << " packets -> "sv << report.messages << " messages (batching ratio "sv
+                    << report.batching_ratio << ") in "sv << us(report.duration) << "us"sv;
+    BOOST_LOG(info) << "Input replay: queue depth max "sv << report.max_queue_depth << ", mean "sv << report.mean_queue_depth;
+    BOOST_LOG(info) << "Input replay: injection latency p50 "sv << us(report.latency_p50) << "us, p90 "sv << us(report.latency_p90)
+                    << "us, p99 "sv << us(report.latency_p99) << "us, max "sv << us(report.latency_max) << "us"sv;
+  }
+}  // namespace input::replay
@@ -0,0 +1,128 @@
+/**
+ * @file src/input_replay.h
+ * @brief Declarations for recording and replaying input streams.
+ */
+#pragma once
+
+// standard includes
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace input::replay {
+  /**
+   * @brief A decrypted input packet, as received on the control stream.
+   */
+  struct packet_t {
+    std::chrono::nanoseconds timestamp;  ///< Time since the start of the recording
+    std::vector<std::uint8_t> data;
+  };
+
+  /**
+   * @brief Writes input packets with their arrival time to a file.
+   *
+   * The file starts with an 8 byte magic, followed by one record per packet:
+   * a little-endian 64-bit timestamp in nanoseconds, a little-endian 16-bit length and the packet itself.
+   * Packets are written by a background thread, so recording doesn't stall the control stream.
+   */
+  class recorder_t {
+  public:
+    /**
+     * @brief Create (or truncate) a recording.
+     * @param path The file to write to.
+     * @return The recorder, or nullptr if the file can't be opened.
+     */
+    static std::unique_ptr<recorder_t>
+    open(const std::string &path);
+
+    /**
+     * @brief Write the packets still pending and close the file.
+     */
+    ~recorder_t();
+
+    /**
+     * @brief Append a packet, timestamped relative to the creation of the recorder.
+     */
+    void
+    record(const std::vector<std::uint8_t> &data);
+
+    /**
+     * @brief Append a packet with an explicit timestamp.
+     */
+    void
+    record(std::chrono::nanoseconds timestamp, const std::vector<std::uint8_t> &data);
+
+  private:
+    recorder_t(std::ofstream &&file);
+
+    void
+    write_pending();
+
+    std::ofstream _file;
+    std::chrono::steady_clock::time_point _start;
+
+    std::mutex _lock;
+    std::condition_variable _cv;
+    std::vector<packet_t> _pending;
+    bool _stop { false };
+    std::thread _writer;
+  };
+
+  /**
+   * @brief The recording of one session, so that concurrent sessions don't write to the same file.
+   * @param path The configured recording, e.g. `/tmp/input.rec`.
+   * @param session The number of the session.
+   * @return The path with the session number appended to the file name, e.g. `/tmp/input-2.rec`.
+   */
+  std::string
+  session_path(const std::string &path, std::uint32_t session);
+
+  /**
+   * @brief Read back a recording.
+   * @param path The file written by recorder_t.
+   * @return The packets in recording order, or std::nullopt if the file is missing or malformed.
+   */
+  std::optional<std::vector<packet_t>>
+  load(const std::string &path);
+
+  /**
+   * @brief Results of a replay.
+   */
+  struct report_t {
+    std::size_t packets;  ///< Packets fed to input::passthrough()
+    std::size_t messages;  ///< Messages left after batching
+    double batching_ratio;  ///< packets / messages
+    std::size_t max_queue_depth;  ///< Deepest input queue observed after batching
+    double mean_queue_depth;
+    std::chrono::nanoseconds latency_p50;  ///< Time from queueing a packet to injecting it
+    std::chrono::nanoseconds latency_p90;
+    std::chrono::nanoseconds latency_p99;
+    std::chrono::nanoseconds latency_max;
+    std::chrono::nanoseconds duration;  ///< Wall time of the whole replay
+  };
+
+  /**
+   * @brief Drive input::passthrough() with a recording against a mock platform.
+   *
+   * Batched messages are diverted through input::set_dispatch_hook(), so nothing reaches the OS.
+   * The global task_pool must be running.
+   * @param packets The recording.
+   * @param speed Playback speed relative to the recording, or 0 to replay as fast as possible.
+   * @return The batching, queue depth and latency statistics.
+   */
+  report_t
+  run(const std::vector<packet_t> &packets, double speed = 1.0);
+
+  /**
+   * @brief Log a report at info level.
+   */
+  void
+  log(const report_t &report);
+}  // namespace input::replay
@@ -9,7 +9,9 @@
 #include <iostream>
 
 // local includes
+#include "color_convert.h"
 #include "confighttp.h"
+#include "cursor_blend.h"
 #include "display_device/session.h"
 #include "entry_handler.h"
 #include "globals.h"
@@ -19,6 +21,7 @@
 #include "nvhttp.h"
 #include "process.h"
 #include "system_tray.h"
+#include "tile_hash.h"
 #include "upnp.h"
 #include "version.h"
 #include "video.h"
@@ -356,6 +359,9 @@ main(int argc, char *argv[]) {
   }
 
   reed_solomon_init();
+  BOOST_LOG(debug) << "Cursor blending kernel: "sv << cursor_blend::init();
+  BOOST_LOG(debug) << "Color conversion kernels: "sv << color_convert::init();
+  BOOST_LOG(debug) << "Tile hashing kernel: "sv << tile_hash::init();
   auto input_deinit_guard = input::init();
 
   if (input::probe_gamepads()) {
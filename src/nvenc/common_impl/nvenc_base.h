@@ -41,7 +41,7 @@ namespace nvenc {
     destroy_encoder() override;
 
     nvenc_encoded_frame
-    encode_frame(uint64_t frame_index, bool force_idr) override;
+    encode_frame(uint64_t frame_index, bool force_idr, std::vector<uint8_t> &&buffer) override;
 
     bool
     invalidate_ref_frames(uint64_t first_frame, uint64_t last_frame) override;
@@ -50,10 +50,12 @@ namespace nvenc {
      *        Afterwards serves as parameter for `invalidate_ref_frames()`.
      *        No restrictions on the first frame index, but later frame indexes must be subsequent.
      * @param force_idr Whether to encode frame as forced IDR.
+     * @param buffer Receives the encoded data, so its capacity can be reused from a previous frame.
+     *        Left untouched if no data is returned.
      * @return Encoded frame.
      */
     virtual nvenc_encoded_frame
-    encode_frame(uint64_t frame_index, bool force_idr) = 0;
+    encode_frame(uint64_t frame_index, bool force_idr, std::vector<uint8_t> &&buffer) = 0;
 
     /**
      * @brief Perform reference frame invalidation (RFI) procedure.
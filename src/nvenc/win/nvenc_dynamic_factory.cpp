@@ -151,7 +151,7 @@ TEST_P(NvencVersionTests, CreateAndEncode) {
     .bit_depth = 8,
   };
   ASSERT_TRUE(nvenc->create_encoder({}, config, colorspace, platf::pix_fmt_e::nv12));
-  ASSERT_FALSE(nvenc->encode_frame(0, false).data.empty());
+  ASSERT_FALSE(nvenc->encode_frame(0, false, {}).data.empty());
 }
 
 INSTANTIATE_TEST_SUITE_P(NvencFactoryTestsPrivate, NvencVersionTests, testing::ValuesIn(factory_priorities),
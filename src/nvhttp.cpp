@@ -857,7 +857,16 @@ namespace nvhttp {
     tree.put("root.uniqueid", http::unique_id);
     tree.put("root.HttpsPort", net::map_port(PORT_HTTPS));
     tree.put("root.ExternalPort", net::map_port(PORT_HTTP));
-    tree.put("root.MaxLumaPixelsHEVC", video::active_hevc_mode > 1 ? "1869449984" : "0");
+
+    int hevc_mode, av1_mode;
+    std::array<bool, 3> yuv444_for_codec;
+    {
+      std::lock_guard lg { video::probe_result_lock };
+      hevc_mode = video::active_hevc_mode;
+      av1_mode = video::active_av1_mode;
+      yuv444_for_codec = video::last_encoder_probe_supported_yuv444_for_codec;
+    }
+    tree.put("root.MaxLumaPixelsHEVC", hevc_mode > 1 ? "1869449984" : "0");
 
     // Only include the MAC address for requests sent from paired clients over HTTPS.
     // For HTTP requests, use a placeholder MAC address that Moonlight knows to ignore.
@@ -885,30 +894,30 @@ namespace nvhttp {
     }
 
     uint32_t codec_mode_flags = SCM_H264;
-    if (video::last_encoder_probe_supported_yuv444_for_codec[0]) {
+    if (yuv444_for_codec[0]) {
       codec_mode_flags |= SCM_H264_HIGH8_444;
     }
-    if (video::active_hevc_mode >= 2) {
+    if (hevc_mode >= 2) {
       codec_mode_flags |= SCM_HEVC;
-      if (video::last_encoder_probe_supported_yuv444_for_codec[1]) {
+      if (yuv444_for_codec[1]) {
         codec_mode_flags |= SCM_HEVC_REXT8_444;
       }
     }
-    if (video::active_hevc_mode >= 3) {
+    if (hevc_mode >= 3) {
       codec_mode_flags |= SCM_HEVC_MAIN10;
-      if (video::last_encoder_probe_supported_yuv444_for_codec[1]) {
+      if (yuv444_for_codec[1]) {
         codec_mode_flags |= SCM_HEVC_REXT10_444;
       }
     }
-    if (video::active_av1_mode >= 2) {
+    if (av1_mode >= 2) {
       codec_mode_flags |= SCM_AV1_MAIN8;
-      if (video::last_encoder_probe_supported_yuv444_for_codec[2]) {
+      if (yuv444_for_codec[2]) {
         codec_mode_flags |= SCM_AV1_HIGH8_444;
       }
     }
-    if (video::active_av1_mode >= 3) {
+    if (av1_mode >= 3) {
       codec_mode_flags |= SCM_AV1_MAIN10;
-      if (video::last_encoder_probe_supported_yuv444_for_codec[2]) {
+      if (yuv444_for_codec[2]) {
         codec_mode_flags |= SCM_AV1_HIGH10_444;
       }
     }
@@ -987,10 +996,16 @@ namespace nvhttp {
 
     apps.put("<xmlattr>.status_code", 200);
 
+    int hevc_mode;
+    {
+      std::lock_guard lg { video::probe_result_lock };
+      hevc_mode = video::active_hevc_mode;
+    }
+
     for (auto &proc : proc::proc.get_apps()) {
       pt::ptree app;
 
-      app.put("IsHdrSupported"s, video::active_hevc_mode == 3 ? 1 : 0);
+      app.put("IsHdrSupported"s, hevc_mode == 3 ? 1 : 0);
       app.put("AppTitle"s, proc.name);
       app.put("ID"s, proc.id);
 
@@ -1199,6 +1214,17 @@ namespace nvhttp {
           param.value.int_value = vbv;
           break;
         }
+        case video::dynamic_param_type_e::RESOLUTION_SCALE: {
+          int scale = std::stoi(param_value);
+          if (scale < 25 || scale > 100) {
+            tree.put("root.success", 0);
+            tree.put("root.<xmlattr>.status_code", 400);
+            tree.put("root.<xmlattr>.status_message", "Invalid resolution scale. Must be between 25 and 100");
+            return;
+          }
+          param.value.int_value = scale;
+          break;
+        }
         default:
           tree.put("root.success", 0);
           tree.put("root.<xmlattr>.status_code", 400);
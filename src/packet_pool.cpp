@@ -0,0 +1,243 @@
+/**
+ * @file src/packet_pool.cpp
+ * @brief Definitions for the pool of encoded packets.
+ */
+// standard includes
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+extern "C" {
+#include <libavutil/buffer.h>
+}
+
+// local includes
+#include "packet_pool.h"
+
+namespace video {
+  namespace {
+    // The payload buffers are resized based on the largest frame of this many
+    constexpr std::uint64_t size_window = 256;
+
+    // Free AVPackets and vectors kept beyond this are freed,
+    // there are never more in flight than the video thread queues up
+    constexpr std::size_t max_free = 16;
+
+    void
+    free_buffer_pool(AVBufferPool *pool) {
+      av_buffer_pool_uninit(&pool);
+    }
+
+    using buffer_pool_t = util::safe_ptr<AVBufferPool, free_buffer_pool>;
+  }  // namespace
+
+  struct packet_pool_t::state_t {
+    ~state_t() {
+      for (auto av_packet : free_packets) {
+        av_packet_free(&av_packet);
+      }
+    }
+
+    /**
+     * @brief Get a payload buffer of at least size bytes, followed by the padding libavcodec requires.
+     */
+    AVBufferRef *
+    get_buffer(std::size_t size) {
+      ++packets;
+
+      std::lock_guard lg { lock };
+
+      window_max = std::max(window_max, size);
+      if (++window_packets == size_window) {
+        // Shrink once the frames no longer need most of the buffers
+        if (buffer_size > window_max * 3) {
+          buffer_pool.reset();
+        }
+
+        largest = window_max;
+        window_max = 0;
+        window_packets = 0;
+      }
+
+      // Buffers of the previous pool are freed as they are released
+      if (!buffer_pool || buffer_size < size) {
+        buffer_size = std::max({ size, window_max, largest }) * 3 / 2;
+        buffer_pool.reset(av_buffer_pool_init2(buffer_size + AV_INPUT_BUFFER_PADDING_SIZE, this, &state_t::alloc, nullptr));
+        if (!buffer_pool) {
+          return nullptr;
+        }
+      }
+
+      auto buf = av_buffer_pool_get(buffer_pool.get());
+      if (buf) {
+        std::memset(buf->data + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+      }
+
+      return buf;
+    }
+
+    AVPacket *
+    get_packet() {
+      {
+        std::lock_guard lg { lock };
+        if (!free_packets.empty()) {
+          auto av_packet = free_packets.back();
+          free_packets.pop_back();
+
+          return av_packet;
+        }
+      }
+
+      return av_packet_alloc();
+    }
+
+    void
+    release(AVPacket *av_packet) {
+      // The payload goes back to its buffer pool
+      av_packet_unref(av_packet);
+
+      {
+        std::lock_guard lg { lock };
+        if (free_packets.size() < max_free) {
+          free_packets.push_back(av_packet);
+          return;
+        }
+      }
+
+      av_packet_free(&av_packet);
+    }
+
+    std::vector<uint8_t>
+    get_vector() {
+      ++packets;
+
+      std::lock_guard lg { lock };
+      if (free_vectors.empty()) {
+        ++allocations;
+        return {};
+      }
+
+      auto frame_data = std::move(free_vectors.back());
+      free_vectors.pop_back();
+
+      return frame_data;
+    }
+
+    void
+    release(std::vector<uint8_t> &&frame_data) {
+      std::lock_guard lg { lock };
+      if (free_vectors.size() < max_free) {
+        frame_data.clear();
+        free_vectors.emplace_back(std::move(frame_data));
+      }
+    }
+
+    static AVBufferRef *
+    alloc(void *opaque, std::size_t size) {
+      auto state = (state_t *) opaque;
+      ++state->allocations;
+
+      return av_buffer_alloc(size);
+    }
+
+    static int
+    get_encode_buffer(AVCodecContext *ctx, AVPacket *av_packet, int flags) {
+      auto state = (state_t *) ctx->opaque;
+
+      // libavcodec sets the size of the payload before asking for a buffer
+      av_packet->buf = state->get_buffer(av_packet->size);
+      if (!av_packet->buf) {
+        return AVERROR(ENOMEM);
+      }
+
+      av_packet->data = av_packet->buf->data;
+
+      return 0;
+    }
+
+    mutable std::mutex lock;
+
+    buffer_pool_t buffer_pool;
+    std::size_t buffer_size {};
+
+    // The largest payload of the previous window, and of the current one so far
+    std::size_t largest {};
+    std::size_t window_max {};
+    std::uint64_t window_packets {};
+
+    std::vector<AVPacket *> free_packets;
+    std::vector<std::vector<uint8_t>> free_vectors;
+
+    std::atomic<std::uint64_t> packets {};
+    std::atomic<std::uint64_t> allocations {};
+  };
+
+  struct packet_pool_t::packet_raw_pooled_avcodec: packet_raw_avcodec {
+    packet_raw_pooled_avcodec(std::shared_ptr<state_t> state, AVPacket *av_packet):
+        packet_raw_avcodec { av_packet }, state { std::move(state) } {}
+
+    ~packet_raw_pooled_avcodec() {
+      // Taken back before the base class frees it
+      state->release(av_packet);
+      av_packet = nullptr;
+    }
+
+    std::shared_ptr<state_t> state;
+  };
+
+  struct packet_pool_t::packet_raw_pooled_generic: packet_raw_generic {
+    packet_raw_pooled_generic(std::shared_ptr<state_t> state, std::vector<uint8_t> &&frame_data, int64_t frame_index, bool idr):
+        packet_raw_generic { std::move(frame_data), frame_index, idr }, state { std::move(state) } {}
+
+    ~packet_raw_pooled_generic() {
+      state->release(std::move(frame_data));
+    }
+
+    std::shared_ptr<state_t> state;
+  };
+
+  packet_pool_t::packet_pool_t():
+      _state { std::make_shared<state_t>() } {}
+
+  void
+  packet_pool_t::attach(AVCodecContext *ctx) {
+    if (!ctx->codec || !(ctx->codec->capabilities & AV_CODEC_CAP_DR1)) {
+      return;
+    }
+
+    ctx->opaque = _state.get();
+    ctx->get_encode_buffer = &state_t::get_encode_buffer;
+  }
+
+  std::unique_ptr<packet_raw_avcodec>
+  packet_pool_t::make_avcodec() {
+    auto av_packet = _state->get_packet();
+    if (!av_packet) {
+      return nullptr;
+    }
+
+    return std::make_unique<packet_raw_pooled_avcodec>(_state, av_packet);
+  }
+
+  std::vector<uint8_t>
+  packet_pool_t::acquire_buffer() {
+    return _state->get_vector();
+  }
+
+  std::unique_ptr<packet_raw_generic>
+  packet_pool_t::make_generic(std::vector<uint8_t> &&frame_data, int64_t frame_index, bool idr) {
+    return std::make_unique<packet_raw_pooled_generic>(_state, std::move(frame_data), frame_index, idr);
+  }
+
+  void
+  packet_pool_t::release_buffer(std::vector<uint8_t> &&frame_data) {
+    _state->release(std::move(frame_data));
+  }
+
+  packet_pool_t::stats_t
+  packet_pool_t::stats() const {
+    std::lock_guard lg { _state->lock };
+    return { _state->packets, _state->allocations, _state->buffer_size };
+  }
+}  // namespace video
@@ -0,0 +1,79 @@
+/**
+ * @file src/packet_pool.h
+ * @brief Declarations for the pool of encoded packets.
+ */
+#pragma once
+
+// standard includes
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// local includes
+#include "video.h"
+
+namespace video {
+  /**
+   * @brief Recycles the packets of an encoder and their payload buffers.
+   *
+   * Packets are released by the thread sending them, long after the encoder produced them.
+   * Instead of being freed there, their AVPacket, payload buffer or vector goes back to the pool,
+   * where the encoder picks it up again for one of the next frames.
+   * Payload buffers are sized to fit the largest frame of the last few hundred, so they are
+   * only reallocated when the frames grow past that or shrink far below it.
+   */
+  class packet_pool_t {
+  public:
+    struct stats_t {
+      std::uint64_t packets;  ///< Packets handed out
+      std::uint64_t allocations;  ///< Payload buffers allocated, the other packets reused one
+      std::size_t buffer_size;  ///< Size of the payload buffers handed out now
+    };
+
+    packet_pool_t();
+
+    /**
+     * @brief Make the encoder write its packets into buffers of the pool.
+     *
+     * The pool must outlive the context, the packets may outlive both.
+     * Encoders without AV_CODEC_CAP_DR1 keep allocating their own buffers.
+     */
+    void
+    attach(AVCodecContext *ctx);
+
+    /**
+     * @brief Get a packet for avcodec_receive_packet().
+     */
+    std::unique_ptr<packet_raw_avcodec>
+    make_avcodec();
+
+    /**
+     * @brief Get a vector for the data of an encoded frame, with its capacity left from a previous frame.
+     */
+    std::vector<uint8_t>
+    acquire_buffer();
+
+    /**
+     * @brief Wrap encoded data from acquire_buffer() in a packet, which returns it to the pool once released.
+     */
+    std::unique_ptr<packet_raw_generic>
+    make_generic(std::vector<uint8_t> &&frame_data, int64_t frame_index, bool idr);
+
+    /**
+     * @brief Return a vector from acquire_buffer() that didn't end up in a packet, e.g. when encoding failed.
+     */
+    void
+    release_buffer(std::vector<uint8_t> &&frame_data);
+
+    stats_t
+    stats() const;
+
+  private:
+    struct state_t;
+    struct packet_raw_pooled_avcodec;
+    struct packet_raw_pooled_generic;
+
+    std::shared_ptr<state_t> _state;
+  };
+}  // namespace video
@@ -10,6 +10,7 @@
 #include <functional>
 #include <mutex>
 #include <string>
+#include <vector>
 
 // lib includes
 #include <boost/core/noncopyable.hpp>
@@ -368,6 +369,16 @@ namespace platf {
     virtual ~deinit_t() = default;
   };
 
+  /**
+   * @brief A rectangle in image coordinates.
+   */
+  struct rect_t {
+    std::int32_t x;
+    std::int32_t y;
+    std::int32_t width;
+    std::int32_t height;
+  };
+
   struct img_t: std::enable_shared_from_this<img_t> {
   public:
     img_t() = default;
@@ -387,6 +398,9 @@ namespace platf {
 
     std::optional<std::chrono::steady_clock::time_point> frame_timestamp;
 
+    // Areas that changed since the previous frame, empty if unknown (i.e. the whole frame may have changed)
+    std::vector<rect_t> damage;
+
     virtual ~img_t() = default;
   };
 
@@ -663,6 +677,13 @@ namespace platf {
   bool
   needs_encoder_reenumeration();
 
+  /**
+   * @brief Identify the GPUs and their drivers, so cached encoder probe results can be matched against them.
+   * @return A description that changes along with the GPUs or their drivers, or an empty string if unknown.
+   */
+  std::string
+  encoder_adapter_identity();
+
   boost::process::v1::child
   run_command(bool elevated, bool interactive, const std::string &cmd, boost::filesystem::path &working_dir, const boost::process::v1::environment &env, FILE *file, std::error_code &ec, boost::process::v1::group *group);
 
@@ -675,6 +696,40 @@ namespace platf {
   void
   adjust_thread_priority(thread_priority_e priority);
 
+  /**
+   * @brief Scheduling state of the calling thread as seen by the OS.
+   */
+  struct thread_info_t {
+    std::int64_t id;  ///< OS thread id
+    std::vector<int> cpus;  ///< CPUs the thread may run on, empty if unknown
+    std::string scheduling;  ///< Human readable scheduling policy and priority
+  };
+
+  /**
+   * @brief Set the name of the calling thread, as shown by debuggers and `top -H`.
+   * @param name The thread name, may be truncated by the OS.
+   */
+  void
+  set_thread_name(std::string_view name);
+
+  /**
+   * @brief Restrict the calling thread to a set of logical CPUs.
+   * @param cpus The logical CPU indices.
+   * @return 0 on success.
+   */
+  int
+  set_thread_affinity(const std::vector<int> &cpus);
+
+  /**
+   * @brief Get the logical CPUs belonging to a NUMA node.
+   * @return The CPUs of the node, or an empty list if the node doesn't exist.
+   */
+  std::vector<int>
+  numa_node_cpus(int node);
+
+  thread_info_t
+  current_thread_info();
+
   // Allow OS-specific actions to be taken to prepare for streaming
   void
   streaming_will_start();
@@ -0,0 +1,123 @@
+/**
+ * @file src/platform/linux/capture_scheduler.cpp
+ * @brief Definitions for pacing the capture loops of the Linux display backends.
+ */
+#include "capture_scheduler.h"
+
+#include <cerrno>
+#include <ctime>
+
+using namespace std::literals;
+
+namespace platf {
+  namespace {
+    /**
+     * @brief Sleep until an absolute time, immune to the drift of relative sleeps.
+     *
+     * std::chrono::steady_clock is CLOCK_MONOTONIC on Linux.
+     */
+    void
+    sleep_until(capture_scheduler_t::clock::time_point deadline) {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+
+      timespec ts;
+      ts.tv_sec = ns / 1000000000;
+      ts.tv_nsec = ns % 1000000000;
+
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+    }
+  }  // namespace
+
+  capture_scheduler_t::capture_scheduler_t(std::chrono::nanoseconds period):
+      _period { period } {
+    reset();
+  }
+
+  void
+  capture_scheduler_t::reset() {
+    _anchor = clock::now();
+    _frame = 0;
+
+    _stats = {};
+    _jitter_total = 0ns;
+
+    _jitter_logger.reset();
+    _last_missed_log = _anchor;
+    _missed_since_log = 0;
+  }
+
+  std::uint64_t
+  capture_scheduler_t::wait() {
+    auto now = clock::now();
+    auto target = deadline(_frame);
+
+    // Capturing the missed frames back to back would only add latency, resume with the latest deadline
+    std::uint64_t skipped = 0;
+    if (now - target >= _period) {
+      skipped = (now - target) / _period;
+      _frame += skipped;
+      target = deadline(_frame);
+    }
+
+    if (target > now) {
+      sleep_until(target);
+    }
+
+    auto woke = clock::now();
+    auto jitter = std::max(woke - target, clock::duration::zero());
+    ++_frame;
+
+    _stats.frames += 1;
+    _stats.missed += skipped;
+    _stats.jitter_max = std::max<std::chrono::nanoseconds>(_stats.jitter_max, jitter);
+    _jitter_total += jitter;
+    _stats.jitter_mean = _jitter_total / _stats.frames;
+
+    _jitter_logger.first_point(target);
+    _jitter_logger.second_point_and_log(woke);
+
+    _missed_since_log += skipped;
+    if (_missed_since_log && woke - _last_missed_log > 20s) {
+      BOOST_LOG(debug) << "Frame capture missed "sv << _missed_since_log << " deadlines in the last "sv
+                       << std::chrono::duration_cast<std::chrono::seconds>(woke - _last_missed_log).count() << 's';
+
+      _missed_since_log = 0;
+      _last_missed_log = woke;
+    }
+
+    return skipped;
+  }
+
+  void
+  capture_scheduler_t::align(clock::time_point vblank) {
+    // How far the next deadline lies past the vblank phase, in [0, period)
+    auto offset = (next_deadline() - vblank) % _period;
+    if (offset < 0ns) {
+      offset += _period;
+    }
+
+    // Move whichever way is shorter
+    auto shift = offset <= _period / 2 ? -offset : _period - offset;
+    if (std::chrono::abs(shift) < align_tolerance) {
+      return;
+    }
+
+    _anchor += shift;
+    _stats.realigned += 1;
+  }
+
+  capture_scheduler_t::clock::time_point
+  capture_scheduler_t::next_deadline() const {
+    return deadline(_frame);
+  }
+
+  capture_scheduler_t::stats_t
+  capture_scheduler_t::stats() const {
+    return _stats;
+  }
+
+  capture_scheduler_t::clock::time_point
+  capture_scheduler_t::deadline(std::uint64_t frame) const {
+    return _anchor + _period * (std::int64_t) frame;
+  }
+}  // namespace platf
@@ -0,0 +1,93 @@
+/**
+ * @file src/platform/linux/capture_scheduler.h
+ * @brief Declarations for pacing the capture loops of the Linux display backends.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "src/logging.h"
+
+namespace platf {
+  /**
+   * @brief Decides when a display backend captures the next frame.
+   *
+   * Deadlines are derived from a fixed anchor, `anchor + n * period`, so rounding errors
+   * don't accumulate, and the capture thread sleeps until the absolute deadline.
+   * When a capture overruns by a whole period or more, the missed deadlines are skipped
+   * rather than captured back to back.
+   * Backends that know when the display refreshes can align the deadlines to its vblank.
+   */
+  class capture_scheduler_t {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    struct stats_t {
+      std::uint64_t frames;  ///< Deadlines that were captured
+      std::uint64_t missed;  ///< Deadlines skipped because a capture overran
+      std::uint64_t realigned;  ///< Times the deadlines were moved to match the vblank
+      std::chrono::nanoseconds jitter_max;  ///< Longest wake-up past a deadline
+      std::chrono::nanoseconds jitter_mean;
+    };
+
+    /**
+     * @param period The time between two frames.
+     */
+    explicit capture_scheduler_t(std::chrono::nanoseconds period);
+
+    /**
+     * @brief Restart the schedule, the first deadline is now.
+     */
+    void
+    reset();
+
+    /**
+     * @brief Sleep until the next deadline.
+     * @return The number of deadlines skipped because the previous capture overran.
+     */
+    std::uint64_t
+    wait();
+
+    /**
+     * @brief Shift the deadlines to the phase of a vblank of the captured display.
+     *
+     * The shift is at most half a period, and small phase errors are ignored,
+     * so the backend can report vblanks as often as it likes.
+     * @param vblank The time of a recent vblank, or presentation of a frame, on the steady clock.
+     */
+    void
+    align(clock::time_point vblank);
+
+    /**
+     * @brief The deadline the next call to wait() sleeps until, unless it skips.
+     */
+    clock::time_point
+    next_deadline() const;
+
+    /**
+     * @brief Counters since the last reset().
+     */
+    stats_t
+    stats() const;
+
+    // Phase errors below this are not worth moving the deadlines for
+    static constexpr std::chrono::nanoseconds align_tolerance = std::chrono::microseconds { 250 };
+
+  private:
+    clock::time_point
+    deadline(std::uint64_t frame) const;
+
+    std::chrono::nanoseconds _period;
+    clock::time_point _anchor;
+    std::uint64_t _frame {};
+
+    stats_t _stats {};
+    std::chrono::nanoseconds _jitter_total {};
+
+    // Reported at debug level
+    logging::time_delta_periodic_logger _jitter_logger { debug, "Frame capture sleep overshoot" };
+    clock::time_point _last_missed_log;
+    std::uint64_t _missed_since_log {};
+  };
+}  // namespace platf
@@ -16,6 +16,7 @@ extern "C" {
 #include <libavutil/imgutils.h>
 }
 
+#include "capture_scheduler.h"
 #include "cuda.h"
 #include "graphics.h"
 #include "src/logging.h"
@@ -790,8 +791,6 @@ namespace cuda {
 
       platf::capture_e
       capture(const push_captured_image_cb_t &push_captured_image_cb, const pull_free_image_cb_t &pull_free_image_cb, bool *cursor) override {
-        auto next_frame = std::chrono::steady_clock::now();
-
         {
           // We must create at least one texture on this thread before calling NvFBCToCudaSetUp()
           // Otherwise it fails with "Unable to register an OpenGL buffer to a CUDA resource (result: 201)" message
@@ -807,20 +806,10 @@ namespace cuda {
           handle.reset();
         });
 
-        sleep_overshoot_logger.reset();
+        platf::capture_scheduler_t scheduler { delay };
 
         while (true) {
-          auto now = std::chrono::steady_clock::now();
-          if (next_frame > now) {
-            std::this_thread::sleep_for(next_frame - now);
-            sleep_overshoot_logger.first_point(next_frame);
-            sleep_overshoot_logger.second_point_now_and_log();
-          }
-
-          next_frame += delay;
-          if (next_frame < now) {  // some major slowdown happened; we couldn't keep up
-            next_frame = now + delay;
-          }
+          scheduler.wait();
 
           std::shared_ptr<platf::img_t> img_out;
           auto status = snapshot(pull_free_image_cb, img_out, 150ms, *cursor);
@@ -0,0 +1,100 @@
+/**
+ * @file src/platform/linux/input/evdev_batch.h
+ * @brief Declarations for batching evdev events into a single uinput write.
+ */
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+
+#include <linux/input.h>
+#include <unistd.h>
+
+namespace platf::evdev {
+  /**
+   * @brief Collects the events of one report and writes them to a uinput fd with a single write().
+   *
+   * libevdev_uinput_write_event() costs one syscall per event.
+   * The kernel accepts any number of consecutive input_event structs in one write(),
+   * so the events are buffered until the report is terminated by SYN_REPORT.
+   * Like libevdev, the timestamps are left zero so the kernel fills them in.
+   */
+  class batch_t {
+  public:
+    static constexpr std::size_t max_events = 64;
+
+    explicit batch_t(int fd):
+        _fd { fd } {}
+
+    batch_t(const batch_t &) = delete;
+    batch_t &
+    operator=(const batch_t &) = delete;
+
+    ~batch_t() {
+      flush();
+    }
+
+    /**
+     * @brief Append an event, flushing after SYN_REPORT or when the buffer is full.
+     * @return 0 on success, -errno if a flush failed.
+     */
+    int
+    write(unsigned int type, unsigned int code, int value) {
+      auto &ev = _events[_count++];
+      ev = {};
+      ev.type = type;
+      ev.code = code;
+      ev.value = value;
+
+      if ((type == EV_SYN && code == SYN_REPORT) || _count == _events.size()) {
+        return flush();
+      }
+
+      return 0;
+    }
+
+    /**
+     * @brief Write all pending events.
+     * @return 0 on success, -errno on failure.
+     */
+    int
+    flush() {
+      auto data = (const char *) _events.data();
+      auto bytes = _count * sizeof(input_event);
+      _count = 0;
+
+      while (bytes) {
+        auto written = ::write(_fd, data, bytes);
+        ++_writes;
+
+        if (written < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+
+          return -errno;
+        }
+
+        data += written;
+        bytes -= written;
+      }
+
+      return 0;
+    }
+
+    /**
+     * @brief Number of write() syscalls issued so far.
+     */
+    std::size_t
+    writes() const {
+      return _writes;
+    }
+
+  private:
+    int _fd;
+    std::size_t _count {};
+    std::size_t _writes {};
+    std::array<input_event, max_events> _events;
+  };
+}  // namespace platf::evdev
@@ -35,6 +35,8 @@ extern "C" {
 
 #include "src/platform/linux/misc.h"
 
+#include "evdev_batch.h"
+
 // Support older versions
 #ifndef REL_HWHEEL_HI_RES
   #define REL_HWHEEL_HI_RES 0x0c
@@ -1142,9 +1144,10 @@ namespace platf {
     auto scaled_x = (int) std::lround((x + touch_port.offset_x) * ((float) target_touch_port.width / (float) touch_port.width));
     auto scaled_y = (int) std::lround((y + touch_port.offset_y) * ((float) target_touch_port.height / (float) touch_port.height));
 
-    libevdev_uinput_write_event(mouse_abs, EV_ABS, ABS_X, scaled_x);
-    libevdev_uinput_write_event(mouse_abs, EV_ABS, ABS_Y, scaled_y);
-    libevdev_uinput_write_event(mouse_abs, EV_SYN, SYN_REPORT, 0);
+    evdev::batch_t batch { libevdev_uinput_get_fd(mouse_abs) };
+    batch.write(EV_ABS, ABS_X, scaled_x);
+    batch.write(EV_ABS, ABS_Y, scaled_y);
+    batch.write(EV_SYN, SYN_REPORT, 0);
 
     // Remember this was the last device we sent input on
     raw->last_mouse_device_used = mouse_abs;
@@ -1190,15 +1193,17 @@ namespace platf {
       return;
     }
 
+    evdev::batch_t batch { libevdev_uinput_get_fd(mouse_rel) };
+
     if (deltaX) {
-      libevdev_uinput_write_event(mouse_rel, EV_REL, REL_X, deltaX);
+      batch.write(EV_REL, REL_X, deltaX);
     }
 
     if (deltaY) {
-      libevdev_uinput_write_event(mouse_rel, EV_REL, REL_Y, deltaY);
+      batch.write(EV_REL, REL_Y, deltaY);
     }
 
-    libevdev_uinput_write_event(mouse_rel, EV_SYN, SYN_REPORT, 0);
+    batch.write(EV_SYN, SYN_REPORT, 0);
 
     // Remember this was the last device we sent input on
     raw->last_mouse_device_used = mouse_rel;
@@ -1318,9 +1323,10 @@ namespace platf {
       scan = 90005;
     }
 
-    libevdev_uinput_write_event(chosen_mouse_dev, EV_MSC, MSC_SCAN, scan);
-    libevdev_uinput_write_event(chosen_mouse_dev, EV_KEY, btn_type, release ? 0 : 1);
-    libevdev_uinput_write_event(chosen_mouse_dev, EV_SYN, SYN_REPORT, 0);
+    evdev::batch_t batch { libevdev_uinput_get_fd(chosen_mouse_dev) };
+    batch.write(EV_MSC, MSC_SCAN, scan);
+    batch.write(EV_KEY, btn_type, release ? 0 : 1);
+    batch.write(EV_SYN, SYN_REPORT, 0);
 
     if (release) {
       *chosen_mouse_dev_buttons_down &= ~(1 << button);
@@ -1376,11 +1382,12 @@ namespace platf {
     // via the relative pointing device for Xorg compatibility.
     auto mouse = raw->mouse_rel_input.get();
     if (mouse) {
+      evdev::batch_t batch { libevdev_uinput_get_fd(mouse) };
       if (full_ticks) {
-        libevdev_uinput_write_event(mouse, EV_REL, REL_WHEEL, full_ticks);
+        batch.write(EV_REL, REL_WHEEL, full_ticks);
       }
-      libevdev_uinput_write_event(mouse, EV_REL, REL_WHEEL_HI_RES, high_res_distance);
-      libevdev_uinput_write_event(mouse, EV_SYN, SYN_REPORT, 0);
+      batch.write(EV_REL, REL_WHEEL_HI_RES, high_res_distance);
+      batch.write(EV_SYN, SYN_REPORT, 0);
     }
     else if (full_ticks) {
       x_scroll(input, full_ticks, 4, 5);
@@ -1408,11 +1415,12 @@ namespace platf {
     // via the relative pointing device for Xorg compatibility.
     auto mouse_rel = raw->mouse_rel_input.get();
     if (mouse_rel) {
+      evdev::batch_t batch { libevdev_uinput_get_fd(mouse_rel) };
       if (full_ticks) {
-        libevdev_uinput_write_event(mouse_rel, EV_REL, REL_HWHEEL, full_ticks);
+        batch.write(EV_REL, REL_HWHEEL, full_ticks);
       }
-      libevdev_uinput_write_event(mouse_rel, EV_REL, REL_HWHEEL_HI_RES, high_res_distance);
-      libevdev_uinput_write_event(mouse_rel, EV_SYN, SYN_REPORT, 0);
+      batch.write(EV_REL, REL_HWHEEL_HI_RES, high_res_distance);
+      batch.write(EV_SYN, SYN_REPORT, 0);
     }
     else if (full_ticks) {
       x_scroll(input, full_ticks, 6, 7);
@@ -1486,18 +1494,21 @@ namespace platf {
       return;
     }
 
+    evdev::batch_t batch { libevdev_uinput_get_fd(keyboard) };
+
     if (keycode.scancode != UNKNOWN) {
-      libevdev_uinput_write_event(keyboard, EV_MSC, MSC_SCAN, keycode.scancode);
+      batch.write(EV_MSC, MSC_SCAN, keycode.scancode);
     }
 
-    libevdev_uinput_write_event(keyboard, EV_KEY, keycode.keycode, release ? 0 : 1);
-    libevdev_uinput_write_event(keyboard, EV_SYN, SYN_REPORT, 0);
+    batch.write(EV_KEY, keycode.keycode, release ? 0 : 1);
+    batch.write(EV_SYN, SYN_REPORT, 0);
   }
 
   void
   keyboard_ev(libevdev_uinput *keyboard, int linux_code, int event_code = 1) {
-    libevdev_uinput_write_event(keyboard, EV_KEY, linux_code, event_code);
-    libevdev_uinput_write_event(keyboard, EV_SYN, SYN_REPORT, 0);
+    evdev::batch_t batch { libevdev_uinput_get_fd(keyboard) };
+    batch.write(EV_KEY, linux_code, event_code);
+    batch.write(EV_SYN, SYN_REPORT, 0);
   }
 
   /**
@@ -1584,6 +1595,8 @@ namespace platf {
   gamepad_update(input_t &input, int nr, const gamepad_state_t &gamepad_state) {
     TUPLE_2D_REF(uinput, gamepad_state_old, ((input_raw_t *) input.get())->gamepads[nr]);
 
+    evdev::batch_t batch { libevdev_uinput_get_fd(uinput.get()) };
+
     auto bf = gamepad_state.buttonFlags ^ gamepad_state_old.buttonFlags;
     auto bf_new = gamepad_state.buttonFlags;
 
@@ -1592,54 +1605,54 @@ namespace platf {
       if ((DPAD_UP | DPAD_DOWN) & bf) {
         int button_state = bf_new & DPAD_UP ? -1 : (bf_new & DPAD_DOWN ? 1 : 0);
 
-        libevdev_uinput_write_event(uinput.get(), EV_ABS, ABS_HAT0Y, button_state);
+        batch.write(EV_ABS, ABS_HAT0Y, button_state);
       }
 
       if ((DPAD_LEFT | DPAD_RIGHT) & bf) {
         int button_state = bf_new & DPAD_LEFT ? -1 : (bf_new & DPAD_RIGHT ? 1 : 0);
 
-        libevdev_uinput_write_event(uinput.get(), EV_ABS, ABS_HAT0X, button_state);
+        batch.write(EV_ABS, ABS_HAT0X, button_state);
       }
 
-      if (START & bf) libevdev_uinput_write_event(uinput.get(), EV_KEY, BTN_START, bf_new & START ? 1 : 0);
-      if (BACK & bf) libevdev_uinput_write_event(uinput.get(), EV_KEY, BTN_SELECT, bf_new & BACK ? 1 : 0);
-      if (LEFT_STICK & bf) libevdev_uinput_write_event(uinput.get(), EV_KEY, BTN_THUMBL, bf_new & LEFT_STICK ? 1 : 0);
-      if (RIGHT_STICK & bf) libevdev_uinput_write_event(uinput.get(), EV_KEY, BTN_THUMBR, bf_new & RIGHT_STICK ? 1 : 0);
-      if (LEFT_BUTTON & bf) libevdev_uinput_write_event(uinput.get(), EV_KEY, BTN_TL, bf_new & LEFT_BUTTON ? 1 : 0);
-      if (RIGHT_BUTTON & bf) libevdev_uinput_write_event(uinput.get(), EV_KEY, BTN_TR, bf_new & RIGHT_BUTTON ? 1 : 0);
-      if ((HOME | MISC_BUTTON) & bf) libevdev_uinput_write_event(uinput.get(), EV_KEY, BTN_MODE, bf_new & (HOME | MISC_BUTTON) ? 1 : 0);
-      if (A & bf) libevdev_uinput_write_event(uinput.get(), EV_KEY, BTN_SOUTH, bf_new & A ? 1 : 0);
-      if (B & bf) libevdev_uinput_write_event(uinput.get(), EV_KEY, BTN_EAST, bf_new & B ? 1 : 0);
-      if (X & bf) libevdev_uinput_write_event(uinput.get(), EV_KEY, BTN_NORTH, bf_new & X ? 1 : 0);
-      if (Y & bf) libevdev_uinput_write_event(uinput.get(), EV_KEY, BTN_WEST, bf_new & Y ? 1 : 0);
+      if (START & bf) batch.write(EV_KEY, BTN_START, bf_new & START ? 1 : 0);
+      if (BACK & bf) batch.write(EV_KEY, BTN_SELECT, bf_new & BACK ? 1 : 0);
+      if (LEFT_STICK & bf) batch.write(EV_KEY, BTN_THUMBL, bf_new & LEFT_STICK ? 1 : 0);
+      if (RIGHT_STICK & bf) batch.write(EV_KEY, BTN_THUMBR, bf_new & RIGHT_STICK ? 1 : 0);
+      if (LEFT_BUTTON & bf) batch.write(EV_KEY, BTN_TL, bf_new & LEFT_BUTTON ? 1 : 0);
+      if (RIGHT_BUTTON & bf) batch.write(EV_KEY, BTN_TR, bf_new & RIGHT_BUTTON ? 1 : 0);
+      if ((HOME | MISC_BUTTON) & bf) batch.write(EV_KEY, BTN_MODE, bf_new & (HOME | MISC_BUTTON) ? 1 : 0);
+      if (A & bf) batch.write(EV_KEY, BTN_SOUTH, bf_new & A ? 1 : 0);
+      if (B & bf) batch.write(EV_KEY, BTN_EAST, bf_new & B ? 1 : 0);
+      if (X & bf) batch.write(EV_KEY, BTN_NORTH, bf_new & X ? 1 : 0);
+      if (Y & bf) batch.write(EV_KEY, BTN_WEST, bf_new & Y ? 1 : 0);
     }
 
     if (gamepad_state_old.lt != gamepad_state.lt) {
-      libevdev_uinput_write_event(uinput.get(), EV_ABS, ABS_Z, gamepad_state.lt);
+      batch.write(EV_ABS, ABS_Z, gamepad_state.lt);
     }
 
     if (gamepad_state_old.rt != gamepad_state.rt) {
-      libevdev_uinput_write_event(uinput.get(), EV_ABS, ABS_RZ, gamepad_state.rt);
+      batch.write(EV_ABS, ABS_RZ, gamepad_state.rt);
     }
 
     if (gamepad_state_old.lsX != gamepad_state.lsX) {
-      libevdev_uinput_write_event(uinput.get(), EV_ABS, ABS_X, gamepad_state.lsX);
+      batch.write(EV_ABS, ABS_X, gamepad_state.lsX);
     }
 
     if (gamepad_state_old.lsY != gamepad_state.lsY) {
-      libevdev_uinput_write_event(uinput.get(), EV_ABS, ABS_Y, -gamepad_state.lsY);
+      batch.write(EV_ABS, ABS_Y, -gamepad_state.lsY);
     }
 
     if (gamepad_state_old.rsX != gamepad_state.rsX) {
-      libevdev_uinput_write_event(uinput.get(), EV_ABS, ABS_RX, gamepad_state.rsX);
+      batch.write(EV_ABS, ABS_RX, gamepad_state.rsX);
     }
 
     if (gamepad_state_old.rsY != gamepad_state.rsY) {
-      libevdev_uinput_write_event(uinput.get(), EV_ABS, ABS_RY, -gamepad_state.rsY);
+      batch.write(EV_ABS, ABS_RY, -gamepad_state.rsY);
     }
 
     gamepad_state_old = gamepad_state;
-    libevdev_uinput_write_event(uinput.get(), EV_SYN, SYN_REPORT, 0);
+    batch.write(EV_SYN, SYN_REPORT, 0);
   }
 
   constexpr auto NUM_TOUCH_SLOTS = 10;
@@ -1740,19 +1753,20 @@ namespace platf {
     }
 
     auto touch_input = raw->touch_input.get();
+    evdev::batch_t batch { libevdev_uinput_get_fd(touch_input) };
 
     float pressure = std::max(PRESSURE_MIN, touch.pressureOrDistance);
 
     if (touch.eventType == LI_TOUCH_EVENT_CANCEL_ALL) {
       for (int i = 0; i < raw->touch_slots.size(); i++) {
-        libevdev_uinput_write_event(touch_input, EV_ABS, ABS_MT_SLOT, i);
-        libevdev_uinput_write_event(touch_input, EV_ABS, ABS_MT_TRACKING_ID, -1);
+        batch.write(EV_ABS, ABS_MT_SLOT, i);
+        batch.write(EV_ABS, ABS_MT_TRACKING_ID, -1);
       }
       raw->touch_slots.fill(INVALID_TRACKING_ID);
 
-      libevdev_uinput_write_event(touch_input, EV_KEY, BTN_TOUCH, 0);
-      libevdev_uinput_write_event(touch_input, EV_ABS, ABS_PRESSURE, 0);
-      libevdev_uinput_write_event(touch_input, EV_SYN, SYN_REPORT, 0);
+      batch.write(EV_KEY, BTN_TOUCH, 0);
+      batch.write(EV_ABS, ABS_PRESSURE, 0);
+      batch.write(EV_SYN, SYN_REPORT, 0);
       return;
     }
 
@@ -1760,20 +1774,20 @@ namespace platf {
       // Stop tracking this slot
       auto slot_index = slot_index_by_pointer_id(raw, touch.pointerId);
       if (slot_index >= 0) {
-        libevdev_uinput_write_event(touch_input, EV_ABS, ABS_MT_SLOT, slot_index);
-        libevdev_uinput_write_event(touch_input, EV_ABS, ABS_MT_TRACKING_ID, -1);
+        batch.write(EV_ABS, ABS_MT_SLOT, slot_index);
+        batch.write(EV_ABS, ABS_MT_TRACKING_ID, -1);
 
         raw->touch_slots[slot_index] = INVALID_TRACKING_ID;
 
         // Raise BTN_TOUCH if no touches are down
         if (std::all_of(raw->touch_slots.cbegin(), raw->touch_slots.cend(),
               [](uint64_t pointer_id) { return pointer_id == INVALID_TRACKING_ID; })) {
-          libevdev_uinput_write_event(touch_input, EV_KEY, BTN_TOUCH, 0);
+          batch.write(EV_KEY, BTN_TOUCH, 0);
 
           // This may have been the final slot down which was also being emulated
           // through the single-touch axes. Reset ABS_PRESSURE to ensure code that
           // uses ABS_PRESSURE instead of BTN_TOUCH will work properly.
-          libevdev_uinput_write_event(touch_input, EV_ABS, ABS_PRESSURE, 0);
+          batch.write(EV_ABS, ABS_PRESSURE, 0);
         }
       }
     }
@@ -1788,14 +1802,14 @@ namespace platf {
           BOOST_LOG(error) << "No unused pointer entries! Cancelling all active touches!"sv;
 
           for (int i = 0; i < raw->touch_slots.size(); i++) {
-            libevdev_uinput_write_event(touch_input, EV_ABS, ABS_MT_SLOT, i);
-            libevdev_uinput_write_event(touch_input, EV_ABS, ABS_MT_TRACKING_ID, -1);
+            batch.write(EV_ABS, ABS_MT_SLOT, i);
+            batch.write(EV_ABS, ABS_MT_TRACKING_ID, -1);
           }
           raw->touch_slots.fill(INVALID_TRACKING_ID);
 
-          libevdev_uinput_write_event(touch_input, EV_KEY, BTN_TOUCH, 0);
-          libevdev_uinput_write_event(touch_input, EV_ABS, ABS_PRESSURE, 0);
-          libevdev_uinput_write_event(touch_input, EV_SYN, SYN_REPORT, 0);
+          batch.write(EV_KEY, BTN_TOUCH, 0);
+          batch.write(EV_ABS, ABS_PRESSURE, 0);
+          batch.write(EV_SYN, SYN_REPORT, 0);
 
           // All slots are clear, so this should never fail on the second try
           slot_index = allocate_slot_index_for_pointer_id(raw, touch.pointerId);
@@ -1811,22 +1825,22 @@ namespace platf {
         }
       }
 
-      libevdev_uinput_write_event(touch_input, EV_ABS, ABS_MT_SLOT, slot_index);
+      batch.write(EV_ABS, ABS_MT_SLOT, slot_index);
 
       if (touch.eventType == LI_TOUCH_EVENT_UP) {
         // Stop tracking this touch
-        libevdev_uinput_write_event(touch_input, EV_ABS, ABS_MT_TRACKING_ID, -1);
+        batch.write(EV_ABS, ABS_MT_TRACKING_ID, -1);
         raw->touch_slots[slot_index] = INVALID_TRACKING_ID;
 
         // Raise BTN_TOUCH if no touches are down
         if (std::all_of(raw->touch_slots.cbegin(), raw->touch_slots.cend(),
               [](uint64_t pointer_id) { return pointer_id == INVALID_TRACKING_ID; })) {
-          libevdev_uinput_write_event(touch_input, EV_KEY, BTN_TOUCH, 0);
+          batch.write(EV_KEY, BTN_TOUCH, 0);
 
           // This may have been the final slot down which was also being emulated
           // through the single-touch axes. Reset ABS_PRESSURE to ensure code that
           // uses ABS_PRESSURE instead of BTN_TOUCH will work properly.
-          libevdev_uinput_write_event(touch_input, EV_ABS, ABS_PRESSURE, 0);
+          batch.write(EV_ABS, ABS_PRESSURE, 0);
         }
       }
       else {
@@ -1836,16 +1850,16 @@ namespace platf {
         auto scaled_x = (int) std::lround((x + touch_port.offset_x) * ((float) target_touch_port.width / (float) touch_port.width));
         auto scaled_y = (int) std::lround((y + touch_port.offset_y) * ((float) target_touch_port.height / (float) touch_port.height));
 
-        libevdev_uinput_write_event(touch_input, EV_ABS, ABS_MT_TRACKING_ID, slot_index);
-        libevdev_uinput_write_event(touch_input, EV_ABS, ABS_MT_POSITION_X, scaled_x);
-        libevdev_uinput_write_event(touch_input, EV_ABS, ABS_MT_POSITION_Y, scaled_y);
+        batch.write(EV_ABS, ABS_MT_TRACKING_ID, slot_index);
+        batch.write(EV_ABS, ABS_MT_POSITION_X, scaled_x);
+        batch.write(EV_ABS, ABS_MT_POSITION_Y, scaled_y);
 
         if (touch.pressureOrDistance) {
-          libevdev_uinput_write_event(touch_input, EV_ABS, ABS_MT_PRESSURE, PRESSURE_MAX * pressure);
+          batch.write(EV_ABS, ABS_MT_PRESSURE, PRESSURE_MAX * pressure);
         }
         else if (touch.eventType == LI_TOUCH_EVENT_DOWN) {
           // Always report some moderate pressure value when down
-          libevdev_uinput_write_event(touch_input, EV_ABS, ABS_MT_PRESSURE, PRESSURE_MAX / 2);
+          batch.write(EV_ABS, ABS_MT_PRESSURE, PRESSURE_MAX / 2);
         }
 
         if (touch.rotation != LI_ROT_UNKNOWN) {
@@ -1865,7 +1879,7 @@ namespace platf {
             adjusted_angle += 360;
           }
 
-          libevdev_uinput_write_event(touch_input, EV_ABS, ABS_MT_ORIENTATION, adjusted_angle);
+          batch.write(EV_ABS, ABS_MT_ORIENTATION, adjusted_angle);
         }
 
         if (touch.contactAreaMajor) {
@@ -1877,24 +1891,24 @@ namespace platf {
             { target_touch_port.width / (touch_port.width * 65535.f),
               target_touch_port.height / (touch_port.height * 65535.f) });
 
-          libevdev_uinput_write_event(touch_input, EV_ABS, ABS_MT_TOUCH_MAJOR, target_scaled_contact_area.first);
+          batch.write(EV_ABS, ABS_MT_TOUCH_MAJOR, target_scaled_contact_area.first);
 
           // scale_client_contact_area() will treat the contact area as circular (major == minor)
           // if the minor axis wasn't specified, so we unconditionally report ABS_MT_TOUCH_MINOR.
-          libevdev_uinput_write_event(touch_input, EV_ABS, ABS_MT_TOUCH_MINOR, target_scaled_contact_area.second);
+          batch.write(EV_ABS, ABS_MT_TOUCH_MINOR, target_scaled_contact_area.second);
         }
 
         // If this slot is the first active one, send our data through the single touch axes as well
         for (int i = 0; i <= slot_index; i++) {
           if (raw->touch_slots[i] != INVALID_TRACKING_ID) {
             if (i == slot_index) {
-              libevdev_uinput_write_event(touch_input, EV_ABS, ABS_X, scaled_x);
-              libevdev_uinput_write_event(touch_input, EV_ABS, ABS_Y, scaled_y);
+              batch.write(EV_ABS, ABS_X, scaled_x);
+              batch.write(EV_ABS, ABS_Y, scaled_y);
               if (touch.pressureOrDistance) {
-                libevdev_uinput_write_event(touch_input, EV_ABS, ABS_PRESSURE, PRESSURE_MAX * pressure);
+                batch.write(EV_ABS, ABS_PRESSURE, PRESSURE_MAX * pressure);
               }
               else if (touch.eventType == LI_TOUCH_EVENT_DOWN) {
-                libevdev_uinput_write_event(touch_input, EV_ABS, ABS_PRESSURE, PRESSURE_MAX / 2);
+                batch.write(EV_ABS, ABS_PRESSURE, PRESSURE_MAX / 2);
               }
             }
             break;
@@ -1902,7 +1916,7 @@ namespace platf {
         }
       }
 
-      libevdev_uinput_write_event(touch_input, EV_SYN, SYN_REPORT, 0);
+      batch.write(EV_SYN, SYN_REPORT, 0);
     }
   }
 
@@ -1925,6 +1939,7 @@ namespace platf {
     }
 
     auto pen_input = raw->pen_input.get();
+    evdev::batch_t batch { libevdev_uinput_get_fd(pen_input) };
 
     float x = pen.x * touch_port.width;
     float y = pen.y * touch_port.height;
@@ -1936,42 +1951,42 @@ namespace platf {
     // First, process location updates for applicable events
     switch (pen.eventType) {
       case LI_TOUCH_EVENT_HOVER:
-        libevdev_uinput_write_event(pen_input, EV_ABS, ABS_X, scaled_x);
-        libevdev_uinput_write_event(pen_input, EV_ABS, ABS_Y, scaled_y);
+        batch.write(EV_ABS, ABS_X, scaled_x);
+        batch.write(EV_ABS, ABS_Y, scaled_y);
 
-        libevdev_uinput_write_event(pen_input, EV_ABS, ABS_PRESSURE, 0);
+        batch.write(EV_ABS, ABS_PRESSURE, 0);
         if (pen.pressureOrDistance) {
-          libevdev_uinput_write_event(pen_input, EV_ABS, ABS_DISTANCE, DISTANCE_MAX * pen.pressureOrDistance);
+          batch.write(EV_ABS, ABS_DISTANCE, DISTANCE_MAX * pen.pressureOrDistance);
         }
         else {
           // Always report some moderate distance value when hovering to ensure hovering
           // can be detected properly by code that uses ABS_DISTANCE.
-          libevdev_uinput_write_event(pen_input, EV_ABS, ABS_DISTANCE, DISTANCE_MAX / 2);
+          batch.write(EV_ABS, ABS_DISTANCE, DISTANCE_MAX / 2);
         }
         break;
 
       case LI_TOUCH_EVENT_DOWN:
-        libevdev_uinput_write_event(pen_input, EV_ABS, ABS_X, scaled_x);
-        libevdev_uinput_write_event(pen_input, EV_ABS, ABS_Y, scaled_y);
+        batch.write(EV_ABS, ABS_X, scaled_x);
+        batch.write(EV_ABS, ABS_Y, scaled_y);
 
-        libevdev_uinput_write_event(pen_input, EV_ABS, ABS_DISTANCE, 0);
-        libevdev_uinput_write_event(pen_input, EV_ABS, ABS_PRESSURE, PRESSURE_MAX * pressure);
+        batch.write(EV_ABS, ABS_DISTANCE, 0);
+        batch.write(EV_ABS, ABS_PRESSURE, PRESSURE_MAX * pressure);
         break;
 
       case LI_TOUCH_EVENT_UP:
-        libevdev_uinput_write_event(pen_input, EV_ABS, ABS_X, scaled_x);
-        libevdev_uinput_write_event(pen_input, EV_ABS, ABS_Y, scaled_y);
+        batch.write(EV_ABS, ABS_X, scaled_x);
+        batch.write(EV_ABS, ABS_Y, scaled_y);
 
-        libevdev_uinput_write_event(pen_input, EV_ABS, ABS_PRESSURE, 0);
+        batch.write(EV_ABS, ABS_PRESSURE, 0);
         break;
 
       case LI_TOUCH_EVENT_MOVE:
-        libevdev_uinput_write_event(pen_input, EV_ABS, ABS_X, scaled_x);
-        libevdev_uinput_write_event(pen_input, EV_ABS, ABS_Y, scaled_y);
+        batch.write(EV_ABS, ABS_X, scaled_x);
+        batch.write(EV_ABS, ABS_Y, scaled_y);
 
         // Update the pressure value if it's present, otherwise leave the default/previous value alone
         if (pen.pressureOrDistance) {
-          libevdev_uinput_write_event(pen_input, EV_ABS, ABS_PRESSURE, PRESSURE_MAX * pressure);
+          batch.write(EV_ABS, ABS_PRESSURE, PRESSURE_MAX * pressure);
         }
         break;
     }
@@ -1986,7 +2001,7 @@ namespace platf {
           target_touch_port.height / (touch_port.height * 65535.f) });
 
       // ABS_TOOL_WIDTH assumes a circular tool, so we just report the major axis
-      libevdev_uinput_write_event(pen_input, EV_ABS, ABS_TOOL_WIDTH, target_scaled_contact_area.first);
+      batch.write(EV_ABS, ABS_TOOL_WIDTH, target_scaled_contact_area.first);
     }
 
     // We require rotation and tilt to perform the conversion to X and Y tilt angles
@@ -1997,8 +2012,8 @@ namespace platf {
       auto z = std::cos(tilt_rads);
 
       // Convert polar coordinates into X and Y tilt angles
-      libevdev_uinput_write_event(pen_input, EV_ABS, ABS_TILT_X, std::atan2(std::sin(-rotation_rads) * r, z) * 180.f / M_PI);
-      libevdev_uinput_write_event(pen_input, EV_ABS, ABS_TILT_Y, std::atan2(std::cos(-rotation_rads) * r, z) * 180.f / M_PI);
+      batch.write(EV_ABS, ABS_TILT_X, std::atan2(std::sin(-rotation_rads) * r, z) * 180.f / M_PI);
+      batch.write(EV_ABS, ABS_TILT_Y, std::atan2(std::cos(-rotation_rads) * r, z) * 180.f / M_PI);
     }
 
     // Don't update tool type if we're cancelling or ending a touch/hover
@@ -2016,12 +2031,12 @@ namespace platf {
           }
           // fall-through
         case LI_TOOL_TYPE_PEN:
-          libevdev_uinput_write_event(pen_input, EV_KEY, BTN_TOOL_RUBBER, 0);
-          libevdev_uinput_write_event(pen_input, EV_KEY, BTN_TOOL_PEN, 1);
+          batch.write(EV_KEY, BTN_TOOL_RUBBER, 0);
+          batch.write(EV_KEY, BTN_TOOL_PEN, 1);
           break;
         case LI_TOOL_TYPE_ERASER:
-          libevdev_uinput_write_event(pen_input, EV_KEY, BTN_TOOL_PEN, 0);
-          libevdev_uinput_write_event(pen_input, EV_KEY, BTN_TOOL_RUBBER, 1);
+          batch.write(EV_KEY, BTN_TOOL_PEN, 0);
+          batch.write(EV_KEY, BTN_TOOL_RUBBER, 1);
           break;
       }
     }
@@ -2032,24 +2047,24 @@ namespace platf {
       case LI_TOUCH_EVENT_CANCEL_ALL:
       case LI_TOUCH_EVENT_HOVER_LEAVE:
       case LI_TOUCH_EVENT_UP:
-        libevdev_uinput_write_event(pen_input, EV_KEY, BTN_TOUCH, 0);
+        batch.write(EV_KEY, BTN_TOUCH, 0);
 
         // Leaving hover range is detected by all BTN_TOOL_* being cleared
-        libevdev_uinput_write_event(pen_input, EV_KEY, BTN_TOOL_PEN, 0);
-        libevdev_uinput_write_event(pen_input, EV_KEY, BTN_TOOL_RUBBER, 0);
+        batch.write(EV_KEY, BTN_TOOL_PEN, 0);
+        batch.write(EV_KEY, BTN_TOOL_RUBBER, 0);
         break;
 
       case LI_TOUCH_EVENT_DOWN:
-        libevdev_uinput_write_event(pen_input, EV_KEY, BTN_TOUCH, 1);
+        batch.write(EV_KEY, BTN_TOUCH, 1);
         break;
     }
 
     // Finally, process pen buttons
-    libevdev_uinput_write_event(pen_input, EV_KEY, BTN_STYLUS, !!(pen.penButtons & LI_PEN_BUTTON_PRIMARY));
-    libevdev_uinput_write_event(pen_input, EV_KEY, BTN_STYLUS2, !!(pen.penButtons & LI_PEN_BUTTON_SECONDARY));
-    libevdev_uinput_write_event(pen_input, EV_KEY, BTN_STYLUS3, !!(pen.penButtons & LI_PEN_BUTTON_TERTIARY));
+    batch.write(EV_KEY, BTN_STYLUS, !!(pen.penButtons & LI_PEN_BUTTON_PRIMARY));
+    batch.write(EV_KEY, BTN_STYLUS2, !!(pen.penButtons & LI_PEN_BUTTON_SECONDARY));
+    batch.write(EV_KEY, BTN_STYLUS3, !!(pen.penButtons & LI_PEN_BUTTON_TERTIARY));
 
-    libevdev_uinput_write_event(pen_input, EV_SYN, SYN_REPORT, 0);
+    batch.write(EV_SYN, SYN_REPORT, 0);
   }
 
   /**
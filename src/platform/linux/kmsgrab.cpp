@@ -16,12 +16,14 @@
 #include <thread>
 
 #include "src/config.h"
+#include "src/cursor_blend.h"
 #include "src/logging.h"
 #include "src/platform/common.h"
 #include "src/round_robin.h"
 #include "src/utility.h"
 #include "src/video.h"
 
+#include "capture_scheduler.h"
 #include "cuda.h"
 #include "graphics.h"
 #include "vaapi.h"
@@ -1150,6 +1152,32 @@ namespace platf {
       cursor_t captured_cursor {};
 
       card_t card;
+
+      /**
+       * @brief Keep the capture deadlines in phase with the vblank of the captured CRTC.
+       *
+       * The vblank is queried at most once per second, which is plenty to follow a stable refresh rate.
+       */
+      void
+      align_to_vblank(capture_scheduler_t &scheduler) {
+        auto now = std::chrono::steady_clock::now();
+        if (now < next_vblank_query) {
+          return;
+        }
+        next_vblank_query = now + 1s;
+
+        // The timestamp of the last vblank is on CLOCK_MONOTONIC, which backs std::chrono::steady_clock on Linux
+        std::uint64_t sequence, ns;
+        if (drmCrtcGetSequence(card.fd.el, crtc_id, &sequence, &ns)) {
+          // The CRTC may be off, or the driver doesn't support it
+          return;
+        }
+
+        scheduler.align(std::chrono::steady_clock::time_point {
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds { ns }) });
+      }
+
+      std::chrono::steady_clock::time_point next_vblank_query;
     };
 
     class display_ram_t: public display_t {
@@ -1191,23 +1219,11 @@ namespace platf {
 
       capture_e
       capture(const push_captured_image_cb_t &push_captured_image_cb, const pull_free_image_cb_t &pull_free_image_cb, bool *cursor) override {
-        auto next_frame = std::chrono::steady_clock::now();
-
-        sleep_overshoot_logger.reset();
+        capture_scheduler_t scheduler { delay };
 
         while (true) {
-          auto now = std::chrono::steady_clock::now();
-
-          if (next_frame > now) {
-            std::this_thread::sleep_for(next_frame - now);
-            sleep_overshoot_logger.first_point(next_frame);
-            sleep_overshoot_logger.second_point_now_and_log();
-          }
-
-          next_frame += delay;
-          if (next_frame < now) {  // some major slowdown happened; we couldn't keep up
-            next_frame = now + delay;
-          }
+          scheduler.wait();
+          align_to_vblank(scheduler);
 
           std::shared_ptr<platf::img_t> img_out;
           auto status = snapshot(pull_free_image_cb, img_out, 1000ms, *cursor);
@@ -1256,50 +1272,9 @@ namespace platf {
       blend_cursor(img_t &img) {
         // TODO: Cursor scaling is not supported in this codepath.
         // We always draw the cursor at the source size.
-        auto pixels = (int *) img.data;
-
-        int32_t screen_height = img.height;
-        int32_t screen_width = img.width;
-
-        // This is the position in the target that we will start drawing the cursor
-        auto cursor_x = std::max<int32_t>(0, captured_cursor.x - img_offset_x);
-        auto cursor_y = std::max<int32_t>(0, captured_cursor.y - img_offset_y);
-
-        // If the cursor is partially off screen, the coordinates may be negative
-        // which means we will draw the top-right visible portion of the cursor only.
-        auto cursor_delta_x = cursor_x - std::max<int32_t>(-captured_cursor.src_w, captured_cursor.x - img_offset_x);
-        auto cursor_delta_y = cursor_y - std::max<int32_t>(-captured_cursor.src_h, captured_cursor.y - img_offset_y);
-
-        auto delta_height = std::min<uint32_t>(captured_cursor.src_h, std::max<int32_t>(0, screen_height - cursor_y)) - cursor_delta_y;
-        auto delta_width = std::min<uint32_t>(captured_cursor.src_w, std::max<int32_t>(0, screen_width - cursor_x)) - cursor_delta_x;
-        for (auto y = 0; y < delta_height; ++y) {
-          // Offset into the cursor image to skip drawing the parts of the cursor image that are off screen
-          //
-          // NB: We must access the elements via the data() function because cursor_end may point to the
-          // the first element beyond the valid range of the vector. Using vector's [] operator in that
-          // manner is undefined behavior (and triggers errors when using debug libc++), while doing the
-          // same with an array is fine.
-          auto cursor_begin = (uint32_t *) &captured_cursor.pixels.data()[((y + cursor_delta_y) * captured_cursor.src_w + cursor_delta_x) * 4];
-          auto cursor_end = (uint32_t *) &captured_cursor.pixels.data()[((y + cursor_delta_y) * captured_cursor.src_w + delta_width + cursor_delta_x) * 4];
-
-          auto pixels_begin = &pixels[(y + cursor_y) * (img.row_pitch / img.pixel_pitch) + cursor_x];
-
-          std::for_each(cursor_begin, cursor_end, [&](uint32_t cursor_pixel) {
-            auto colors_in = (uint8_t *) pixels_begin;
-
-            auto alpha = (*(uint *) &cursor_pixel) >> 24u;
-            if (alpha == 255) {
-              *pixels_begin = cursor_pixel;
-            }
-            else {
-              auto colors_out = (uint8_t *) &cursor_pixel;
-              colors_in[0] = colors_out[0] + (colors_in[0] * (255 - alpha) + 255 / 2) / 255;
-              colors_in[1] = colors_out[1] + (colors_in[1] * (255 - alpha) + 255 / 2) / 255;
-              colors_in[2] = colors_out[2] + (colors_in[2] * (255 - alpha) + 255 / 2) / 255;
-            }
-            ++pixels_begin;
-          });
-        }
+        cursor_blend::blend(img, (const std::uint32_t *) captured_cursor.pixels.data(),
+          captured_cursor.x - img_offset_x, captured_cursor.y - img_offset_y,
+          captured_cursor.src_w, captured_cursor.src_h);
       }
 
       capture_e
@@ -1414,23 +1389,11 @@ namespace platf {
 
       capture_e
       capture(const push_captured_image_cb_t &push_captured_image_cb, const pull_free_image_cb_t &pull_free_image_cb, bool *cursor) {
-        auto next_frame = std::chrono::steady_clock::now();
-
-        sleep_overshoot_logger.reset();
+        capture_scheduler_t scheduler { delay };
 
         while (true) {
-          auto now = std::chrono::steady_clock::now();
-
-          if (next_frame > now) {
-            std::this_thread::sleep_for(next_frame - now);
-            sleep_overshoot_logger.first_point(next_frame);
-            sleep_overshoot_logger.second_point_now_and_log();
-          }
-
-          next_frame += delay;
-          if (next_frame < now) {  // some major slowdown happened; we couldn't keep up
-            next_frame = now + delay;
-          }
+          scheduler.wait();
+          align_to_vblank(scheduler);
 
           std::shared_ptr<platf::img_t> img_out;
           auto status = snapshot(pull_free_image_cb, img_out, 1000ms, *cursor);
@@ -9,8 +9,12 @@
 #endif
 
 // standard includes
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <sstream>
 
 // lib includes
 #include <arpa/inet.h>
@@ -21,7 +25,13 @@
 #include <fcntl.h>
 #include <ifaddrs.h>
 #include <netinet/udp.h>
+#include <pthread.h>
 #include <pwd.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
 #include <unistd.h>
 
 // local includes
@@ -31,6 +41,7 @@
 #include "src/entry_handler.h"
 #include "src/logging.h"
 #include "src/platform/common.h"
+#include "src/thread_placement.h"
 #include "vaapi.h"
 
 #ifdef __GNUC__
@@ -294,9 +305,282 @@ namespace platf {
     open_url(url);
   }
 
+  namespace rtkit {
+    // Just enough of libdbus-1 to call RealtimeKit, loaded at runtime so it stays optional
+    struct DBusConnection;
+    struct DBusMessage;
+    struct DBusError {
+      const char *name;
+      const char *message;
+      unsigned int dummy;
+      void *padding;
+    };
+
+    constexpr int DBUS_BUS_SYSTEM = 1;
+    constexpr int DBUS_TYPE_INVALID = 0;
+    constexpr int DBUS_TYPE_INT32 = 'i';
+    constexpr int DBUS_TYPE_UINT32 = 'u';
+    constexpr int DBUS_TYPE_UINT64 = 't';
+
+    using error_init_fn = void (*)(DBusError *error);
+    using error_free_fn = void (*)(DBusError *error);
+    using bus_get_fn = DBusConnection *(*) (int type, DBusError *error);
+    using message_new_method_call_fn = DBusMessage *(*) (const char *destination, const char *path, const char *iface, const char *method);
+    using message_append_args_fn = unsigned int (*)(DBusMessage *message, int first_arg_type, ...);
+    using connection_send_with_reply_and_block_fn = DBusMessage *(*) (DBusConnection *connection, DBusMessage *message, int timeout_milliseconds, DBusError *error);
+    using message_unref_fn = void (*)(DBusMessage *message);
+    using connection_unref_fn = void (*)(DBusConnection *connection);
+
+    error_init_fn error_init;
+    error_free_fn error_free;
+    bus_get_fn bus_get;
+    message_new_method_call_fn message_new_method_call;
+    message_append_args_fn message_append_args;
+    connection_send_with_reply_and_block_fn connection_send_with_reply_and_block;
+    message_unref_fn message_unref;
+    connection_unref_fn connection_unref;
+
+    int
+    init() {
+      static void *handle { nullptr };
+      static bool funcs_loaded = false;
+
+      if (funcs_loaded) return 0;
+
+      if (!handle) {
+        handle = dyn::handle({ "libdbus-1.so.3", "libdbus-1.so" });
+        if (!handle) {
+          return -1;
+        }
+      }
+
+      std::vector<std::tuple<dyn::apiproc *, const char *>> funcs {
+        { (dyn::apiproc *) &error_init, "dbus_error_init" },
+        { (dyn::apiproc *) &error_free, "dbus_error_free" },
+        { (dyn::apiproc *) &bus_get, "dbus_bus_get" },
+        { (dyn::apiproc *) &message_new_method_call, "dbus_message_new_method_call" },
+        { (dyn::apiproc *) &message_append_args, "dbus_message_append_args" },
+        { (dyn::apiproc *) &connection_send_with_reply_and_block, "dbus_connection_send_with_reply_and_block" },
+        { (dyn::apiproc *) &message_unref, "dbus_message_unref" },
+        { (dyn::apiproc *) &connection_unref, "dbus_connection_unref" },
+      };
+
+      if (dyn::load(handle, funcs)) {
+        return -1;
+      }
+
+      funcs_loaded = true;
+      return 0;
+    }
+
+    /**
+     * @brief Ask RealtimeKit to change the scheduling of a thread on our behalf.
+     * @param method `MakeThreadRealtime` or `MakeThreadHighPriority`.
+     * @param arg_type The D-Bus type of `arg`, the priority for the former and the nice value for the latter.
+     * @return 0 on success.
+     */
+    int
+    call(const char *method, pid_t tid, int arg_type, void *arg) {
+      if (init()) {
+        return -1;
+      }
+
+      DBusError error;
+      error_init(&error);
+      auto fg = util::fail_guard([&]() { error_free(&error); });
+
+      auto connection = bus_get(DBUS_BUS_SYSTEM, &error);
+      if (!connection) {
+        BOOST_LOG(debug) << "rtkit: couldn't connect to the system bus: "sv << (error.message ? error.message : "unknown error");
+        return -1;
+      }
+      auto connection_fg = util::fail_guard([&]() { connection_unref(connection); });
+
+      auto message = message_new_method_call("org.freedesktop.RealtimeKit1", "/org/freedesktop/RealtimeKit1", "org.freedesktop.RealtimeKit1", method);
+      if (!message) {
+        return -1;
+      }
+      auto message_fg = util::fail_guard([&]() { message_unref(message); });
+
+      std::uint64_t thread = tid;
+      if (!message_append_args(message, DBUS_TYPE_UINT64, &thread, arg_type, arg, DBUS_TYPE_INVALID)) {
+        return -1;
+      }
+
+      auto reply = connection_send_with_reply_and_block(connection, message, 1000, &error);
+      if (!reply) {
+        BOOST_LOG(debug) << "rtkit: "sv << method << " failed: "sv << (error.message ? error.message : "unknown error");
+        return -1;
+      }
+      message_unref(reply);
+
+      return 0;
+    }
+
+    /**
+     * @brief Called on the thread that ran past the soft RLIMIT_RTTIME without blocking.
+     */
+    void
+    on_rttime_exceeded(int) {
+      // Drop back to normal scheduling rather than keep hogging the CPU, it's a bare system call
+      sched_param param {};
+      sched_setscheduler(0, SCHED_OTHER, &param);
+    }
+
+    int
+    make_realtime(pid_t tid, std::uint32_t priority) {
+      // RealtimeKit refuses processes without a limit on their CPU time in real-time mode.
+      // Only the soft limit is set: reaching it raises SIGXCPU, which demotes the thread,
+      // while reaching a hard limit would kill the whole process.
+      static std::once_flag limit_once;
+      std::call_once(limit_once, []() {
+        struct sigaction action {};
+        action.sa_handler = on_rttime_exceeded;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGXCPU, &action, nullptr);
+
+        rlimit limit {};
+        if (!getrlimit(RLIMIT_RTTIME, &limit) && (limit.rlim_cur == RLIM_INFINITY || limit.rlim_cur > 200000)) {
+          limit.rlim_cur = 200000;
+          setrlimit(RLIMIT_RTTIME, &limit);
+        }
+      });
+
+      return call("MakeThreadRealtime", tid, DBUS_TYPE_UINT32, &priority);
+    }
+
+    int
+    make_high_priority(pid_t tid, std::int32_t nice) {
+      return call("MakeThreadHighPriority", tid, DBUS_TYPE_INT32, &nice);
+    }
+  }  // namespace rtkit
+
   void
   adjust_thread_priority(thread_priority_e priority) {
-    // Unimplemented
+    auto &policy_name = config::threads.sched_policy;
+
+    // Thread priorities are left to the OS unless a policy was configured
+    if (policy_name.empty()) {
+      return;
+    }
+
+    auto tid = (pid_t) syscall(SYS_gettid);
+
+    if (priority >= thread_priority_e::high && policy_name != "nice"sv) {
+      int policy = policy_name == "rr"sv ? SCHED_RR : SCHED_FIFO;
+
+      sched_param param {};
+      param.sched_priority = std::clamp(
+        config::threads.rt_priority - (priority == thread_priority_e::high ? 1 : 0),
+        sched_get_priority_min(policy),
+        sched_get_priority_max(policy));
+
+      auto status = pthread_setschedparam(pthread_self(), policy, &param);
+      if (!status) {
+        return;
+      }
+
+      // Without CAP_SYS_NICE, RealtimeKit can still grant SCHED_RR
+      if (!rtkit::make_realtime(tid, param.sched_priority)) {
+        return;
+      }
+
+      BOOST_LOG(warning) << "Unable to set real-time scheduling policy "sv << policy_name << ": "sv << strerror(status) << ", falling back to nice values"sv;
+    }
+
+    int nice;
+    switch (priority) {
+      case thread_priority_e::low:
+        nice = 10;
+        break;
+      case thread_priority_e::normal:
+        nice = 0;
+        break;
+      case thread_priority_e::high:
+        nice = -5;
+        break;
+      case thread_priority_e::critical:
+        nice = -10;
+        break;
+      default:
+        BOOST_LOG(error) << "Unknown thread priority: "sv << (int) priority;
+        return;
+    }
+
+    // On Linux, the nice value of a thread is set through its thread id
+    if (setpriority(PRIO_PROCESS, tid, nice) && (nice >= 0 || rtkit::make_high_priority(tid, nice))) {
+      BOOST_LOG(debug) << "Unable to set nice value of thread "sv << tid << " to "sv << nice;
+    }
+  }
+
+  void
+  set_thread_name(std::string_view name) {
+    // Thread names are limited to 15 characters
+    std::string truncated { name.substr(0, 15) };
+    pthread_setname_np(pthread_self(), truncated.c_str());
+  }
+
+  int
+  set_thread_affinity(const std::vector<int> &cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus) {
+      if (cpu < CPU_SETSIZE) {
+        CPU_SET(cpu, &set);
+      }
+    }
+
+    if (sched_setaffinity(0, sizeof(set), &set)) {
+      BOOST_LOG(debug) << "sched_setaffinity() failed: "sv << strerror(errno);
+      return -1;
+    }
+
+    return 0;
+  }
+
+  std::vector<int>
+  numa_node_cpus(int node) {
+    std::ifstream in { "/sys/devices/system/node/node"s + std::to_string(node) + "/cpulist" };
+
+    std::string list;
+    if (!std::getline(in, list)) {
+      return {};
+    }
+
+    return thread_placement::parse_cpu_list(list).value_or(std::vector<int> {});
+  }
+
+  thread_info_t
+  current_thread_info() {
+    thread_info_t info { syscall(SYS_gettid), {}, {} };
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (!sched_getaffinity(0, sizeof(set), &set)) {
+      for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+          info.cpus.emplace_back(cpu);
+        }
+      }
+    }
+
+    int policy;
+    sched_param param {};
+    pthread_getschedparam(pthread_self(), &policy, &param);
+
+    switch (policy) {
+      case SCHED_FIFO:
+        info.scheduling = "SCHED_FIFO priority "s + std::to_string(param.sched_priority);
+        break;
+      case SCHED_RR:
+        info.scheduling = "SCHED_RR priority "s + std::to_string(param.sched_priority);
+        break;
+      default:
+        info.scheduling = "SCHED_OTHER nice "s + std::to_string(getpriority(PRIO_PROCESS, (id_t) info.id));
+        break;
+    }
+
+    return info;
   }
 
   void
@@ -821,6 +1105,7 @@ namespace platf {
 
   namespace source {
     enum source_e : std::size_t {
+      SYNTHETIC,  ///< Synthetic
 #ifdef SUNSHINE_BUILD_CUDA
       NVFBC,  ///< NvFBC
 #endif
@@ -839,6 +1124,11 @@ namespace platf {
 
   static std::bitset<source::MAX_FLAGS> sources;
 
+  std::vector<std::string>
+  synthetic_display_names();
+  std::shared_ptr<display_t>
+  synthetic_display(mem_type_e hwdevice_type, const std::string &display_name, const video::config_t &config);
+
 #ifdef SUNSHINE_BUILD_CUDA
   std::vector<std::string>
   nvfbc_display_names();
@@ -889,6 +1179,7 @@ namespace platf {
 
   std::vector<std::string>
   display_names(mem_type_e hwdevice_type) {
+    if (sources[source::SYNTHETIC]) return synthetic_display_names();
 #ifdef SUNSHINE_BUILD_CUDA
     // display using NvFBC only supports mem_type_e::cuda
     if (sources[source::NVFBC] && hwdevice_type == mem_type_e::cuda) return nvfbc_display_names();
@@ -915,8 +1206,53 @@ namespace platf {
     return true;
   }
 
+  std::string
+  encoder_adapter_identity() {
+    auto read_line = [](const fs::path &path) {
+      std::string line;
+      std::ifstream file { path };
+      std::getline(file, line);
+      return line;
+    };
+
+    std::vector<std::string> render_nodes;
+    std::error_code ec;
+    for (auto &entry : fs::directory_iterator { "/sys/class/drm", ec }) {
+      auto name = entry.path().filename().string();
+      if (name.starts_with("renderD")) {
+        render_nodes.emplace_back(std::move(name));
+      }
+    }
+    if (render_nodes.empty()) {
+      return {};
+    }
+
+    std::sort(std::begin(render_nodes), std::end(render_nodes));
+
+    std::stringstream identity;
+    for (auto &node : render_nodes) {
+      fs::path device { "/sys/class/drm/" + node + "/device" };
+      auto driver = fs::read_symlink(device / "driver", ec).filename().string();
+
+      // Out-of-tree drivers have their own version, the in-tree ones come with the kernel
+      identity << node << " ["sv << read_line(device / "vendor") << ':' << read_line(device / "device")
+               << "] "sv << driver << ' ' << read_line(fs::path { "/sys/module" } / driver / "version") << ';';
+    }
+
+    utsname kernel;
+    if (!uname(&kernel)) {
+      identity << " kernel "sv << kernel.release;
+    }
+
+    return identity.str();
+  }
+
   std::shared_ptr<display_t>
   display(mem_type_e hwdevice_type, const std::string &display_name, const video::config_t &config) {
+    if (sources[source::SYNTHETIC]) {
+      BOOST_LOG(info) << "Screencasting generated frames"sv;
+      return synthetic_display(hwdevice_type, display_name, config);
+    }
 #ifdef SUNSHINE_BUILD_CUDA
     if (sources[source::NVFBC] && hwdevice_type == mem_type_e::cuda) {
       BOOST_LOG(info) << "Screencasting with NvFBC"sv;
@@ -970,6 +1306,10 @@ namespace platf {
     }
 #endif
 
+    // Never picked automatically, it doesn't show anything that is on the screen
+    if (config::video.capture == "synthetic") {
+      sources[source::SYNTHETIC] = true;
+    }
 #ifdef SUNSHINE_BUILD_CUDA
     if ((config::video.capture.empty() && sources.none()) || config::video.capture == "nvfbc") {
       if (verify_nvfbc()) {
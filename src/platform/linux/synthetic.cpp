@@ -0,0 +1,316 @@
+/**
+ * @file src/platform/linux/synthetic.cpp
+ * @brief Definitions for the frame generators of the synthetic capture backend.
+ */
+// standard includes
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+// local includes
+#include "src/logging.h"
+#include "synthetic.h"
+
+using namespace std::literals;
+
+namespace platf::synthetic {
+  namespace {
+    constexpr int bytes_per_pixel = 4;
+
+    /**
+     * @brief Mix the bits of a value, a single round of splitmix64.
+     */
+    constexpr std::uint64_t
+    mix(std::uint64_t x) {
+      x += 0x9E3779B97F4A7C15;
+      x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+      x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+      return x ^ (x >> 31);
+    }
+
+    void
+    put_pixel(std::uint8_t *row, int x, std::uint8_t r, std::uint8_t g, std::uint8_t b) {
+      auto pixel = row + x * bytes_per_pixel;
+      pixel[0] = b;
+      pixel[1] = g;
+      pixel[2] = r;
+      pixel[3] = 0;
+    }
+
+    /**
+     * @brief Draws frames by copying the rows of a picture drawn in advance.
+     *
+     * Keeps the cost of generating a frame down to a copy, so it doesn't skew the measurements of the pipeline.
+     */
+    class picture_t: public generator_t {
+    public:
+      picture_t(int width, int height, int picture_height):
+          width { width }, height { height }, picture_height { picture_height }, picture((std::size_t) width * picture_height * bytes_per_pixel) {}
+
+      /**
+       * @return The first row of the picture to copy to the frame, later rows wrap around.
+       */
+      virtual int
+      first_row(std::uint64_t frame) = 0;
+
+      int
+      draw(std::uint8_t *data, int row_pitch, std::uint64_t frame) override {
+        auto src_row = first_row(frame);
+        auto row_size = (std::size_t) width * bytes_per_pixel;
+
+        for (int y = 0; y < height; ++y) {
+          std::memcpy(data + (std::size_t) y * row_pitch, row(src_row), row_size);
+
+          if (++src_row == picture_height) {
+            src_row = 0;
+          }
+        }
+
+        return 0;
+      }
+
+    protected:
+      std::uint8_t *
+      row(int y) {
+        return picture.data() + (std::size_t) y * width * bytes_per_pixel;
+      }
+
+      int width;
+      int height;
+      int picture_height;
+      std::vector<std::uint8_t> picture;
+    };
+
+    /**
+     * @brief Color bars over a gray ramp.
+     */
+    class static_image_t: public picture_t {
+    public:
+      static_image_t(int width, int height):
+          picture_t { width, height, height } {
+        // White, yellow, cyan, green, magenta, red, blue, black
+        constexpr std::array<std::array<std::uint8_t, 3>, 8> bars { {
+          { 235, 235, 235 },
+          { 235, 235, 16 },
+          { 16, 235, 235 },
+          { 16, 235, 16 },
+          { 235, 16, 235 },
+          { 235, 16, 16 },
+          { 16, 16, 235 },
+          { 16, 16, 16 },
+        } };
+
+        auto bars_height = height * 2 / 3;
+        for (int y = 0; y < height; ++y) {
+          for (int x = 0; x < width; ++x) {
+            if (y < bars_height) {
+              auto &bar = bars[(std::size_t) x * bars.size() / width];
+              put_pixel(row(y), x, bar[0], bar[1], bar[2]);
+            }
+            else {
+              auto gray = (std::uint8_t) (x * 255 / std::max(width - 1, 1));
+              put_pixel(row(y), x, gray, gray, gray);
+            }
+          }
+        }
+      }
+
+      int
+      first_row(std::uint64_t) override {
+        return 0;
+      }
+    };
+
+    /**
+     * @brief Lines of made up text, scrolling up at a steady pace.
+     */
+    class scroll_t: public picture_t {
+    public:
+      static constexpr int cell_width = 8;
+      static constexpr int cell_height = 16;
+      static constexpr int glyph_width = 5;
+      static constexpr int glyph_height = 7;
+
+      // Rows scrolled per frame
+      static constexpr int speed = 4;
+
+      scroll_t(int width, int height):
+          picture_t { width, height, (height + cell_height - 1) / cell_height * cell_height } {
+        auto columns = width / cell_width;
+
+        for (int y = 0; y < picture_height; ++y) {
+          for (int x = 0; x < width; ++x) {
+            put_pixel(row(y), x, 30, 30, 30);
+          }
+        }
+
+        for (int line = 0; line < picture_height / cell_height; ++line) {
+          auto length = (int) (mix(line) % (columns + 1));
+
+          for (int column = 0; column < length; ++column) {
+            auto glyph = mix(((std::uint64_t) line << 32) | column);
+
+            // Roughly one in six characters is a space between words
+            if (glyph % 6 == 0) {
+              continue;
+            }
+
+            draw_glyph(line * cell_height, column * cell_width, glyph);
+          }
+        }
+      }
+
+      int
+      first_row(std::uint64_t frame) override {
+        return (int) (frame * speed % picture_height);
+      }
+
+    private:
+      /**
+       * @brief Draw a glyph of `glyph_width` x `glyph_height` dots, with each dot two rows tall.
+       */
+      void
+      draw_glyph(int top, int left, std::uint64_t bits) {
+        for (int gy = 0; gy < glyph_height; ++gy) {
+          for (int gx = 0; gx < glyph_width; ++gx) {
+            if (!((bits >> (gy * glyph_width + gx)) & 1)) {
+              continue;
+            }
+
+            put_pixel(row(top + 1 + gy * 2), left + 1 + gx, 220, 220, 220);
+            put_pixel(row(top + 2 + gy * 2), left + 1 + gx, 220, 220, 220);
+          }
+        }
+      }
+    };
+
+    /**
+     * @brief Random pixels, the worst case for an encoder.
+     */
+    class noise_t: public generator_t {
+    public:
+      noise_t(int width, int height):
+          width { width }, height { height } {}
+
+      int
+      draw(std::uint8_t *data, int row_pitch, std::uint64_t frame) override {
+        // Seeded by the frame so the same frame is always drawn the same way
+        std::uint64_t state = mix(frame) | 1;
+
+        auto row_size = (std::size_t) width * bytes_per_pixel;
+        for (int y = 0; y < height; ++y) {
+          auto row = data + (std::size_t) y * row_pitch;
+
+          for (std::size_t x = 0; x < row_size; x += sizeof(state)) {
+            // xorshift64*
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            auto random = state * 0x2545F4914F6CDD1D;
+
+            std::memcpy(row + x, &random, std::min(sizeof(random), row_size - x));
+          }
+        }
+
+        return 0;
+      }
+
+    private:
+      int width;
+      int height;
+    };
+
+    /**
+     * @brief Frames recorded in a file, played in a loop.
+     */
+    class file_t: public generator_t {
+    public:
+      file_t(int width, int height):
+          width { width }, height { height } {}
+
+      int
+      init(const std::string &path) {
+        file.open(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+          BOOST_LOG(error) << "Couldn't open synthetic frames ["sv << path << ']';
+          return -1;
+        }
+
+        auto frame_size = (std::uint64_t) width * height * bytes_per_pixel;
+        auto size = (std::uint64_t) file.tellg();
+        if (size < frame_size || size % frame_size) {
+          BOOST_LOG(error) << "Synthetic frames ["sv << path << "] are not a whole number of "sv << width << 'x' << height << " BGR0 frames"sv;
+          return -1;
+        }
+
+        frames = size / frame_size;
+        BOOST_LOG(info) << "Playing "sv << frames << " synthetic frames from ["sv << path << ']';
+
+        return 0;
+      }
+
+      int
+      draw(std::uint8_t *data, int row_pitch, std::uint64_t frame) override {
+        auto row_size = (std::streamsize) width * bytes_per_pixel;
+
+        file.seekg((std::streamoff) (frame % frames) * row_size * height);
+        for (int y = 0; y < height; ++y) {
+          if (!file.read((char *) data + (std::size_t) y * row_pitch, row_size)) {
+            BOOST_LOG(error) << "Couldn't read synthetic frame "sv << frame % frames;
+            file.clear();
+
+            return -1;
+          }
+        }
+
+        return 0;
+      }
+
+    private:
+      int width;
+      int height;
+
+      std::ifstream file;
+      std::uint64_t frames {};
+    };
+  }  // namespace
+
+  std::optional<pattern_e>
+  pattern_from_view(std::string_view pattern) {
+    if (pattern == "static"sv) return pattern_e::static_image;
+    if (pattern == "scroll"sv) return pattern_e::scroll;
+    if (pattern == "noise"sv) return pattern_e::noise;
+    if (pattern == "file"sv) return pattern_e::file;
+
+    return std::nullopt;
+  }
+
+  std::unique_ptr<generator_t>
+  make_generator(pattern_e pattern, int width, int height, const std::string &file) {
+    if (width <= 0 || height <= 0) {
+      BOOST_LOG(error) << "Invalid synthetic display size "sv << width << 'x' << height;
+      return nullptr;
+    }
+
+    switch (pattern) {
+      case pattern_e::static_image:
+        return std::make_unique<static_image_t>(width, height);
+      case pattern_e::scroll:
+        return std::make_unique<scroll_t>(width, height);
+      case pattern_e::noise:
+        return std::make_unique<noise_t>(width, height);
+      case pattern_e::file: {
+        auto generator = std::make_unique<file_t>(width, height);
+        if (generator->init(file)) {
+          return nullptr;
+        }
+
+        return generator;
+      }
+    }
+
+    return nullptr;
+  }
+}  // namespace platf::synthetic
@@ -0,0 +1,52 @@
+/**
+ * @file src/platform/linux/synthetic.h
+ * @brief Declarations for the frame generators of the synthetic capture backend.
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace platf::synthetic {
+  enum class pattern_e {
+    static_image,  ///< Color bars that never change
+    scroll,  ///< Text scrolling up, like a terminal or a web page
+    noise,  ///< Random pixels, every frame is completely different
+    file,  ///< Raw frames read from a file
+  };
+
+  std::optional<pattern_e>
+  pattern_from_view(std::string_view pattern);
+
+  /**
+   * @brief Draws the frames of the synthetic display in BGR0.
+   */
+  class generator_t {
+  public:
+    virtual ~generator_t() = default;
+
+    /**
+     * @brief Draw a frame.
+     * @param data The top left pixel of the frame.
+     * @param row_pitch The number of bytes between two rows of `data`.
+     * @param frame The number of frame periods since the capture started, frames may be skipped.
+     * @return 0 on success.
+     */
+    virtual int
+    draw(std::uint8_t *data, int row_pitch, std::uint64_t frame) = 0;
+  };
+
+  /**
+   * @brief Create the generator for a pattern.
+   * @param pattern The kind of frames to draw.
+   * @param width The width of the frames.
+   * @param height The height of the frames.
+   * @param file The raw BGR0 frames of `width` x `height` for pattern_e::file, played in a loop.
+   * @return The generator, or nullptr on failure.
+   */
+  std::unique_ptr<generator_t>
+  make_generator(pattern_e pattern, int width, int height, const std::string &file);
+}  // namespace platf::synthetic
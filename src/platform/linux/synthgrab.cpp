@@ -0,0 +1,165 @@
+/**
+ * @file src/platform/linux/synthgrab.cpp
+ * @brief Definitions for the synthetic capture backend, a display that doesn't need a GPU or window system.
+ */
+#include "src/platform/common.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "src/config.h"
+#include "src/logging.h"
+#include "src/utility.h"
+#include "src/video.h"
+
+#include "capture_scheduler.h"
+#include "cuda.h"
+#include "synthetic.h"
+#include "vaapi.h"
+
+using namespace std::literals;
+
+namespace platf {
+  namespace {
+    struct synthetic_img_t: public img_t {
+      std::vector<std::uint8_t> buffer;
+    };
+
+    class synthetic_display_t: public display_t {
+    public:
+      synthetic_display_t(mem_type_e mem_type):
+          mem_type { mem_type } {}
+
+      int
+      init(const ::video::config_t &config) {
+        auto pattern = synthetic::pattern_from_view(config::video.synthetic.pattern);
+        if (!pattern) {
+          BOOST_LOG(error) << "Unknown synthetic pattern ["sv << config::video.synthetic.pattern << ']';
+          return -1;
+        }
+
+        width = config.width;
+        height = config.height;
+        if (!config::video.synthetic.resolution.empty()) {
+          auto &resolution = config::video.synthetic.resolution;
+          auto x = resolution.find('x');
+          if (x == std::string::npos) {
+            BOOST_LOG(error) << "Invalid synthetic resolution ["sv << resolution << ']';
+            return -1;
+          }
+
+          width = (int) util::from_view(std::string_view { resolution }.substr(0, x));
+          height = (int) util::from_view(std::string_view { resolution }.substr(x + 1));
+        }
+
+        env_width = width;
+        env_height = height;
+
+        delay = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double> { 1.0 / config.get_effective_framerate() });
+
+        generator = synthetic::make_generator(*pattern, width, height, config::video.synthetic.file);
+        if (!generator) {
+          return -1;
+        }
+
+        BOOST_LOG(info) << "Generating "sv << config::video.synthetic.pattern << " frames of "sv << width << 'x' << height << " at "sv << config.get_effective_framerate() << " fps"sv;
+
+        return 0;
+      }
+
+      capture_e
+      capture(const push_captured_image_cb_t &push_captured_image_cb, const pull_free_image_cb_t &pull_free_image_cb, bool *cursor) override {
+        capture_scheduler_t scheduler { delay };
+        std::uint64_t frame = 0;
+
+        while (true) {
+          // Skipped frames still advance the picture, so its motion follows the wall clock
+          frame += scheduler.wait();
+
+          std::shared_ptr<platf::img_t> img_out;
+          if (!pull_free_image_cb(img_out)) {
+            return capture_e::interrupted;
+          }
+
+          // The frame exists as of its deadline, however long it takes to draw
+          img_out->frame_timestamp = scheduler.next_deadline() - delay;
+          if (generator->draw(img_out->data, img_out->row_pitch, frame++)) {
+            return capture_e::error;
+          }
+
+          if (!push_captured_image_cb(std::move(img_out), true)) {
+            return capture_e::ok;
+          }
+        }
+
+        return capture_e::ok;
+      }
+
+      std::shared_ptr<img_t>
+      alloc_img() override {
+        auto img = std::make_shared<synthetic_img_t>();
+        img->width = width;
+        img->height = height;
+        img->pixel_pitch = 4;
+        img->row_pitch = img->pixel_pitch * width;
+        img->buffer.resize((std::size_t) img->row_pitch * height);
+        img->data = img->buffer.data();
+
+        return img;
+      }
+
+      int
+      dummy_img(img_t *img) override {
+        if (!img) {
+          return -1;
+        }
+
+        std::fill_n(img->data, (std::size_t) img->row_pitch * img->height, 0);
+        return 0;
+      }
+
+      std::unique_ptr<avcodec_encode_device_t>
+      make_avcodec_encode_device(pix_fmt_e pix_fmt) override {
+#ifdef SUNSHINE_BUILD_VAAPI
+        if (mem_type == mem_type_e::vaapi) {
+          return va::make_avcodec_encode_device(width, height, false);
+        }
+#endif
+
+#ifdef SUNSHINE_BUILD_CUDA
+        if (mem_type == mem_type_e::cuda) {
+          return cuda::make_avcodec_encode_device(width, height, false);
+        }
+#endif
+
+        return std::make_unique<avcodec_encode_device_t>();
+      }
+
+    private:
+      mem_type_e mem_type;
+      std::chrono::nanoseconds delay;
+
+      std::unique_ptr<synthetic::generator_t> generator;
+    };
+  }  // namespace
+
+  std::shared_ptr<display_t>
+  synthetic_display(mem_type_e hwdevice_type, const std::string &display_name, const ::video::config_t &config) {
+    if (hwdevice_type != mem_type_e::system && hwdevice_type != mem_type_e::vaapi && hwdevice_type != mem_type_e::cuda) {
+      BOOST_LOG(error) << "Could not initialize synthetic display with the given hw device type"sv;
+      return nullptr;
+    }
+
+    auto display = std::make_shared<synthetic_display_t>(hwdevice_type);
+    if (display->init(config)) {
+      return nullptr;
+    }
+
+    return display;
+  }
+
+  std::vector<std::string>
+  synthetic_display_names() {
+    return { "0"s };
+  }
+}  // namespace platf
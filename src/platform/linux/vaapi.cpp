@@ -545,11 +545,17 @@ namespace va {
       return false;
     }
 
-    if (video::active_hevc_mode > 1 && !query(display.get(), VAProfileHEVCMain)) {
+    int hevc_mode;
+    {
+      std::lock_guard lg { video::probe_result_lock };
+      hevc_mode = video::active_hevc_mode;
+    }
+
+    if (hevc_mode > 1 && !query(display.get(), VAProfileHEVCMain)) {
       return false;
     }
 
-    if (video::active_hevc_mode > 2 && !query(display.get(), VAProfileHEVCMain10)) {
+    if (hevc_mode > 2 && !query(display.get(), VAProfileHEVCMain10)) {
       return false;
     }
 
@@ -265,6 +265,12 @@ namespace wl {
     current_frame->destroy();
     current_frame = get_next_frame();
 
+    // The presentation clock is CLOCK_MONOTONIC, which backs std::chrono::steady_clock on Linux
+    auto seconds = std::chrono::seconds { ((std::uint64_t) tv_sec_hi << 32) | tv_sec_lo };
+    timestamp = std::chrono::steady_clock::time_point {
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(seconds + std::chrono::nanoseconds { tv_nsec })
+    };
+
     status = READY;
   }
 
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <bitset>
+#include <chrono>
+#include <optional>
 
 #ifdef SUNSHINE_BUILD_WAYLAND
   #include <wlr-export-dmabuf-unstable-v1.h>
@@ -91,6 +93,9 @@ namespace wl {
 
     status_e status;
 
+    // When the compositor presented the last ready frame, on the steady clock
+    std::optional<std::chrono::steady_clock::time_point> timestamp;
+
     std::array<frame_t, 2> frames;
     frame_t *current_frame;
 
@@ -9,6 +9,7 @@
 #include "src/logging.h"
 #include "src/video.h"
 
+#include "capture_scheduler.h"
 #include "cuda.h"
 #include "vaapi.h"
 #include "wayland.h"
@@ -127,23 +128,10 @@ namespace wl {
   public:
     platf::capture_e
     capture(const push_captured_image_cb_t &push_captured_image_cb, const pull_free_image_cb_t &pull_free_image_cb, bool *cursor) override {
-      auto next_frame = std::chrono::steady_clock::now();
-
-      sleep_overshoot_logger.reset();
+      platf::capture_scheduler_t scheduler { delay };
 
       while (true) {
-        auto now = std::chrono::steady_clock::now();
-
-        if (next_frame > now) {
-          std::this_thread::sleep_for(next_frame - now);
-          sleep_overshoot_logger.first_point(next_frame);
-          sleep_overshoot_logger.second_point_now_and_log();
-        }
-
-        next_frame += delay;
-        if (next_frame < now) {  // some major slowdown happened; we couldn't keep up
-          next_frame = now + delay;
-        }
+        scheduler.wait();
 
         std::shared_ptr<platf::img_t> img_out;
         auto status = snapshot(pull_free_image_cb, img_out, 1000ms, *cursor);
@@ -158,6 +146,11 @@ namespace wl {
             }
             break;
           case platf::capture_e::ok:
+            // Capture right after the compositor presents a frame
+            if (dmabuf.timestamp) {
+              scheduler.align(*dmabuf.timestamp);
+            }
+
             if (!push_captured_image_cb(std::move(img_out), true)) {
               return platf::capture_e::ok;
             }
@@ -262,23 +255,10 @@ namespace wl {
   public:
     platf::capture_e
     capture(const push_captured_image_cb_t &push_captured_image_cb, const pull_free_image_cb_t &pull_free_image_cb, bool *cursor) override {
-      auto next_frame = std::chrono::steady_clock::now();
-
-      sleep_overshoot_logger.reset();
+      platf::capture_scheduler_t scheduler { delay };
 
       while (true) {
-        auto now = std::chrono::steady_clock::now();
-
-        if (next_frame > now) {
-          std::this_thread::sleep_for(next_frame - now);
-          sleep_overshoot_logger.first_point(next_frame);
-          sleep_overshoot_logger.second_point_now_and_log();
-        }
-
-        next_frame += delay;
-        if (next_frame < now) {  // some major slowdown happened; we couldn't keep up
-          next_frame = now + delay;
-        }
+        scheduler.wait();
 
         std::shared_ptr<platf::img_t> img_out;
         auto status = snapshot(pull_free_image_cb, img_out, 1000ms, *cursor);
@@ -293,6 +273,11 @@ namespace wl {
             }
             break;
           case platf::capture_e::ok:
+            // Capture right after the compositor presents a frame
+            if (dmabuf.timestamp) {
+              scheduler.align(*dmabuf.timestamp);
+            }
+
             if (!push_captured_image_cb(std::move(img_out), true)) {
               return platf::capture_e::ok;
             }
@@ -4,6 +4,7 @@
  */
 #include "src/platform/common.h"
 
+#include <deque>
 #include <fstream>
 #include <thread>
 
@@ -14,15 +15,18 @@
 #include <X11/extensions/Xrandr.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
+#include <xcb/damage.h>
 #include <xcb/shm.h>
 #include <xcb/xfixes.h>
 
 #include "src/config.h"
+#include "src/cursor_blend.h"
 #include "src/globals.h"
 #include "src/logging.h"
 #include "src/task_pool.h"
 #include "src/video.h"
 
+#include "capture_scheduler.h"
 #include "cuda.h"
 #include "graphics.h"
 #include "misc.h"
@@ -61,6 +65,16 @@ namespace platf {
     _FN(CloseDisplay, int, (Display * display));
     _FN(Free, int, (void *data));
     _FN(InitThreads, Status, (void) );
+    _FN(QueryPointer, Bool,
+      (
+        Display * display,
+        Window w,
+        Window *root_return, Window *child_return,
+        int *root_x_return, int *root_y_return,
+        int *win_x_return, int *win_y_return,
+        unsigned int *mask_return));
+    _FN(Pending, int, (Display * display));
+    _FN(NextEvent, int, (Display * display, XEvent *event_return));
 
     namespace rr {
       _FN(GetScreenResources, XRRScreenResources *, (Display * dpy, Window window));
@@ -104,6 +118,8 @@ namespace platf {
     }  // namespace rr
     namespace fix {
       _FN(GetCursorImage, XFixesCursorImage *, (Display * dpy));
+      _FN(QueryExtension, Bool, (Display * dpy, int *event_base_return, int *error_base_return));
+      _FN(SelectCursorInput, void, (Display * dpy, Window win, unsigned long eventMask));
 
       static int
       init() {
@@ -121,6 +137,8 @@ namespace platf {
 
         std::vector<std::tuple<dyn::apiproc *, const char *>> funcs {
           { (dyn::apiproc *) &GetCursorImage, "XFixesGetCursorImage" },
+          { (dyn::apiproc *) &QueryExtension, "XFixesQueryExtension" },
+          { (dyn::apiproc *) &SelectCursorInput, "XFixesSelectCursorInput" },
         };
 
         if (dyn::load(handle, funcs)) {
@@ -153,6 +171,9 @@ namespace platf {
         { (dyn::apiproc *) &Free, "XFree" },
         { (dyn::apiproc *) &CloseDisplay, "XCloseDisplay" },
         { (dyn::apiproc *) &InitThreads, "XInitThreads" },
+        { (dyn::apiproc *) &QueryPointer, "XQueryPointer" },
+        { (dyn::apiproc *) &Pending, "XPending" },
+        { (dyn::apiproc *) &NextEvent, "XNextEvent" },
       };
 
       if (dyn::load(handle, funcs)) {
@@ -190,6 +211,8 @@ namespace platf {
         uint32_t shmid,
         uint8_t read_only));
 
+    _FN(shm_detach, xcb_void_cookie_t, (xcb_connection_t * c, xcb_shm_seg_t shmseg));
+
     _FN(get_extension_data, xcb_query_extension_reply_t *,
       (xcb_connection_t * c, xcb_extension_t *ext));
 
@@ -199,6 +222,87 @@ namespace platf {
     _FN(connect, xcb_connection_t *, (const char *displayname, int *screenp));
     _FN(setup_roots_iterator, xcb_screen_iterator_t, (const xcb_setup_t *R));
     _FN(generate_id, std::uint32_t, (xcb_connection_t * c));
+    _FN(poll_for_event, xcb_generic_event_t *, (xcb_connection_t * c));
+    _FN(flush, int, (xcb_connection_t * c));
+
+    namespace damage {
+      static xcb_extension_t *damage_id;
+      static xcb_extension_t *xfixes_id;
+
+      _FN(query_version, xcb_damage_query_version_cookie_t,
+        (xcb_connection_t * c, uint32_t client_major_version, uint32_t client_minor_version));
+      _FN(query_version_reply, xcb_damage_query_version_reply_t *,
+        (xcb_connection_t * c, xcb_damage_query_version_cookie_t cookie, xcb_generic_error_t **e));
+      _FN(create, xcb_void_cookie_t,
+        (xcb_connection_t * c, xcb_damage_damage_t damage, xcb_drawable_t drawable, uint8_t level));
+      _FN(destroy, xcb_void_cookie_t, (xcb_connection_t * c, xcb_damage_damage_t damage));
+      _FN(subtract, xcb_void_cookie_t,
+        (xcb_connection_t * c, xcb_damage_damage_t damage, xcb_xfixes_region_t repair, xcb_xfixes_region_t parts));
+
+      _FN(xfixes_query_version, xcb_xfixes_query_version_cookie_t,
+        (xcb_connection_t * c, uint32_t client_major_version, uint32_t client_minor_version));
+      _FN(xfixes_query_version_reply, xcb_xfixes_query_version_reply_t *,
+        (xcb_connection_t * c, xcb_xfixes_query_version_cookie_t cookie, xcb_generic_error_t **e));
+      _FN(create_region, xcb_void_cookie_t,
+        (xcb_connection_t * c, xcb_xfixes_region_t region, uint32_t rectangles_len, const xcb_rectangle_t *rectangles));
+      _FN(destroy_region, xcb_void_cookie_t, (xcb_connection_t * c, xcb_xfixes_region_t region));
+      _FN(fetch_region, xcb_xfixes_fetch_region_cookie_t, (xcb_connection_t * c, xcb_xfixes_region_t region));
+      _FN(fetch_region_reply, xcb_xfixes_fetch_region_reply_t *,
+        (xcb_connection_t * c, xcb_xfixes_fetch_region_cookie_t cookie, xcb_generic_error_t **e));
+      _FN(fetch_region_rectangles, xcb_rectangle_t *, (const xcb_xfixes_fetch_region_reply_t *R));
+      _FN(fetch_region_rectangles_length, int, (const xcb_xfixes_fetch_region_reply_t *R));
+
+      int
+      init() {
+        static void *damage_handle { nullptr };
+        static void *xfixes_handle { nullptr };
+        static bool funcs_loaded = false;
+
+        if (funcs_loaded) return 0;
+
+        if (!damage_handle) {
+          damage_handle = dyn::handle({ "libxcb-damage.so.0", "libxcb-damage.so" });
+          if (!damage_handle) {
+            return -1;
+          }
+        }
+
+        if (!xfixes_handle) {
+          xfixes_handle = dyn::handle({ "libxcb-xfixes.so.0", "libxcb-xfixes.so" });
+          if (!xfixes_handle) {
+            return -1;
+          }
+        }
+
+        std::vector<std::tuple<dyn::apiproc *, const char *>> damage_funcs {
+          { (dyn::apiproc *) &damage_id, "xcb_damage_id" },
+          { (dyn::apiproc *) &query_version, "xcb_damage_query_version" },
+          { (dyn::apiproc *) &query_version_reply, "xcb_damage_query_version_reply" },
+          { (dyn::apiproc *) &create, "xcb_damage_create" },
+          { (dyn::apiproc *) &destroy, "xcb_damage_destroy" },
+          { (dyn::apiproc *) &subtract, "xcb_damage_subtract" },
+        };
+
+        std::vector<std::tuple<dyn::apiproc *, const char *>> xfixes_funcs {
+          { (dyn::apiproc *) &xfixes_id, "xcb_xfixes_id" },
+          { (dyn::apiproc *) &xfixes_query_version, "xcb_xfixes_query_version" },
+          { (dyn::apiproc *) &xfixes_query_version_reply, "xcb_xfixes_query_version_reply" },
+          { (dyn::apiproc *) &create_region, "xcb_xfixes_create_region" },
+          { (dyn::apiproc *) &destroy_region, "xcb_xfixes_destroy_region" },
+          { (dyn::apiproc *) &fetch_region, "xcb_xfixes_fetch_region" },
+          { (dyn::apiproc *) &fetch_region_reply, "xcb_xfixes_fetch_region_reply" },
+          { (dyn::apiproc *) &fetch_region_rectangles, "xcb_xfixes_fetch_region_rectangles" },
+          { (dyn::apiproc *) &fetch_region_rectangles_length, "xcb_xfixes_fetch_region_rectangles_length" },
+        };
+
+        if (dyn::load(damage_handle, damage_funcs) || dyn::load(xfixes_handle, xfixes_funcs)) {
+          return -1;
+        }
+
+        funcs_loaded = true;
+        return 0;
+      }
+    }  // namespace damage
 
     int
     init_shm() {
@@ -219,6 +323,7 @@ namespace platf {
         { (dyn::apiproc *) &shm_get_image_reply, "xcb_shm_get_image_reply" },
         { (dyn::apiproc *) &shm_get_image_unchecked, "xcb_shm_get_image_unchecked" },
         { (dyn::apiproc *) &shm_attach, "xcb_shm_attach" },
+        { (dyn::apiproc *) &shm_detach, "xcb_shm_detach" },
       };
 
       if (dyn::load(handle, funcs)) {
@@ -251,6 +356,8 @@ namespace platf {
         { (dyn::apiproc *) &connect, "xcb_connect" },
         { (dyn::apiproc *) &setup_roots_iterator, "xcb_setup_roots_iterator" },
         { (dyn::apiproc *) &generate_id, "xcb_generate_id" },
+        { (dyn::apiproc *) &poll_for_event, "xcb_poll_for_event" },
+        { (dyn::apiproc *) &flush, "xcb_flush" },
       };
 
       if (dyn::load(handle, funcs)) {
@@ -269,8 +376,8 @@ namespace platf {
   void
   freeX(XFixesCursorImage *);
 
-  using xcb_connect_t = util::dyn_safe_ptr<xcb_connection_t, &xcb::disconnect>;
   using xcb_img_t = util::c_ptr<xcb_shm_get_image_reply_t>;
+  using xcb_region_t = util::c_ptr<xcb_xfixes_fetch_region_reply_t>;
 
   using ximg_t = util::safe_ptr<XImage, freeImage>;
   using xcursor_t = util::safe_ptr<XFixesCursorImage, freeX>;
@@ -326,61 +433,140 @@ namespace platf {
 
   struct shm_img_t: public img_t {
     ~shm_img_t() override {
-      delete[] data;
+      if (seg) {
+        xcb::shm_detach(xcb.get(), seg);
+        xcb::flush(xcb.get());
+      }
+
       data = nullptr;
     }
+
+    std::shared_ptr<xcb_connection_t> xcb;
+    std::uint32_t seg {};
+
+    shm_id_t shm_id;
+    shm_data_t shm_data;
+
+    // The screen content in the image, 0 if unknown
+    std::uint64_t sequence {};
+
+    // Where the cursor was blended into the image
+    std::optional<rect_t> cursor_rect;
   };
 
-  static void
-  blend_cursor(Display *display, img_t &img, int offsetX, int offsetY) {
-    xcursor_t overlay { x11::fix::GetCursorImage(display) };
+  /**
+   * @brief The cursor image, fetched from the server only when its shape changes.
+   *
+   * XFixes reports shape changes as CursorNotify events on a dedicated connection.
+   * Until one arrives, only the pointer position is queried and the pixels are reused.
+   */
+  class cursor_cache_t {
+  public:
+    int
+    init() {
+      xdisplay.reset(x11::OpenDisplay(nullptr));
+      if (!xdisplay) {
+        return -1;
+      }
+
+      int error_base;
+      notify = x11::fix::QueryExtension(xdisplay.get(), &event_base, &error_base);
+      if (notify) {
+        x11::fix::SelectCursorInput(xdisplay.get(), DefaultRootWindow(xdisplay.get()), XFixesDisplayCursorNotifyMask);
+      }
 
-    if (!overlay) {
-      BOOST_LOG(error) << "Couldn't get cursor from XFixesGetCursorImage"sv;
-      return;
+      valid = false;
+      return 0;
     }
 
-    overlay->x -= overlay->xhot;
-    overlay->y -= overlay->yhot;
+    /**
+     * @brief Bring the position, and the shape if it changed, up to date.
+     * @return false if the cursor is unavailable.
+     */
+    bool
+    update() {
+      auto display = xdisplay.get();
+      if (!display) {
+        return false;
+      }
 
-    overlay->x -= offsetX;
-    overlay->y -= offsetY;
+      bool shape_changed = !valid || !notify;
+      while (notify && x11::Pending(display)) {
+        XEvent event;
+        x11::NextEvent(display, &event);
 
-    overlay->x = std::max((short) 0, overlay->x);
-    overlay->y = std::max((short) 0, overlay->y);
+        if (event.type == event_base + XFixesCursorNotify) {
+          shape_changed = true;
+        }
+      }
 
-    auto pixels = (int *) img.data;
+      if (!shape_changed) {
+        Window root, child;
+        int root_x, root_y, win_x, win_y;
+        unsigned int mask;
+        if (x11::QueryPointer(display, DefaultRootWindow(display), &root, &child, &root_x, &root_y, &win_x, &win_y, &mask)) {
+          x = root_x - xhot;
+          y = root_y - yhot;
+          return true;
+        }
+      }
 
-    auto screen_height = img.height;
-    auto screen_width = img.width;
+      xcursor_t overlay { x11::fix::GetCursorImage(display) };
+      if (!overlay) {
+        BOOST_LOG(error) << "Couldn't get cursor from XFixesGetCursorImage"sv;
+        valid = false;
+        return false;
+      }
 
-    auto delta_height = std::min<uint16_t>(overlay->height, std::max(0, screen_height - overlay->y));
-    auto delta_width = std::min<uint16_t>(overlay->width, std::max(0, screen_width - overlay->x));
-    for (auto y = 0; y < delta_height; ++y) {
-      auto overlay_begin = &overlay->pixels[y * overlay->width];
-      auto overlay_end = &overlay->pixels[y * overlay->width + delta_width];
+      xhot = overlay->xhot;
+      yhot = overlay->yhot;
+      x = overlay->x - xhot;
+      y = overlay->y - yhot;
 
-      auto pixels_begin = &pixels[(y + overlay->y) * (img.row_pitch / img.pixel_pitch) + overlay->x];
+      if (!valid || overlay->cursor_serial != serial) {
+        // XFixes stores each 32-bit pixel in a long
+        width = overlay->width;
+        height = overlay->height;
+        pixels.resize(width * height);
+        std::copy_n(overlay->pixels, pixels.size(), std::begin(pixels));
 
-      std::for_each(overlay_begin, overlay_end, [&](long pixel) {
-        int *pixel_p = (int *) &pixel;
+        serial = overlay->cursor_serial;
+      }
 
-        auto colors_in = (uint8_t *) pixels_begin;
+      valid = true;
+      return true;
+    }
 
-        auto alpha = (*(uint *) pixel_p) >> 24u;
-        if (alpha == 255) {
-          *pixels_begin = *pixel_p;
-        }
-        else {
-          auto colors_out = (uint8_t *) pixel_p;
-          colors_in[0] = colors_out[0] + (colors_in[0] * (255 - alpha) + 255 / 2) / 255;
-          colors_in[1] = colors_out[1] + (colors_in[1] * (255 - alpha) + 255 / 2) / 255;
-          colors_in[2] = colors_out[2] + (colors_in[2] * (255 - alpha) + 255 / 2) / 255;
-        }
-        ++pixels_begin;
-      });
+    /**
+     * @brief Blend the cursor into an image.
+     * @param offsetX, offsetY Top left corner of the image on the root window.
+     */
+    void
+    blend(img_t &img, int offsetX, int offsetY) const {
+      cursor_blend::blend(img, pixels.data(), x - offsetX, y - offsetY, width, height);
     }
-  }
+
+    // Premultiplied BGRA
+    std::vector<std::uint32_t> pixels;
+
+    // Top left corner on the root window
+    int x {};
+    int y {};
+
+    int width {};
+    int height {};
+    unsigned long serial {};
+
+  private:
+    x11::xdisplay_t xdisplay;
+
+    int xhot {};
+    int yhot {};
+
+    int event_base {};
+    bool notify {};
+    bool valid {};
+  };
 
   struct x11_attr_t: public display_t {
     std::chrono::nanoseconds delay;
@@ -389,6 +575,9 @@ namespace platf {
     Window xwindow;
     XWindowAttributes xattr;
 
+    // Uses a connection of its own, the refresh task shares xdisplay
+    cursor_cache_t cursor_cache;
+
     mem_type_e mem_type;
 
     /**
@@ -413,6 +602,10 @@ namespace platf {
 
       xwindow = DefaultRootWindow(xdisplay.get());
 
+      if (cursor_cache.init()) {
+        BOOST_LOG(warning) << "Could not open X11 display for the cursor"sv;
+      }
+
       refresh();
 
       int streamedMonitor = -1;
@@ -479,23 +672,10 @@ namespace platf {
 
     capture_e
     capture(const push_captured_image_cb_t &push_captured_image_cb, const pull_free_image_cb_t &pull_free_image_cb, bool *cursor) override {
-      auto next_frame = std::chrono::steady_clock::now();
-
-      sleep_overshoot_logger.reset();
+      capture_scheduler_t scheduler { delay };
 
       while (true) {
-        auto now = std::chrono::steady_clock::now();
-
-        if (next_frame > now) {
-          std::this_thread::sleep_for(next_frame - now);
-          sleep_overshoot_logger.first_point(next_frame);
-          sleep_overshoot_logger.second_point_now_and_log();
-        }
-
-        next_frame += delay;
-        if (next_frame < now) {  // some major slowdown happened; we couldn't keep up
-          next_frame = now + delay;
-        }
+        scheduler.wait();
 
         std::shared_ptr<platf::img_t> img_out;
         auto status = snapshot(pull_free_image_cb, img_out, 1000ms, *cursor);
@@ -548,8 +728,8 @@ namespace platf {
       img->pixel_pitch = x_img->bits_per_pixel / 8;
       img->img.reset(x_img);
 
-      if (cursor) {
-        blend_cursor(xdisplay.get(), *img, offset_x, offset_y);
+      if (cursor && cursor_cache.update()) {
+        cursor_cache.blend(*img, offset_x, offset_y);
       }
 
       return capture_e::ok;
@@ -594,14 +774,25 @@ namespace platf {
   };
 
   struct shm_attr_t: public x11_attr_t {
-    x11::xdisplay_t shm_xdisplay;  // Prevent race condition with x11_attr_t::xdisplay
-    xcb_connect_t xcb;
+    // Shared with the images, which detach their segments on destruction
+    std::shared_ptr<xcb_connection_t> xcb;
     xcb_screen_t *display;
-    std::uint32_t seg;
 
-    shm_id_t shm_id;
+    // XDamage state, damage is 0 if the extension isn't available
+    std::uint32_t damage {};
+    std::uint32_t damage_region {};
+
+    // Damage between consecutive screen contents, used to bring an older image up to date
+    struct damage_history_t {
+      std::uint64_t sequence;  ///< The screen content this damage leads to
+      std::vector<rect_t> rects;
+    };
+    std::deque<damage_history_t> damage_history;
+    std::uint64_t sequence {};
 
-    shm_data_t data;
+    // Where the cursor was blended into the last captured frame
+    std::optional<rect_t> last_cursor_rect;
+    unsigned long last_cursor_serial {};
 
     task_pool_util::TaskPool::task_id_t refresh_task_id;
 
@@ -613,34 +804,27 @@ namespace platf {
     }
 
     shm_attr_t(mem_type_e mem_type):
-        x11_attr_t(mem_type), shm_xdisplay { x11::OpenDisplay(nullptr) } {
+        x11_attr_t(mem_type) {
       refresh_task_id = task_pool.pushDelayed(&shm_attr_t::delayed_refresh, 2s, this).task_id;
     }
 
     ~shm_attr_t() override {
       while (!task_pool.cancel(refresh_task_id))
         ;
+
+      if (damage) {
+        xcb::damage::destroy(xcb.get(), damage);
+        xcb::damage::destroy_region(xcb.get(), damage_region);
+        xcb::flush(xcb.get());
+      }
     }
 
     capture_e
     capture(const push_captured_image_cb_t &push_captured_image_cb, const pull_free_image_cb_t &pull_free_image_cb, bool *cursor) override {
-      auto next_frame = std::chrono::steady_clock::now();
-
-      sleep_overshoot_logger.reset();
+      capture_scheduler_t scheduler { delay };
 
       while (true) {
-        auto now = std::chrono::steady_clock::now();
-
-        if (next_frame > now) {
-          std::this_thread::sleep_for(next_frame - now);
-          sleep_overshoot_logger.first_point(next_frame);
-          sleep_overshoot_logger.second_point_now_and_log();
-        }
-
-        next_frame += delay;
-        if (next_frame < now) {  // some major slowdown happened; we couldn't keep up
-          next_frame = now + delay;
-        }
+        scheduler.wait();
 
         std::shared_ptr<platf::img_t> img_out;
         auto status = snapshot(pull_free_image_cb, img_out, 1000ms, *cursor);
@@ -675,31 +859,239 @@ namespace platf {
         BOOST_LOG(warning) << "X dimensions changed in SHM mode, request reinit"sv;
         return capture_e::reinit;
       }
+      else if (damage) {
+        return damage_snapshot(pull_free_image_cb, img_out, cursor);
+      }
       else {
-        auto img_cookie = xcb::shm_get_image_unchecked(xcb.get(), display->root, offset_x, offset_y, width, height, ~0, XCB_IMAGE_FORMAT_Z_PIXMAP, seg, 0);
-        auto frame_timestamp = std::chrono::steady_clock::now();
+        if (!pull_free_image_cb(img_out)) {
+          return platf::capture_e::interrupted;
+        }
+        auto img = (shm_img_t *) img_out.get();
 
-        xcb_img_t img_reply { xcb::shm_get_image_reply(xcb.get(), img_cookie, nullptr) };
-        if (!img_reply) {
-          BOOST_LOG(error) << "Could not get image reply"sv;
+        // The server writes straight into the segment backing the image
+        auto frame_timestamp = std::chrono::steady_clock::now();
+        if (fetch_bands(*img, { rect_t { 0, 0, width, height } })) {
           return capture_e::reinit;
         }
 
-        if (!pull_free_image_cb(img_out)) {
-          return platf::capture_e::interrupted;
+        img->frame_timestamp = frame_timestamp;
+        img->damage.clear();
+
+        if (cursor && cursor_cache.update()) {
+          cursor_cache.blend(*img, offset_x, offset_y);
+        }
+
+        return capture_e::ok;
+      }
+    }
+
+    /**
+     * @brief Capture only what changed since the image was last filled.
+     *
+     * The damage accumulated on the root window is fetched and reset in one round trip.
+     * Without damage and without cursor movement, the frame is skipped with capture_e::timeout.
+     * Otherwise the image is brought up to date by fetching the rows that changed since
+     * it was last filled, using the damage history.
+     */
+    capture_e
+    damage_snapshot(const pull_free_image_cb_t &pull_free_image_cb, std::shared_ptr<platf::img_t> &img_out, bool cursor) {
+      xcb::damage::subtract(xcb.get(), damage, XCB_NONE, damage_region);
+      auto region_cookie = xcb::damage::fetch_region(xcb.get(), damage_region);
+      auto frame_timestamp = std::chrono::steady_clock::now();
+
+      xcb_region_t region_reply { xcb::damage::fetch_region_reply(xcb.get(), region_cookie, nullptr) };
+      if (!region_reply) {
+        BOOST_LOG(error) << "Could not fetch the damaged region"sv;
+        return capture_e::reinit;
+      }
+
+      // DamageNotify events are not needed, the damage is polled
+      while (auto event = xcb::poll_for_event(xcb.get())) {
+        free(event);
+      }
+
+      std::vector<rect_t> rects;
+      if (sequence == 0) {
+        rects.emplace_back(rect_t { 0, 0, width, height });
+      }
+      else {
+        auto xrects = xcb::damage::fetch_region_rectangles(region_reply.get());
+        auto count = xcb::damage::fetch_region_rectangles_length(region_reply.get());
+        for (int x = 0; x < count; ++x) {
+          if (auto rect = clip(xrects[x].x - offset_x, xrects[x].y - offset_y, xrects[x].width, xrects[x].height)) {
+            rects.emplace_back(*rect);
+          }
         }
+      }
 
-        std::copy_n((std::uint8_t *) data.data, frame_size(), img_out->data);
-        img_out->frame_timestamp = frame_timestamp;
+      // The cursor image is only fetched again when its shape changed
+      bool cursor_visible = cursor && cursor_cache.update();
+      std::optional<rect_t> cursor_rect;
+      if (cursor_visible) {
+        cursor_rect = clip(cursor_cache.x - offset_x, cursor_cache.y - offset_y, cursor_cache.width, cursor_cache.height);
+      }
 
-        if (cursor) {
-          blend_cursor(shm_xdisplay.get(), *img_out, offset_x, offset_y);
+      auto cursor_moved = [](const std::optional<rect_t> &l, const std::optional<rect_t> &r) {
+        if (!l || !r) {
+          return l.has_value() != r.has_value();
         }
 
-        return capture_e::ok;
+        return l->x != r->x || l->y != r->y || l->width != r->width || l->height != r->height;
+      };
+
+      bool cursor_changed = cursor_moved(cursor_rect, last_cursor_rect) || (cursor_visible && cursor_cache.serial != last_cursor_serial);
+      if (rects.empty() && !cursor_changed) {
+        return capture_e::timeout;
+      }
+
+      damage_history.emplace_back(damage_history_t { ++sequence, rects });
+      if (damage_history.size() > max_damage_history) {
+        damage_history.pop_front();
+      }
+
+      if (!pull_free_image_cb(img_out)) {
+        return platf::capture_e::interrupted;
+      }
+      auto img = (shm_img_t *) img_out.get();
+
+      if (fetch_bands(*img, stale_rects(*img))) {
+        return capture_e::reinit;
+      }
+
+      img->sequence = sequence;
+      img->frame_timestamp = frame_timestamp;
+
+      img->damage = std::move(rects);
+      if (cursor_changed) {
+        // The area under the old cursor must be repainted as well
+        for (auto &rect : { last_cursor_rect, cursor_rect }) {
+          if (rect) {
+            img->damage.emplace_back(*rect);
+          }
+        }
+      }
+
+      if (cursor_visible) {
+        last_cursor_serial = cursor_cache.serial;
+        cursor_cache.blend(*img, offset_x, offset_y);
+      }
+      img->cursor_rect = cursor_rect;
+      last_cursor_rect = cursor_rect;
+
+      return capture_e::ok;
+    }
+
+    /**
+     * @brief Everything that differs between the image and the current screen content.
+     */
+    std::vector<rect_t>
+    stale_rects(const shm_img_t &img) {
+      if (img.sequence == 0 || damage_history.empty() || damage_history.front().sequence > img.sequence + 1) {
+        return { rect_t { 0, 0, width, height } };
+      }
+
+      std::vector<rect_t> rects;
+      for (auto &entry : damage_history) {
+        if (entry.sequence > img.sequence) {
+          rects.insert(std::end(rects), std::begin(entry.rects), std::end(entry.rects));
+        }
+      }
+
+      // The cursor was blended into the image
+      if (img.cursor_rect) {
+        rects.emplace_back(*img.cursor_rect);
+      }
+
+      return rects;
+    }
+
+    /**
+     * @brief Fetch the rows covered by the given rectangles straight into the image's SHM segment.
+     *
+     * Full rows are fetched, since xcb_shm_get_image() writes tightly packed:
+     * a band of full rows has the same layout in the reply as in the image.
+     * All requests are issued before waiting on the first reply.
+     * @return 0 on success, -1 on failure.
+     */
+    int
+    fetch_bands(shm_img_t &img, const std::vector<rect_t> &rects) {
+      constexpr std::size_t max_requests = 16;
+
+      if (rects.empty()) {
+        return 0;
+      }
+
+      std::vector<std::pair<int, int>> bands;
+      bands.reserve(rects.size());
+      for (auto &rect : rects) {
+        bands.emplace_back(rect.y, rect.y + rect.height);
+      }
+
+      // Merge overlapping and adjacent bands
+      std::sort(std::begin(bands), std::end(bands));
+      auto last = std::begin(bands);
+      for (auto it = std::next(last); it != std::end(bands); ++it) {
+        if (it->first <= last->second) {
+          last->second = std::max(last->second, it->second);
+        }
+        else {
+          *++last = *it;
+        }
+      }
+      bands.erase(std::next(last), std::end(bands));
+
+      if (bands.size() > max_requests) {
+        bands = { { bands.front().first, bands.back().second } };
+      }
+
+      std::vector<xcb_shm_get_image_cookie_t> cookies;
+      cookies.reserve(bands.size());
+      for (auto &[top, bottom] : bands) {
+        cookies.emplace_back(xcb::shm_get_image_unchecked(
+          xcb.get(), display->root, offset_x, offset_y + top, width, bottom - top, ~0, XCB_IMAGE_FORMAT_Z_PIXMAP, img.seg, top * img.row_pitch));
+      }
+
+      // All replies must be collected, even after an error
+      int status = 0;
+      for (auto &cookie : cookies) {
+        xcb_img_t img_reply { xcb::shm_get_image_reply(xcb.get(), cookie, nullptr) };
+        if (!img_reply) {
+          BOOST_LOG(error) << "Could not get image reply"sv;
+          status = -1;
+        }
+      }
+
+      if (status) {
+        // The content of the image is unknown now
+        img.sequence = 0;
       }
+
+      return status;
     }
 
+    /**
+     * @brief Translate a rectangle from root window coordinates relative to the captured area and clip it.
+     */
+    std::optional<rect_t>
+    clip(int x, int y, int w, int h) {
+      auto left = std::max(x, 0);
+      auto top = std::max(y, 0);
+      auto right = std::min(x + w, width);
+      auto bottom = std::min(y + h, height);
+
+      if (left >= right || top >= bottom) {
+        return std::nullopt;
+      }
+
+      return rect_t { left, top, right - left, bottom - top };
+    }
+
+    /**
+     * @brief Allocate an image backed by its own SHM segment, attached to the X server.
+     *
+     * The capture pool holds several of these, so the server can write the next frame
+     * into one image while the encoder is still converting another.
+     */
     std::shared_ptr<img_t>
     alloc_img() override {
       auto img = std::make_shared<shm_img_t>();
@@ -707,7 +1099,23 @@ namespace platf {
       img->height = height;
       img->pixel_pitch = 4;
       img->row_pitch = img->pixel_pitch * width;
-      img->data = new std::uint8_t[height * img->row_pitch];
+
+      img->shm_id.id = shmget(IPC_PRIVATE, frame_size(), IPC_CREAT | 0777);
+      if (img->shm_id.id == -1) {
+        BOOST_LOG(error) << "shmget failed"sv;
+        return nullptr;
+      }
+
+      img->shm_data.data = shmat(img->shm_id.id, nullptr, 0);
+      if ((uintptr_t) img->shm_data.data == -1) {
+        BOOST_LOG(error) << "shmat failed"sv;
+        return nullptr;
+      }
+
+      img->xcb = xcb;
+      img->seg = xcb::generate_id(xcb.get());
+      xcb::shm_attach(xcb.get(), img->seg, img->shm_id.id, false);
+      img->data = (std::uint8_t *) img->shm_data.data;
 
       return img;
     }
@@ -723,8 +1131,7 @@ namespace platf {
         return 1;
       }
 
-      shm_xdisplay.reset(x11::OpenDisplay(nullptr));
-      xcb.reset(xcb::connect(nullptr, nullptr));
+      xcb.reset(xcb::connect(nullptr, nullptr), xcb::disconnect);
       if (xcb::connection_has_error(xcb.get())) {
         return -1;
       }
@@ -737,30 +1144,61 @@ namespace platf {
 
       auto iter = xcb::setup_roots_iterator(xcb::get_setup(xcb.get()));
       display = iter.data;
-      seg = xcb::generate_id(xcb.get());
 
-      shm_id.id = shmget(IPC_PRIVATE, frame_size(), IPC_CREAT | 0777);
-      if (shm_id.id == -1) {
-        BOOST_LOG(error) << "shmget failed"sv;
+      // Make sure SHM segments can be created, so we can fall back otherwise
+      if (!alloc_img()) {
         return -1;
       }
 
-      xcb::shm_attach(xcb.get(), seg, shm_id.id, false);
-      data.data = shmat(shm_id.id, nullptr, 0);
+      init_damage();
 
-      if ((uintptr_t) data.data == -1) {
-        BOOST_LOG(error) << "shmat failed"sv;
+      return 0;
+    }
 
-        return -1;
+    /**
+     * @brief Subscribe to XDamage on the root window, so unchanged frames can be skipped.
+     *
+     * Capture falls back to fetching every frame in full if XDamage isn't available.
+     */
+    void
+    init_damage() {
+      if (xcb::damage::init()) {
+        BOOST_LOG(info) << "libxcb-damage or libxcb-xfixes not found, capturing full frames"sv;
+        return;
       }
 
-      return 0;
+      if (!xcb::get_extension_data(xcb.get(), xcb::damage::damage_id)->present ||
+          !xcb::get_extension_data(xcb.get(), xcb::damage::xfixes_id)->present) {
+        BOOST_LOG(info) << "Missing DAMAGE or XFIXES extension, capturing full frames"sv;
+        return;
+      }
+
+      // The versions must be negotiated before any other request of the extensions
+      auto xfixes_cookie = xcb::damage::xfixes_query_version(xcb.get(), XCB_XFIXES_MAJOR_VERSION, XCB_XFIXES_MINOR_VERSION);
+      auto damage_cookie = xcb::damage::query_version(xcb.get(), XCB_DAMAGE_MAJOR_VERSION, XCB_DAMAGE_MINOR_VERSION);
+      util::c_ptr<xcb_xfixes_query_version_reply_t> xfixes_version { xcb::damage::xfixes_query_version_reply(xcb.get(), xfixes_cookie, nullptr) };
+      util::c_ptr<xcb_damage_query_version_reply_t> damage_version { xcb::damage::query_version_reply(xcb.get(), damage_cookie, nullptr) };
+      if (!xfixes_version || xfixes_version->major_version < 2 || !damage_version) {
+        BOOST_LOG(info) << "Unsupported DAMAGE or XFIXES version, capturing full frames"sv;
+        return;
+      }
+
+      damage_region = xcb::generate_id(xcb.get());
+      xcb::damage::create_region(xcb.get(), damage_region, 0, nullptr);
+
+      damage = xcb::generate_id(xcb.get());
+      xcb::damage::create(xcb.get(), damage, display->root, XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+      xcb::flush(xcb.get());
+
+      BOOST_LOG(info) << "Using XDamage to capture only changed areas"sv;
     }
 
     std::uint32_t
     frame_size() {
       return width * height * 4;
     }
+
+    static constexpr std::size_t max_damage_history = 16;
   };
 
   std::shared_ptr<display_t>
@@ -907,7 +1345,15 @@ namespace platf {
 
     void
     cursor_t::blend(img_t &img, int offsetX, int offsetY) {
-      blend_cursor((xdisplay_t::pointer) ctx.get(), img, offsetX, offsetY);
+      xcursor_t overlay { fix::GetCursorImage((xdisplay_t::pointer) ctx.get()) };
+      if (!overlay) {
+        BOOST_LOG(error) << "Couldn't get cursor from XFixesGetCursorImage"sv;
+        return;
+      }
+
+      // XFixes stores each 32-bit pixel in a long
+      std::vector<std::uint32_t> pixels(overlay->pixels, overlay->pixels + overlay->width * overlay->height);
+      cursor_blend::blend(img, pixels.data(), overlay->x - overlay->xhot - offsetX, overlay->y - overlay->yhot - offsetY, overlay->width, overlay->height);
     }
 
     xdisplay_t
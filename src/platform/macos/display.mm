@@ -2,6 +2,9 @@
  * @file src/platform/macos/display.mm
  * @brief Definitions for display capture on macOS.
  */
+#include <cstring>
+#include <sys/sysctl.h>
+
 #include "src/platform/common.h"
 #include "src/platform/macos/av_img_t.h"
 #include "src/platform/macos/av_video.h"
@@ -216,4 +219,31 @@ namespace platf {
     // We don't track GPU state, so we will always reenumerate. Fortunately, it is fast on macOS.
     return true;
   }
+
+  std::string
+  encoder_adapter_identity() {
+    // VideoToolbox ships with the OS, so the machine and OS build identify it
+    auto sysctl_string = [](const char *name) {
+      std::size_t size = 0;
+      if (sysctlbyname(name, nullptr, &size, nullptr, 0) || !size) {
+        return std::string {};
+      }
+
+      std::string value(size, '\0');
+      if (sysctlbyname(name, value.data(), &size, nullptr, 0)) {
+        return std::string {};
+      }
+
+      value.resize(std::strlen(value.c_str()));
+      return value;
+    };
+
+    auto model = sysctl_string("hw.model");
+    auto os_version = sysctl_string("kern.osversion");
+    if (model.empty() || os_version.empty()) {
+      return {};
+    }
+
+    return model + " macOS "s + os_version;
+  }
 }  // namespace platf
@@ -15,6 +15,7 @@
 #include <ifaddrs.h>
 #include <mach-o/dyld.h>
 #include <net/if_dl.h>
+#include <pthread.h>
 #include <pwd.h>
 
 #include "misc.h"
@@ -227,6 +228,36 @@ namespace platf {
     // Unimplemented
   }
 
+  void
+  set_thread_name(std::string_view name) {
+    std::string tmp { name };
+    pthread_setname_np(tmp.c_str());
+  }
+
+  int
+  set_thread_affinity(const std::vector<int> &cpus) {
+    // macOS doesn't allow pinning threads to CPUs
+    BOOST_LOG(debug) << "Thread affinity is not supported on macOS"sv;
+    return -1;
+  }
+
+  std::vector<int>
+  numa_node_cpus(int node) {
+    return {};
+  }
+
+  thread_info_t
+  current_thread_info() {
+    std::uint64_t tid = 0;
+    pthread_threadid_np(nullptr, &tid);
+
+    int policy;
+    sched_param param {};
+    pthread_getschedparam(pthread_self(), &policy, &param);
+
+    return { (std::int64_t) tid, {}, "priority "s + std::to_string(param.sched_priority) };
+  }
+
   void
   streaming_will_start() {
     // Nothing to do
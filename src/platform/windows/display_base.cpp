@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cmath>
 #include <initguid.h>
+#include <sstream>
 #include <thread>
 
 #include <boost/algorithm/string/join.hpp>
@@ -1236,6 +1237,40 @@ namespace platf {
     return adapter_names;
   }
 
+  std::string
+  encoder_adapter_identity() {
+    HRESULT status;
+
+    dxgi::factory1_t factory;
+    status = CreateDXGIFactory1(IID_IDXGIFactory1, (void **) &factory);
+    if (FAILED(status)) {
+      BOOST_LOG(error) << "Failed to create DXGIFactory1 [0x"sv << util::hex(status).to_string_view() << ']';
+      return {};
+    }
+
+    std::stringstream identity;
+
+    dxgi::adapter_t adapter;
+    for (int x = 0; factory->EnumAdapters1(x, &adapter) != DXGI_ERROR_NOT_FOUND; ++x) {
+      DXGI_ADAPTER_DESC1 adapter_desc;
+      adapter->GetDesc1(&adapter_desc);
+
+      // The user mode driver version changes with every driver update
+      LARGE_INTEGER driver_version {};
+      adapter->CheckInterfaceSupport(IID_IDXGIDevice, &driver_version);
+
+      identity << to_utf8(adapter_desc.Description)
+               << " ["sv << util::hex(adapter_desc.VendorId).to_string_view()
+               << ':' << util::hex(adapter_desc.DeviceId).to_string_view()
+               << ':' << util::hex(adapter_desc.SubSysId).to_string_view()
+               << ':' << util::hex(adapter_desc.Revision).to_string_view()
+               << "] driver "sv << HIWORD(driver_version.HighPart) << '.' << LOWORD(driver_version.HighPart)
+               << '.' << HIWORD(driver_version.LowPart) << '.' << LOWORD(driver_version.LowPart) << ';';
+    }
+
+    return identity.str();
+  }
+
   /**
    * @brief Returns if GPUs/drivers have changed since the last call to this function.
    * @return `true` if a change has occurred or if it is unknown whether a change occurred.
@@ -1229,6 +1229,94 @@ namespace platf {
     }
   }
 
+  void
+  set_thread_name(std::string_view name) {
+    auto wname = from_utf8(std::string { name });
+    SetThreadDescription(GetCurrentThread(), wname.c_str());
+  }
+
+  int
+  set_thread_affinity(const std::vector<int> &cpus) {
+    GROUP_AFFINITY current {};
+    if (!GetThreadGroupAffinity(GetCurrentThread(), &current)) {
+      return -1;
+    }
+
+    // A thread can only be restricted to CPUs of a single processor group, use the group of the first CPU
+    GROUP_AFFINITY affinity {};
+    affinity.Group = cpus.empty() ? current.Group : (WORD) (cpus.front() / 64);
+    for (auto cpu : cpus) {
+      if (cpu / 64 == affinity.Group) {
+        affinity.Mask |= KAFFINITY { 1 } << (cpu % 64);
+      }
+      else {
+        BOOST_LOG(warning) << "CPU "sv << cpu << " is not in processor group "sv << affinity.Group << ", ignoring it"sv;
+      }
+    }
+
+    if (!SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr)) {
+      auto winerr = GetLastError();
+      BOOST_LOG(debug) << "SetThreadGroupAffinity() failed: "sv << winerr;
+      return -1;
+    }
+
+    return 0;
+  }
+
+  std::vector<int>
+  numa_node_cpus(int node) {
+    GROUP_AFFINITY affinity {};
+    if (!GetNumaNodeProcessorMaskEx((USHORT) node, &affinity)) {
+      return {};
+    }
+
+    std::vector<int> cpus;
+    for (int bit = 0; bit < 64; ++bit) {
+      if (affinity.Mask & (KAFFINITY { 1 } << bit)) {
+        cpus.emplace_back(affinity.Group * 64 + bit);
+      }
+    }
+
+    return cpus;
+  }
+
+  thread_info_t
+  current_thread_info() {
+    thread_info_t info { GetCurrentThreadId(), {}, {} };
+
+    GROUP_AFFINITY affinity {};
+    if (GetThreadGroupAffinity(GetCurrentThread(), &affinity)) {
+      for (int bit = 0; bit < 64; ++bit) {
+        if (affinity.Mask & (KAFFINITY { 1 } << bit)) {
+          info.cpus.emplace_back(affinity.Group * 64 + bit);
+        }
+      }
+    }
+
+    switch (GetThreadPriority(GetCurrentThread())) {
+      case THREAD_PRIORITY_BELOW_NORMAL:
+        info.scheduling = "THREAD_PRIORITY_BELOW_NORMAL"s;
+        break;
+      case THREAD_PRIORITY_NORMAL:
+        info.scheduling = "THREAD_PRIORITY_NORMAL"s;
+        break;
+      case THREAD_PRIORITY_ABOVE_NORMAL:
+        info.scheduling = "THREAD_PRIORITY_ABOVE_NORMAL"s;
+        break;
+      case THREAD_PRIORITY_HIGHEST:
+        info.scheduling = "THREAD_PRIORITY_HIGHEST"s;
+        break;
+      case THREAD_PRIORITY_TIME_CRITICAL:
+        info.scheduling = "THREAD_PRIORITY_TIME_CRITICAL"s;
+        break;
+      default:
+        info.scheduling = "thread priority "s + std::to_string(GetThreadPriority(GetCurrentThread()));
+        break;
+    }
+
+    return info;
+  }
+
   void
   streaming_will_start() {
     static std::once_flag load_wlanapi_once_flag;
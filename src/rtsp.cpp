@@ -837,15 +837,24 @@ namespace rtsp_stream {
     ss << "a=x-ss-general.encryptionSupported:" << encryption_flags_supported << std::endl;
     ss << "a=x-ss-general.encryptionRequested:" << encryption_flags_requested << std::endl;
 
-    if (video::last_encoder_probe_supported_ref_frames_invalidation) {
+    bool ref_frames_invalidation;
+    int hevc_mode, av1_mode;
+    {
+      std::lock_guard lg { video::probe_result_lock };
+      ref_frames_invalidation = video::last_encoder_probe_supported_ref_frames_invalidation;
+      hevc_mode = video::active_hevc_mode;
+      av1_mode = video::active_av1_mode;
+    }
+
+    if (ref_frames_invalidation) {
       ss << "a=x-nv-video[0].refPicInvalidation:1"sv << std::endl;
     }
 
-    if (video::active_hevc_mode != 1) {
+    if (hevc_mode != 1) {
       ss << "sprop-parameter-sets=AAAAAU"sv << std::endl;
     }
 
-    if (video::active_av1_mode != 1) {
+    if (av1_mode != 1) {
       ss << "a=rtpmap:98 AV1/90000"sv << std::endl;
     }
 
@@ -1148,14 +1157,21 @@ namespace rtsp_stream {
       config.monitor.bitrate = configuredBitrateKbps;
     }
 
-    if (config.monitor.videoFormat == 1 && video::active_hevc_mode == 1) {
+    int hevc_mode, av1_mode;
+    {
+      std::lock_guard lg { video::probe_result_lock };
+      hevc_mode = video::active_hevc_mode;
+      av1_mode = video::active_av1_mode;
+    }
+
+    if (config.monitor.videoFormat == 1 && hevc_mode == 1) {
       BOOST_LOG(warning) << "HEVC is disabled, yet the client requested HEVC"sv;
 
       respond(sock, session, &option, 400, "BAD REQUEST", req->sequenceNumber, {});
       return;
     }
 
-    if (config.monitor.videoFormat == 2 && video::active_av1_mode == 1) {
+    if (config.monitor.videoFormat == 2 && av1_mode == 1) {
       BOOST_LOG(warning) << "AV1 is disabled, yet the client requested AV1"sv;
 
       respond(sock, session, &option, 400, "BAD REQUEST", req->sequenceNumber, {});
@@ -0,0 +1,220 @@
+/**
+ * @file src/shared_convert.cpp
+ * @brief Definitions for the color conversion shared by the sessions encoding the same images.
+ */
+// standard includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+// local includes
+#include "config.h"
+#include "logging.h"
+#include "platform/common.h"
+#include "shared_convert.h"
+
+using namespace std::literals;
+
+namespace video {
+  namespace {
+    // Displays of different sizes would discard the converter and tiers of each other in a shared stage
+    using stage_key_t = std::tuple<AVPixelFormat, colorspace_e, bool, unsigned, int, int>;
+
+    std::mutex stages_lock;
+    std::map<stage_key_t, std::weak_ptr<shared_convert_t>> stages;
+
+    /**
+     * @brief Make a frame reference the buffers of another, keeping its own properties and side data.
+     */
+    int
+    ref_buffers(AVFrame *frame, const AVFrame *src) {
+      for (int x = 0; x < AV_NUM_DATA_POINTERS; ++x) {
+        av_buffer_unref(&frame->buf[x]);
+        if (src->buf[x]) {
+          frame->buf[x] = av_buffer_ref(src->buf[x]);
+          if (!frame->buf[x]) {
+            return -1;
+          }
+        }
+
+        frame->data[x] = src->data[x];
+        frame->linesize[x] = src->linesize[x];
+      }
+      frame->extended_data = frame->data;
+
+      return 0;
+    }
+  }  // namespace
+
+  std::shared_ptr<shared_convert_t>
+  shared_convert_t::get(AVPixelFormat format, const sunshine_colorspace_t &colorspace, int width, int height) {
+    if (!color_convert::converter_t::supported(format)) {
+      return nullptr;
+    }
+
+    stage_key_t key { format, colorspace.colorspace, colorspace.full_range, colorspace.bit_depth, width, height };
+
+    std::lock_guard lg { stages_lock };
+
+    // Forget the stages destroyed with their last session
+    std::erase_if(stages, [](const auto &entry) {
+      return entry.second.expired();
+    });
+
+    auto &stage_wp = stages[key];
+    auto stage = stage_wp.lock();
+    if (!stage) {
+      stage = std::make_shared<shared_convert_t>(format, colorspace);
+      stage_wp = stage;
+    }
+
+    return stage;
+  }
+
+  shared_convert_t::shared_convert_t(AVPixelFormat format, const sunshine_colorspace_t &colorspace):
+      _format { format }, _colorspace { colorspace } {}
+
+  int
+  shared_convert_t::convert(platf::img_t &img, AVFrame *frame) {
+    std::lock_guard lg { _lock };
+
+    // The sessions encoding the same display receive the same images,
+    // an image without a capture time can't be told apart from the previous one though
+    if (&img != _img || !img.frame_timestamp || img.frame_timestamp != _img_timestamp) {
+      if (convert_full(img, frame)) {
+        return -1;
+      }
+
+      _img = &img;
+      _img_timestamp = img.frame_timestamp;
+      ++_sequence;
+    }
+
+    auto tier = std::find_if(std::begin(_tiers), std::end(_tiers), [frame](const tier_t &tier) {
+      return tier.width == frame->width && tier.height == frame->height;
+    });
+    if (tier == std::end(_tiers)) {
+      BOOST_LOG(info) << "Sharing the "sv << av_get_pix_fmt_name(_format) << " conversion of "sv
+                      << _full->width << 'x' << _full->height << " images at "sv << frame->width << 'x' << frame->height;
+
+      tier = _tiers.insert(std::end(_tiers), tier_t { frame->width, frame->height });
+    }
+
+    if (tier->sequence != _sequence) {
+      if (convert_tier(*tier, frame)) {
+        return -1;
+      }
+
+      tier->sequence = _sequence;
+    }
+
+    // The picture type, timestamps and HDR metadata are set by the session
+    return ref_buffers(frame, tier->current.get());
+  }
+
+  std::uint64_t
+  shared_convert_t::conversions() {
+    std::lock_guard lg { _lock };
+    return _sequence;
+  }
+
+  AVFrame *
+  shared_convert_t::acquire(std::vector<avcodec_frame_t> &frames, const AVFrame *props, int width, int height) {
+    for (auto &frame : frames) {
+      if (av_frame_is_writable(frame.get())) {
+        return frame.get();
+      }
+    }
+
+    avcodec_frame_t frame { av_frame_alloc() };
+    frame->format = _format;
+    frame->width = width;
+    frame->height = height;
+    if (av_frame_copy_props(frame.get(), props) < 0 || av_frame_get_buffer(frame.get(), 0) < 0) {
+      return nullptr;
+    }
+
+    // Only the image is written from now on, the aspect ratio padding stays black
+    ptrdiff_t linesize[4] = { frame->linesize[0], frame->linesize[1], frame->linesize[2], frame->linesize[3] };
+    av_image_fill_black(frame->data, linesize, _format, frame->color_range, width, height);
+
+    return frames.emplace_back(std::move(frame)).get();
+  }
+
+  int
+  shared_convert_t::convert_full(platf::img_t &img, const AVFrame *props) {
+    // A new display resolution invalidates everything derived from the previous one
+    if (!_full || _full->width != img.width || _full->height != img.height) {
+      _converter = std::make_unique<color_convert::converter_t>(_format, _colorspace, img.width, img.height, config::video.min_threads);
+      _full_frames.clear();
+      _full.reset();
+      _tiers.clear();
+    }
+
+    auto full = acquire(_full_frames, props, img.width, img.height);
+    if (!full) {
+      return -1;
+    }
+
+    _converter->convert(img.data, img.row_pitch, full->data, full->linesize);
+    _full.reset(av_frame_clone(full));
+
+    return _full ? 0 : -1;
+  }
+
+  int
+  shared_convert_t::convert_tier(tier_t &tier, const AVFrame *props) {
+    // Ensure aspect ratio is maintained, like the software encode device
+    auto scalar = std::fminf((float) tier.width / _full->width, (float) tier.height / _full->height);
+    int out_width = _full->width * scalar;
+    int out_height = _full->height * scalar;
+
+    // Result is always positive
+    auto offset_w = (tier.width - out_width) / 2;
+    auto offset_h = (tier.height - out_height) / 2;
+
+    // Nothing to scale nor pad, the sessions share the full resolution frame
+    if (out_width == tier.width && out_height == tier.height && out_width == _full->width && out_height == _full->height) {
+      tier.current.reset(av_frame_clone(_full.get()));
+      return tier.current ? 0 : -1;
+    }
+
+    // Same format and range on both ends, only the size changes
+    if (!tier.sws) {
+      tier.sws.reset(sws_getContext(_full->width, _full->height, _format, out_width, out_height, _format, SWS_BILINEAR, nullptr, nullptr, nullptr));
+      if (!tier.sws) {
+        return -1;
+      }
+    }
+
+    auto frame = acquire(tier.frames, props, tier.width, tier.height);
+    if (!frame) {
+      return -1;
+    }
+
+    {
+      // The view references the frame, it must be gone before the frame can be reused
+      avcodec_frame_t view { av_frame_alloc() };
+      if (frame_view(view.get(), frame, offset_w, offset_h, out_width, out_height)) {
+        return -1;
+      }
+
+      auto status = sws_scale_frame(tier.sws.get(), view.get(), _full.get());
+      if (status < 0) {
+        char string[AV_ERROR_MAX_STRING_SIZE];
+        BOOST_LOG(error) << "Couldn't scale frame: "sv << av_make_error_string(string, AV_ERROR_MAX_STRING_SIZE, status);
+        return -1;
+      }
+    }
+
+    tier.current.reset(av_frame_clone(frame));
+
+    return tier.current ? 0 : -1;
+  }
+}  // namespace video
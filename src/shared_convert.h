@@ -0,0 +1,101 @@
+/**
+ * @file src/shared_convert.h
+ * @brief Declarations for the color conversion shared by the sessions encoding the same images.
+ */
+#pragma once
+
+// standard includes
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// local includes
+#include "color_convert.h"
+#include "video.h"
+
+namespace platf {
+  struct img_t;
+}
+
+namespace video {
+  /**
+   * @brief Converts each captured image once for all the sessions encoding it in the same format and colorspace.
+   *
+   * The image is converted at full resolution, then scaled down once per tier,
+   * i.e. per frame size requested by the sessions. The sessions' frames reference
+   * the converted tiers, whose buffers are only reused once no frame references them anymore.
+   */
+  class shared_convert_t {
+  public:
+    /**
+     * @brief Get the stage for a format and colorspace, creating it if needed.
+     * @param width The width of the captured images.
+     * @param height The height of the captured images.
+     * @return The stage, or nullptr if the format isn't supported.
+     */
+    static std::shared_ptr<shared_convert_t>
+    get(AVPixelFormat format, const sunshine_colorspace_t &colorspace, int width, int height);
+
+    shared_convert_t(AVPixelFormat format, const sunshine_colorspace_t &colorspace);
+
+    /**
+     * @brief Make a frame reference an image converted to its size.
+     *
+     * The image is scaled to fit the frame with the aspect ratio preserved, the borders are black.
+     * @param img The captured image.
+     * @param frame The frame of the session. Its properties and side data are kept, its buffers are replaced.
+     * @return 0 on success, -1 otherwise.
+     */
+    int
+    convert(platf::img_t &img, AVFrame *frame);
+
+    /**
+     * @return The number of images converted at full resolution.
+     */
+    std::uint64_t
+    conversions();
+
+  private:
+    struct tier_t {
+      int width;
+      int height;
+
+      sws_t sws;
+      std::vector<avcodec_frame_t> frames;
+
+      // The converted image at the size of this tier, and the image it was converted from
+      avcodec_frame_t current;
+      std::uint64_t sequence {};
+    };
+
+    /**
+     * @brief Get a frame none of the sessions references anymore.
+     */
+    AVFrame *
+    acquire(std::vector<avcodec_frame_t> &frames, const AVFrame *props, int width, int height);
+
+    int
+    convert_full(platf::img_t &img, const AVFrame *props);
+
+    int
+    convert_tier(tier_t &tier, const AVFrame *props);
+
+    std::mutex _lock;
+
+    AVPixelFormat _format;
+    sunshine_colorspace_t _colorspace;
+
+    // The last image converted, identified by its address and capture time
+    const platf::img_t *_img {};
+    std::optional<std::chrono::steady_clock::time_point> _img_timestamp;
+    std::uint64_t _sequence {};
+
+    std::unique_ptr<color_convert::converter_t> _converter;
+    std::vector<avcodec_frame_t> _full_frames;
+    avcodec_frame_t _full;
+
+    std::vector<tier_t> _tiers;
+  };
+}  // namespace video
@@ -29,6 +29,7 @@ extern "C" {
 #include "stream.h"
 #include "sync.h"
 #include "system_tray.h"
+#include "thread_placement.h"
 #include "thread_safe.h"
 #include "utility.h"
 
@@ -412,6 +413,9 @@ namespace stream {
       safe::mail_raw_t::event_t<video::dynamic_param_t> dynamic_param_change_events;  // 新增：动态参数调整事件
 
       std::unique_ptr<platf::deinit_t> qos;
+
+      // When the stream was announced, cleared once its first packet is sent
+      std::optional<std::chrono::steady_clock::time_point> announce_time;
     } video;
 
     struct {
@@ -775,68 +779,64 @@ namespace stream {
   }  // namespace fec
 
   /**
-   * @brief Combines two buffers and inserts new buffers at each slice boundary of the result.
+   * @brief Combines buffers and inserts new buffers at each slice boundary of the result.
    * @param insert_size The number of bytes to insert.
    * @param slice_size The number of bytes between insertions.
-   * @param data1 The first data buffer.
-   * @param data2 The second data buffer.
+   * @param buffers The data buffers, in order.
    */
   std::vector<uint8_t>
-  concat_and_insert(uint64_t insert_size, uint64_t slice_size, const std::string_view &data1, const std::string_view &data2) {
-    auto data_size = data1.size() + data2.size();
+  concat_and_insert(uint64_t insert_size, uint64_t slice_size, const std::vector<std::string_view> &buffers) {
+    uint64_t data_size = 0;
+    for (auto &buffer : buffers) {
+      data_size += buffer.size();
+    }
+
     auto pad = data_size % slice_size != 0;
     auto elements = data_size / slice_size + (pad ? 1 : 0);
 
     std::vector<uint8_t> result;
     result.resize(elements * insert_size + data_size);
 
-    auto next = std::begin(data1);
-    auto end = std::end(data1);
+    auto buffer = std::begin(buffers);
+    std::size_t offset = 0;
     for (auto x = 0; x < elements; ++x) {
-      void *p = &result[x * (insert_size + slice_size)];
+      auto p = (char *) &result[x * (insert_size + slice_size)] + insert_size;
 
       // For the last iteration, only copy to the end of the data
       if (x == elements - 1) {
         slice_size = data_size - (x * slice_size);
       }
 
-      // Test if this slice will extend into the next buffer
-      if (next + slice_size > end) {
-        // Copy the first portion from the first buffer
-        auto copy_len = end - next;
-        std::copy(next, end, (char *) p + insert_size);
+      // The slice may extend over several buffers
+      for (auto remaining = slice_size; remaining > 0;) {
+        if (offset == buffer->size()) {
+          ++buffer;
+          offset = 0;
+          continue;
+        }
+
+        auto copy_len = std::min<uint64_t>(remaining, buffer->size() - offset);
+        std::copy_n(buffer->data() + offset, copy_len, p);
 
-        // Copy the remaining portion from the second buffer
-        next = std::begin(data2);
-        end = std::end(data2);
-        std::copy(next, next + (slice_size - copy_len), (char *) p + copy_len + insert_size);
-        next += slice_size - copy_len;
-      }
-      else {
-        std::copy(next, next + slice_size, (char *) p + insert_size);
-        next += slice_size;
+        p += copy_len;
+        offset += copy_len;
+        remaining -= copy_len;
       }
     }
 
     return result;
   }
 
+  /**
+   * @brief Combines two buffers and inserts new buffers at each slice boundary of the result.
+   * @param insert_size The number of bytes to insert.
+   * @param slice_size The number of bytes between insertions.
+   * @param data1 The first data buffer.
+   * @param data2 The second data buffer.
+   */
   std::vector<uint8_t>
-  replace(const std::string_view &original, const std::string_view &old, const std::string_view &_new) {
-    std::vector<uint8_t> replaced;
-    replaced.reserve(original.size() + _new.size() - old.size());
-
-    auto begin = std::begin(original);
-    auto end = std::end(original);
-    auto next = std::search(begin, end, std::begin(old), std::end(old));
-
-    std::copy(begin, next, std::back_inserter(replaced));
-    if (next != end) {
-      std::copy(std::begin(_new), std::end(_new), std::back_inserter(replaced));
-      std::copy(next + old.size(), end, std::back_inserter(replaced));
-    }
-
-    return replaced;
+  concat_and_insert(uint64_t insert_size, uint64_t slice_size, const std::string_view &data1, const std::string_view &data2) {
+    return concat_and_insert(insert_size, slice_size, std::vector<std::string_view> { data1, data2 });
   }
 
   /**
@@ -1159,7 +1159,7 @@ namespace stream {
     });
 
     // This thread handles latency-sensitive control messages
-    platf::adjust_thread_priority(platf::thread_priority_e::critical);
+    thread_placement::apply(thread_placement::thread_e::control, platf::thread_priority_e::critical);
 
     // Check for both the full shutdown event and the shutdown event for this
     // broadcast to ensure we can inform connected clients of our graceful
@@ -1483,7 +1483,7 @@ namespace stream {
     auto video_epoch = std::chrono::steady_clock::now();
 
     // Video traffic is sent on this thread
-    platf::adjust_thread_priority(platf::thread_priority_e::high);
+    thread_placement::apply(thread_placement::thread_e::video_send, platf::thread_priority_e::high);
 
     logging::min_max_avg_periodic_logger<double> frame_processing_latency_logger(debug, "Frame processing latency", "ms");
 
@@ -1511,29 +1511,36 @@ namespace stream {
       auto session = (session_t *) packet->channel_data;
       auto lowseq = session->video.lowseq;
 
-      std::string_view payload { (char *) packet->data(), packet->data_size() };
-      std::vector<uint8_t> payload_with_replacements;
-
-      // Apply replacements on the packet payload before performing any other operations.
-      // We need to know the final frame size to calculate the last packet size, and we
-      // must avoid matching replacements against the frame header or any other non-video
-      // part of the payload.
-      if (packet->is_idr() && packet->replacements) {
-        for (auto &replacement : *packet->replacements) {
-          auto frame_old = replacement.old;
-          auto frame_new = replacement._new;
-
-          payload_with_replacements = replace(payload, frame_old, frame_new);
-          payload = { (char *) payload_with_replacements.data(), payload_with_replacements.size() };
-        }
+      if (session->video.announce_time) {
+        auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - *session->video.announce_time);
+        BOOST_LOG(info) << "First video packet sent "sv << delay.count() << "ms after the stream was announced"sv;
+        session->video.announce_time.reset();
       }
 
+      std::string_view payload { (char *) packet->data(), packet->data_size() };
+
+      // The frame header comes first, followed by the payload, with its parameter sets
+      // already rewritten by the encoder if needed.
       video_short_frame_header_t frame_header = {};
+      std::vector<std::string_view> buffers { std::string_view { (char *) &frame_header, sizeof(frame_header) } };
+      if (packet->gather.empty()) {
+        buffers.emplace_back(payload);
+      }
+      else {
+        buffers.insert(std::end(buffers), std::begin(packet->gather), std::end(packet->gather));
+      }
+
+      std::size_t payload_size = 0;
+      for (auto it = std::next(std::begin(buffers)); it != std::end(buffers); ++it) {
+        payload_size += it->size();
+      }
+
       frame_header.headerType = 0x01;  // Short header type
       frame_header.frameType = packet->is_idr()                     ? 2 :
                                packet->after_ref_frame_invalidation ? 5 :
+                               packet->intra_refresh                ? 4 :
                                                                       1;
-      frame_header.lastPayloadLen = (payload.size() + sizeof(frame_header)) % (session->config.packetsize - sizeof(NV_VIDEO_PACKET));
+      frame_header.lastPayloadLen = (payload_size + sizeof(frame_header)) % (session->config.packetsize - sizeof(NV_VIDEO_PACKET));
       if (frame_header.lastPayloadLen == 0) {
         frame_header.lastPayloadLen = session->config.packetsize - sizeof(NV_VIDEO_PACKET);
       }
@@ -1557,8 +1564,7 @@ namespace stream {
       // Insert space for packet headers
       auto blocksize = session->config.packetsize + MAX_RTP_HEADER_SIZE;
       auto payload_blocksize = blocksize - sizeof(video_packet_raw_t);
-      auto payload_new = concat_and_insert(sizeof(video_packet_raw_t), payload_blocksize,
-        std::string_view { (char *) &frame_header, sizeof(frame_header) }, payload);
+      auto payload_new = concat_and_insert(sizeof(video_packet_raw_t), payload_blocksize, buffers);
 
       payload = std::string_view { (char *) payload_new.data(), payload_new.size() };
 
@@ -1790,7 +1796,8 @@ namespace stream {
                              << "] shards ["sv << shards.size() << "/"sv << shards.percentage << "%]"sv
                              << (frame_is_dupe ? " Dupe" : "")
                              << (packet->is_idr() ? " Key" : "")
-                             << (packet->after_ref_frame_invalidation ? " RFI" : "");
+                             << (packet->after_ref_frame_invalidation ? " RFI" : "")
+                             << (packet->intra_refresh ? " IR" : "");
 
           ++blockIndex;
           lowseq += shards.size();
@@ -1829,7 +1836,7 @@ namespace stream {
     audio_packet.rtp.ssrc = 0;
 
     // Audio traffic is sent on this thread
-    platf::adjust_thread_priority(platf::thread_priority_e::high);
+    thread_placement::apply(thread_placement::thread_e::audio_send, platf::thread_priority_e::high);
 
     while (auto packet = packets->pop()) {
       if (shutdown_event->peek()) {
@@ -2108,6 +2115,9 @@ namespace stream {
 
     while_starting_do_nothing(session->state);
 
+    // Build the encoder while the client is still connecting, it's discarded if the client doesn't ping
+    auto prewarmed = video::prewarm(session->mail, session->config.monitor);
+
     auto ref = broadcast_shared.ref();
     auto error = recv_ping(session, ref, socket_e::video, session->video.ping_payload, session->video.peer, config::stream.ping_timeout);
     if (error < 0) {
@@ -2122,7 +2132,7 @@ namespace stream {
     BOOST_LOG(debug) << "Start capturing Video"sv;
     // Debug: Log the display_name before calling video::capture
     BOOST_LOG(debug) << "stream.cpp: session->config.monitor.display_name = [" << (session->config.monitor.display_name.empty() ? "<empty>" : session->config.monitor.display_name) << "]";
-    video::capture(session->mail, session->config.monitor, session, session->video.dynamic_param_change_events);
+    video::capture(session->mail, session->config.monitor, session, session->video.dynamic_param_change_events, std::move(prewarmed));
   }
 
   void
@@ -2355,6 +2365,7 @@ namespace stream {
       session->client_name = launch_session.client_name;
 
       session->config = config;
+      session->video.announce_time = std::chrono::steady_clock::now();
 
       // Initialize current total bitrate (including FEC) from config
       // config.monitor.bitrate is the encoding bitrate (excluding FEC)
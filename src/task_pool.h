@@ -77,9 +77,13 @@ namespace task_pool_util {
       return *this;
     }
 
+    /**
+     * @brief Wrap a callable and its arguments into a runnable task.
+     * @return The runnable task and the future that receives its result.
+     */
     template <class Function, class... Args>
-    auto
-    push(Function &&newTask, Args &&...args) {
+    static auto
+    make_task(Function &&newTask, Args &&...args) {
       static_assert(std::is_invocable_v<Function, Args &&...>, "arguments don't match the function");
 
       using __return = std::invoke_result_t<Function, Args &&...>;
@@ -93,10 +97,18 @@ namespace task_pool_util {
 
       auto future = task.get_future();
 
+      return std::pair<__task, std::future<__return>> { toRunnable(std::move(task)), std::move(future) };
+    }
+
+    template <class Function, class... Args>
+    auto
+    push(Function &&newTask, Args &&...args) {
+      auto [runnable, future] = make_task(std::forward<Function>(newTask), std::forward<Args>(args)...);
+
       std::lock_guard<std::mutex> lg(_task_mutex);
-      _tasks.emplace_back(toRunnable(std::move(task)));
+      _tasks.emplace_back(std::move(runnable));
 
-      return future;
+      return std::move(future);
     }
 
     void
@@ -119,10 +131,7 @@ namespace task_pool_util {
     template <class Function, class X, class Y, class... Args>
     auto
     pushDelayed(Function &&newTask, std::chrono::duration<X, Y> duration, Args &&...args) {
-      static_assert(std::is_invocable_v<Function, Args &&...>, "arguments don't match the function");
-
       using __return = std::invoke_result_t<Function, Args &&...>;
-      using task_t = std::packaged_task<__return()>;
 
       __time_point time_point;
       if constexpr (std::is_floating_point_v<X>) {
@@ -132,14 +141,7 @@ namespace task_pool_util {
         time_point = std::chrono::steady_clock::now() + duration;
       }
 
-      auto bind = [task = std::forward<Function>(newTask), tuple_args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
-        return std::apply(task, std::move(tuple_args));
-      };
-
-      task_t task(std::move(bind));
-
-      auto future = task.get_future();
-      auto runnable = toRunnable(std::move(task));
+      auto [runnable, future] = make_task(std::forward<Function>(newTask), std::forward<Args>(args)...);
 
       task_id_t task_id = &*runnable;
 
@@ -254,7 +256,7 @@ namespace task_pool_util {
 
   private:
     template <class Function>
-    std::unique_ptr<_ImplBase>
+    static std::unique_ptr<_ImplBase>
     toRunnable(Function &&f) {
       return std::make_unique<_Impl<Function>>(std::forward<Function &&>(f));
     }
@@ -0,0 +1,183 @@
+/**
+ * @file src/thread_placement.cpp
+ * @brief Definitions for naming and placing the streaming pipeline threads.
+ */
+// standard includes
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+// local includes
+#include "config.h"
+#include "logging.h"
+#include "thread_placement.h"
+
+using namespace std::literals;
+
+namespace thread_placement {
+  namespace {
+    std::mutex status_lock;
+    std::map<std::string, status_t, std::less<>> status_by_name;
+
+    std::optional<int>
+    to_int(std::string_view view) {
+      int value;
+      auto [ptr, ec] = std::from_chars(view.data(), view.data() + view.size(), value);
+      if (ec != std::errc {} || ptr != view.data() + view.size() || value < 0) {
+        return std::nullopt;
+      }
+
+      return value;
+    }
+
+    std::string_view
+    trim(std::string_view view) {
+      while (!view.empty() && std::isspace((unsigned char) view.front())) view.remove_prefix(1);
+      while (!view.empty() && std::isspace((unsigned char) view.back())) view.remove_suffix(1);
+
+      return view;
+    }
+
+    /**
+     * @brief Resolve the configured CPU set and NUMA node of a thread into a list of CPUs.
+     */
+    std::vector<int>
+    requested_cpus(std::string_view name) {
+      auto it = config::threads.placement.find(std::string { name });
+      if (it == std::end(config::threads.placement)) {
+        return {};
+      }
+
+      auto &placement = it->second;
+
+      std::vector<int> cpus;
+      if (!placement.cpus.empty()) {
+        auto parsed = parse_cpu_list(placement.cpus);
+        if (!parsed) {
+          BOOST_LOG(warning) << "Ignoring malformed CPU list for thread "sv << name << ": "sv << placement.cpus;
+        }
+        else {
+          cpus = std::move(*parsed);
+        }
+      }
+
+      if (placement.numa_node >= 0) {
+        auto node_cpus = platf::numa_node_cpus(placement.numa_node);
+        if (node_cpus.empty()) {
+          BOOST_LOG(warning) << "NUMA node "sv << placement.numa_node << " for thread "sv << name << " has no CPUs"sv;
+        }
+        else if (cpus.empty()) {
+          cpus = std::move(node_cpus);
+        }
+        else {
+          // Both were given, keep the CPUs of the set that belong to the node
+          std::vector<int> intersection;
+          std::set_intersection(std::begin(cpus), std::end(cpus), std::begin(node_cpus), std::end(node_cpus), std::back_inserter(intersection));
+          if (intersection.empty()) {
+            BOOST_LOG(warning) << "CPU list "sv << placement.cpus << " for thread "sv << name << " doesn't overlap NUMA node "sv << placement.numa_node;
+          }
+          cpus = std::move(intersection);
+        }
+      }
+
+      return cpus;
+    }
+  }  // namespace
+
+  std::string_view
+  to_string(thread_e thread) {
+    return thread_names[(std::size_t) thread];
+  }
+
+  std::optional<std::vector<int>>
+  parse_cpu_list(std::string_view list) {
+    std::vector<int> cpus;
+
+    while (!list.empty()) {
+      auto comma = list.find(',');
+      auto range = trim(list.substr(0, comma));
+      list = comma == std::string_view::npos ? std::string_view {} : list.substr(comma + 1);
+
+      if (range.empty()) {
+        continue;
+      }
+
+      auto dash = range.find('-');
+      auto first = to_int(trim(range.substr(0, dash)));
+      auto last = dash == std::string_view::npos ? first : to_int(trim(range.substr(dash + 1)));
+      if (!first || !last || *last < *first) {
+        return std::nullopt;
+      }
+
+      // A typo like 0-99999999 shouldn't allocate CPUs no OS can address
+      for (int cpu = *first; cpu <= std::min(*last, max_cpus - 1); ++cpu) {
+        cpus.emplace_back(cpu);
+      }
+    }
+
+    std::sort(std::begin(cpus), std::end(cpus));
+    cpus.erase(std::unique(std::begin(cpus), std::end(cpus)), std::end(cpus));
+
+    return cpus;
+  }
+
+  std::string
+  to_cpu_list(const std::vector<int> &cpus) {
+    std::stringstream ss;
+
+    for (std::size_t x = 0; x < cpus.size();) {
+      auto y = x;
+      while (y + 1 < cpus.size() && cpus[y + 1] == cpus[y] + 1) {
+        ++y;
+      }
+
+      if (x) {
+        ss << ',';
+      }
+      ss << cpus[x];
+      if (y > x) {
+        ss << '-' << cpus[y];
+      }
+
+      x = y + 1;
+    }
+
+    return ss.str();
+  }
+
+  void
+  apply(thread_e thread, platf::thread_priority_e priority) {
+    auto name = to_string(thread);
+
+    platf::set_thread_name(name);
+
+    auto cpus = requested_cpus(name);
+    if (!cpus.empty() && platf::set_thread_affinity(cpus)) {
+      BOOST_LOG(warning) << "Couldn't pin thread "sv << name << " to CPUs "sv << to_cpu_list(cpus);
+    }
+
+    platf::adjust_thread_priority(priority);
+
+    auto info = platf::current_thread_info();
+    BOOST_LOG(info) << "Thread "sv << name << " ["sv << info.id << "]: CPUs "sv
+                    << (info.cpus.empty() ? "any"s : to_cpu_list(info.cpus)) << ", "sv << info.scheduling;
+
+    std::lock_guard lg { status_lock };
+    status_by_name.insert_or_assign(std::string { name }, status_t { std::string { name }, info.id, std::move(cpus), std::move(info.cpus), std::move(info.scheduling) });
+  }
+
+  std::vector<status_t>
+  current() {
+    std::lock_guard lg { status_lock };
+
+    std::vector<status_t> result;
+    for (auto &[_, status] : status_by_name) {
+      result.emplace_back(status);
+    }
+
+    return result;
+  }
+}  // namespace thread_placement
@@ -0,0 +1,92 @@
+/**
+ * @file src/thread_placement.h
+ * @brief Declarations for naming and placing the streaming pipeline threads.
+ */
+#pragma once
+
+// standard includes
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// local includes
+#include "platform/common.h"
+
+namespace thread_placement {
+  /**
+   * @brief The pipeline threads that can be placed through the configuration.
+   */
+  enum class thread_e : int {
+    capture,  ///< Display capture
+    encode,  ///< Video conversion and encoding
+    video_send,  ///< Video packetization, FEC and sending
+    audio_capture,  ///< Audio capture
+    audio_encode,  ///< Opus encoding
+    audio_send,  ///< Audio packetization and sending
+    control,  ///< Control stream
+    _count  ///< Number of pipeline threads
+  };
+
+  /**
+   * @brief Names used for the configuration keys, thread names and the troubleshooting API.
+   */
+  constexpr std::array<std::string_view, (std::size_t) thread_e::_count> thread_names {
+    "capture",
+    "encode",
+    "video_send",
+    "audio_capture",
+    "audio_encode",
+    "audio_send",
+    "control",
+  };
+
+  /**
+   * @brief Effective placement of a pipeline thread, as reported by the OS after it was applied.
+   */
+  struct status_t {
+    std::string name;
+    std::int64_t thread_id;
+    std::vector<int> requested_cpus;
+    std::vector<int> cpus;
+    std::string scheduling;
+  };
+
+  std::string_view
+  to_string(thread_e thread);
+
+  /**
+   * @brief Number of CPUs a list can address, the `CPU_SETSIZE` of glibc.
+   */
+  constexpr int max_cpus = 1024;
+
+  /**
+   * @brief Parse a CPU list in the format used by `taskset` and `/sys`, e.g. `0-3,8,10-11`.
+   * CPUs from `max_cpus` on are ignored.
+   * @return The sorted list of CPUs, or `std::nullopt` if the list is malformed.
+   */
+  std::optional<std::vector<int>>
+  parse_cpu_list(std::string_view list);
+
+  /**
+   * @brief Format a CPU list, collapsing consecutive CPUs into ranges.
+   */
+  std::string
+  to_cpu_list(const std::vector<int> &cpus);
+
+  /**
+   * @brief Name the calling thread, apply its configured CPU placement and adjust its priority.
+   * @param thread The pipeline stage running on the calling thread.
+   * @param priority The priority class requested by the stage.
+   */
+  void
+  apply(thread_e thread, platf::thread_priority_e priority);
+
+  /**
+   * @brief The effective placement of every pipeline thread that has been started so far.
+   */
+  std::vector<status_t>
+  current();
+}  // namespace thread_placement
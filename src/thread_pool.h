@@ -5,6 +5,10 @@
 #pragma once
 
 #include "task_pool.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
 #include <thread>
 
 namespace thread_pool_util {
@@ -128,4 +132,313 @@ namespace thread_pool_util {
       }
     }
   };
+
+  /**
+   * @brief Lanes of the work-stealing pool, tasks in a higher lane are always picked first.
+   */
+  enum class task_priority_e : int {
+    critical,  ///< Latency sensitive tasks, e.g. input injection
+    background,  ///< Tasks that may be postponed, e.g. webhooks or display device bookkeeping
+    _count  ///< Number of lanes
+  };
+
+  /**
+   * @brief Thread pool with a deque per worker, priority lanes and work stealing.
+   *
+   * Tasks pushed from a worker go to that worker's own deque, tasks pushed from any other thread
+   * are distributed round-robin. An idle worker first drains its own deque and then steals from the
+   * back of the other workers' deques, so producers and consumers rarely contend on the same lock.
+   *
+   * The `push`/`pushDelayed`/`delay`/`cancel` API mirrors `ThreadPool`, so callers can move over one by one.
+   * Unlike a single-threaded `ThreadPool`, tasks are not guaranteed to run in submission order when
+   * more than one worker is running.
+   */
+  class WorkStealingPool {
+  public:
+    typedef task_pool_util::TaskPool::__task __task;
+    typedef task_pool_util::TaskPool::task_id_t task_id_t;
+    typedef task_pool_util::TaskPool::__time_point __time_point;
+
+    /**
+     * @brief Called on each worker thread before it picks up its first task.
+     * Can be used to pin the worker to a CPU set or to adjust its priority.
+     */
+    using worker_init_t = std::function<void(std::size_t worker)>;
+
+  private:
+    struct worker_t {
+      std::mutex lock;
+      std::array<std::deque<__task>, (std::size_t) task_priority_e::_count> lanes;
+    };
+
+    std::vector<std::unique_ptr<worker_t>> _workers;
+    std::vector<std::thread> _thread;
+
+    // Delayed tasks are kept sorted by the TaskPool and picked up by the first idle worker once due
+    task_pool_util::TaskPool _timers;
+
+    std::condition_variable _cv;
+    std::mutex _lock;
+
+    // Kept on separate cache lines, they're touched by every push and pop
+    alignas(64) std::atomic<std::size_t> _pending { 0 };
+    alignas(64) std::atomic<std::size_t> _sleeping { 0 };
+    alignas(64) std::atomic<std::size_t> _next_worker { 0 };
+    alignas(64) std::atomic<std::size_t> _delayed { 0 };
+    std::atomic<std::uint64_t> _stolen { 0 };
+    std::atomic_bool _continue { false };
+
+    worker_init_t _worker_init;
+
+    struct current_t {
+      const WorkStealingPool *pool;
+      std::size_t worker;
+    };
+    inline static thread_local current_t _current { nullptr, 0 };
+
+  public:
+    WorkStealingPool() = default;
+
+    explicit WorkStealingPool(int threads, worker_init_t worker_init = nullptr) {
+      start(threads, std::move(worker_init));
+    }
+
+    ~WorkStealingPool() noexcept {
+      if (_continue) {
+        stop();
+      }
+
+      // The workers may have been stopped without being joined
+      join();
+    }
+
+    template <class Function, class... Args>
+    auto
+    push(task_priority_e priority, Function &&newTask, Args &&...args) {
+      auto [runnable, future] = task_pool_util::TaskPool::make_task(std::forward<Function>(newTask), std::forward<Args>(args)...);
+
+      enqueue(priority, std::move(runnable));
+      return std::move(future);
+    }
+
+    template <class Function, class... Args>
+    auto
+    push(Function &&newTask, Args &&...args) {
+      return push(task_priority_e::critical, std::forward<Function>(newTask), std::forward<Args>(args)...);
+    }
+
+    void
+    pushDelayed(std::pair<__time_point, __task> &&task) {
+      ++_delayed;
+      _timers.pushDelayed(std::move(task));
+
+      wake_all();
+    }
+
+    template <class Function, class X, class Y, class... Args>
+    auto
+    pushDelayed(Function &&newTask, std::chrono::duration<X, Y> duration, Args &&...args) {
+      ++_delayed;
+      auto timer_task = _timers.pushDelayed(std::forward<Function>(newTask), duration, std::forward<Args>(args)...);
+
+      // Update all timers for wait_until
+      wake_all();
+      return timer_task;
+    }
+
+    template <class X, class Y>
+    void
+    delay(task_id_t task_id, std::chrono::duration<X, Y> duration) {
+      _timers.delay(task_id, duration);
+
+      wake_all();
+    }
+
+    bool
+    cancel(task_id_t task_id) {
+      if (_timers.cancel(task_id)) {
+        --_delayed;
+        return true;
+      }
+
+      return false;
+    }
+
+    void
+    start(int threads, worker_init_t worker_init = nullptr) {
+      _worker_init = std::move(worker_init);
+      _continue = true;
+
+      _workers.clear();
+      for (int x = 0; x < threads; ++x) {
+        _workers.emplace_back(std::make_unique<worker_t>());
+      }
+
+      _thread.resize(threads);
+      for (std::size_t x = 0; x < _thread.size(); ++x) {
+        _thread[x] = std::thread(&WorkStealingPool::_main, this, x);
+      }
+    }
+
+    void
+    stop() {
+      std::lock_guard lg(_lock);
+
+      _continue = false;
+      _cv.notify_all();
+    }
+
+    void
+    join() {
+      for (auto &t : _thread) {
+        if (t.joinable()) {
+          t.join();
+        }
+      }
+      _thread.clear();
+    }
+
+    /**
+     * @return The number of tasks that were executed by a worker other than the one they were queued on.
+     */
+    std::uint64_t
+    stolen() const {
+      return _stolen;
+    }
+
+  private:
+    void
+    enqueue(task_priority_e priority, __task &&task) {
+      // Without workers, e.g. before start(), nobody would ever pick the task up
+      if (_workers.empty()) {
+        task->run();
+        return;
+      }
+
+      auto worker = _current.pool == this ? _current.worker : _next_worker++ % _workers.size();
+
+      ++_pending;
+      {
+        auto &w = *_workers[worker];
+        std::lock_guard lg(w.lock);
+        w.lanes[(std::size_t) priority].emplace_back(std::move(task));
+      }
+
+      // Only pay for the lock when a worker is actually asleep.
+      // A worker increments _sleeping before checking _pending, so one of the two sides always sees the other.
+      if (_sleeping) {
+        std::lock_guard lg(_lock);
+        _cv.notify_one();
+      }
+    }
+
+    void
+    wake_all() {
+      std::lock_guard lg(_lock);
+      _cv.notify_all();
+    }
+
+    std::optional<__task>
+    pop_lane(std::size_t worker, std::size_t lane) {
+      // Own deque first, oldest task first
+      {
+        auto &w = *_workers[worker];
+        std::lock_guard lg(w.lock);
+
+        auto &tasks = w.lanes[lane];
+        if (!tasks.empty()) {
+          __task task = std::move(tasks.front());
+          tasks.pop_front();
+
+          --_pending;
+          return task;
+        }
+      }
+
+      // Steal the newest task of a sibling, it's the one least likely to be picked up soon
+      for (std::size_t x = 1; x < _workers.size(); ++x) {
+        auto &w = *_workers[(worker + x) % _workers.size()];
+
+        std::unique_lock ul(w.lock, std::try_to_lock);
+        if (!ul.owns_lock()) {
+          continue;
+        }
+
+        auto &tasks = w.lanes[lane];
+        if (!tasks.empty()) {
+          __task task = std::move(tasks.back());
+          tasks.pop_back();
+
+          --_pending;
+          ++_stolen;
+          return task;
+        }
+      }
+
+      return std::nullopt;
+    }
+
+    std::optional<__task>
+    pop(std::size_t worker) {
+      if (auto task = pop_lane(worker, (std::size_t) task_priority_e::critical)) {
+        return task;
+      }
+
+      // Delayed tasks are treated as latency critical
+      if (_delayed) {
+        if (auto task = _timers.pop()) {
+          --_delayed;
+          return task;
+        }
+      }
+
+      return pop_lane(worker, (std::size_t) task_priority_e::background);
+    }
+
+  public:
+    void
+    _main(std::size_t worker) {
+      _current = { this, worker };
+
+      if (_worker_init) {
+        _worker_init(worker);
+      }
+
+      while (_continue) {
+        if (auto task = pop(worker)) {
+          (*task)->run();
+        }
+        else {
+          std::unique_lock uniq_lock(_lock);
+          ++_sleeping;
+
+          // A task may still be pending if stealing failed on a contended lock
+          if (_pending || (_delayed && _timers.ready())) {
+            --_sleeping;
+            uniq_lock.unlock();
+            std::this_thread::yield();
+            continue;
+          }
+
+          if (!_continue) {
+            --_sleeping;
+            break;
+          }
+
+          if (auto tp = _delayed ? _timers.next() : std::nullopt) {
+            _cv.wait_until(uniq_lock, *tp);
+          }
+          else {
+            _cv.wait(uniq_lock);
+          }
+          --_sleeping;
+        }
+      }
+
+      // Execute remaining tasks
+      while (auto task = pop(worker)) {
+        (*task)->run();
+      }
+    }
+  };
 }  // namespace thread_pool_util
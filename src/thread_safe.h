@@ -4,12 +4,14 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <map>
 #include <mutex>
+#include <optional>
 #include <vector>
 
 #include "utility.h"
@@ -257,13 +259,67 @@ namespace safe {
     return std::make_shared<alarm_raw_t<T>>();
   }
 
+  /**
+   * @brief What a bounded queue does when an element is raised while it is full.
+   */
+  enum class overflow_e : int {
+    clear,  ///< Drop every queued element, then queue the new one
+    drop_oldest,  ///< Drop the oldest queued element to make room
+    drop_newest,  ///< Drop the element being raised
+    block,  ///< Wait for room up to a timeout, then drop the element being raised
+  };
+
+  /**
+   * @brief Snapshot of the depth counters of a queue.
+   */
+  struct queue_stats_t {
+    std::size_t depth;
+    std::size_t capacity;
+    std::size_t high_water;
+    std::uint64_t dropped;
+  };
+
+  /**
+   * @brief Depth counters shared by all queue types, so they can be queried without knowing the element type.
+   */
+  class queue_metrics_t {
+  public:
+    explicit queue_metrics_t(std::size_t capacity):
+        _capacity { capacity } {}
+
+    [[nodiscard]] queue_stats_t
+    stats() const {
+      return { _depth, _capacity, _high_water, _dropped };
+    }
+
+  protected:
+    void
+    record_depth(std::size_t depth) {
+      _depth = depth;
+      if (depth > _high_water) {
+        _high_water = depth;
+      }
+    }
+
+    void
+    record_drop(std::size_t count = 1) {
+      _dropped += count;
+    }
+
+  private:
+    std::size_t _capacity;
+    std::atomic<std::size_t> _depth { 0 };
+    std::atomic<std::size_t> _high_water { 0 };
+    std::atomic<std::uint64_t> _dropped { 0 };
+  };
+
   template <class T>
-  class queue_t {
+  class queue_t: public queue_metrics_t {
   public:
     using status_t = util::optional_t<T>;
 
     queue_t(std::uint32_t max_elements = 32):
-        _max_elements { max_elements } {}
+        queue_metrics_t { max_elements }, _max_elements { max_elements } {}
 
     template <class... Args>
     void
@@ -275,10 +331,12 @@ namespace safe {
       }
 
       if (_queue.size() == _max_elements) {
+        record_drop(_queue.size());
         _queue.clear();
       }
 
       _queue.emplace_back(std::forward<Args>(args)...);
+      record_depth(_queue.size());
 
       _cv.notify_all();
     }
@@ -305,6 +363,7 @@ namespace safe {
 
       auto val = std::move(_queue.front());
       _queue.erase(std::begin(_queue));
+      record_depth(_queue.size());
 
       return val;
     }
@@ -327,6 +386,7 @@ namespace safe {
 
       auto val = std::move(_queue.front());
       _queue.erase(std::begin(_queue));
+      record_depth(_queue.size());
 
       return val;
     }
@@ -360,6 +420,165 @@ namespace safe {
     std::vector<T> _queue;
   };
 
+  /**
+   * @brief Fixed capacity queue backed by a ring buffer.
+   *
+   * Behaves like queue_t for `raise`/`pop`/`peek`, but pops in O(1) and lets the owner choose
+   * what happens when the queue is full instead of always clearing it.
+   * A capacity of 0 is raised to 1.
+   */
+  template <class T>
+  class ring_queue_t: public queue_metrics_t {
+  public:
+    using status_t = util::optional_t<T>;
+
+    explicit ring_queue_t(std::uint32_t capacity = 32, overflow_e overflow = overflow_e::drop_oldest, std::chrono::milliseconds block_timeout = std::chrono::milliseconds { 0 }):
+        queue_metrics_t { std::max<std::uint32_t>(capacity, 1) }, _overflow { overflow }, _block_timeout { block_timeout }, _ring(std::max<std::uint32_t>(capacity, 1)) {}
+
+    /**
+     * @return false if the element was dropped.
+     */
+    template <class... Args>
+    bool
+    raise(Args &&...args) {
+      std::unique_lock ul { _lock };
+
+      if (!_continue) {
+        return false;
+      }
+
+      if (_size == _ring.size()) {
+        switch (_overflow) {
+          case overflow_e::clear:
+            record_drop(_size);
+            clear();
+            break;
+          case overflow_e::drop_oldest:
+            record_drop();
+            pop_front();
+            break;
+          case overflow_e::drop_newest:
+            record_drop();
+            return false;
+          case overflow_e::block:
+            if (!_cv_space.wait_for(ul, _block_timeout, [this]() { return !_continue || _size < _ring.size(); }) || !_continue) {
+              record_drop();
+              return false;
+            }
+            break;
+        }
+      }
+
+      _ring[(_head + _size) % _ring.size()].emplace(std::forward<Args>(args)...);
+      ++_size;
+      record_depth(_size);
+
+      _cv.notify_all();
+      return true;
+    }
+
+    bool
+    peek() {
+      std::lock_guard lg { _lock };
+
+      return _continue && _size > 0;
+    }
+
+    template <class Rep, class Period>
+    status_t
+    pop(std::chrono::duration<Rep, Period> delay) {
+      std::unique_lock ul { _lock };
+
+      if (!_continue) {
+        return util::false_v<status_t>;
+      }
+
+      while (!_size) {
+        if (!_continue || _cv.wait_for(ul, delay) == std::cv_status::timeout) {
+          return util::false_v<status_t>;
+        }
+      }
+
+      return pop_front();
+    }
+
+    status_t
+    pop() {
+      std::unique_lock ul { _lock };
+
+      if (!_continue) {
+        return util::false_v<status_t>;
+      }
+
+      while (!_size) {
+        _cv.wait(ul);
+
+        if (!_continue) {
+          return util::false_v<status_t>;
+        }
+      }
+
+      return pop_front();
+    }
+
+    void
+    stop() {
+      std::lock_guard lg { _lock };
+
+      _continue = false;
+
+      _cv.notify_all();
+      _cv_space.notify_all();
+    }
+
+    [[nodiscard]] bool
+    running() const {
+      return _continue;
+    }
+
+  private:
+    // Requires _lock and a non-empty queue
+    T
+    pop_front() {
+      auto &slot = _ring[_head];
+
+      T val = std::move(*slot);
+      slot.reset();
+
+      _head = (_head + 1) % _ring.size();
+      --_size;
+      record_depth(_size);
+
+      if (_overflow == overflow_e::block) {
+        _cv_space.notify_one();
+      }
+
+      return val;
+    }
+
+    // Requires _lock
+    void
+    clear() {
+      while (_size) {
+        _ring[_head].reset();
+        _head = (_head + 1) % _ring.size();
+        --_size;
+      }
+    }
+
+    bool _continue { true };
+    overflow_e _overflow;
+    std::chrono::milliseconds _block_timeout;
+
+    std::mutex _lock;
+    std::condition_variable _cv;
+    std::condition_variable _cv_space;
+
+    std::vector<std::optional<T>> _ring;
+    std::size_t _head { 0 };
+    std::size_t _size { 0 };
+  };
+
   template <class T>
   class shared_t {
   public:
@@ -481,7 +700,7 @@ namespace safe {
 
     std::array<std::uint8_t, sizeof(element_type)> _object_buf;
 
-    std::uint32_t _count;
+    std::uint32_t _count {};
     std::mutex _lock;
   };
 
@@ -528,6 +747,9 @@ namespace safe {
     template <class T>
     using queue_t = std::shared_ptr<post_t<queue_t<T>>>;
 
+    template <class T>
+    using ring_queue_t = std::shared_ptr<post_t<ring_queue_t<T>>>;
+
     template <class T>
     event_t<T>
     event(const std::string_view &id) {
@@ -556,10 +778,70 @@ namespace safe {
 
       auto post = std::make_shared<typename queue_t<T>::element_type>(shared_from_this(), 32);
       id_to_post.emplace(std::pair<std::string, std::weak_ptr<void>> { std::string { id }, post });
+      id_to_metrics.emplace(std::pair<std::string, std::weak_ptr<queue_metrics_t>> { std::string { id }, post });
 
       return post;
     }
 
+    /**
+     * @brief Get or create a ring buffer queue.
+     * @note The capacity and overflow policy are only applied by the call that creates the queue.
+     */
+    template <class T>
+    ring_queue_t<T>
+    ring_queue(const std::string_view &id, std::uint32_t capacity = 32, overflow_e overflow = overflow_e::drop_oldest, std::chrono::milliseconds block_timeout = std::chrono::milliseconds { 0 }) {
+      std::lock_guard lg { mutex };
+
+      auto it = id_to_post.find(id);
+      if (it != std::end(id_to_post)) {
+        return lock<ring_queue_t<T>>(it->second);
+      }
+
+      auto post = std::make_shared<typename ring_queue_t<T>::element_type>(shared_from_this(), capacity, overflow, block_timeout);
+      id_to_post.emplace(std::pair<std::string, std::weak_ptr<void>> { std::string { id }, post });
+      id_to_metrics.emplace(std::pair<std::string, std::weak_ptr<queue_metrics_t>> { std::string { id }, post });
+
+      return post;
+    }
+
+    /**
+     * @brief Query the depth counters of a live queue by name.
+     * @return std::nullopt if no queue with that name exists.
+     */
+    std::optional<queue_stats_t>
+    queue_stats(const std::string_view &id) {
+      std::lock_guard lg { mutex };
+
+      auto it = id_to_metrics.find(id);
+      if (it == std::end(id_to_metrics)) {
+        return std::nullopt;
+      }
+
+      auto metrics = it->second.lock();
+      if (!metrics) {
+        return std::nullopt;
+      }
+
+      return metrics->stats();
+    }
+
+    /**
+     * @brief Query the depth counters of all live queues.
+     */
+    std::vector<std::pair<std::string, queue_stats_t>>
+    queue_stats() {
+      std::lock_guard lg { mutex };
+
+      std::vector<std::pair<std::string, queue_stats_t>> result;
+      for (auto &[id, weak] : id_to_metrics) {
+        if (auto metrics = weak.lock()) {
+          result.emplace_back(id, metrics->stats());
+        }
+      }
+
+      return result;
+    }
+
     void
     cleanup() {
       std::lock_guard lg { mutex };
@@ -568,6 +850,7 @@ namespace safe {
         auto &weak = it->second;
 
         if (weak.expired()) {
+          id_to_metrics.erase(it->first);
           id_to_post.erase(it);
 
           return;
@@ -578,6 +861,7 @@ namespace safe {
     std::mutex mutex;
 
     std::map<std::string, std::weak_ptr<void>, std::less<>> id_to_post;
+    std::map<std::string, std::weak_ptr<queue_metrics_t>, std::less<>> id_to_metrics;
   };
 
   inline void
@@ -0,0 +1,208 @@
+/**
+ * @file src/tile_hash.cpp
+ * @brief Definitions for the detection of changed tiles in captured images.
+ */
+// standard includes
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+// local includes
+#include "tile_hash.h"
+
+#ifdef SUNSHINE_TILE_HASH_X86
+  #include <immintrin.h>
+#endif
+
+namespace tile_hash {
+  crc_runs_t crc_runs = crc_runs_scalar;
+
+  namespace {
+    // Castagnoli polynomial, bit-reversed
+    constexpr std::uint32_t polynomial = 0x82F63B78;
+
+    constexpr std::array<std::uint32_t, 256>
+    make_table() {
+      std::array<std::uint32_t, 256> table {};
+      for (std::uint32_t x = 0; x < 256; ++x) {
+        auto crc = x;
+        for (int bit = 0; bit < 8; ++bit) {
+          crc = (crc >> 1) ^ (crc & 1 ? polynomial : 0);
+        }
+        table[x] = crc;
+      }
+
+      return table;
+    }
+
+    constexpr auto table = make_table();
+  }  // namespace
+
+  void
+  crc_runs_scalar(std::uint32_t *crcs, const std::uint8_t *data, std::size_t size, std::size_t count) {
+    for (std::size_t run = 0; run < count; ++run) {
+      auto crc = crcs[run];
+      auto bytes = data + run * size;
+      for (std::size_t x = 0; x < size; ++x) {
+        crc = (crc >> 8) ^ table[(crc ^ bytes[x]) & 0xFF];
+      }
+      crcs[run] = crc;
+    }
+  }
+
+#ifdef SUNSHINE_TILE_HASH_X86
+  // Compile the SSE4.2 kernel without raising the baseline of the rest of the binary
+  #if defined(__clang__)
+    #pragma clang attribute push(__attribute__((target("sse4.2"))), apply_to = function)
+  #else
+    #pragma GCC push_options
+    #pragma GCC target("sse4.2")
+  #endif
+
+  static inline std::uint64_t
+  load64(const std::uint8_t *data) {
+    std::uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return word;
+  }
+
+  static inline std::uint32_t
+  crc_tail(std::uint32_t crc, const std::uint8_t *data, std::size_t size) {
+    for (std::size_t x = 0; x < size; ++x) {
+      crc = _mm_crc32_u8(crc, data[x]);
+    }
+
+    return crc;
+  }
+
+  void
+  crc_runs_sse42(std::uint32_t *crcs, const std::uint8_t *data, std::size_t size, std::size_t count) {
+    auto words = size / 8 * 8;
+
+    // One crc32 depends on the previous one of its run, four runs at once hide the latency of the instruction
+    std::size_t run = 0;
+    for (; run + 4 <= count; run += 4) {
+      auto bytes = data + run * size;
+      std::uint64_t crc0 = crcs[run], crc1 = crcs[run + 1], crc2 = crcs[run + 2], crc3 = crcs[run + 3];
+      for (std::size_t x = 0; x < words; x += 8) {
+        crc0 = _mm_crc32_u64(crc0, load64(bytes + x));
+        crc1 = _mm_crc32_u64(crc1, load64(bytes + size + x));
+        crc2 = _mm_crc32_u64(crc2, load64(bytes + size * 2 + x));
+        crc3 = _mm_crc32_u64(crc3, load64(bytes + size * 3 + x));
+      }
+
+      crcs[run] = crc_tail((std::uint32_t) crc0, bytes + words, size - words);
+      crcs[run + 1] = crc_tail((std::uint32_t) crc1, bytes + size + words, size - words);
+      crcs[run + 2] = crc_tail((std::uint32_t) crc2, bytes + size * 2 + words, size - words);
+      crcs[run + 3] = crc_tail((std::uint32_t) crc3, bytes + size * 3 + words, size - words);
+    }
+
+    for (; run < count; ++run) {
+      auto bytes = data + run * size;
+      std::uint64_t crc = crcs[run];
+      for (std::size_t x = 0; x < words; x += 8) {
+        crc = _mm_crc32_u64(crc, load64(bytes + x));
+      }
+
+      crcs[run] = crc_tail((std::uint32_t) crc, bytes + words, size - words);
+    }
+  }
+
+  #if defined(__clang__)
+    #pragma clang attribute pop
+  #else
+    #pragma GCC pop_options
+  #endif
+#endif
+
+  const char *
+  init() {
+#ifdef SUNSHINE_TILE_HASH_X86
+    if (__builtin_cpu_supports("sse4.2")) {
+      crc_runs = crc_runs_sse42;
+      return "sse4.2";
+    }
+#endif
+
+    crc_runs = crc_runs_scalar;
+    return "scalar";
+  }
+
+  std::size_t
+  tracker_t::update(const platf::img_t &img) {
+    if (img.width != _width || img.height != _height) {
+      _width = img.width;
+      _height = img.height;
+      _columns = (_width + tile_size - 1) / tile_size;
+      _rows = (_height + tile_size - 1) / tile_size;
+      _hashes.clear();
+    }
+
+    auto tiles = (std::size_t) _columns * _rows;
+    _next.assign(tiles, ~0u);
+
+    // Row by row through the image, each row extends the hashes of a row of tiles
+    auto full_columns = _width / tile_size;
+    auto tile_bytes = (std::size_t) tile_size * img.pixel_pitch;
+    auto last_bytes = (std::size_t) (_width - full_columns * tile_size) * img.pixel_pitch;
+    for (int y = 0; y < _height; ++y) {
+      auto row = img.data + (std::size_t) y * img.row_pitch;
+      auto hashes = _next.data() + (std::size_t) (y / tile_size) * _columns;
+
+      crc_runs(hashes, row, tile_bytes, full_columns);
+      if (last_bytes) {
+        crc_runs(hashes + full_columns, row + full_columns * tile_bytes, last_bytes, 1);
+      }
+    }
+
+    _changed.resize(tiles);
+
+    std::size_t count = 0;
+    bool first = _hashes.size() != tiles;
+    for (std::size_t x = 0; x < tiles; ++x) {
+      _changed[x] = first || _hashes[x] != _next[x];
+      count += _changed[x];
+    }
+
+    std::swap(_hashes, _next);
+
+    return count;
+  }
+
+  void
+  tracker_t::reset() {
+    _hashes.clear();
+  }
+
+  std::vector<platf::rect_t>
+  tracker_t::damage() const {
+    std::vector<platf::rect_t> rects;
+    if (_changed.empty()) {
+      return rects;
+    }
+
+    for (int row = 0; row < _rows; ++row) {
+      auto changed = _changed.data() + (std::size_t) row * _columns;
+      auto top = row * tile_size;
+      auto height = std::min(tile_size, _height - top);
+
+      int column = 0;
+      while (column < _columns) {
+        if (!changed[column]) {
+          ++column;
+          continue;
+        }
+
+        auto first = column;
+        while (column < _columns && changed[column]) {
+          ++column;
+        }
+
+        auto left = first * tile_size;
+        rects.emplace_back(platf::rect_t { left, top, std::min(column * tile_size, _width) - left, height });
+      }
+    }
+
+    return rects;
+  }
+}  // namespace tile_hash
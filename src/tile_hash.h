@@ -0,0 +1,119 @@
+/**
+ * @file src/tile_hash.h
+ * @brief Declarations for the detection of changed tiles in captured images.
+ */
+#pragma once
+
+// standard includes
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// local includes
+#include "platform/common.h"
+
+namespace tile_hash {
+  /**
+   * @brief Width and height of the tiles in pixels, the tiles on the right and bottom edges may be smaller.
+   */
+  constexpr int tile_size = 64;
+
+  /**
+   * @brief Extend CRC32Cs with runs of bytes that follow each other, like the tiles of a row of pixels.
+   *
+   * Like the crc32 instructions, the CRCs are neither inverted before nor after.
+   * @param crcs The CRCs of the bytes so far, one per run.
+   * @param data The runs, the first byte of run `x` is `data[x * size]`.
+   * @param size The number of bytes of each run.
+   * @param count The number of runs.
+   */
+  using crc_runs_t = void (*)(std::uint32_t *crcs, const std::uint8_t *data, std::size_t size, std::size_t count);
+
+  /**
+   * @brief The best kernel for this CPU, selected by init(). Defaults to the scalar kernel.
+   */
+  extern crc_runs_t crc_runs;
+
+  /**
+   * @brief The reference implementation, the hardware kernels match it bit for bit.
+   */
+  void
+  crc_runs_scalar(std::uint32_t *crcs, const std::uint8_t *data, std::size_t size, std::size_t count);
+
+#if defined(__x86_64) || defined(__x86_64__) || defined(__amd64) || defined(__amd64__) || defined(_M_AMD64)
+  #define SUNSHINE_TILE_HASH_X86
+
+  void
+  crc_runs_sse42(std::uint32_t *crcs, const std::uint8_t *data, std::size_t size, std::size_t count);
+#endif
+
+  /**
+   * @brief Select the best kernel available on this CPU.
+   * @return The name of the selected kernel.
+   */
+  const char *
+  init();
+
+  /**
+   * @brief Tracks which tiles of the captured images changed from one image to the next.
+   *
+   * For capture backends that can't tell what changed, the rows of each tile are hashed
+   * into one CRC32C per tile, which is compared with the one of the previous image.
+   * Two different tiles hash alike with a chance of 1 in 2^32, such a change goes unnoticed
+   * until the tile changes again.
+   */
+  class tracker_t {
+  public:
+    /**
+     * @brief Hash the tiles of an image in main memory and compare them with those of the previous one.
+     * @return The number of tiles that changed, all of them for the first image, after reset()
+     *         or when the size of the images changed.
+     */
+    std::size_t
+    update(const platf::img_t &img);
+
+    /**
+     * @brief Forget the previous image, the next one is reported as changed entirely.
+     */
+    void
+    reset();
+
+    /**
+     * @return One entry per tile, row by row: non-zero if the tile changed in the last image.
+     */
+    const std::vector<std::uint8_t> &
+    changed() const {
+      return _changed;
+    }
+
+    /**
+     * @brief The tiles that changed in the last image, as rectangles clipped to the image.
+     *
+     * Adjacent tiles that changed in a row of tiles are merged into one rectangle.
+     */
+    std::vector<platf::rect_t>
+    damage() const;
+
+    int
+    columns() const {
+      return _columns;
+    }
+
+    int
+    rows() const {
+      return _rows;
+    }
+
+  private:
+    int _width {};
+    int _height {};
+    int _columns {};
+    int _rows {};
+
+    // The hashes of the previous image, empty after reset(), and those of the current one
+    std::vector<std::uint32_t> _hashes;
+    std::vector<std::uint32_t> _next;
+
+    std::vector<std::uint8_t> _changed;
+  };
+}  // namespace tile_hash
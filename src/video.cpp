@@ -3,10 +3,14 @@
  * @brief Definitions for video.
  */
 // standard includes
+#include <array>
 #include <atomic>
 #include <bitset>
 #include <functional>
-#include <list>
+#include <future>
+#include <map>
+#include <mutex>
+#include <sstream>
 #include <thread>
 
 #include <boost/pointer_cast.hpp>
@@ -42,15 +46,25 @@ struct AMFEncoderContext_Partial {
 
 // lib includes
 #include "cbs.h"
+#include "color_convert.h"
 #include "config.h"
 #include "display_device/display_device.h"
+#include "encoder_probe_cache.h"
+#include "frame_ring.h"
 #include "globals.h"
+#include "image_pool.h"
 #include "input.h"
 #include "logging.h"
 #include "nvenc/nvenc_encoder.h"
+#include "packet_pool.h"
 #include "platform/common.h"
+#include "shared_convert.h"
 #include "sync.h"
+#include "thread_placement.h"
+#include "tile_hash.h"
+#include "version.h"
 #include "video.h"
+#include "video_broadcast.h"
 
 #ifdef _WIN32
 extern "C" {
@@ -109,6 +123,36 @@ namespace video {
     av_buffer_unref(&ref);
   }
 
+  int
+  frame_view(AVFrame *view, const AVFrame *frame, int x, int y, int width, int height) {
+    av_frame_unref(view);
+
+    if (!frame->buf[0]) {
+      return -1;
+    }
+
+    view->buf[0] = av_buffer_ref(frame->buf[0]);
+    if (!view->buf[0]) {
+      return -1;
+    }
+
+    view->format = frame->format;
+    view->width = width;
+    view->height = height;
+
+    auto fmt_desc = av_pix_fmt_desc_get((AVPixelFormat) frame->format);
+    auto planes = av_pix_fmt_count_planes((AVPixelFormat) frame->format);
+    for (int plane = 0; plane < planes; plane++) {
+      auto shift_h = plane == 0 ? 0 : fmt_desc->log2_chroma_h;
+      auto shift_w = plane == 0 ? 0 : fmt_desc->log2_chroma_w;
+
+      view->data[plane] = frame->data[plane] + ((x >> shift_w) * fmt_desc->comp[plane].step) + (y >> shift_h) * frame->linesize[plane];
+      view->linesize[plane] = frame->linesize[plane];
+    }
+
+    return 0;
+  }
+
   namespace nv {
 
     enum class profile_h264_e : int {
@@ -157,37 +201,12 @@ namespace video {
   public:
     int
     convert(platf::img_t &img) override {
-      // If we need to add aspect ratio padding, we need to scale into an intermediate output buffer
-      bool requires_padding = (sw_frame->width != sws_output_frame->width || sw_frame->height != sws_output_frame->height);
-
-      // Setup the input frame using the caller's img_t
-      sws_input_frame->data[0] = img.data;
-      sws_input_frame->linesize[0] = img.row_pitch;
-
-      // Perform color conversion and scaling to the final size
-      auto status = sws_scale_frame(sws.get(), requires_padding ? sws_output_frame.get() : sw_frame.get(), sws_input_frame.get());
-      if (status < 0) {
-        char string[AV_ERROR_MAX_STRING_SIZE];
-        BOOST_LOG(error) << "Couldn't scale frame: "sv << av_make_error_string(string, AV_ERROR_MAX_STRING_SIZE, status);
-        return -1;
+      if (shared) {
+        return shared->convert(img, frame);
       }
 
-      // If we require aspect ratio padding, copy the output frame into the final padded frame
-      if (requires_padding) {
-        auto fmt_desc = av_pix_fmt_desc_get((AVPixelFormat) sws_output_frame->format);
-        auto planes = av_pix_fmt_count_planes((AVPixelFormat) sws_output_frame->format);
-        for (int plane = 0; plane < planes; plane++) {
-          auto shift_h = plane == 0 ? 0 : fmt_desc->log2_chroma_h;
-          auto shift_w = plane == 0 ? 0 : fmt_desc->log2_chroma_w;
-          auto offset = ((offsetW >> shift_w) * fmt_desc->comp[plane].step) + (offsetH >> shift_h) * sw_frame->linesize[plane];
-
-          // Copy line-by-line to preserve leading padding for each row
-          for (int line = 0; line < sws_output_frame->height >> shift_h; line++) {
-            memcpy(sw_frame->data[plane] + offset + (line * sw_frame->linesize[plane]),
-              sws_output_frame->data[plane] + (line * sws_output_frame->linesize[plane]),
-              (size_t) (sws_output_frame->width >> shift_w) * fmt_desc->comp[plane].step);
-          }
-        }
+      if (convert_into(img, sws_output_frame.get())) {
+        return -1;
       }
 
       // If frame is not a software frame, it means we still need to transfer from main memory
@@ -204,6 +223,41 @@ namespace video {
       return 0;
     }
 
+    /**
+     * @brief Convert an image into a view made by view(), without touching `frame`.
+     */
+    int
+    convert_into(platf::img_t &img, AVFrame *view) {
+      // Both paths write straight into the final frame, past the aspect ratio padding
+      if (converter) {
+        converter->convert(img.data, img.row_pitch, view->data, view->linesize);
+        return 0;
+      }
+
+      // Setup the input frame using the caller's img_t
+      sws_input_frame->data[0] = img.data;
+      sws_input_frame->linesize[0] = img.row_pitch;
+
+      // Perform color conversion and scaling to the final size
+      auto status = sws_scale_frame(sws.get(), view, sws_input_frame.get());
+      if (status < 0) {
+        char string[AV_ERROR_MAX_STRING_SIZE];
+        BOOST_LOG(error) << "Couldn't scale frame: "sv << av_make_error_string(string, AV_ERROR_MAX_STRING_SIZE, status);
+        return -1;
+      }
+
+      return 0;
+    }
+
+    /**
+     * @brief Make `view` the area of `frame` the image is converted into, past the aspect ratio padding.
+     * @param frame A frame with the format and size of the current one.
+     */
+    int
+    view(AVFrame *view, AVFrame *frame) {
+      return frame_view(view, frame, offsetW, offsetH, sws_output_frame->width, sws_output_frame->height);
+    }
+
     int
     set_frame(AVFrame *frame, AVBufferRef *hw_frames_ctx) override {
       this->frame = frame;
@@ -228,6 +282,16 @@ namespace video {
         sws_getCoefficients(SWS_CS_DEFAULT), 0,
         sws_getCoefficients(avcodec_colorspace.software_format), avcodec_colorspace.range - 1,
         0, 1 << 16, 1 << 16);
+
+      // Sessions encoding the same images in main memory convert each of them only once
+      if (config::video.shared_conversion && !hw_frame) {
+        shared = shared_convert_t::get((AVPixelFormat) sws_output_frame->format, colorspace, sws_input_frame->width, sws_input_frame->height);
+      }
+
+      if (unscaled && !shared) {
+        converter = std::make_unique<color_convert::converter_t>((AVPixelFormat) sws_output_frame->format, colorspace,
+          sws_output_frame->width, sws_output_frame->height, config::video.min_threads);
+      }
     }
 
     /**
@@ -272,15 +336,22 @@ namespace video {
       sws_input_frame->height = in_height;
       sws_input_frame->format = AV_PIX_FMT_BGR0;
 
-      sws_output_frame.reset(av_frame_alloc());
-      sws_output_frame->width = out_width;
-      sws_output_frame->height = out_height;
-      sws_output_frame->format = format;
-
       // Result is always positive
       offsetW = (frame->width - out_width) / 2;
       offsetH = (frame->height - out_height) / 2;
 
+      // The image is written in place into the padded frame, prefill() has blackened the borders for good
+      sws_output_frame.reset(av_frame_alloc());
+      if (frame_view(sws_output_frame.get(), sw_frame ? sw_frame.get() : this->frame, offsetW, offsetH, out_width, out_height)) {
+        BOOST_LOG(error) << "Failed to map the image into the padded frame"sv;
+        return -1;
+      }
+
+      // Without scaling, the common case, only the colors need converting.
+      // An odd offset would split the chroma samples of subsampled formats.
+      unscaled = out_width == in_width && out_height == in_height && !(offsetW & 1) && !(offsetH & 1) &&
+                 color_convert::converter_t::supported(format);
+
       sws.reset(sws_alloc_context());
       if (!sws) {
         return -1;
@@ -319,9 +390,18 @@ namespace video {
 
     avcodec_frame_t sw_frame;
     avcodec_frame_t sws_input_frame;
+
+    // View of the final frame, without the aspect ratio padding
     avcodec_frame_t sws_output_frame;
     sws_t sws;
 
+    // Replaces swscale when the image doesn't need scaling
+    bool unscaled {};
+    std::unique_ptr<color_convert::converter_t> converter;
+
+    // Replaces both when the conversion is shared with other sessions
+    std::shared_ptr<shared_convert_t> shared;
+
     // Offset of input image to output frame in pixels
     int offsetW;
     int offsetH;
@@ -340,13 +420,14 @@ namespace video {
     ALWAYS_REPROBE = 1 << 9,  ///< This is an encoder of last resort and we want to aggressively probe for a better one
     YUV444_SUPPORT = 1 << 10,  ///< Encoder may support 4:4:4 chroma sampling depending on hardware
     ASYNC_TEARDOWN = 1 << 11,  ///< Encoder supports async teardown on a different thread
+    PARALLEL_PROBING = 1 << 12,  ///< Test sessions can be validated concurrently, each on a display of its own. Not for DXGI capture, its desktop duplication is exclusive per output
   };
 
   class avcodec_encode_session_t: public encode_session_t {
   public:
     avcodec_encode_session_t() = default;
-    avcodec_encode_session_t(avcodec_ctx_t &&avcodec_ctx, std::unique_ptr<platf::avcodec_encode_device_t> encode_device, int inject):
-        avcodec_ctx { std::move(avcodec_ctx) }, device { std::move(encode_device) }, inject { inject } {}
+    avcodec_encode_session_t(avcodec_ctx_t &&avcodec_ctx, std::unique_ptr<platf::avcodec_encode_device_t> encode_device, packet_pool_t &&packet_pool, int inject):
+        avcodec_ctx { std::move(avcodec_ctx) }, device { std::move(encode_device) }, packet_pool { std::move(packet_pool) }, inject { inject } {}
 
     avcodec_encode_session_t(avcodec_encode_session_t &&other) noexcept = default;
     ~avcodec_encode_session_t() {
@@ -356,6 +437,11 @@ namespace video {
         while (avcodec_receive_packet(avcodec_ctx.get(), pkt.av_packet) == 0);
       }
 
+      if (avcodec_ctx) {
+        auto stats = packet_pool.stats();
+        BOOST_LOG(debug) << "Encoded "sv << stats.packets << " packets into "sv << stats.allocations << " buffers of up to "sv << stats.buffer_size << " bytes"sv;
+      }
+
       // Order matters here because the context relies on the hwdevice still being valid
       avcodec_ctx.reset();
       device.reset();
@@ -366,11 +452,16 @@ namespace video {
     operator=(avcodec_encode_session_t &&other) {
       device = std::move(other.device);
       avcodec_ctx = std::move(other.avcodec_ctx);
-      replacements = std::move(other.replacements);
-      sps = std::move(other.sps);
-      vps = std::move(other.vps);
+      packet_pool = std::move(other.packet_pool);
+      parameter_sets = std::move(other.parameter_sets);
 
       inject = other.inject;
+      refresh_period = other.refresh_period;
+      frame_nr = other.frame_nr;
+      recovery_frame_nr = other.recovery_frame_nr;
+      recovery_pending = other.recovery_pending;
+      damage_roi = other.damage_roi;
+      loss_reports_expected = other.loss_reports_expected;
 
       return *this;
     }
@@ -401,7 +492,27 @@ namespace video {
 
     void
     invalidate_ref_frames(int64_t first_frame, int64_t last_frame) override {
-      BOOST_LOG(error) << "Encoder doesn't support reference frame invalidation";
+      if (!refresh_period) {
+        // Advertised for the intra refresh before the client chose its codec
+        if (loss_reports_expected) {
+          BOOST_LOG(debug) << "Intra refresh only applies to H.264, recovering from the loss with an IDR frame"sv;
+        }
+        else {
+          BOOST_LOG(error) << "Encoder doesn't support reference frame invalidation";
+        }
+        request_idr_frame();
+        return;
+      }
+
+      // The refresh cycles repair a loss without an IDR frame.
+      // A client reporting another loss within two cycles couldn't recover, it gets an IDR frame then.
+      if (!recovery_frame_nr || frame_nr - *recovery_frame_nr > 2 * refresh_period) {
+        recovery_frame_nr = frame_nr;
+        recovery_pending = true;
+        return;
+      }
+
+      recovery_frame_nr.reset();
       request_idr_frame();
     }
 
@@ -469,6 +580,53 @@ namespace video {
                       << config::stream.fec_percentage << "%)";
     }
 
+    void
+    set_damage(const std::vector<platf::rect_t> &damage, int width, int height) override {
+      if (!damage_roi || !device || !device->frame) {
+        return;
+      }
+
+      auto frame = device->frame;
+      av_frame_remove_side_data(frame, AV_FRAME_DATA_REGIONS_OF_INTEREST);
+
+      // Without damage the whole image may have changed, and an IDR frame must be sharp everywhere
+      if (damage.empty() || width <= 0 || height <= 0 || frame->pict_type == AV_PICTURE_TYPE_I) {
+        return;
+      }
+
+      auto side_data = av_frame_new_side_data(frame, AV_FRAME_DATA_REGIONS_OF_INTEREST, sizeof(AVRegionOfInterest) * (damage.size() + 1));
+      if (!side_data) {
+        return;
+      }
+
+      // The image is scaled into the frame keeping its aspect ratio, like the touch port
+      auto scalar = std::fminf((float) frame->width / width, (float) frame->height / height);
+      auto offset_x = (frame->width - width * scalar) * 0.5f;
+      auto offset_y = (frame->height - height * scalar) * 0.5f;
+
+      // Earlier regions take precedence, the changed areas keep the quality of the rate control
+      auto regions = (AVRegionOfInterest *) side_data->data;
+      for (std::size_t x = 0; x < damage.size(); ++x) {
+        auto &rect = damage[x];
+        regions[x] = AVRegionOfInterest {
+          sizeof(AVRegionOfInterest),
+          (int) (offset_y + rect.y * scalar),
+          (int) std::ceil(offset_y + (rect.y + rect.height) * scalar),
+          (int) (offset_x + rect.x * scalar),
+          (int) std::ceil(offset_x + (rect.x + rect.width) * scalar),
+          { 0, 1 },
+        };
+      }
+      regions[damage.size()] = AVRegionOfInterest {
+        sizeof(AVRegionOfInterest),
+        0,
+        frame->height,
+        0,
+        frame->width,
+        unchanged_qoffset,
+      };
+    }
+
     void
     set_dynamic_param(const dynamic_param_t &param) override {
       if (!avcodec_ctx) return;
@@ -508,13 +666,38 @@ namespace video {
     avcodec_ctx_t avcodec_ctx;
     std::unique_ptr<platf::avcodec_encode_device_t> device;
 
-    std::vector<packet_raw_t::replace_t> replacements;
+    // The encoder writes into its buffers, it must outlive the context
+    packet_pool_t packet_pool;
 
-    cbs::nal_t sps;
-    cbs::nal_t vps;
+    // The parameter sets rewritten for injection, shared with the packets whose payload references them
+    struct parameter_sets_t {
+      cbs::nal_t sps;
+      cbs::nal_t vps;
+      std::vector<packet_raw_t::replace_t> replacements;
+    };
+    std::shared_ptr<parameter_sets_t> parameter_sets;
 
     // inject sps/vps data into idr pictures
     int inject;
+
+    // Frames per intra refresh cycle, 0 if losses are recovered from with IDR frames
+    int refresh_period {};
+
+    // The last frame encoded, and the one during which a loss was left to the refresh cycles
+    int64_t frame_nr {};
+    std::optional<int64_t> recovery_frame_nr;
+
+    // The next packet is the first one after a loss left to the refresh cycles
+    bool recovery_pending {};
+
+    // Clients report losses to the software encoder with intra refresh, whatever the codec
+    bool loss_reports_expected {};
+
+    // Hint the encoder with regions of interest to code the areas that didn't change at a lower quality
+    bool damage_roi {};
+
+    // A tenth of the QP range, about 5 more for 8-bit libx264
+    static constexpr AVRational unchanged_qoffset { 1, 10 };
   };
 
   class nvenc_encode_session_t: public encode_session_t {
@@ -603,14 +786,16 @@ namespace video {
     }
 
     nvenc::nvenc_encoded_frame
-    encode_frame(uint64_t frame_index) {
+    encode_frame(uint64_t frame_index, std::vector<uint8_t> &&buffer) {
       if (!device || !device->nvenc) return {};
 
-      auto result = device->nvenc->encode_frame(frame_index, force_idr);
+      auto result = device->nvenc->encode_frame(frame_index, force_idr, std::move(buffer));
       force_idr = false;
       return result;
     }
 
+    packet_pool_t packet_pool;
+
   private:
     std::unique_ptr<platf::nvenc_encode_device_t> device;
     bool force_idr = false;
@@ -623,6 +808,7 @@ namespace video {
     safe::mail_raw_t::event_t<bool> idr_events;
     safe::mail_raw_t::event_t<hdr_info_t> hdr_events;
     safe::mail_raw_t::event_t<input::touch_port_t> touch_port_events;
+    safe::mail_raw_t::event_t<int> switch_display_events;
 
     config_t config;
     int frame_nr;
@@ -640,6 +826,9 @@ namespace video {
   struct capture_ctx_t {
     img_event_t images;
     config_t config;
+
+    // Display switches requested by the session
+    safe::mail_raw_t::event_t<int> switch_display_events;
   };
 
   struct capture_thread_async_ctx_t {
@@ -649,6 +838,9 @@ namespace video {
     safe::signal_t reinit_event;
     const encoder_t *encoder_p;
     sync_util::sync_t<std::weak_ptr<platf::display_t>> display_wp;
+
+    // Set once a session switched the display, new sessions get a capture thread of their own then
+    std::atomic_bool display_switched {};
   };
 
   struct capture_thread_sync_ctx_t {
@@ -664,14 +856,19 @@ namespace video {
   void
   end_capture_async(capture_thread_async_ctx_t &ctx);
 
-  // Keep a reference counter to ensure the capture thread only runs when other threads have a reference to the capture thread
-  auto capture_thread_async = safe::make_shared<capture_thread_async_ctx_t>(start_capture_async, end_capture_async);
+  // Keep a reference counter to ensure a capture thread only runs when other threads have a reference to it.
+  // Asynchronous capture runs one thread per display, so clients streaming different displays capture in parallel.
+  std::mutex capture_threads_async_lock;
+  std::map<std::string, std::unique_ptr<safe::shared_t<capture_thread_async_ctx_t>>> capture_threads_async;
+
+  // Capture threads whose sessions switched to another display, kept until their last session ends
+  std::vector<std::unique_ptr<safe::shared_t<capture_thread_async_ctx_t>>> capture_threads_async_retired;
   auto capture_thread_sync = safe::make_shared<capture_thread_sync_ctx_t>(start_capture_sync, end_capture_sync);
 
 #ifdef _WIN32
   encoder_t nvenc {
     "nvenc"sv,
-    std::make_unique<encoder_platform_formats_nvenc>(
+    std::make_shared<encoder_platform_formats_nvenc>(
       platf::mem_type_e::dxgi,
       platf::pix_fmt_e::nv12, platf::pix_fmt_e::p010,
       platf::pix_fmt_e::ayuv, platf::pix_fmt_e::yuv444p16),
@@ -707,7 +904,7 @@ namespace video {
 #elif !defined(__APPLE__)
   encoder_t nvenc {
     "nvenc"sv,
-    std::make_unique<encoder_platform_formats_avcodec>(
+    std::make_shared<encoder_platform_formats_avcodec>(
   #ifdef _WIN32
       AV_HWDEVICE_TYPE_D3D11VA, AV_HWDEVICE_TYPE_NONE,
       AV_PIX_FMT_D3D11,
@@ -795,14 +992,14 @@ namespace video {
       {},  // Fallback options
       "h264_nvenc"s,
     },
-    PARALLEL_ENCODING
+    PARALLEL_ENCODING | PARALLEL_PROBING
   };
 #endif
 
 #ifdef _WIN32
   encoder_t quicksync {
     "quicksync"sv,
-    std::make_unique<encoder_platform_formats_avcodec>(
+    std::make_shared<encoder_platform_formats_avcodec>(
       AV_HWDEVICE_TYPE_D3D11VA, AV_HWDEVICE_TYPE_QSV,
       AV_PIX_FMT_QSV,
       AV_PIX_FMT_NV12, AV_PIX_FMT_P010,
@@ -904,7 +1101,7 @@ namespace video {
 
   encoder_t amdvce {
     "amdvce"sv,
-    std::make_unique<encoder_platform_formats_avcodec>(
+    std::make_shared<encoder_platform_formats_avcodec>(
       AV_HWDEVICE_TYPE_D3D11VA, AV_HWDEVICE_TYPE_NONE,
       AV_PIX_FMT_D3D11,
       AV_PIX_FMT_NV12, AV_PIX_FMT_P010,
@@ -1006,9 +1203,18 @@ namespace video {
   };
 #endif
 
+  /**
+   * @return Frames per intra refresh cycle of libx264, 0 if it sends IDR frames on loss.
+   */
+  int
+  sw_intra_refresh_period() {
+    // A session joining a shared encoder needs an IDR frame to start from
+    return config::video.shared_encoder ? 0 : config::video.sw.sw_intra_refresh;
+  }
+
   encoder_t software {
     "software"sv,
-    std::make_unique<encoder_platform_formats_avcodec>(
+    std::make_shared<encoder_platform_formats_avcodec>(
       AV_HWDEVICE_TYPE_NONE, AV_HWDEVICE_TYPE_NONE,
       AV_PIX_FMT_NONE,
       AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P10,
@@ -1061,6 +1267,10 @@ namespace video {
       {
         { "preset"s, &config::video.sw.sw_preset },
         { "tune"s, &config::video.sw.sw_tune },
+        { "x264-params"s, [](const config_t &) -> const std::string {
+           auto period = sw_intra_refresh_period();
+           return period ? "keyint="s + std::to_string(period) + ":intra-refresh=1" : ""s;
+         } },
       },
       {},  // SDR-specific options
       {},  // HDR-specific options
@@ -1069,13 +1279,17 @@ namespace video {
       {},  // Fallback options
       "libx264"s,
     },
+#ifdef _WIN32
     H264_ONLY | PARALLEL_ENCODING | ALWAYS_REPROBE | YUV444_SUPPORT
+#else
+    H264_ONLY | PARALLEL_ENCODING | ALWAYS_REPROBE | YUV444_SUPPORT | PARALLEL_PROBING
+#endif
   };
 
 #ifdef __linux__
   encoder_t vaapi {
     "vaapi"sv,
-    std::make_unique<encoder_platform_formats_avcodec>(
+    std::make_shared<encoder_platform_formats_avcodec>(
       AV_HWDEVICE_TYPE_VAAPI, AV_HWDEVICE_TYPE_NONE,
       AV_PIX_FMT_VAAPI,
       AV_PIX_FMT_NV12, AV_PIX_FMT_P010,
@@ -1130,7 +1344,7 @@ namespace video {
 #ifdef __APPLE__
   encoder_t videotoolbox {
     "videotoolbox"sv,
-    std::make_unique<encoder_platform_formats_avcodec>(
+    std::make_shared<encoder_platform_formats_avcodec>(
       AV_HWDEVICE_TYPE_VIDEOTOOLBOX, AV_HWDEVICE_TYPE_NONE,
       AV_PIX_FMT_VIDEOTOOLBOX,
       AV_PIX_FMT_NV12, AV_PIX_FMT_P010,
@@ -1209,6 +1423,7 @@ namespace video {
   };
 
   static encoder_t *chosen_encoder;
+  std::mutex probe_result_lock;
   int active_hevc_mode;
   int active_av1_mode;
   bool last_encoder_probe_supported_ref_frames_invalidation = false;
@@ -1287,11 +1502,95 @@ namespace video {
     }
   }
 
+  /**
+   * @brief Pick the display to capture for a session.
+   * @param display_names The displays, as refreshed by refresh_displays().
+   * @param display_p The selected display, updated to the one picked.
+   * @param display_name The display the session asked for, empty for the selected one.
+   * @return The name of the display.
+   */
+  std::string
+  pick_display(const std::vector<std::string> &display_names, int &display_p, const std::string &display_name) {
+    if (!display_name.empty()) {
+      for (int x = 0; x < display_names.size(); ++x) {
+        if (display_names[x] == display_name) {
+          display_p = x;
+          return display_name;
+        }
+      }
+
+      BOOST_LOG(warning) << "Client-specified display [" << display_name << "] not found, using default display";
+    }
+
+    return display_names[display_p];
+  }
+
+  /**
+   * @brief The capture settings that suit every session of a capture thread.
+   *
+   * The display is captured at the highest frame rate any of them streams at,
+   * the other settings are those of the first session.
+   */
+  config_t
+  capture_config(const std::vector<capture_ctx_t> &capture_ctxs) {
+    auto config = capture_ctxs.front().config;
+    for (auto &capture_ctx : capture_ctxs) {
+      if (capture_ctx.config.get_effective_framerate() > config.get_effective_framerate()) {
+        config.framerate = capture_ctx.config.framerate;
+        config.frameRateNum = capture_ctx.config.frameRateNum;
+        config.frameRateDen = capture_ctx.config.frameRateDen;
+      }
+    }
+
+    return config;
+  }
+
+  /**
+   * @brief Get a reference to the capture thread for the session's display, starting it if needed.
+   * @details Sessions streaming the same display share its capture thread, whatever their frame rate.
+   */
+  safe::shared_t<capture_thread_async_ctx_t>::ptr_t
+  ref_capture_thread_async(const config_t &config) {
+    // Resolve the display now, so the configured display and an explicit request for it share a thread
+    std::vector<std::string> display_names;
+    int display_p = -1;
+    refresh_displays(chosen_encoder->platform_formats->dev_type, display_names, display_p);
+    auto display_name = pick_display(display_names, display_p, config.display_name);
+
+    std::lock_guard lg { capture_threads_async_lock };
+
+    // Forget the capture threads that stopped with their last session
+    std::erase_if(capture_threads_async, [&](auto &entry) {
+      return entry.first != display_name && !entry.second->has_ref();
+    });
+    std::erase_if(capture_threads_async_retired, [](auto &capture_thread) {
+      return !capture_thread->has_ref();
+    });
+
+    auto &capture_thread = capture_threads_async[display_name];
+    if (capture_thread && capture_thread->has_ref()) {
+      auto ref = capture_thread->ref();
+      if (!ref || !ref->display_switched) {
+        return ref;
+      }
+
+      // Its sessions moved on to another display
+      capture_threads_async_retired.emplace_back(std::move(capture_thread));
+    }
+
+    if (!capture_thread) {
+      capture_thread = std::make_unique<safe::shared_t<capture_thread_async_ctx_t>>(start_capture_async, end_capture_async);
+    }
+
+    return capture_thread->ref();
+  }
+
   void
   captureThread(
     std::shared_ptr<safe::queue_t<capture_ctx_t>> capture_ctx_queue,
     sync_util::sync_t<std::weak_ptr<platf::display_t>> &display_wp,
     safe::signal_t &reinit_event,
+    std::atomic_bool &display_switched,
     const encoder_t &encoder) {
     std::vector<capture_ctx_t> capture_ctxs;
 
@@ -1307,8 +1606,6 @@ namespace video {
       }
     });
 
-    auto switch_display_event = mail::man->event<int>(mail::switch_display);
-
     // Wait for the initial capture context or a request to stop the queue
     auto initial_capture_ctx = capture_ctx_queue->pop();
     if (!initial_capture_ctx) {
@@ -1321,140 +1618,66 @@ namespace video {
     std::vector<std::string> display_names;
     int display_p = -1;
     refresh_displays(encoder.platform_formats->dev_type, display_names, display_p);
-    
+
     // Use client-specified display_name if provided, otherwise use the selected display
-    std::string target_display_name;
-    const auto &config = capture_ctxs.front().config;
-    if (!config.display_name.empty()) {
-      // Try to find the client-specified display in the list
-      bool found = false;
-      for (int x = 0; x < display_names.size(); ++x) {
-        if (display_names[x] == config.display_name) {
-          display_p = x;
-          target_display_name = config.display_name;
-          found = true;
-          BOOST_LOG(info) << "Using client-specified display: " << target_display_name;
-          break;
-        }
-      }
-      if (!found) {
-        BOOST_LOG(warning) << "Client-specified display [" << config.display_name << "] not found, using default display";
-        target_display_name = display_names[display_p];
-      }
-    }
-    else {
-      target_display_name = display_names[display_p];
-    }
-    
+    auto config = capture_config(capture_ctxs);
+    auto target_display_name = pick_display(display_names, display_p, config.display_name);
+
     auto disp = platf::display(encoder.platform_formats->dev_type, target_display_name, config);
     if (!disp) {
       return;
     }
     display_wp = disp;
 
+    // Free images are destroyed after sitting unused for 3 seconds
     constexpr auto capture_buffer_size = 12;
-    std::list<std::shared_ptr<platf::img_t>> imgs(capture_buffer_size);
-
-    std::vector<std::optional<std::chrono::steady_clock::time_point>> imgs_used_timestamps;
-    const std::chrono::seconds trim_timeot = 3s;
-    auto trim_imgs = [&]() {
-      // count allocated and used within current pool
-      size_t allocated_count = 0;
-      size_t used_count = 0;
-      for (const auto &img : imgs) {
-        if (img) {
-          allocated_count += 1;
-          if (img.use_count() > 1) {
-            used_count += 1;
-          }
-        }
-      }
-
-      // remember the timestamp of currently used count
-      const auto now = std::chrono::steady_clock::now();
-      if (imgs_used_timestamps.size() <= used_count) {
-        imgs_used_timestamps.resize(used_count + 1);
-      }
-      imgs_used_timestamps[used_count] = now;
-
-      // decide whether to trim allocated unused above the currently used count
-      // based on last used timestamp and universal timeout
-      size_t trim_target = used_count;
-      for (size_t i = used_count; i < imgs_used_timestamps.size(); i++) {
-        if (imgs_used_timestamps[i] && now - *imgs_used_timestamps[i] < trim_timeot) {
-          trim_target = i;
-        }
-      }
-
-      // trim allocated unused above the newly decided trim target
-      if (allocated_count > trim_target) {
-        size_t to_trim = allocated_count - trim_target;
-        // prioritize trimming least recently used
-        for (auto it = imgs.rbegin(); it != imgs.rend(); it++) {
-          auto &img = *it;
-          if (img && img.use_count() == 1) {
-            img.reset();
-            to_trim -= 1;
-            if (to_trim == 0) break;
-          }
-        }
-        // forget timestamps that no longer relevant
-        imgs_used_timestamps.resize(trim_target + 1);
-      }
-    };
+    image_pool_t imgs { capture_buffer_size, 3s };
 
     auto pull_free_image_callback = [&](std::shared_ptr<platf::img_t> &img_out) -> bool {
+      // Return the previous image first, in case the pool is exhausted
       img_out.reset();
-      while (capture_ctx_queue->running()) {
-        // pick first allocated but unused
-        for (auto it = imgs.begin(); it != imgs.end(); it++) {
-          if (*it && it->use_count() == 1) {
-            img_out = *it;
-            if (it != imgs.begin()) {
-              // move image to the front of the list to prioritize its reusal
-              imgs.erase(it);
-              imgs.push_front(img_out);
-            }
-            break;
-          }
-        }
-        // otherwise pick first unallocated
-        if (!img_out) {
-          for (auto it = imgs.begin(); it != imgs.end(); it++) {
-            if (!*it) {
-              // allocate image
-              *it = disp->alloc_img();
-              img_out = *it;
-              if (it != imgs.begin()) {
-                // move image to the front of the list to prioritize its reusal
-                imgs.erase(it);
-                imgs.push_front(img_out);
-              }
-              break;
-            }
-          }
-        }
-        if (img_out) {
-          // trim allocated but unused portion of the pool based on timeouts
-          trim_imgs();
-          img_out->frame_timestamp.reset();
-          return true;
-        }
-        else {
-          // sleep and retry if image pool is full
-          std::this_thread::sleep_for(1ms);
+      img_out = imgs.acquire(
+        [&]() {
+          return disp->alloc_img();
+        },
+        [&]() {
+          return capture_ctx_queue->running();
+        });
+
+      if (!img_out) {
+        if (capture_ctx_queue->running()) {
+          BOOST_LOG(error) << "Couldn't allocate a capture image"sv;
         }
+
+        return false;
       }
-      return false;
+
+      img_out->frame_timestamp.reset();
+      img_out->damage.clear();
+      return true;
     };
 
+    // Without damage reported by the backend, the images are compared tile by tile
+    tile_hash::tracker_t tiles;
+
     // Capture takes place on this thread
-    platf::adjust_thread_priority(platf::thread_priority_e::critical);
+    thread_placement::apply(thread_placement::thread_e::capture, platf::thread_priority_e::critical);
 
     while (capture_ctx_queue->running()) {
       bool artificial_reinit = false;
 
       auto push_captured_image_callback = [&](std::shared_ptr<platf::img_t> &&img, bool frame_captured) -> bool {
+        if (frame_captured && config::video.skip_static_frames && img->data && img->damage.empty()) {
+          if (!tiles.update(*img)) {
+            // Like a capture timeout, the encoders repeat the previous frame when they must
+            frame_captured = false;
+          }
+          else {
+            // The encoder spends its bits on the tiles that changed
+            img->damage = tiles.damage();
+          }
+        }
+
         KITTY_WHILE_LOOP(auto capture_ctx = std::begin(capture_ctxs), capture_ctx != std::end(capture_ctxs), {
           if (!capture_ctx->images->running()) {
             capture_ctx = capture_ctxs.erase(capture_ctx);
@@ -1475,14 +1698,24 @@ namespace video {
 
         while (capture_ctx_queue->peek()) {
           capture_ctxs.emplace_back(std::move(*capture_ctx_queue->pop()));
+
+          // A new session starts from a blank frame, it needs the next image even if nothing changed
+          tiles.reset();
+
+          // Reopen the display to capture at the frame rate of a faster session
+          if (capture_ctxs.back().config.get_effective_framerate() > config.get_effective_framerate()) {
+            artificial_reinit = true;
+          }
         }
 
-        if (switch_display_event->peek()) {
-          artificial_reinit = true;
-          return false;
+        // A session asked to switch the display it streams, see input::apply_shortcut()
+        for (auto &capture_ctx : capture_ctxs) {
+          if (capture_ctx.switch_display_events->peek()) {
+            artificial_reinit = true;
+          }
         }
 
-        return true;
+        return !artificial_reinit;
       };
 
       auto status = disp->capture(push_captured_image_callback, pull_free_image_callback, &display_cursor);
@@ -1498,9 +1731,8 @@ namespace video {
           reinit_event.raise(true);
 
           // Some classes of images contain references to the display --> display won't delete unless img is deleted
-          for (auto &img : imgs) {
-            img.reset();
-          }
+          imgs.clear();
+          tiles.reset();
 
           // display_wp is modified in this thread only
           // Wait for the other shared_ptr's of display to be destroyed.
@@ -1535,29 +1767,21 @@ namespace video {
             refresh_displays(encoder.platform_formats->dev_type, display_names, display_p);
 
             // Process any pending display switch with the new list of displays
-            if (switch_display_event->peek()) {
-              display_p = std::clamp(*switch_display_event->pop(), 0, (int) display_names.size() - 1);
-            }
+            for (auto &capture_ctx : capture_ctxs) {
+              if (capture_ctx.switch_display_events->peek()) {
+                display_p = std::clamp(*capture_ctx.switch_display_events->pop(), 0, (int) display_names.size() - 1);
 
-            // Use client-specified display_name if provided
-            const auto &config = capture_ctxs.front().config;
-            std::string target_display_name = display_names[display_p];
-            if (!config.display_name.empty()) {
-              // Try to find the client-specified display in the list
-              bool found = false;
-              for (int x = 0; x < display_names.size(); ++x) {
-                if (display_names[x] == config.display_name) {
-                  display_p = x;
-                  target_display_name = config.display_name;
-                  found = true;
-                  break;
-                }
-              }
-              if (!found) {
-                BOOST_LOG(warning) << "Client-specified display [" << config.display_name << "] not found, using default display";
+                // The sessions of this thread no longer capture the display it was started for
+                display_switched = true;
               }
             }
 
+            // Use client-specified display_name if provided, unless the sessions switched to another display
+            config = capture_config(capture_ctxs);
+            auto target_display_name = display_switched ?
+                                         display_names[display_p] :
+                                         pick_display(display_names, display_p, config.display_name);
+
             // reset_display() will sleep between retries
             reset_display(disp, encoder.platform_formats->dev_type, target_display_name, config);
             if (disp) {
@@ -1585,16 +1809,58 @@ namespace video {
     }
   }
 
+  std::vector<std::string_view>
+  gather_replacements(std::string_view data, const std::vector<packet_raw_t::replace_t> &replacements, bool hevc) {
+    constexpr auto start_code = "\0\0\1"sv;
+
+    std::vector<std::string_view> pieces;
+
+    // The start of the data that isn't part of the pieces yet
+    std::size_t next = 0;
+    for (auto pos = data.find(start_code); pos != std::string_view::npos; pos = data.find(start_code, pos + start_code.size())) {
+      auto header = pos + start_code.size();
+      if (header >= data.size()) {
+        break;
+      }
+
+      // The parameter sets precede the slices, which are left alone
+      auto nal_type = (std::uint8_t) data[header];
+      if (hevc ? ((nal_type >> 1) & 0x3F) < 32 : (nal_type & 0x1F) >= 1 && (nal_type & 0x1F) <= 5) {
+        break;
+      }
+
+      for (auto &replacement : replacements) {
+        // The start code of the replaced NAL unit may have more leading zeros than the one found
+        auto zeros = replacement.old.find_first_not_of('\0');
+        if (zeros == std::string_view::npos || zeros < 2 || zeros > pos + 2) {
+          continue;
+        }
+
+        auto begin = pos + 2 - zeros;
+        if (begin < next || data.substr(begin, replacement.old.size()) != replacement.old) {
+          continue;
+        }
+
+        pieces.emplace_back(data.substr(next, begin - next));
+        pieces.emplace_back(replacement._new);
+        next = begin + replacement.old.size();
+        break;
+      }
+    }
+
+    pieces.emplace_back(data.substr(next));
+
+    return pieces;
+  }
+
   int
   encode_avcodec(int64_t frame_nr, avcodec_encode_session_t &session, safe::mail_raw_t::queue_t<packet_t> &packets, void *channel_data, std::optional<std::chrono::steady_clock::time_point> frame_timestamp) {
     auto &frame = session.device->frame;
     frame->pts = frame_nr;
+    session.frame_nr = frame_nr;
 
     auto &ctx = session.avcodec_ctx;
 
-    auto &sps = session.sps;
-    auto &vps = session.vps;
-
     // send the frame to the encoder
     auto ret = avcodec_send_frame(ctx.get(), frame);
     if (ret < 0) {
@@ -1605,7 +1871,10 @@ namespace video {
     }
 
     while (ret >= 0) {
-      auto packet = std::make_unique<packet_raw_avcodec>();
+      auto packet = session.packet_pool.make_avcodec();
+      if (!packet) {
+        return -1;
+      }
       auto av_packet = packet.get()->av_packet;
 
       ret = avcodec_receive_packet(ctx.get(), av_packet);
@@ -1616,6 +1885,21 @@ namespace video {
         return ret;
       }
 
+      // With intra refresh, the encoder flags the P-frames starting a refresh cycle as key frames as well
+      if (session.refresh_period && (av_packet->flags & AV_PKT_FLAG_KEY)) {
+        std::size_t size;
+        auto stats = av_packet_get_side_data(av_packet, AV_PKT_DATA_QUALITY_STATS, &size);
+
+        // The picture type follows the 32-bit quality
+        if (stats && size >= 5 && stats[4] != AV_PICTURE_TYPE_I) {
+          av_packet->flags &= ~AV_PKT_FLAG_KEY;
+          packet->intra_refresh = true;
+        }
+      }
+
+      // The client resumes decoding from there, the refresh cycle repairs what referenced the lost frames
+      packet->after_ref_frame_invalidation = std::exchange(session.recovery_pending, false);
+
       if (av_packet->flags & AV_PKT_FLAG_KEY) {
         BOOST_LOG(debug) << "Frame "sv << frame_nr << ": IDR Keyframe (AV_FRAME_FLAG_KEY)"sv;
       }
@@ -1625,6 +1909,10 @@ namespace video {
       }
 
       if (session.inject) {
+        auto parameter_sets = std::make_shared<avcodec_encode_session_t::parameter_sets_t>();
+        auto &sps = parameter_sets->sps;
+        auto &vps = parameter_sets->vps;
+
         if (session.inject == 1) {
           auto h264 = cbs::make_sps_h264(ctx.get(), av_packet);
 
@@ -1636,23 +1924,30 @@ namespace video {
           sps = std::move(hevc.sps);
           vps = std::move(hevc.vps);
 
-          session.replacements.emplace_back(
+          parameter_sets->replacements.emplace_back(
             std::string_view((char *) std::begin(vps.old), vps.old.size()),
             std::string_view((char *) std::begin(vps._new), vps._new.size()));
         }
 
         session.inject = 0;
 
-        session.replacements.emplace_back(
+        parameter_sets->replacements.emplace_back(
           std::string_view((char *) std::begin(sps.old), sps.old.size()),
           std::string_view((char *) std::begin(sps._new), sps._new.size()));
+
+        session.parameter_sets = std::move(parameter_sets);
       }
 
       if (av_packet && av_packet->pts == frame_nr) {
         packet->frame_timestamp = frame_timestamp;
       }
 
-      packet->replacements = &session.replacements;
+      // The parameter sets are located once here, the video thread only copies the pieces
+      if ((av_packet->flags & AV_PKT_FLAG_KEY) && session.parameter_sets) {
+        packet->gather = gather_replacements({ (char *) av_packet->data, (std::size_t) av_packet->size }, session.parameter_sets->replacements, ctx->codec_id == AV_CODEC_ID_HEVC);
+        packet->gather_buffers = session.parameter_sets;
+      }
+
       packet->channel_data = channel_data;
       packets->raise(std::move(packet));
     }
@@ -1662,8 +1957,12 @@ namespace video {
 
   int
   encode_nvenc(int64_t frame_nr, nvenc_encode_session_t &session, safe::mail_raw_t::queue_t<packet_t> &packets, void *channel_data, std::optional<std::chrono::steady_clock::time_point> frame_timestamp) {
-    auto encoded_frame = session.encode_frame(frame_nr);
+    auto frame_data = session.packet_pool.acquire_buffer();
+    auto encoded_frame = session.encode_frame(frame_nr, std::move(frame_data));
     if (encoded_frame.data.empty()) {
+      // The vector went unused, it goes back to the pool
+      session.packet_pool.release_buffer(std::move(frame_data.capacity() ? frame_data : encoded_frame.data));
+
       // Empty data with valid frame_index means encoder needs more input (NV_ENC_ERR_NEED_MORE_INPUT).
       // This is not an error - just return success and continue with next frame.
       if (encoded_frame.frame_index == static_cast<uint64_t>(frame_nr)) {
@@ -1678,7 +1977,7 @@ namespace video {
       BOOST_LOG(error) << "NvENC frame index mismatch " << frame_nr << " " << encoded_frame.frame_index;
     }
 
-    auto packet = std::make_unique<packet_raw_generic>(std::move(encoded_frame.data), encoded_frame.frame_index, encoded_frame.idr);
+    auto packet = session.packet_pool.make_generic(std::move(encoded_frame.data), encoded_frame.frame_index, encoded_frame.idr);
     packet->channel_data = channel_data;
     packet->after_ref_frame_invalidation = encoded_frame.after_ref_frame_invalidation;
     packet->frame_timestamp = frame_timestamp;
@@ -1743,9 +2042,11 @@ namespace video {
     // Note: If we later end up needing multiple sets of
     // fallback options, we may need to allow more retries
     // to try applying each set.
+    packet_pool_t packet_pool;
     avcodec_ctx_t ctx;
     for (int retries = 0; retries < 2; retries++) {
       ctx.reset(avcodec_alloc_context3(codec));
+      packet_pool.attach(ctx.get());
       ctx->width = config.width;
       ctx->height = config.height;
 
@@ -2191,10 +2492,19 @@ namespace video {
     auto session = std::make_unique<avcodec_encode_session_t>(
       std::move(ctx),
       std::move(encode_device_final),
+      std::move(packet_pool),
 
       // 0 ==> don't inject, 1 ==> inject for h264, 2 ==> inject for hevc
       config.videoFormat <= 1 ? (1 - (int) video_format[encoder_t::VUI_PARAMETERS]) * (1 + config.videoFormat) : 0);
 
+    session->loss_reports_expected = encoder.name == software.name && sw_intra_refresh_period();
+
+    // libx265 flags only IRAP pictures as key frames, the start of a refresh cycle couldn't be told apart
+    if (video_format.name == "libx264"sv) {
+      session->refresh_period = sw_intra_refresh_period();
+      session->damage_roi = true;
+    }
+
     return session;
   }
 
@@ -2335,23 +2645,212 @@ namespace video {
     return nullptr;
   }
 
-  void
-  encode_run(
-    int &frame_nr,  // Store progress of the frame number
-    safe::mail_t mail,
-    img_event_t images,
-    config_t config,
-    std::shared_ptr<platf::display_t> disp,
-    std::unique_ptr<platf::encode_device_t> encode_device,
-    safe::signal_t &reinit_event,
-    const encoder_t &encoder,
-    void *channel_data,
-    std::optional<safe::mail_raw_t::event_t<dynamic_param_t>> dynamic_param_events) {
-    auto session = make_encode_session(disp.get(), encoder, config, disp->width, disp->height, std::move(encode_device));
-    if (!session) {
-      return;
+  /**
+   * @brief Converts images on a thread of its own while the encoding thread encodes the previous one.
+   *
+   * Only for software encoders, whose device converts into frames in main memory.
+   * The device converts into the frames of a frame_ring_t, and next() makes the latest
+   * converted one the frame the session encodes.
+   */
+  class software_pipeline_t {
+  public:
+    /**
+     * @return The pipeline, or nullptr if the session doesn't encode from main memory.
+     */
+    static std::unique_ptr<software_pipeline_t>
+    make(encode_session_t &session, img_event_t images) {
+      auto avcodec_session = dynamic_cast<avcodec_encode_session_t *>(&session);
+      if (!avcodec_session) {
+        return nullptr;
+      }
+
+      // With a shared conversion, the frame references the buffers of the stage instead of its own
+      auto device = dynamic_cast<avcodec_software_encode_device_t *>(avcodec_session->device.get());
+      if (!device || !device->frame || device->frame->hw_frames_ctx || device->shared) {
+        return nullptr;
+      }
+
+      auto pipeline = std::unique_ptr<software_pipeline_t> { new software_pipeline_t { *device, std::move(images) } };
+      if (pipeline->init()) {
+        return nullptr;
+      }
+
+      return pipeline;
+    }
+
+    ~software_pipeline_t() {
+      stop = true;
+      ring.close();
+      if (thread.joinable()) {
+        thread.join();
+      }
+
+      // The device owns the first frame only
+      device.frame = frames[0].release();
+    }
+
+    /**
+     * @brief Encode the latest converted frame from now on.
+     *
+     * Picture type requests made on the previous frame carry over to it.
+     * @param timeout How long to wait for a frame.
+     * @return The frame, or `std::nullopt` if none was converted in time.
+     */
+    std::optional<frame_ring_t::entry_t>
+    next(std::chrono::steady_clock::duration timeout) {
+      auto entry = ring.take(timeout);
+      if (!entry) {
+        return std::nullopt;
+      }
+
+      auto current = device.frame;
+      auto next = frames[entry->slot].get();
+      next->pict_type = current->pict_type;
+      next->flags = (next->flags & ~AV_FRAME_FLAG_KEY) | (current->flags & AV_FRAME_FLAG_KEY);
+      device.frame = next;
+
+      return entry;
+    }
+
+    /**
+     * @return `true` if a converted frame is waiting.
+     */
+    bool
+    ready() {
+      return ring.ready();
+    }
+
+    /**
+     * @return `true` if the conversion thread stopped on an error.
+     */
+    bool
+    failed() {
+      return failure;
+    }
+
+    /**
+     * @brief The areas that changed in the image converted into a slot taken with next().
+     */
+    struct damage_t {
+      std::vector<platf::rect_t> rects;
+      int width;
+      int height;
+    };
+
+    const damage_t &
+    damage_of(int slot) const {
+      return damage[slot];
+    }
+
+    /**
+     * @return The image converted last, or nullptr if none was converted yet.
+     */
+    std::shared_ptr<platf::img_t>
+    latest_image() {
+      std::lock_guard lg { latest_lock };
+      return latest;
+    }
+
+  private:
+    software_pipeline_t(avcodec_software_encode_device_t &device, img_event_t images):
+        device { device }, images { std::move(images) } {}
+
+    int
+    init() {
+      // The current frame already holds the latest image
+      frames[0].reset(device.frame);
+      for (int slot = 1; slot < frame_ring_t::slots; ++slot) {
+        auto &frame = frames[slot];
+        frame.reset(av_frame_alloc());
+
+        frame->format = device.frame->format;
+        frame->width = device.frame->width;
+        frame->height = device.frame->height;
+        if (av_frame_copy_props(frame.get(), device.frame) || av_frame_get_buffer(frame.get(), 0)) {
+          return -1;
+        }
+
+        ptrdiff_t linesize[4] = { frame->linesize[0], frame->linesize[1], frame->linesize[2], frame->linesize[3] };
+        av_image_fill_black(frame->data, linesize, (AVPixelFormat) frame->format, frame->color_range, frame->width, frame->height);
+      }
+
+      for (int slot = 0; slot < frame_ring_t::slots; ++slot) {
+        views[slot].reset(av_frame_alloc());
+        if (device.view(views[slot].get(), frames[slot].get())) {
+          return -1;
+        }
+      }
+
+      thread = std::thread { &software_pipeline_t::run, this };
+
+      return 0;
+    }
+
+    void
+    run() {
+      platf::set_thread_name("convert");
+      thread_placement::apply(thread_placement::thread_e::encode, platf::thread_priority_e::high);
+
+      while (!stop) {
+        // Time out regularly to notice when the pipeline is stopped
+        auto img = images->pop(50ms);
+        if (!img) {
+          if (!images->running()) {
+            break;
+          }
+
+          continue;
+        }
+
+        auto slot = ring.acquire();
+        if (device.convert_into(*img, views[slot].get())) {
+          BOOST_LOG(error) << "Could not convert image"sv;
+          failure = true;
+          break;
+        }
+
+        // The slot is the encoder's once published
+        damage[slot] = { img->damage, img->width, img->height };
+        ring.publish(slot, img->frame_timestamp);
+
+        std::lock_guard lg { latest_lock };
+        latest = std::move(img);
+      }
+
+      ring.close();
     }
 
+    avcodec_software_encode_device_t &device;
+    img_event_t images;
+
+    frame_ring_t ring;
+
+    // The first frame belongs to the device, the destructor releases it
+    std::array<avcodec_frame_t, frame_ring_t::slots> frames;
+    std::array<avcodec_frame_t, frame_ring_t::slots> views;
+    std::array<damage_t, frame_ring_t::slots> damage;
+
+    std::mutex latest_lock;
+    std::shared_ptr<platf::img_t> latest;
+
+    std::atomic_bool stop {};
+    std::atomic_bool failure {};
+    std::thread thread;
+  };
+
+  void
+  encode_run(
+    int &frame_nr,  // Store progress of the frame number
+    safe::mail_t mail,
+    img_event_t images,
+    safe::mail_raw_t::queue_t<packet_t> packets,
+    config_t config,
+    std::shared_ptr<platf::display_t> disp,
+    std::unique_ptr<encode_session_t> session,
+    safe::signal_t &reinit_event,
+    const encoder_t &encoder,
+    void *channel_data,
+    std::optional<safe::mail_raw_t::event_t<dynamic_param_t>> dynamic_param_events) {
     // As a workaround for NVENC hangs and to generally speed up encoder reinit,
     // we will complete the encoder teardown in a separate thread if supported.
     // This will move expensive processing off the encoder thread to allow us
@@ -2383,7 +2882,6 @@ namespace video {
     }
 
     auto shutdown_event = mail->event<bool>(mail::shutdown);
-    auto packets = mail::man->queue<packet_t>(mail::video_packets);
     auto idr_events = mail->event<bool>(mail::idr);
     auto invalidate_ref_frames_events = mail->event<std::pair<int64_t, int64_t>>(mail::invalidate_ref_frames);
     auto dynamic_param_events_ptr = dynamic_param_events.value_or(mail::man->event<dynamic_param_t>(mail::dynamic_param_change));
@@ -2399,6 +2897,75 @@ namespace video {
       }
     }
 
+    // Convert the next image on another thread while the current one is encoded
+    std::unique_ptr<software_pipeline_t> pipeline;
+    if (config::video.sw.sw_pipeline) {
+      pipeline = software_pipeline_t::make(*session, images);
+      if (pipeline) {
+        BOOST_LOG(info) << "Converting images ahead of the software encoder"sv;
+      }
+    }
+
+    // The dynamic parameters applied so far, a rescaled session starts with them too
+    std::array<std::optional<dynamic_param_t>, (std::size_t) dynamic_param_type_e::MAX_PARAM_TYPE> applied_params;
+    std::shared_ptr<platf::img_t> last_img;
+    int scale_percent = 100;
+
+    // Swap the session for one encoding at another resolution, the capture keeps going as is.
+    // Returns false if the stream can't go on.
+    auto rescale = [&](int percent) {
+      percent = std::clamp(percent, 25, 100);
+      if (percent == scale_percent) {
+        return true;
+      }
+
+      auto scaled = make_scaled_encode_session(*disp, encoder, config, percent);
+      if (!scaled) {
+        BOOST_LOG(warning) << "Couldn't rescale the stream to "sv << percent << "%, staying at "sv << scale_percent << '%';
+        return true;
+      }
+
+      // The pipeline converts into the frames of the current session
+      auto img = pipeline ? pipeline->latest_image() : last_img;
+      pipeline.reset();
+
+      // Start from the latest image, so the first frame at the new resolution isn't blank
+      if (!img) {
+        img = disp->alloc_img();
+        if (!img || disp->dummy_img(img.get())) {
+          return false;
+        }
+      }
+      if (scaled->convert(*img)) {
+        BOOST_LOG(error) << "Could not convert image"sv;
+        return false;
+      }
+
+      for (auto &param : applied_params) {
+        if (param) {
+          scaled->set_dynamic_param(*param);
+        }
+      }
+
+      std::swap(session, scaled);
+      if (encoder.flags & ASYNC_TEARDOWN) {
+        std::thread { [scaled = std::move(scaled)]() mutable {
+          scaled.reset();
+        } }.detach();
+      }
+      scaled.reset();
+
+      if (config::video.sw.sw_pipeline) {
+        pipeline = software_pipeline_t::make(*session, images);
+      }
+
+      auto encoded = scaled_config(config, percent);
+      BOOST_LOG(info) << "Encoding at "sv << encoded.width << 'x' << encoded.height << " ("sv << percent << "% of the stream resolution)"sv;
+
+      scale_percent = percent;
+      return true;
+    };
+
     while (true) {
       // Break out of the encoding loop if any of the following are true:
       // a) The stream is ending
@@ -2428,7 +2995,20 @@ namespace video {
       while (dynamic_param_events_ptr->peek()) {
         if (auto param = dynamic_param_events_ptr->pop(0ms)) {
           BOOST_LOG(info) << "Applying dynamic parameter change: type=" << (int) param->type;
+          if (param->type == dynamic_param_type_e::RESOLUTION_SCALE) {
+            if (!rescale(param->value.int_value)) {
+              return;
+            }
+
+            // The new encoder starts with a keyframe anyway, the client expects one after a resolution change
+            requested_idr_frame = true;
+            continue;
+          }
+
           session->set_dynamic_param(*param);
+          if (param->type < dynamic_param_type_e::MAX_PARAM_TYPE) {
+            applied_params[(std::size_t) param->type] = *param;
+          }
         }
       }
 
@@ -2441,7 +3021,24 @@ namespace video {
 
       // Encode at a minimum FPS to avoid image quality issues with static content
       // When variable_refresh_rate is enabled, only encode when we have a new frame
-      if (!requested_idr_frame || images->peek()) {
+      if (pipeline) {
+        if (!requested_idr_frame || pipeline->ready()) {
+          if (auto converted = pipeline->next(std::chrono::duration_cast<std::chrono::steady_clock::duration>(minimum_frame_time))) {
+            frame_timestamp = converted->frame_timestamp;
+            has_new_frame = true;
+
+            auto &damage = pipeline->damage_of(converted->slot);
+            session->set_damage(damage.rects, damage.width, damage.height);
+          }
+          else if (pipeline->failed()) {
+            return;
+          }
+          else if (!images->running()) {
+            break;
+          }
+        }
+      }
+      else if (!requested_idr_frame || images->peek()) {
         if (auto img = images->pop(minimum_frame_time)) {
           frame_timestamp = img->frame_timestamp;
           if (session->convert(*img)) {
@@ -2449,6 +3046,8 @@ namespace video {
             return;
           }
           has_new_frame = true;
+          session->set_damage(img->damage, img->width, img->height);
+          last_img = std::move(img);
         }
         else if (!images->running()) {
           break;
@@ -2506,6 +3105,17 @@ namespace video {
     };
   }
 
+  config_t
+  scaled_config(const config_t &config, int scale_percent) {
+    scale_percent = std::clamp(scale_percent, 25, 100);
+
+    auto scaled = config;
+    scaled.width = std::max(2, (config.width * scale_percent / 100) & ~1);
+    scaled.height = std::max(2, (config.height * scale_percent / 100) & ~1);
+
+    return scaled;
+  }
+
   std::unique_ptr<platf::encode_device_t>
   make_encode_device(platf::display_t &disp, const encoder_t &encoder, const config_t &config) {
     std::unique_ptr<platf::encode_device_t> result;
@@ -2559,6 +3169,19 @@ namespace video {
     return result;
   }
 
+  std::unique_ptr<encode_session_t>
+  make_scaled_encode_session(platf::display_t &disp, const encoder_t &encoder, const config_t &config, int scale_percent) {
+    auto scaled = scaled_config(config, scale_percent);
+
+    // The device scales the images of the display down to the encoded resolution while converting them
+    auto encode_device = make_encode_device(disp, encoder, scaled);
+    if (!encode_device) {
+      return nullptr;
+    }
+
+    return make_encode_session(&disp, encoder, scaled, disp.width, disp.height, std::move(encode_device));
+  }
+
   std::optional<sync_session_t>
   make_synced_session(platf::display_t *disp, const encoder_t &encoder, platf::img_t &img, sync_session_ctx_t &ctx) {
     sync_session_t encode_session;
@@ -2613,13 +3236,12 @@ namespace video {
     std::vector<std::unique_ptr<sync_session_ctx_t>> &synced_session_ctxs,
     encode_session_ctx_queue_t &encode_session_ctx_queue,
     std::vector<std::string> &display_names,
-    int &display_p) {
+    int &display_p,
+    bool &display_switched) {
     const auto &encoder = *chosen_encoder;
 
     std::shared_ptr<platf::display_t> disp;
 
-    auto switch_display_event = mail::man->event<int>(mail::switch_display);
-
     if (synced_session_ctxs.empty()) {
       auto ctx = encode_session_ctx_queue.pop();
       if (!ctx) {
@@ -2634,28 +3256,18 @@ namespace video {
       refresh_displays(encoder.platform_formats->dev_type, display_names, display_p);
 
       // Process any pending display switch with the new list of displays
-      if (switch_display_event->peek()) {
-        display_p = std::clamp(*switch_display_event->pop(), 0, (int) display_names.size() - 1);
+      for (auto &ctx : synced_session_ctxs) {
+        if (ctx->switch_display_events->peek()) {
+          display_p = std::clamp(*ctx->switch_display_events->pop(), 0, (int) display_names.size() - 1);
+          display_switched = true;
+        }
       }
 
-      // Use client-specified display_name if provided
+      // Use client-specified display_name if provided, unless the sessions switched to another display
       const auto &config = synced_session_ctxs.front()->config;
-      std::string target_display_name = display_names[display_p];
-      if (!config.display_name.empty()) {
-        // Try to find the client-specified display in the list
-        bool found = false;
-        for (int x = 0; x < display_names.size(); ++x) {
-          if (display_names[x] == config.display_name) {
-            display_p = x;
-            target_display_name = config.display_name;
-            found = true;
-            break;
-          }
-        }
-        if (!found) {
-          BOOST_LOG(warning) << "Client-specified display [" << config.display_name << "] not found, using default display";
-        }
-      }
+      auto target_display_name = display_switched ?
+                                   display_names[display_p] :
+                                   pick_display(display_names, display_p, config.display_name);
 
       // reset_display() will sleep between retries
       reset_display(disp, encoder.platform_formats->dev_type, target_display_name, config);
@@ -2750,7 +3362,10 @@ namespace video {
           ++pos;
         })
 
-        if (switch_display_event->peek()) {
+        // A session asked to switch the display, see input::apply_shortcut()
+        if (std::any_of(std::begin(synced_session_ctxs), std::end(synced_session_ctxs), [](auto &ctx) {
+              return ctx->switch_display_events->peek();
+            })) {
           ec = platf::capture_e::reinit;
           return false;
         }
@@ -2800,11 +3415,140 @@ namespace video {
     });
 
     // Encoding and capture takes place on this thread
-    platf::adjust_thread_priority(platf::thread_priority_e::high);
+    thread_placement::apply(thread_placement::thread_e::encode, platf::thread_priority_e::high);
 
     std::vector<std::string> display_names;
     int display_p = -1;
-    while (encode_run_sync(synced_session_ctxs, ctx, display_names, display_p) == encode_e::reinit) {}
+    bool display_switched = false;
+    while (encode_run_sync(synced_session_ctxs, ctx, display_names, display_p, display_switched) == encode_e::reinit) {}
+  }
+
+  /**
+   * @brief What capture_async() needs to start streaming, prepared ahead of time by prewarm().
+   */
+  struct warm_start_t {
+    img_event_t images;
+    safe::shared_t<capture_thread_async_ctx_t>::ptr_t ref;
+
+    // The encoder session and the display it was built for
+    std::shared_ptr<platf::display_t> display;
+    const encoder_t *encoder {};
+    sunshine_colorspace_t colorspace {};
+    std::unique_ptr<encode_session_t> session;
+  };
+
+  class prewarmed_session_t {
+  public:
+    prewarmed_session_t(const config_t &config, safe::mail_raw_t::event_t<int> switch_display_events):
+        config { config },
+        switch_display_events { std::move(switch_display_events) } {
+      thread = std::thread { &prewarmed_session_t::build, this };
+    }
+
+    ~prewarmed_session_t() {
+      cancel = true;
+      wait();
+
+      // Not taken, the capture thread no longer needs to deliver images for it
+      if (warm.images) {
+        warm.images->stop();
+      }
+    }
+
+    /**
+     * @brief Wait for the encoder to be built, and take it if it was built for this configuration.
+     * @return `false` if the stream has to start from scratch.
+     */
+    bool
+    take(const config_t &config, warm_start_t &warm_start) {
+      wait();
+
+      if (!warm.ref) {
+        return false;
+      }
+
+      if (!(this->config == config)) {
+        BOOST_LOG(info) << "Discarding the encoder built ahead of the stream, its settings changed"sv;
+        return false;
+      }
+
+      warm_start = std::move(warm);
+      return true;
+    }
+
+  private:
+    void
+    wait() {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+
+    void
+    build() {
+      auto start = std::chrono::steady_clock::now();
+
+      warm.images = std::make_shared<img_event_t::element_type>();
+      warm.ref = ref_capture_thread_async(config);
+      if (!warm.ref) {
+        return;
+      }
+
+      warm.ref->capture_ctx_queue->raise(capture_ctx_t { warm.images, config, switch_display_events });
+
+      // The capture thread opens the display once it has a session to capture for
+      while (!cancel && warm.images->running() && warm.ref->capture_ctx_queue->running()) {
+        {
+          auto lg = warm.ref->display_wp.lock();
+          if (!warm.ref->display_wp->expired()) {
+            warm.display = warm.ref->display_wp->lock();
+          }
+        }
+
+        if (warm.display) {
+          break;
+        }
+
+        std::this_thread::sleep_for(5ms);
+      }
+
+      if (cancel || !warm.display) {
+        return;
+      }
+
+      auto &encoder = *chosen_encoder;
+      auto encode_device = make_encode_device(*warm.display, encoder, config);
+      if (!encode_device) {
+        return;
+      }
+
+      warm.encoder = &encoder;
+      warm.colorspace = encode_device->colorspace;
+      warm.session = make_encode_session(warm.display.get(), encoder, config, warm.display->width, warm.display->height, std::move(encode_device));
+      if (!warm.session) {
+        return;
+      }
+
+      auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+      BOOST_LOG(info) << "Encoder built ahead of the stream in "sv << delay.count() << "ms"sv;
+    }
+
+    const config_t config;
+    safe::mail_raw_t::event_t<int> switch_display_events;
+    warm_start_t warm;
+
+    std::atomic_bool cancel {};
+    std::thread thread;
+  };
+
+  std::shared_ptr<prewarmed_session_t>
+  prewarm(safe::mail_t mail, const config_t &config) {
+    if (!config::video.prewarm_encoder || !chosen_encoder ||
+        !(chosen_encoder->flags & PARALLEL_ENCODING) || config::video.shared_encoder) {
+      return nullptr;
+    }
+
+    return std::make_shared<prewarmed_session_t>(config, mail->event<int>(mail::switch_display));
   }
 
   void
@@ -2812,21 +3556,33 @@ namespace video {
     safe::mail_t mail,
     config_t &config,
     void *channel_data,
-    std::optional<safe::mail_raw_t::event_t<dynamic_param_t>> dynamic_param_events) {
+    safe::mail_raw_t::queue_t<packet_t> packets,
+    std::optional<safe::mail_raw_t::event_t<dynamic_param_t>> dynamic_param_events,
+    std::shared_ptr<prewarmed_session_t> prewarmed = nullptr) {
     auto shutdown_event = mail->event<bool>(mail::shutdown);
 
-    auto images = std::make_shared<img_event_t::element_type>();
+    // A session prepared ahead of time already joined the capture thread
+    warm_start_t warm;
+    if (!prewarmed || !prewarmed->take(config, warm)) {
+      warm.images = std::make_shared<img_event_t::element_type>();
+    }
+    prewarmed.reset();
+
+    auto images = warm.images;
     auto lg = util::fail_guard([&]() {
       images->stop();
       shutdown_event->raise(true);
     });
 
-    auto ref = capture_thread_async.ref();
+    auto ref = std::move(warm.ref);
     if (!ref) {
-      return;
-    }
+      ref = ref_capture_thread_async(config);
+      if (!ref) {
+        return;
+      }
 
-    ref->capture_ctx_queue->raise(capture_ctx_t { images, config });
+      ref->capture_ctx_queue->raise(capture_ctx_t { images, config, mail->event<int>(mail::switch_display) });
+    }
 
     if (!ref->capture_ctx_queue->running()) {
       return;
@@ -2838,7 +3594,7 @@ namespace video {
     auto hdr_event = mail->event<hdr_info_t>(mail::hdr);
 
     // Encoding takes place on this thread
-    platf::adjust_thread_priority(platf::thread_priority_e::high);
+    thread_placement::apply(thread_placement::thread_e::encode, platf::thread_priority_e::high);
 
     while (!shutdown_event->peek() && images->running()) {
       // Wait for the main capture event when the display is being reinitialized
@@ -2861,9 +3617,27 @@ namespace video {
 
       auto &encoder = *chosen_encoder;
 
-      auto encode_device = make_encode_device(*display, encoder, config);
-      if (!encode_device) {
-        return;
+      // The session built ahead of time is only good for the display and encoder it was built for
+      std::unique_ptr<encode_session_t> session;
+      sunshine_colorspace_t colorspace;
+      if (warm.session && warm.display == display && warm.encoder == &encoder) {
+        BOOST_LOG(info) << "Streaming with the encoder built ahead of the stream"sv;
+        session = std::move(warm.session);
+        colorspace = warm.colorspace;
+      }
+      else {
+        auto encode_device = make_encode_device(*display, encoder, config);
+        if (!encode_device) {
+          return;
+        }
+
+        colorspace = encode_device->colorspace;
+        session = make_encode_session(display.get(), encoder, config, display->width, display->height, std::move(encode_device));
+      }
+      warm = {};
+
+      if (!session) {
+        continue;
       }
 
       // absolute mouse coordinates require that the dimensions of the screen are known
@@ -2871,7 +3645,7 @@ namespace video {
 
       // Update client with our current HDR display state
       hdr_info_t hdr_info = std::make_unique<hdr_info_raw_t>(false);
-      if (colorspace_is_hdr(encode_device->colorspace)) {
+      if (colorspace_is_hdr(colorspace)) {
         if (display->get_hdr_metadata(hdr_info->metadata)) {
           hdr_info->enabled = true;
         }
@@ -2883,28 +3657,306 @@ namespace video {
 
       encode_run(
         frame_nr,
-        mail, images,
+        mail, images, packets,
         config, display,
-        std::move(encode_device),
+        std::move(session),
         ref->reinit_event, *ref->encoder_p,
         channel_data, dynamic_param_events);
     }
   }
 
-  void
-  capture(
-    safe::mail_t mail,
-    config_t config,
-    void *channel_data,
-    std::optional<safe::mail_raw_t::event_t<dynamic_param_t>> dynamic_param_events) {
-    auto idr_events = mail->event<bool>(mail::idr);
+  /**
+   * @brief Sessions with the same configuration share an encoder, see config::video.shared_encoder.
+   */
+  struct broadcast_key_t {
+    std::string display_name;
+    int width;
+    int height;
+    int framerate;
+    int frame_rate_num;
+    int frame_rate_den;
+    int bitrate;
+    int slices_per_frame;
+    int num_ref_frames;
+    int encoder_csc_mode;
+    int video_format;
+    int dynamic_range;
+    int chroma_sampling_type;
+    int enable_intra_refresh;
+
+    auto
+    operator<=>(const broadcast_key_t &) const = default;
+  };
 
-    idr_events->raise(true);
-    if (chosen_encoder->flags & PARALLEL_ENCODING) {
-      capture_async(std::move(mail), config, channel_data, dynamic_param_events);
+  /**
+   * @brief An encoder whose packets are sent to every session subscribed to it.
+   *
+   * The encoder runs capture_async() on a mail of its own, a second thread fans its
+   * packets out to the sessions. The encoder stops with the last session.
+   */
+  struct broadcast_t {
+    explicit broadcast_t(const config_t &config):
+        config { config },
+        hub { (std::size_t) std::max(1, config.framerate / 10) },
+        mail { std::make_shared<safe::mail_raw_t>() },
+        shutdown_event { mail->event<bool>(mail::shutdown) },
+        idr_events { mail->event<bool>(mail::idr) },
+        invalidate_ref_frames_events { mail->event<std::pair<int64_t, int64_t>>(mail::invalidate_ref_frames) },
+        touch_port_event { mail->event<input::touch_port_t>(mail::touch_port) },
+        hdr_event { mail->event<hdr_info_t>(mail::hdr) },
+        dynamic_param_events { mail->event<dynamic_param_t>(mail::dynamic_param_change) },
+        switch_display_events { mail->event<int>(mail::switch_display) },
+        packets { mail->queue<packet_t>(mail::video_packets) } {
+      encode_thread = std::thread { [this]() {
+        capture_async(this->mail, this->config, nullptr, packets, dynamic_param_events);
+        packets->stop();
+      } };
+
+      fan_out_thread = std::thread { &broadcast_t::fan_out, this };
     }
-    else {
-      safe::signal_t join_event;
+
+    ~broadcast_t() {
+      shutdown_event->raise(true);
+      packets->stop();
+
+      encode_thread.join();
+      fan_out_thread.join();
+    }
+
+    /**
+     * @brief Start sending the packets to a session.
+     * @return `true` if the session waits for a new IDR frame.
+     */
+    bool
+    subscribe(void *channel_data, const safe::mail_t &session_mail) {
+      std::lock_guard lg { lock };
+
+      // Catch up with the display, then with the stream
+      auto &subscriber = subscribers.emplace_back(channel_data, session_mail);
+      if (touch_port) {
+        subscriber.second->event<input::touch_port_t>(mail::touch_port)->raise(*touch_port);
+      }
+      if (hdr_info) {
+        subscriber.second->event<hdr_info_t>(mail::hdr)->raise(std::make_unique<hdr_info_raw_t>(*hdr_info));
+      }
+
+      std::vector<packet_t> replay;
+      if (hub.subscribe(channel_data, replay)) {
+        return true;
+      }
+
+      // Queued under the lock, so the replay precedes the packets fan_out() publishes next
+      auto video_packets = mail::man->queue<packet_t>(mail::video_packets);
+      for (auto &packet : replay) {
+        video_packets->raise(std::move(packet));
+      }
+
+      return false;
+    }
+
+    void
+    unsubscribe(void *channel_data) {
+      std::lock_guard lg { lock };
+
+      hub.unsubscribe(channel_data);
+      std::erase_if(subscribers, [channel_data](const auto &subscriber) {
+        return subscriber.first == channel_data;
+      });
+    }
+
+    void
+    fan_out() {
+      auto video_packets = mail::man->queue<packet_t>(mail::video_packets);
+
+      while (auto packet = packets->pop()) {
+        relay_display_events();
+
+        // A session subscribing meanwhile queues its replay either before or after this packet, never around it
+        std::lock_guard lg { lock };
+        for (auto &session_packet : hub.publish(std::move(packet))) {
+          video_packets->raise(std::move(session_packet));
+        }
+      }
+    }
+
+    /**
+     * @brief Pass the display events of the encoder on to the sessions.
+     *
+     * They are raised each time the encoder is created, e.g. after the display was reinitialized.
+     */
+    void
+    relay_display_events() {
+      if (!touch_port_event->peek() && !hdr_event->peek()) {
+        return;
+      }
+
+      // The cached packets belong to the previous encoder
+      hub.reset();
+
+      std::lock_guard lg { lock };
+
+      if (auto port = touch_port_event->pop(0ms)) {
+        touch_port = *port;
+        for (auto &[_, session_mail] : subscribers) {
+          session_mail->event<input::touch_port_t>(mail::touch_port)->raise(*touch_port);
+        }
+      }
+
+      if (auto info = hdr_event->pop(0ms)) {
+        hdr_info = *info;
+        for (auto &[_, session_mail] : subscribers) {
+          session_mail->event<hdr_info_t>(mail::hdr)->raise(std::make_unique<hdr_info_raw_t>(*hdr_info));
+        }
+      }
+    }
+
+    config_t config;
+    broadcast_hub_t hub;
+
+    // Events of the encoder, kept alive so none is missed while it is being recreated
+    safe::mail_t mail;
+    safe::mail_raw_t::event_t<bool> shutdown_event;
+    safe::mail_raw_t::event_t<bool> idr_events;
+    safe::mail_raw_t::event_t<std::pair<int64_t, int64_t>> invalidate_ref_frames_events;
+    safe::mail_raw_t::event_t<input::touch_port_t> touch_port_event;
+    safe::mail_raw_t::event_t<hdr_info_t> hdr_event;
+    safe::mail_raw_t::event_t<dynamic_param_t> dynamic_param_events;
+    safe::mail_raw_t::event_t<int> switch_display_events;
+    safe::mail_raw_t::queue_t<packet_t> packets;
+
+    std::mutex lock;
+    std::vector<std::pair<void *, safe::mail_t>> subscribers;
+    std::optional<input::touch_port_t> touch_port;
+    std::optional<hdr_info_raw_t> hdr_info;
+
+    std::thread encode_thread;
+    std::thread fan_out_thread;
+  };
+
+  std::mutex broadcasts_lock;
+  std::map<broadcast_key_t, std::weak_ptr<broadcast_t>> broadcasts;
+
+  /**
+   * @brief Get the encoder of the sessions with this configuration, starting it if needed.
+   */
+  std::shared_ptr<broadcast_t>
+  ref_broadcast(const config_t &config) {
+    broadcast_key_t key {
+      config.display_name,
+      config.width,
+      config.height,
+      config.framerate,
+      config.frameRateNum,
+      config.frameRateDen,
+      config.bitrate,
+      config.slicesPerFrame,
+      config.numRefFrames,
+      config.encoderCscMode,
+      config.videoFormat,
+      config.dynamicRange,
+      config.chromaSamplingType,
+      config.enableIntraRefresh,
+    };
+
+    std::lock_guard lg { broadcasts_lock };
+
+    // Forget the encoders that stopped with their last session
+    std::erase_if(broadcasts, [](const auto &entry) {
+      return entry.second.expired();
+    });
+
+    auto &broadcast_wp = broadcasts[key];
+    auto broadcast = broadcast_wp.lock();
+    if (!broadcast) {
+      BOOST_LOG(info) << "Starting a shared encoder for "sv << config.width << 'x' << config.height << '@' << config.framerate;
+
+      broadcast = std::make_shared<broadcast_t>(config);
+      broadcast_wp = broadcast;
+    }
+
+    return broadcast;
+  }
+
+  /**
+   * @brief Stream the packets of the shared encoder matching the session's configuration.
+   *
+   * The IDR frame and reference frame invalidation requests of the session are passed
+   * on to the shared encoder, so every session gets the frame that was requested.
+   * Its dynamic parameter changes are dropped, the encoder settings belong to every session.
+   */
+  void
+  capture_shared(
+    safe::mail_t mail,
+    config_t &config,
+    void *channel_data,
+    std::optional<safe::mail_raw_t::event_t<dynamic_param_t>> dynamic_param_events) {
+    auto shutdown_event = mail->event<bool>(mail::shutdown);
+    auto idr_events = mail->event<bool>(mail::idr);
+    auto invalidate_ref_frames_events = mail->event<std::pair<int64_t, int64_t>>(mail::invalidate_ref_frames);
+    auto switch_display_events = mail->event<int>(mail::switch_display);
+
+    auto broadcast = ref_broadcast(config);
+    auto lg = util::fail_guard([&]() {
+      broadcast->unsubscribe(channel_data);
+      shutdown_event->raise(true);
+    });
+
+    // Starting with the replay of the frames since the last IDR frame, no need for a new one
+    if (!broadcast->subscribe(channel_data, mail)) {
+      idr_events->pop(0ms);
+    }
+    else {
+      broadcast->idr_events->raise(true);
+    }
+
+    while (!shutdown_event->peek() && !broadcast->shutdown_event->peek()) {
+      if (idr_events->pop(5ms)) {
+        broadcast->idr_events->raise(true);
+      }
+
+      // The sessions share the display along with the encoder
+      if (auto display = switch_display_events->pop(0ms)) {
+        broadcast->switch_display_events->raise(*display);
+      }
+
+      // The encoder settings belong to every session of the encoder, see shared_encoder in the docs
+      if (dynamic_param_events) {
+        if (auto param = (*dynamic_param_events)->pop(0ms)) {
+          BOOST_LOG(warning) << "Ignoring dynamic parameter change ["sv << (int) param->type << "] of a session sharing its encoder"sv;
+        }
+      }
+
+      while (invalidate_ref_frames_events->peek()) {
+        if (auto frames = invalidate_ref_frames_events->pop(0ms)) {
+          // Frames the session hasn't received yet can't be invalidated
+          auto first = broadcast->hub.encoder_frame_index(channel_data, frames->first);
+          auto last = broadcast->hub.encoder_frame_index(channel_data, frames->second);
+          if (first && last) {
+            broadcast->invalidate_ref_frames_events->raise(*first, *last);
+          }
+        }
+      }
+    }
+  }
+
+  void
+  capture(
+    safe::mail_t mail,
+    config_t config,
+    void *channel_data,
+    std::optional<safe::mail_raw_t::event_t<dynamic_param_t>> dynamic_param_events,
+    std::shared_ptr<prewarmed_session_t> prewarmed) {
+    auto idr_events = mail->event<bool>(mail::idr);
+
+    idr_events->raise(true);
+    if (chosen_encoder->flags & PARALLEL_ENCODING && config::video.shared_encoder) {
+      capture_shared(std::move(mail), config, channel_data, dynamic_param_events);
+    }
+    else if (chosen_encoder->flags & PARALLEL_ENCODING) {
+      capture_async(std::move(mail), config, channel_data, mail::man->queue<packet_t>(mail::video_packets), dynamic_param_events, std::move(prewarmed));
+    }
+    else {
+      safe::signal_t join_event;
       auto ref = capture_thread_sync.ref();
       ref->encode_session_ctx_queue.raise(sync_session_ctx_t {
         &join_event,
@@ -2913,6 +3965,7 @@ namespace video {
         std::move(idr_events),
         mail->event<hdr_info_t>(mail::hdr),
         mail->event<input::touch_port_t>(mail::touch_port),
+        mail->event<int>(mail::switch_display),
         config,
         1,
         channel_data,
@@ -2949,7 +4002,9 @@ namespace video {
 
     session->request_idr_frame();
 
-    auto packets = mail::man->queue<packet_t>(mail::video_packets);
+    // Tests may run concurrently, each collects its packets on a queue of its own
+    auto test_mail = std::make_shared<safe::mail_raw_t>();
+    auto packets = test_mail->queue<packet_t>(mail::video_packets);
     while (!packets->peek()) {
       if (encode(1, *session, packets, nullptr, {})) {
         return -1;
@@ -3024,34 +4079,90 @@ namespace video {
     return -1;
   }
 
+  namespace {
+    // Deficiencies of the packets found by validate_config(), and the codec flags they clear
+    const std::vector<std::pair<validate_flag_e, encoder_t::flag_e>> packet_deficiencies {
+      { VUI_PARAMS, encoder_t::VUI_PARAMETERS },
+    };
+
+    using probe_test_t = std::function<void(std::shared_ptr<platf::display_t> &)>;
+
+    // Set at shutdown, a probe running in the background gives up on the encoders and tests left
+    std::atomic_bool probe_stop;
+
+    /**
+     * @brief Run independent tests of a probe, concurrently if the encoder allows it.
+     * @param probe The probe, its display is used by the first test.
+     * @param display_config Configuration to open the displays of the concurrent tests with.
+     * @param tests The tests, each taking the display to validate on.
+     */
+    void
+    run_probe_tests(encoder_probe_t &probe, const config_t &display_config, const std::vector<probe_test_t> &tests) {
+      if (!probe.parallel || tests.size() < 2) {
+        for (auto &test : tests) {
+          if (!probe_stop) {
+            test(probe.disp);
+          }
+        }
+
+        return;
+      }
+
+      // Display and encode devices aren't thread safe, so each concurrent test opens a display of its own
+      std::vector<std::future<bool>> concurrent;
+      for (auto it = std::next(std::begin(tests)); it != std::end(tests); ++it) {
+        concurrent.emplace_back(std::async(std::launch::async, [&probe, &display_config, &test = *it]() {
+          std::shared_ptr<platf::display_t> disp;
+          reset_display(disp, probe.encoder->platform_formats->dev_type, probe.display_name, display_config);
+          if (!disp) {
+            return false;
+          }
+
+          test(disp);
+          return true;
+        }));
+      }
+
+      tests.front()(probe.disp);
+
+      // Tests that couldn't open a display of their own run on the display of the probe
+      for (std::size_t x = 0; x < concurrent.size(); ++x) {
+        if (!concurrent[x].get()) {
+          tests[x + 1](probe.disp);
+        }
+      }
+    }
+  }  // namespace
+
   bool
-  validate_encoder(encoder_t &encoder, bool expect_failure) {
-    std::shared_ptr<platf::display_t> disp;
+  probe_baseline(encoder_probe_t &probe, bool expect_failure) {
+    auto &encoder = *probe.encoder;
 
     BOOST_LOG(info) << "Trying encoder ["sv << encoder.name << ']';
     auto fg = util::fail_guard([&]() {
       BOOST_LOG(info) << "Encoder ["sv << encoder.name << "] failed"sv;
     });
 
-    auto test_hevc = active_hevc_mode >= 2 || (active_hevc_mode == 0 && !(encoder.flags & H264_ONLY));
-    auto test_av1 = active_av1_mode >= 2 || (active_av1_mode == 0 && !(encoder.flags & H264_ONLY));
+    probe.test_hevc = config::video.hevc_mode >= 2 || (config::video.hevc_mode == 0 && !(encoder.flags & H264_ONLY));
+    probe.test_av1 = config::video.av1_mode >= 2 || (config::video.av1_mode == 0 && !(encoder.flags & H264_ONLY));
+    probe.parallel = encoder.flags & PARALLEL_PROBING;
 
+    // Until probe_extended() is done, the encoder is only known to handle H.264
     encoder.h264.capabilities.set();
-    encoder.hevc.capabilities.set();
-    encoder.av1.capabilities.set();
+    encoder.hevc.capabilities.reset();
+    encoder.av1.capabilities.reset();
 
     // First, test encoder viability
-    // Note: videoFormat starts at 0 (H.264), will be changed to 1 (HEVC) or 2 (AV1) later if needed
     config_t config_max_ref_frames { 1920, 1080, 60, 1000, 1, 1, 1, 0, 0, 0, 0 };
     config_t config_autoselect { 1920, 1080, 60, 1000, 1, 1, 0, 0, 0, 0, 0 };
 
     // If the encoder isn't supported at all (not even H.264), bail early
-    const auto output_display_name { display_device::get_display_name(config::video.output_name) };
-    reset_display(disp, encoder.platform_formats->dev_type, output_display_name, config_autoselect);
-    if (!disp) {
+    probe.display_name = display_device::get_display_name(config::video.output_name);
+    reset_display(probe.disp, encoder.platform_formats->dev_type, probe.display_name, config_autoselect);
+    if (!probe.disp) {
       return false;
     }
-    if (!disp->is_codec_supported(encoder.h264.name, config_autoselect)) {
+    if (!probe.disp->is_codec_supported(encoder.h264.name, config_autoselect)) {
       fg.disable();
       BOOST_LOG(info) << "Encoder ["sv << encoder.name << "] is not supported on this GPU"sv;
       return false;
@@ -3059,20 +4170,16 @@ namespace video {
 
     // If we're expecting failure, use the autoselect ref config first since that will always succeed
     // if the encoder is available.
-    auto max_ref_frames_h264 = expect_failure ? -1 : validate_config(disp, encoder, config_max_ref_frames);
-    auto autoselect_h264 = max_ref_frames_h264 >= 0 ? max_ref_frames_h264 : validate_config(disp, encoder, config_autoselect);
+    auto max_ref_frames_h264 = expect_failure ? -1 : validate_config(probe.disp, encoder, config_max_ref_frames);
+    auto autoselect_h264 = max_ref_frames_h264 >= 0 ? max_ref_frames_h264 : validate_config(probe.disp, encoder, config_autoselect);
     if (autoselect_h264 < 0) {
       return false;
     }
     else if (expect_failure) {
       // We expected failure, but actually succeeded. Do the max_ref_frames probe we skipped.
-      max_ref_frames_h264 = validate_config(disp, encoder, config_max_ref_frames);
+      max_ref_frames_h264 = validate_config(probe.disp, encoder, config_max_ref_frames);
     }
 
-    std::vector<std::pair<validate_flag_e, encoder_t::flag_e>> packet_deficiencies {
-      { VUI_PARAMS, encoder_t::VUI_PARAMETERS },
-    };
-
     for (auto [validate_flag, encoder_flag] : packet_deficiencies) {
       encoder.h264[encoder_flag] = (max_ref_frames_h264 & validate_flag && autoselect_h264 & validate_flag);
     }
@@ -3080,92 +4187,98 @@ namespace video {
     encoder.h264[encoder_t::REF_FRAMES_RESTRICT] = max_ref_frames_h264 >= 0;
     encoder.h264[encoder_t::PASSED] = true;
 
-    if (test_hevc) {
-      config_max_ref_frames.videoFormat = 1;
-      config_autoselect.videoFormat = 1;
+    // HDR is not supported with H.264. Don't bother even trying it.
+    encoder.h264[encoder_t::DYNAMIC_RANGE] = false;
+    encoder.h264[encoder_t::YUV444] = false;
+
+    encoder.h264[encoder_t::VUI_PARAMETERS] = encoder.h264[encoder_t::VUI_PARAMETERS] && !config::sunshine.flags[config::flag::FORCE_VIDEO_HEADER_REPLACE];
+    if (!encoder.h264[encoder_t::VUI_PARAMETERS]) {
+      BOOST_LOG(warning) << encoder.name << ": h264 missing sps->vui parameters"sv;
+    }
+
+    probe.max_ref_frames_h264 = max_ref_frames_h264;
 
-      if (disp->is_codec_supported(encoder.hevc.name, config_autoselect)) {
-        auto max_ref_frames_hevc = validate_config(disp, encoder, config_max_ref_frames);
+    fg.disable();
+    return true;
+  }
 
-        // If H.264 succeeded with max ref frames specified, assume that we can count on
-        // HEVC to also succeed with max ref frames specified if HEVC is supported.
-        auto autoselect_hevc = (max_ref_frames_hevc >= 0 || max_ref_frames_h264 >= 0) ?
-                                 max_ref_frames_hevc :
-                                 validate_config(disp, encoder, config_autoselect);
+  bool
+  probe_extended(encoder_probe_t &probe) {
+    auto &encoder = *probe.encoder;
 
-        for (auto [validate_flag, encoder_flag] : packet_deficiencies) {
-          encoder.hevc[encoder_flag] = (max_ref_frames_hevc & validate_flag && autoselect_hevc & validate_flag);
-        }
+    auto fg = util::fail_guard([&]() {
+      BOOST_LOG(info) << "Encoder ["sv << encoder.name << "] failed"sv;
 
-        encoder.hevc[encoder_t::REF_FRAMES_RESTRICT] = max_ref_frames_hevc >= 0;
-        encoder.hevc[encoder_t::PASSED] = max_ref_frames_hevc >= 0 || autoselect_hevc >= 0;
-      }
-      else {
-        BOOST_LOG(info) << "Encoder ["sv << encoder.hevc.name << "] is not supported on this GPU"sv;
-        encoder.hevc.capabilities.reset();
-      }
-    }
-    else {
-      // Clear all cap bits for HEVC if we didn't probe it
+      // Leave the encoder as probe_baseline() found it
+      encoder.h264[encoder_t::YUV444] = false;
       encoder.hevc.capabilities.reset();
+      encoder.av1.capabilities.reset();
+    });
+
+    // The test sessions are only created for what the flags claim to be supported
+    encoder.h264[encoder_t::YUV444] = true;
+    if (probe.test_hevc) {
+      encoder.hevc.capabilities.set();
+    }
+    if (probe.test_av1) {
+      encoder.av1.capabilities.set();
     }
 
-    if (test_av1) {
-      config_max_ref_frames.videoFormat = 2;
-      config_autoselect.videoFormat = 2;
+    auto test_codec = [&](auto &flag_map, int video_format) {
+      return [&, &flag_map = flag_map, video_format](std::shared_ptr<platf::display_t> &disp) {
+        config_t config_max_ref_frames { 1920, 1080, 60, 1000, 1, 1, 1, video_format, 0, 0, 0 };
+        config_t config_autoselect { 1920, 1080, 60, 1000, 1, 1, 0, video_format, 0, 0, 0 };
+
+        if (!disp->is_codec_supported(flag_map.name, config_autoselect)) {
+          BOOST_LOG(info) << "Encoder ["sv << flag_map.name << "] is not supported on this GPU"sv;
+          flag_map.capabilities.reset();
+          return;
+        }
 
-      if (disp->is_codec_supported(encoder.av1.name, config_autoselect)) {
-        auto max_ref_frames_av1 = validate_config(disp, encoder, config_max_ref_frames);
+        auto max_ref_frames = validate_config(disp, encoder, config_max_ref_frames);
 
         // If H.264 succeeded with max ref frames specified, assume that we can count on
-        // AV1 to also succeed with max ref frames specified if AV1 is supported.
-        auto autoselect_av1 = (max_ref_frames_av1 >= 0 || max_ref_frames_h264 >= 0) ?
-                                max_ref_frames_av1 :
-                                validate_config(disp, encoder, config_autoselect);
+        // this codec to also succeed with max ref frames specified if it is supported.
+        auto autoselect = (max_ref_frames >= 0 || probe.max_ref_frames_h264 >= 0) ?
+                            max_ref_frames :
+                            validate_config(disp, encoder, config_autoselect);
 
         for (auto [validate_flag, encoder_flag] : packet_deficiencies) {
-          encoder.av1[encoder_flag] = (max_ref_frames_av1 & validate_flag && autoselect_av1 & validate_flag);
+          flag_map[encoder_flag] = (max_ref_frames & validate_flag && autoselect & validate_flag);
         }
 
-        encoder.av1[encoder_t::REF_FRAMES_RESTRICT] = max_ref_frames_av1 >= 0;
-        encoder.av1[encoder_t::PASSED] = max_ref_frames_av1 >= 0 || autoselect_av1 >= 0;
-      }
-      else {
-        BOOST_LOG(info) << "Encoder ["sv << encoder.av1.name << "] is not supported on this GPU"sv;
-        encoder.av1.capabilities.reset();
-      }
+        flag_map[encoder_t::REF_FRAMES_RESTRICT] = max_ref_frames >= 0;
+        flag_map[encoder_t::PASSED] = max_ref_frames >= 0 || autoselect >= 0;
+      };
+    };
+
+    std::vector<probe_test_t> sdr_tests;
+    if (probe.test_hevc) {
+      sdr_tests.emplace_back(test_codec(encoder.hevc, 1));
     }
-    else {
-      // Clear all cap bits for AV1 if we didn't probe it
-      encoder.av1.capabilities.reset();
+    if (probe.test_av1) {
+      sdr_tests.emplace_back(test_codec(encoder.av1, 2));
     }
 
-    // Test HDR and YUV444 support
-    {
-      // H.264 is special because encoders may support YUV 4:4:4 without supporting 10-bit color depth
-      if (encoder.flags & YUV444_SUPPORT) {
+    // H.264 is special because encoders may support YUV 4:4:4 without supporting 10-bit color depth
+    if (encoder.flags & YUV444_SUPPORT) {
+      sdr_tests.emplace_back([&](std::shared_ptr<platf::display_t> &disp) {
         config_t config_h264_yuv444 { 1920, 1080, 60, 1000, 1, 1, 0, 0, 0, 0, 1 };
         encoder.h264[encoder_t::YUV444] = disp->is_codec_supported(encoder.h264.name, config_h264_yuv444) &&
                                           validate_config(disp, encoder, config_h264_yuv444) >= 0;
-      }
-      else {
-        encoder.h264[encoder_t::YUV444] = false;
-      }
-
-      const config_t generic_hdr_config = { 1920, 1080, 60, 1000, 1, 1, 0, 3, 1, 1, 0 };
-
-      // Reset the display since we're switching from SDR to HDR
-      reset_display(disp, encoder.platform_formats->dev_type, output_display_name, generic_hdr_config);
-      if (!disp) {
-        return false;
-      }
-
-      auto test_hdr_and_yuv444 = [&](auto &flag_map, auto video_format) {
-        auto config = generic_hdr_config;
-        config.videoFormat = video_format;
+      });
+    }
+    else {
+      encoder.h264[encoder_t::YUV444] = false;
+    }
 
-        if (!flag_map[encoder_t::PASSED]) return;
+    const config_t config_autoselect { 1920, 1080, 60, 1000, 1, 1, 0, 0, 0, 0, 0 };
+    run_probe_tests(probe, config_autoselect, sdr_tests);
 
+    // Test HDR and YUV444 support
+    auto test_hdr_and_yuv444 = [&](auto &flag_map, int video_format) {
+      return [&, &flag_map = flag_map, video_format](std::shared_ptr<platf::display_t> &disp) {
+        config_t config { 1920, 1080, 60, 1000, 1, 1, 0, video_format, 1, 1, 0 };
         auto encoder_codec_name = encoder.codec_from_config(config).name;
 
         // Test 4:4:4 HDR first. If 4:4:4 is supported, 4:2:0 should also be supported.
@@ -3191,20 +4304,29 @@ namespace video {
           flag_map[encoder_t::DYNAMIC_RANGE] = false;
         }
       };
+    };
 
-      // HDR is not supported with H.264. Don't bother even trying it.
-      encoder.h264[encoder_t::DYNAMIC_RANGE] = false;
-
-      test_hdr_and_yuv444(encoder.hevc, 1);
-      test_hdr_and_yuv444(encoder.av1, 2);
+    std::vector<probe_test_t> hdr_tests;
+    if (encoder.hevc[encoder_t::PASSED]) {
+      hdr_tests.emplace_back(test_hdr_and_yuv444(encoder.hevc, 1));
+    }
+    if (encoder.av1[encoder_t::PASSED]) {
+      hdr_tests.emplace_back(test_hdr_and_yuv444(encoder.av1, 2));
     }
 
-    encoder.h264[encoder_t::VUI_PARAMETERS] = encoder.h264[encoder_t::VUI_PARAMETERS] && !config::sunshine.flags[config::flag::FORCE_VIDEO_HEADER_REPLACE];
-    encoder.hevc[encoder_t::VUI_PARAMETERS] = encoder.hevc[encoder_t::VUI_PARAMETERS] && !config::sunshine.flags[config::flag::FORCE_VIDEO_HEADER_REPLACE];
+    if (!hdr_tests.empty()) {
+      const config_t generic_hdr_config = { 1920, 1080, 60, 1000, 1, 1, 0, 3, 1, 1, 0 };
 
-    if (!encoder.h264[encoder_t::VUI_PARAMETERS]) {
-      BOOST_LOG(warning) << encoder.name << ": h264 missing sps->vui parameters"sv;
+      // Reset the display since we're switching from SDR to HDR
+      reset_display(probe.disp, encoder.platform_formats->dev_type, probe.display_name, generic_hdr_config);
+      if (!probe.disp) {
+        return false;
+      }
+
+      run_probe_tests(probe, generic_hdr_config, hdr_tests);
     }
+
+    encoder.hevc[encoder_t::VUI_PARAMETERS] = encoder.hevc[encoder_t::VUI_PARAMETERS] && !config::sunshine.flags[config::flag::FORCE_VIDEO_HEADER_REPLACE];
     if (encoder.hevc[encoder_t::PASSED] && !encoder.hevc[encoder_t::VUI_PARAMETERS]) {
       BOOST_LOG(warning) << encoder.name << ": hevc missing sps->vui parameters"sv;
     }
@@ -3213,57 +4335,228 @@ namespace video {
     return true;
   }
 
-  int
-  probe_encoders() {
-    if (!allow_encoder_probing()) {
-      // Error already logged
-      return -1;
-    }
-    auto encoder_list = encoders;
+  bool
+  validate_encoder(encoder_t &encoder, bool expect_failure) {
+    encoder_probe_t probe { &encoder };
 
-    // If we already have a good encoder, check to see if another probe is required
-    if (chosen_encoder && !(chosen_encoder->flags & ALWAYS_REPROBE) && !platf::needs_encoder_reenumeration()) {
-      return 0;
-    }
+    return probe_baseline(probe, expect_failure) && probe_extended(probe);
+  }
 
-    // Restart encoder selection
-    auto previous_encoder = chosen_encoder;
-    chosen_encoder = nullptr;
-    active_hevc_mode = config::video.hevc_mode;
-    active_av1_mode = config::video.av1_mode;
-    last_encoder_probe_supported_ref_frames_invalidation = false;
+  namespace {
+    // Serializes the probes, including the one finishing in the background
+    std::mutex probe_lock;
 
-    auto adjust_encoder_constraints = [&](encoder_t *encoder) {
-      // If we can't satisfy both the encoder and codec requirement, prefer the encoder over codec support
-      if (active_hevc_mode == 3 && !encoder->hevc[encoder_t::DYNAMIC_RANGE]) {
-        BOOST_LOG(warning) << "Encoder ["sv << encoder->name << "] does not support HEVC Main10 on this system"sv;
-        active_hevc_mode = 0;
+    /**
+     * @brief Probe finishing in the background after startup, joined by the next probe.
+     * At shutdown, it gives up at the next encoder or test instead of completing.
+     */
+    struct background_probe_t {
+      ~background_probe_t() {
+        probe_stop = true;
+        join();
       }
-      else if (active_hevc_mode == 2 && !encoder->hevc[encoder_t::PASSED]) {
-        BOOST_LOG(warning) << "Encoder ["sv << encoder->name << "] does not support HEVC on this system"sv;
-        active_hevc_mode = 0;
+
+      void
+      join() {
+        if (thread.joinable()) {
+          thread.join();
+        }
       }
 
-      if (active_av1_mode == 3 && !encoder->av1[encoder_t::DYNAMIC_RANGE]) {
-        BOOST_LOG(warning) << "Encoder ["sv << encoder->name << "] does not support AV1 Main10 on this system"sv;
-        active_av1_mode = 0;
+      std::thread thread;
+    } background_probe;
+
+    // Set once the probe at startup ran, only that one may finish in the background
+    bool startup_probe_done = false;
+
+    std::string
+    probe_cache_path() {
+      return platf::appdata().string() + "/encoder_probe.json";
+    }
+
+    /**
+     * @brief Identify what the outcome of a probe depends on.
+     * @return The key, or an empty string if the GPUs and their drivers can't be identified.
+     */
+    std::string
+    probe_cache_key() {
+      auto adapters = platf::encoder_adapter_identity();
+      if (adapters.empty()) {
+        return {};
+      }
+
+      std::stringstream ss;
+      ss << PROJECT_NAME << ' ' << PROJECT_VER << '\n'
+         << "FFmpeg "sv << av_version_info() << '\n'
+         << adapters << '\n'
+         << "encoder="sv << config::video.encoder << '\n'
+         << "adapter_name="sv << config::video.adapter_name << '\n'
+         << "output_name="sv << config::video.output_name << '\n'
+         << "capture="sv << config::video.capture << '\n'
+         << "hevc_mode="sv << config::video.hevc_mode << '\n'
+         << "av1_mode="sv << config::video.av1_mode << '\n'
+         << "force_video_header_replace="sv << config::sunshine.flags[config::flag::FORCE_VIDEO_HEADER_REPLACE];
+
+      return ss.str();
+    }
+
+    /**
+     * @brief The outcome of a probe that chose an encoder.
+     * @param hevc_mode The HEVC mode the encoder was chosen for, 0 to use what it supports.
+     * @param av1_mode The AV1 mode the encoder was chosen for, 0 to use what it supports.
+     */
+    probe_result_t
+    make_probe_result(const encoder_t &encoder, int hevc_mode, int av1_mode) {
+      if (hevc_mode == 0) {
+        hevc_mode = encoder.hevc[encoder_t::PASSED] ? (encoder.hevc[encoder_t::DYNAMIC_RANGE] ? 3 : 2) : 1;
       }
-      else if (active_av1_mode == 2 && !encoder->av1[encoder_t::PASSED]) {
-        BOOST_LOG(warning) << "Encoder ["sv << encoder->name << "] does not support AV1 on this system"sv;
-        active_av1_mode = 0;
+
+      if (av1_mode == 0) {
+        av1_mode = encoder.av1[encoder_t::PASSED] ? (encoder.av1[encoder_t::DYNAMIC_RANGE] ? 3 : 2) : 1;
       }
-    };
 
-    if (!config::video.encoder.empty()) {
-      // If there is a specific encoder specified, use it if it passes validation
-      KITTY_WHILE_LOOP(auto pos = std::begin(encoder_list), pos != std::end(encoder_list), {
-        auto encoder = *pos;
+      return {
+        std::string { encoder.name },
+        encoder.h264.capabilities.to_ulong(),
+        encoder.hevc.capabilities.to_ulong(),
+        encoder.av1.capabilities.to_ulong(),
+        hevc_mode,
+        av1_mode,
+      };
+    }
+
+    /**
+     * @brief Validate the encoders and choose one of them.
+     * @param candidates The encoders to validate, in order of preference.
+     * @param previous_encoder The name of the encoder chosen by the previous probe, empty if none.
+     * @param result Receives the outcome, only published by publish_probe_result().
+     * @param pending If set and no codec besides H.264 is required, only H.264 is validated,
+     *                and the probe to complete with probe_extended() is stored here.
+     * @return 0 on success, -1 if no encoder works.
+     */
+    int
+    select_encoder(const std::vector<encoder_t *> &candidates, std::string_view previous_encoder, probe_result_t &result, std::optional<encoder_probe_t> *pending = nullptr) {
+      auto encoder_list = candidates;
+
+      encoder_t *chosen_encoder = nullptr;
+      auto active_hevc_mode = config::video.hevc_mode;
+      auto active_av1_mode = config::video.av1_mode;
+
+      auto lazy = pending && active_hevc_mode < 2 && active_av1_mode < 2;
+      auto validate = [&](encoder_t *encoder, bool expect_failure) {
+        if (probe_stop) {
+          return false;
+        }
+
+        if (!lazy) {
+          return validate_encoder(*encoder, expect_failure);
+        }
+
+        encoder_probe_t probe { encoder };
+        if (!probe_baseline(probe, expect_failure)) {
+          return false;
+        }
+
+        *pending = std::move(probe);
+        return true;
+      };
+
+      auto adjust_encoder_constraints = [&](encoder_t *encoder) {
+        // If we can't satisfy both the encoder and codec requirement, prefer the encoder over codec support
+        if (active_hevc_mode == 3 && !encoder->hevc[encoder_t::DYNAMIC_RANGE]) {
+          BOOST_LOG(warning) << "Encoder ["sv << encoder->name << "] does not support HEVC Main10 on this system"sv;
+          active_hevc_mode = 0;
+        }
+        else if (active_hevc_mode == 2 && !encoder->hevc[encoder_t::PASSED]) {
+          BOOST_LOG(warning) << "Encoder ["sv << encoder->name << "] does not support HEVC on this system"sv;
+          active_hevc_mode = 0;
+        }
+
+        if (active_av1_mode == 3 && !encoder->av1[encoder_t::DYNAMIC_RANGE]) {
+          BOOST_LOG(warning) << "Encoder ["sv << encoder->name << "] does not support AV1 Main10 on this system"sv;
+          active_av1_mode = 0;
+        }
+        else if (active_av1_mode == 2 && !encoder->av1[encoder_t::PASSED]) {
+          BOOST_LOG(warning) << "Encoder ["sv << encoder->name << "] does not support AV1 on this system"sv;
+          active_av1_mode = 0;
+        }
+      };
+
+      if (!config::video.encoder.empty()) {
+        // If there is a specific encoder specified, use it if it passes validation
+        KITTY_WHILE_LOOP(auto pos = std::begin(encoder_list), pos != std::end(encoder_list), {
+          auto encoder = *pos;
+
+          if (encoder->name == config::video.encoder) {
+            // Remove the encoder from the list entirely if it fails validation
+            if (!validate(encoder, !previous_encoder.empty() && previous_encoder != encoder->name)) {
+              pos = encoder_list.erase(pos);
+              break;
+            }
+
+            // We will return an encoder here even if it fails one of the codec requirements specified by the user
+            adjust_encoder_constraints(encoder);
+
+            chosen_encoder = encoder;
+            break;
+          }
+
+          pos++;
+        });
+
+        if (chosen_encoder == nullptr) {
+          BOOST_LOG(error) << "Couldn't find any working encoder matching ["sv << config::video.encoder << ']';
+        }
+      }
+
+      BOOST_LOG(info) << "Testing for available encoders - Errors during this phase can be ignored (测试可用编码器 - 此阶段的错误可以忽略)";
+
+      // If we haven't found an encoder yet, but we want one with specific codec support, search for that now.
+      if (chosen_encoder == nullptr && (active_hevc_mode >= 2 || active_av1_mode >= 2)) {
+        KITTY_WHILE_LOOP(auto pos = std::begin(encoder_list), pos != std::end(encoder_list), {
+          auto encoder = *pos;
 
-        if (encoder->name == config::video.encoder) {
           // Remove the encoder from the list entirely if it fails validation
-          if (!validate_encoder(*encoder, previous_encoder && previous_encoder != encoder)) {
+          if (!validate(encoder, !previous_encoder.empty() && previous_encoder != encoder->name)) {
             pos = encoder_list.erase(pos);
-            break;
+            continue;
+          }
+
+          // Skip it if it doesn't support the specified codec at all
+          if ((active_hevc_mode >= 2 && !encoder->hevc[encoder_t::PASSED]) ||
+              (active_av1_mode >= 2 && !encoder->av1[encoder_t::PASSED])) {
+            pos++;
+            continue;
+          }
+
+          // Skip it if it doesn't support HDR on the specified codec
+          if ((active_hevc_mode == 3 && !encoder->hevc[encoder_t::DYNAMIC_RANGE]) ||
+              (active_av1_mode == 3 && !encoder->av1[encoder_t::DYNAMIC_RANGE])) {
+            pos++;
+            continue;
+          }
+
+          chosen_encoder = encoder;
+          break;
+        });
+
+        if (chosen_encoder == nullptr) {
+          BOOST_LOG(error) << "Couldn't find any working encoder that meets HEVC/AV1 requirements"sv;
+        }
+      }
+
+      // If no encoder was specified or the specified encoder was unusable, keep trying
+      // the remaining encoders until we find one that passes validation.
+      if (chosen_encoder == nullptr) {
+        KITTY_WHILE_LOOP(auto pos = std::begin(encoder_list), pos != std::end(encoder_list), {
+          auto encoder = *pos;
+
+          // If we've used a previous encoder and it's not this one, we expect this encoder to
+          // fail to validate. It will use a slightly different order of checks to more quickly
+          // eliminate failing encoders.
+          if (!validate(encoder, !previous_encoder.empty() && previous_encoder != encoder->name)) {
+            pos = encoder_list.erase(pos);
+            continue;
           }
 
           // We will return an encoder here even if it fails one of the codec requirements specified by the user
@@ -3271,134 +4564,234 @@ namespace video {
 
           chosen_encoder = encoder;
           break;
-        }
+        });
+      }
 
-        pos++;
-      });
+      if (probe_stop) {
+        return -1;
+      }
 
       if (chosen_encoder == nullptr) {
-        BOOST_LOG(error) << "Couldn't find any working encoder matching ["sv << config::video.encoder << ']';
+        const auto output_display_name { display_device::get_display_name(config::video.output_name) };
+        BOOST_LOG(fatal) << "Unable to find display or encoder during startup."sv;
+        if (!config::video.adapter_name.empty() || !output_display_name.empty()) {
+          BOOST_LOG(fatal) << "Please ensure your manually chosen GPU and monitor are connected and powered on."sv;
+        }
+        else {
+          BOOST_LOG(fatal) << "Please check that a display is connected and powered on."sv;
+        }
+        return -1;
       }
+
+      BOOST_LOG(info) << "Ignore any errors, Encoder testing completed (忽略任何错误，编码器测试完成)";
+
+      result = make_probe_result(*chosen_encoder, active_hevc_mode, active_av1_mode);
+      return 0;
     }
 
-    BOOST_LOG(info) << "Testing for available encoders - Errors during this phase can be ignored (测试可用编码器 - 此阶段的错误可以忽略)";
+    /**
+     * @brief Make the outcome of a probe the one streams and clients see.
+     * @return `true` if the encoder of the result is available in this build.
+     */
+    bool
+    publish_probe_result(const probe_result_t &result) {
+      auto pos = std::find_if(std::begin(encoders), std::end(encoders), [&](auto encoder) {
+        return encoder->name == result.encoder;
+      });
+      if (pos == std::end(encoders)) {
+        return false;
+      }
+
+      auto &encoder = **pos;
+      {
+        std::lock_guard lg { probe_result_lock };
+
+        encoder.h264.capabilities = std::bitset<encoder_t::MAX_FLAGS> { result.h264 };
+        encoder.hevc.capabilities = std::bitset<encoder_t::MAX_FLAGS> { result.hevc };
+        encoder.av1.capabilities = std::bitset<encoder_t::MAX_FLAGS> { result.av1 };
+
+        chosen_encoder = &encoder;
+        active_hevc_mode = result.hevc_mode;
+        active_av1_mode = result.av1_mode;
+
+        // With intra refresh, the software encoder recovers from the losses the client reports
+        last_encoder_probe_supported_ref_frames_invalidation = (encoder.flags & REF_FRAMES_INVALIDATION) ||
+                                                               (&encoder == &software && sw_intra_refresh_period());
+        last_encoder_probe_supported_yuv444_for_codec[0] = encoder.h264[encoder_t::PASSED] &&
+                                                           encoder.h264[encoder_t::YUV444];
+        last_encoder_probe_supported_yuv444_for_codec[1] = encoder.hevc[encoder_t::PASSED] &&
+                                                           encoder.hevc[encoder_t::YUV444];
+        last_encoder_probe_supported_yuv444_for_codec[2] = encoder.av1[encoder_t::PASSED] &&
+                                                           encoder.av1[encoder_t::YUV444];
+      }
 
-    // If we haven't found an encoder yet, but we want one with specific codec support, search for that now.
-    if (chosen_encoder == nullptr && (active_hevc_mode >= 2 || active_av1_mode >= 2)) {
-      KITTY_WHILE_LOOP(auto pos = std::begin(encoder_list), pos != std::end(encoder_list), {
-        auto encoder = *pos;
+      BOOST_LOG(debug) << "------  h264 ------"sv;
+      for (int x = 0; x < encoder_t::MAX_FLAGS; ++x) {
+        auto flag = (encoder_t::flag_e) x;
+        BOOST_LOG(debug) << encoder_t::from_flag(flag) << (encoder.h264[flag] ? ": supported"sv : ": unsupported"sv);
+      }
+      BOOST_LOG(debug) << "-------------------"sv;
+      BOOST_LOG(info) << "Found H.264 encoder: "sv << encoder.h264.name << " ["sv << encoder.name << ']';
 
-        // Remove the encoder from the list entirely if it fails validation
-        if (!validate_encoder(*encoder, previous_encoder && previous_encoder != encoder)) {
-          pos = encoder_list.erase(pos);
-          continue;
+      if (encoder.hevc[encoder_t::PASSED]) {
+        BOOST_LOG(debug) << "------  hevc ------"sv;
+        for (int x = 0; x < encoder_t::MAX_FLAGS; ++x) {
+          auto flag = (encoder_t::flag_e) x;
+          BOOST_LOG(debug) << encoder_t::from_flag(flag) << (encoder.hevc[flag] ? ": supported"sv : ": unsupported"sv);
         }
+        BOOST_LOG(debug) << "-------------------"sv;
 
-        // Skip it if it doesn't support the specified codec at all
-        if ((active_hevc_mode >= 2 && !encoder->hevc[encoder_t::PASSED]) ||
-            (active_av1_mode >= 2 && !encoder->av1[encoder_t::PASSED])) {
-          pos++;
-          continue;
-        }
+        BOOST_LOG(info) << "Found HEVC encoder: "sv << encoder.hevc.name << " ["sv << encoder.name << ']';
+      }
 
-        // Skip it if it doesn't support HDR on the specified codec
-        if ((active_hevc_mode == 3 && !encoder->hevc[encoder_t::DYNAMIC_RANGE]) ||
-            (active_av1_mode == 3 && !encoder->av1[encoder_t::DYNAMIC_RANGE])) {
-          pos++;
-          continue;
+      if (encoder.av1[encoder_t::PASSED]) {
+        BOOST_LOG(debug) << "------  av1 ------"sv;
+        for (int x = 0; x < encoder_t::MAX_FLAGS; ++x) {
+          auto flag = (encoder_t::flag_e) x;
+          BOOST_LOG(debug) << encoder_t::from_flag(flag) << (encoder.av1[flag] ? ": supported"sv : ": unsupported"sv);
         }
+        BOOST_LOG(debug) << "-------------------"sv;
 
-        chosen_encoder = encoder;
-        break;
-      });
-
-      if (chosen_encoder == nullptr) {
-        BOOST_LOG(error) << "Couldn't find any working encoder that meets HEVC/AV1 requirements"sv;
+        BOOST_LOG(info) << "Found AV1 encoder: "sv << encoder.av1.name << " ["sv << encoder.name << ']';
       }
+
+      return true;
     }
 
-    // If no encoder was specified or the specified encoder was unusable, keep trying
-    // the remaining encoders until we find one that passes validation.
-    if (chosen_encoder == nullptr) {
-      KITTY_WHILE_LOOP(auto pos = std::begin(encoder_list), pos != std::end(encoder_list), {
-        auto encoder = *pos;
+    /**
+     * @brief Probe copies of the encoders, and replace the cached result if it turned out stale.
+     */
+    void
+    revalidate_probe(const probe_result_t &cached, const std::string &key) {
+      BOOST_LOG(info) << "Revalidating cached encoder probe result"sv;
+
+      // The encoders keep the capabilities of the cached result until a new one is published
+      std::vector<encoder_t> copies;
+      copies.reserve(encoders.size());
+      std::vector<encoder_t *> candidates;
+      for (auto encoder : encoders) {
+        candidates.emplace_back(&copies.emplace_back(*encoder));
+      }
 
-        // If we've used a previous encoder and it's not this one, we expect this encoder to
-        // fail to validate. It will use a slightly different order of checks to more quickly
-        // eliminate failing encoders.
-        if (!validate_encoder(*encoder, previous_encoder && previous_encoder != encoder)) {
-          pos = encoder_list.erase(pos);
-          continue;
-        }
+      probe_result_t result;
+      if (select_encoder(candidates, cached.encoder, result) || probe_stop) {
+        // Keep what worked before rather than being left without an encoder
+        return;
+      }
 
-        // We will return an encoder here even if it fails one of the codec requirements specified by the user
-        adjust_encoder_constraints(encoder);
+      if (result == cached) {
+        BOOST_LOG(info) << "Cached encoder probe result is up to date"sv;
+        return;
+      }
 
-        chosen_encoder = encoder;
-        break;
-      });
+      BOOST_LOG(warning) << "Cached encoder probe result was stale, now using encoder ["sv << result.encoder << ']';
+      publish_probe_result(result);
+      save_probe_result(probe_cache_path(), key, result);
     }
 
-    if (chosen_encoder == nullptr) {
-      const auto output_display_name { display_device::get_display_name(config::video.output_name) };
-      BOOST_LOG(fatal) << "Unable to find display or encoder during startup."sv;
-      if (!config::video.adapter_name.empty() || !output_display_name.empty()) {
-        BOOST_LOG(fatal) << "Please ensure your manually chosen GPU and monitor are connected and powered on."sv;
+    /**
+     * @brief Finish a probe that only validated H.264, and publish the other codecs found.
+     */
+    void
+    complete_probe(encoder_probe_t &probe, const std::string &key) {
+      auto start = std::chrono::steady_clock::now();
+
+      auto extended = probe_extended(probe);
+      probe.disp.reset();
+
+      auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+      if (!extended) {
+        BOOST_LOG(warning) << "Encoder ["sv << probe.encoder->name << "] is limited to H.264, testing the other codecs failed"sv;
+        return;
       }
-      else {
-        BOOST_LOG(fatal) << "Please check that a display is connected and powered on."sv;
+
+      if (probe_stop) {
+        return;
+      }
+
+      // The modes were resolved for H.264 alone
+      auto result = make_probe_result(*probe.encoder, config::video.hevc_mode, config::video.av1_mode);
+      publish_probe_result(result);
+
+      BOOST_LOG(info) << "Encoder ["sv << probe.encoder->name << "] codecs and formats probed in the background in "sv << delay.count() << "ms"sv;
+      if (config::video.encoder_probe_cache && !key.empty()) {
+        save_probe_result(probe_cache_path(), key, result);
       }
-      return -1;
     }
+  }  // namespace
 
-    BOOST_LOG(info) << "Ignore any errors, Encoder testing completed (忽略任何错误，编码器测试完成)";
+  int
+  probe_encoders() {
+    if (!allow_encoder_probing()) {
+      // Error already logged
+      return -1;
+    }
 
-    auto &encoder = *chosen_encoder;
+    // Streams must not start on an encoder that is still being probed
+    background_probe.join();
 
-    last_encoder_probe_supported_ref_frames_invalidation = (encoder.flags & REF_FRAMES_INVALIDATION);
-    last_encoder_probe_supported_yuv444_for_codec[0] = encoder.h264[encoder_t::PASSED] &&
-                                                       encoder.h264[encoder_t::YUV444];
-    last_encoder_probe_supported_yuv444_for_codec[1] = encoder.hevc[encoder_t::PASSED] &&
-                                                       encoder.hevc[encoder_t::YUV444];
-    last_encoder_probe_supported_yuv444_for_codec[2] = encoder.av1[encoder_t::PASSED] &&
-                                                       encoder.av1[encoder_t::YUV444];
+    std::lock_guard lg { probe_lock };
 
-    BOOST_LOG(debug) << "------  h264 ------"sv;
-    for (int x = 0; x < encoder_t::MAX_FLAGS; ++x) {
-      auto flag = (encoder_t::flag_e) x;
-      BOOST_LOG(debug) << encoder_t::from_flag(flag) << (encoder.h264[flag] ? ": supported"sv : ": unsupported"sv);
+    // If we already have a good encoder, check to see if another probe is required
+    if (chosen_encoder && !(chosen_encoder->flags & ALWAYS_REPROBE) && !platf::needs_encoder_reenumeration()) {
+      return 0;
     }
-    BOOST_LOG(debug) << "-------------------"sv;
-    BOOST_LOG(info) << "Found H.264 encoder: "sv << encoder.h264.name << " ["sv << encoder.name << ']';
 
-    if (encoder.hevc[encoder_t::PASSED]) {
-      BOOST_LOG(debug) << "------  hevc ------"sv;
-      for (int x = 0; x < encoder_t::MAX_FLAGS; ++x) {
-        auto flag = (encoder_t::flag_e) x;
-        BOOST_LOG(debug) << encoder_t::from_flag(flag) << (encoder.hevc[flag] ? ": supported"sv : ": unsupported"sv);
-      }
-      BOOST_LOG(debug) << "-------------------"sv;
+    // Later probes precede a stream, or mean the hardware may have changed.
+    // Only the probe at startup is taken from the cache or finished in the background.
+    auto startup = !std::exchange(startup_probe_done, true);
+    auto start = std::chrono::steady_clock::now();
+    auto log_ready = [&]() {
+      auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+      BOOST_LOG(info) << "Encoder ready for streaming after "sv << delay.count() << "ms"sv;
+    };
 
-      BOOST_LOG(info) << "Found HEVC encoder: "sv << encoder.hevc.name << " ["sv << encoder.name << ']';
-    }
+    auto previous_encoder = chosen_encoder ? chosen_encoder->name : ""sv;
+    auto key = probe_cache_key();
+    if (startup && config::video.encoder_probe_cache && !key.empty()) {
+      auto cached = load_probe_result(probe_cache_path(), key);
+      if (cached && publish_probe_result(*cached)) {
+        BOOST_LOG(info) << "Using cached encoder probe result"sv;
+
+        if (config::video.encoder_probe_revalidate) {
+          background_probe.thread = std::thread { [cached = *cached, key]() {
+            std::lock_guard lg { probe_lock };
+            revalidate_probe(cached, key);
+          } };
+        }
 
-    if (encoder.av1[encoder_t::PASSED]) {
-      BOOST_LOG(debug) << "------  av1 ------"sv;
-      for (int x = 0; x < encoder_t::MAX_FLAGS; ++x) {
-        auto flag = (encoder_t::flag_e) x;
-        BOOST_LOG(debug) << encoder_t::from_flag(flag) << (encoder.av1[flag] ? ": supported"sv : ": unsupported"sv);
+        log_ready();
+        return 0;
       }
-      BOOST_LOG(debug) << "-------------------"sv;
+    }
 
-      BOOST_LOG(info) << "Found AV1 encoder: "sv << encoder.av1.name << " ["sv << encoder.name << ']';
+    probe_result_t result;
+    std::optional<encoder_probe_t> pending;
+    if (select_encoder(encoders, previous_encoder, result, startup && config::video.encoder_probe_lazy ? &pending : nullptr)) {
+      std::lock_guard lg { probe_result_lock };
+      chosen_encoder = nullptr;
+      return -1;
     }
 
-    if (active_hevc_mode == 0) {
-      active_hevc_mode = encoder.hevc[encoder_t::PASSED] ? (encoder.hevc[encoder_t::DYNAMIC_RANGE] ? 3 : 2) : 1;
+    publish_probe_result(result);
+    log_ready();
+
+    if (pending) {
+      BOOST_LOG(info) << "Probing the other codecs and formats of encoder ["sv << chosen_encoder->name << "] in the background"sv;
+
+      // The published encoder keeps its H.264 capabilities until the result of the copy is published
+      auto encoder = std::make_unique<encoder_t>(*pending->encoder);
+      pending->encoder = encoder.get();
+      background_probe.thread = std::thread { [encoder = std::move(encoder), probe = std::move(*pending), key]() mutable {
+        std::lock_guard lg { probe_lock };
+        complete_probe(probe, key);
+      } };
+
+      return 0;
     }
 
-    if (active_av1_mode == 0) {
-      active_av1_mode = encoder.av1[encoder_t::PASSED] ? (encoder.av1[encoder_t::DYNAMIC_RANGE] ? 3 : 2) : 1;
+    if (config::video.encoder_probe_cache && !key.empty()) {
+      save_probe_result(probe_cache_path(), key, result);
     }
 
     return 0;
@@ -3507,6 +4900,7 @@ namespace video {
       capture_thread_ctx.capture_ctx_queue,
       std::ref(capture_thread_ctx.display_wp),
       std::ref(capture_thread_ctx.reinit_event),
+      std::ref(capture_thread_ctx.display_switched),
       std::ref(*capture_thread_ctx.encoder_p)
     };
 
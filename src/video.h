@@ -26,6 +26,7 @@ namespace video {
     ADAPTIVE_QUANTIZATION, // 自适应量化
     MULTI_PASS,        // 多遍编码
     VBV_BUFFER_SIZE,   // VBV缓冲区大小
+    RESOLUTION_SCALE,  // 编码分辨率缩放 (串流分辨率的百分比, 25-100)
     MAX_PARAM_TYPE
   };
 
@@ -87,6 +88,9 @@ namespace video {
       }
       return static_cast<double>(framerate);
     }
+
+    bool
+    operator==(const config_t &) const = default;
   };
 
   platf::mem_type_e
@@ -101,6 +105,23 @@ namespace video {
   void
   free_buffer(AVBufferRef *ref);
 
+  /**
+   * @brief Make `view` a reference to a rectangle of `frame`, so it can be written to in place.
+   *
+   * The view shares the buffers and line sizes of `frame`, its data pointers are moved
+   * to the top left corner of the rectangle. Since it holds a buffer reference,
+   * sws_scale_frame() writes into it instead of allocating new buffers.
+   * @param view The frame to turn into the view, it is unreferenced first.
+   * @param frame The frame to look into, it must have buffers.
+   * @param x The left edge of the rectangle, rounded down to the chroma subsampling in chroma planes.
+   * @param y The top edge of the rectangle, rounded down to the chroma subsampling in chroma planes.
+   * @param width The width of the rectangle.
+   * @param height The height of the rectangle.
+   * @return 0 on success, a negative value otherwise.
+   */
+  int
+  frame_view(AVFrame *view, const AVFrame *frame, int x, int y, int width, int height);
+
   using avcodec_ctx_t = util::safe_ptr<AVCodecContext, free_ctx>;
   using avcodec_frame_t = util::safe_ptr<AVFrame, free_frame>;
   using avcodec_buffer_t = util::safe_ptr<AVBufferRef, free_buffer>;
@@ -204,7 +225,8 @@ namespace video {
           name { std::move(name) }, value { std::move(value) } {}
     };
 
-    const std::unique_ptr<const encoder_platform_formats_t> platform_formats;
+    // Shared so the probe can validate copies of the encoders
+    const std::shared_ptr<const encoder_platform_formats_t> platform_formats;
 
     struct codec_t {
       std::vector<option_t> common_options;
@@ -266,6 +288,15 @@ namespace video {
 
     virtual void
     set_dynamic_param(const dynamic_param_t &param) = 0;  // 新增：通用动态参数调整方法
+
+    /**
+     * @brief Hint which parts of the image converted last changed since the previous one.
+     * @param damage The changed areas in image coordinates, empty if unknown.
+     * @param width The width of the image.
+     * @param height The height of the image.
+     */
+    virtual void
+    set_damage(const std::vector<platf::rect_t> &damage, int width, int height) {}
   };
 
   // encoders
@@ -313,9 +344,13 @@ namespace video {
           old { std::move(old) }, _new { std::move(_new) } {}
     };
 
-    std::vector<replace_t> *replacements = nullptr;
+    // The payload to send instead of data() if not empty, e.g. with its parameter sets rewritten.
+    // The pieces point into data() and into gather_buffers, which the packet keeps alive past its encode session.
+    std::vector<std::string_view> gather;
+    std::shared_ptr<const void> gather_buffers;
     void *channel_data = nullptr;
     bool after_ref_frame_invalidation = false;
+    bool intra_refresh = false;  // A P-frame starting an intra refresh cycle of libx264, which recovers from losses instead of an IDR frame
     std::optional<std::chrono::steady_clock::time_point> frame_timestamp;
   };
 
@@ -324,6 +359,12 @@ namespace video {
       av_packet = av_packet_alloc();
     }
 
+    /**
+     * @param av_packet An empty packet, freed with this object unless it's taken back before.
+     */
+    explicit packet_raw_avcodec(AVPacket *av_packet):
+        av_packet { av_packet } {}
+
     ~packet_raw_avcodec() {
       av_packet_free(&this->av_packet);
     }
@@ -383,6 +424,18 @@ namespace video {
 
   using packet_t = std::unique_ptr<packet_raw_t>;
 
+  /**
+   * @brief Apply replacements to the parameter sets at the start of an IDR frame.
+   *
+   * Only the NAL units up to the first slice are looked at, the slices are passed through as is.
+   * @param data The IDR frame in Annex B format.
+   * @param replacements The parameter sets to replace, each with its start code.
+   * @param hevc `true` for HEVC, `false` for H.264.
+   * @return The frame with the replacements applied, as pieces of `data` and of the replacements.
+   */
+  std::vector<std::string_view>
+  gather_replacements(std::string_view data, const std::vector<packet_raw_t::replace_t> &replacements, bool hevc);
+
   struct hdr_info_raw_t {
     explicit hdr_info_raw_t(bool enabled):
         enabled { enabled }, metadata {} {};
@@ -395,21 +448,108 @@ namespace video {
 
   using hdr_info_t = std::unique_ptr<hdr_info_raw_t>;
 
+  /**
+   * @brief Guards the outcome of the last encoder probe below, as a probe may finish in the background.
+   * Streams need not take it, probe_encoders() joins the background probe before they start.
+   */
+  extern std::mutex probe_result_lock;
   extern int active_hevc_mode;
   extern int active_av1_mode;
   extern bool last_encoder_probe_supported_ref_frames_invalidation;
   extern std::array<bool, 3> last_encoder_probe_supported_yuv444_for_codec;  // 0 - H.264, 1 - HEVC, 2 - AV1
 
+  /**
+   * @brief The configuration to encode a stream at a fraction of its resolution.
+   * @param scale_percent The resolution in percent of the stream's, clamped to [25, 100].
+   * @return The configuration, with even dimensions as chroma subsampling requires.
+   */
+  config_t
+  scaled_config(const config_t &config, int scale_percent);
+
+  /**
+   * @brief Build an encode session that encodes a stream at a fraction of its resolution.
+   *
+   * The encode device scales the captured images down while converting them, the capture is left as is.
+   * @param scale_percent The resolution in percent of the stream's, see scaled_config().
+   * @return The session, or nullptr on failure.
+   */
+  std::unique_ptr<encode_session_t>
+  make_scaled_encode_session(platf::display_t &disp, const encoder_t &encoder, const config_t &config, int scale_percent);
+
+  int
+  encode(int64_t frame_nr, encode_session_t &session, safe::mail_raw_t::queue_t<packet_t> &packets, void *channel_data, std::optional<std::chrono::steady_clock::time_point> frame_timestamp);
+
+  /**
+   * @brief Encode the images of a capture until the stream ends or the capture has to be reinitialized.
+   * @param frame_nr The number of the next frame, kept across reinitializations.
+   * @param session The session to encode with, replaced on RESOLUTION_SCALE changes.
+   * @param dynamic_param_events The dynamic parameter changes of the session, those of the mail manager if not set.
+   */
+  void
+  encode_run(
+    int &frame_nr,
+    safe::mail_t mail,
+    img_event_t images,
+    safe::mail_raw_t::queue_t<packet_t> packets,
+    config_t config,
+    std::shared_ptr<platf::display_t> disp,
+    std::unique_ptr<encode_session_t> session,
+    safe::signal_t &reinit_event,
+    const encoder_t &encoder,
+    void *channel_data,
+    std::optional<safe::mail_raw_t::event_t<dynamic_param_t>> dynamic_param_events);
+
+  class prewarmed_session_t;
+
+  /**
+   * @brief Start building the encoder of a stream in the background, while the client is still connecting.
+   * @param mail The mail of the session.
+   * @param config The stream settings, as they will be passed to capture().
+   * @return The session to hand to capture(), dropping it discards the encoder.
+   *         `nullptr` if the encoder isn't built ahead of time for the chosen encoder or settings.
+   */
+  std::shared_ptr<prewarmed_session_t>
+  prewarm(safe::mail_t mail, const config_t &config);
+
   void
   capture(
     safe::mail_t mail,
     config_t config,
     void *channel_data,
-    std::optional<safe::mail_raw_t::event_t<dynamic_param_t>> dynamic_param_events = std::nullopt);
+    std::optional<safe::mail_raw_t::event_t<dynamic_param_t>> dynamic_param_events = std::nullopt,
+    std::shared_ptr<prewarmed_session_t> prewarmed = nullptr);
 
   bool
   validate_encoder(encoder_t &encoder, bool expect_failure);
 
+  /**
+   * @brief State of an encoder probe, carried from its H.264 baseline to the other codecs and formats.
+   */
+  struct encoder_probe_t {
+    encoder_t *encoder;
+    std::shared_ptr<platf::display_t> disp;
+    std::string display_name;
+    int max_ref_frames_h264 {};
+    bool test_hevc {};
+    bool test_av1 {};
+    bool parallel {};  ///< Run independent tests concurrently, each on a display of its own
+  };
+
+  /**
+   * @brief Validate H.264, which is enough for the encoder to be used.
+   * HEVC, AV1 and YUV 4:4:4 are reported as unsupported until probe_extended() tested them.
+   * @return `true` if the encoder works.
+   */
+  bool
+  probe_baseline(encoder_probe_t &probe, bool expect_failure);
+
+  /**
+   * @brief Validate HEVC, AV1, YUV 4:4:4 and HDR support of an encoder that passed probe_baseline().
+   * @return `false` if the tests couldn't run, the encoder is then left as probe_baseline() found it.
+   */
+  bool
+  probe_extended(encoder_probe_t &probe);
+
   /**
    * @brief Probe encoders and select the preferred encoder.
    * This is called once at startup and each time a stream is launched to
@@ -0,0 +1,141 @@
+/**
+ * @file src/video_broadcast.cpp
+ * @brief Definitions for fanning the packets of a shared encoder out to several sessions.
+ */
+// standard includes
+#include <algorithm>
+
+// local includes
+#include "video_broadcast.h"
+
+namespace video {
+  packet_raw_shared::packet_raw_shared(std::shared_ptr<packet_raw_t> packet, int64_t frame_index):
+      packet { std::move(packet) }, index { frame_index } {
+    gather = this->packet->gather;
+    gather_buffers = this->packet->gather_buffers;
+    after_ref_frame_invalidation = this->packet->after_ref_frame_invalidation;
+    intra_refresh = this->packet->intra_refresh;
+    frame_timestamp = this->packet->frame_timestamp;
+  }
+
+  bool
+  packet_raw_shared::is_idr() {
+    return packet->is_idr();
+  }
+
+  int64_t
+  packet_raw_shared::frame_index() {
+    return index;
+  }
+
+  uint8_t *
+  packet_raw_shared::data() {
+    return packet->data();
+  }
+
+  size_t
+  packet_raw_shared::data_size() {
+    return packet->data_size();
+  }
+
+  broadcast_hub_t::broadcast_hub_t(std::size_t max_replay):
+      _max_replay { max_replay } {}
+
+  bool
+  broadcast_hub_t::subscribe(void *channel_data, std::vector<packet_t> &replay) {
+    std::lock_guard lg { _lock };
+
+    auto &subscriber = _subscribers.emplace_back(subscriber_t { channel_data, std::nullopt });
+    if (_gop.empty()) {
+      return true;
+    }
+
+    subscriber.base = _gop.front()->frame_index() - 1;
+    for (auto &packet : _gop) {
+      replay.emplace_back(make_packet(subscriber, packet));
+    }
+
+    return false;
+  }
+
+  void
+  broadcast_hub_t::unsubscribe(void *channel_data) {
+    std::lock_guard lg { _lock };
+
+    std::erase_if(_subscribers, [channel_data](const subscriber_t &subscriber) {
+      return subscriber.channel_data == channel_data;
+    });
+  }
+
+  std::size_t
+  broadcast_hub_t::subscribers() {
+    std::lock_guard lg { _lock };
+    return _subscribers.size();
+  }
+
+  std::vector<packet_t>
+  broadcast_hub_t::publish(packet_t &&packet) {
+    std::shared_ptr<packet_raw_t> shared { std::move(packet) };
+
+    std::lock_guard lg { _lock };
+
+    if (shared->is_idr()) {
+      _gop.clear();
+    }
+
+    // Without an IDR frame to start from, the frames are useless to a joining session.
+    // Past max_replay frames, a joining session waits for a new IDR frame instead.
+    if (!_gop.empty() || shared->is_idr()) {
+      _gop.emplace_back(shared);
+
+      if (_gop.size() > _max_replay) {
+        _gop.clear();
+      }
+    }
+
+    std::vector<packet_t> packets;
+    packets.reserve(_subscribers.size());
+    for (auto &subscriber : _subscribers) {
+      if (!subscriber.base) {
+        if (!shared->is_idr()) {
+          continue;
+        }
+
+        subscriber.base = shared->frame_index() - 1;
+      }
+
+      packets.emplace_back(make_packet(subscriber, shared));
+    }
+
+    return packets;
+  }
+
+  std::optional<int64_t>
+  broadcast_hub_t::encoder_frame_index(void *channel_data, int64_t frame_index) {
+    std::lock_guard lg { _lock };
+
+    auto subscriber = std::find_if(std::begin(_subscribers), std::end(_subscribers), [channel_data](const subscriber_t &subscriber) {
+      return subscriber.channel_data == channel_data;
+    });
+
+    if (subscriber == std::end(_subscribers) || !subscriber->base) {
+      return std::nullopt;
+    }
+
+    return *subscriber->base + frame_index;
+  }
+
+  void
+  broadcast_hub_t::reset() {
+    std::lock_guard lg { _lock };
+    _gop.clear();
+  }
+
+  packet_t
+  broadcast_hub_t::make_packet(subscriber_t &subscriber, const std::shared_ptr<packet_raw_t> &packet) {
+    auto session_packet = std::make_unique<packet_raw_shared>(packet, packet->frame_index() - *subscriber.base);
+    session_packet->channel_data = subscriber.channel_data;
+
+    return session_packet;
+  }
+}  // namespace video
@@ -0,0 +1,121 @@
+/**
+ * @file src/video_broadcast.h
+ * @brief Declarations for fanning the packets of a shared encoder out to several sessions.
+ */
+#pragma once
+
+// standard includes
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// local includes
+#include "video.h"
+
+namespace video {
+  /**
+   * @brief A packet of a shared encoder, as seen by one of the sessions it is sent to.
+   *
+   * The encoded data is shared, only the frame index and the fields filled in
+   * by the video thread belong to the session.
+   */
+  struct packet_raw_shared: packet_raw_t {
+    packet_raw_shared(std::shared_ptr<packet_raw_t> packet, int64_t frame_index);
+
+    bool
+    is_idr() override;
+
+    int64_t
+    frame_index() override;
+
+    uint8_t *
+    data() override;
+
+    size_t
+    data_size() override;
+
+    std::shared_ptr<packet_raw_t> packet;
+    int64_t index;
+  };
+
+  /**
+   * @brief Fans the packets of one encoder out to the sessions subscribed to it.
+   *
+   * Each session numbers its frames from 1, starting at the first IDR frame it receives,
+   * so it doesn't mistake the frames encoded before it joined for lost ones.
+   * The frames since the last IDR frame are kept, so a session joining shortly after
+   * an IDR frame starts right away with a replay of them instead of waiting for a new one.
+   */
+  class broadcast_hub_t {
+  public:
+    /**
+     * @param max_replay The maximum number of frames replayed to a joining session.
+     */
+    explicit broadcast_hub_t(std::size_t max_replay);
+
+    /**
+     * @brief Add a session.
+     * @param channel_data The channel data of the session's packets.
+     * @param replay Receives the packets the session starts with.
+     * @return `true` if the session is waiting for a new IDR frame, `false` if it starts with `replay`.
+     */
+    bool
+    subscribe(void *channel_data, std::vector<packet_t> &replay);
+
+    /**
+     * @brief Remove a session.
+     */
+    void
+    unsubscribe(void *channel_data);
+
+    /**
+     * @return The number of sessions.
+     */
+    std::size_t
+    subscribers();
+
+    /**
+     * @brief Make a packet of the encoder for each session that can decode it.
+     *
+     * Sessions waiting for an IDR frame start with the first one published.
+     */
+    std::vector<packet_t>
+    publish(packet_t &&packet);
+
+    /**
+     * @brief Translate a frame index of a session to the encoder's.
+     * @return The frame index, or `std::nullopt` if the session hasn't received any frame yet.
+     */
+    std::optional<int64_t>
+    encoder_frame_index(void *channel_data, int64_t frame_index);
+
+    /**
+     * @brief Forget the frames since the last IDR frame, e.g. when the encoder is recreated.
+     *
+     * The rewritten parameter sets of the cached packets belong to the encoder session.
+     */
+    void
+    reset();
+
+  private:
+    struct subscriber_t {
+      void *channel_data;
+
+      // The encoder frame index preceding the first frame of the session
+      std::optional<int64_t> base;
+    };
+
+    packet_t
+    make_packet(subscriber_t &subscriber, const std::shared_ptr<packet_raw_t> &packet);
+
+    std::mutex _lock;
+
+    std::size_t _max_replay;
+    std::vector<subscriber_t> _subscribers;
+
+    // The frames since the last IDR frame, starting with it
+    std::vector<std::shared_ptr<packet_raw_t>> _gop;
+  };
+}  // namespace video
@@ -0,0 +1,105 @@
+/**
+ * @file tests/unit/platform/linux/test_capture_scheduler.cpp
+ * @brief Test src/platform/linux/capture_scheduler.*.
+ */
+#ifdef __linux__
+  #include <src/platform/linux/capture_scheduler.h>
+
+  #include <thread>
+
+  #include "../../../tests_common.h"
+
+using platf::capture_scheduler_t;
+
+TEST(CaptureSchedulerTest, FirstDeadlineIsImmediate) {
+  capture_scheduler_t scheduler { 1s };
+
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(scheduler.wait(), 0);
+  ASSERT_LT(std::chrono::steady_clock::now() - start, 100ms);
+  ASSERT_EQ(scheduler.stats().frames, 1);
+}
+
+TEST(CaptureSchedulerTest, DoesNotDrift) {
+  constexpr auto period = 4ms;
+  constexpr int frames = 50;
+  capture_scheduler_t scheduler { period };
+
+  auto first = scheduler.next_deadline();
+  for (int x = 0; x < frames; ++x) {
+    scheduler.wait();
+
+    // Some work that takes a varying fraction of the period
+    std::this_thread::sleep_for(std::chrono::microseconds { (x % 4) * 500 });
+  }
+
+  // Deadlines stay on the grid regardless of the work done in between,
+  // a hiccup of the runner only skips whole periods
+  auto stats = scheduler.stats();
+  ASSERT_EQ(stats.frames, frames);
+  ASSERT_EQ(scheduler.next_deadline(), first + period * (frames + (int) stats.missed));
+  ASSERT_LE(stats.jitter_mean, stats.jitter_max);
+}
+
+TEST(CaptureSchedulerTest, SkipsMissedDeadlines) {
+  constexpr auto period = 10ms;
+  capture_scheduler_t scheduler { period };
+
+  scheduler.wait();
+  auto next = scheduler.next_deadline();
+
+  // Overrun the next 3 deadlines and a half
+  std::this_thread::sleep_until(next + period * 3 + period / 2);
+  ASSERT_EQ(scheduler.wait(), 3);
+
+  // Resumed on the grid, right after the last missed deadline
+  ASSERT_EQ(scheduler.next_deadline(), next + period * 4);
+  ASSERT_EQ(scheduler.stats().missed, 3);
+  ASSERT_EQ(scheduler.stats().frames, 2);
+}
+
+TEST(CaptureSchedulerTest, LateWithinPeriodIsNotSkipped) {
+  constexpr auto period = 20ms;
+  capture_scheduler_t scheduler { period };
+
+  scheduler.wait();
+  std::this_thread::sleep_until(scheduler.next_deadline() + period / 4);
+
+  ASSERT_EQ(scheduler.wait(), 0);
+  ASSERT_EQ(scheduler.stats().missed, 0);
+}
+
+TEST(CaptureSchedulerTest, AlignsToVblank) {
+  constexpr auto period = 16ms;
+  capture_scheduler_t scheduler { period };
+
+  // A vblank 3ms after a deadline delays the deadlines by 3ms
+  auto next = scheduler.next_deadline();
+  scheduler.align(next + 3ms - period * 10);
+  ASSERT_EQ(scheduler.next_deadline(), next + 3ms);
+  ASSERT_EQ(scheduler.stats().realigned, 1);
+
+  // A vblank 4ms before a deadline moves them back, the shorter way
+  next = scheduler.next_deadline();
+  scheduler.align(next - 4ms + period * 2);
+  ASSERT_EQ(scheduler.next_deadline(), next - 4ms);
+
+  // Small phase errors are ignored
+  next = scheduler.next_deadline();
+  scheduler.align(next + capture_scheduler_t::align_tolerance / 2);
+  ASSERT_EQ(scheduler.next_deadline(), next);
+  ASSERT_EQ(scheduler.stats().realigned, 2);
+}
+
+TEST(CaptureSchedulerTest, ResetRestartsSchedule) {
+  capture_scheduler_t scheduler { 10ms };
+
+  scheduler.wait();
+  std::this_thread::sleep_for(50ms);
+  scheduler.reset();
+
+  ASSERT_EQ(scheduler.wait(), 0);
+  ASSERT_EQ(scheduler.stats().frames, 1);
+  ASSERT_EQ(scheduler.stats().missed, 0);
+}
+#endif
@@ -0,0 +1,174 @@
+/**
+ * @file tests/unit/platform/linux/test_evdev_batch.cpp
+ * @brief Test src/platform/linux/input/evdev_batch.h.
+ */
+#ifdef __linux__
+  #include <src/platform/linux/input/evdev_batch.h>
+
+  #include <fcntl.h>
+
+  #include <vector>
+
+  #include "../../../tests_common.h"
+
+namespace {
+  struct pipe_t {
+    pipe_t() {
+      EXPECT_EQ(pipe2(fds, O_NONBLOCK), 0);
+    }
+
+    ~pipe_t() {
+      close(fds[0]);
+      close(fds[1]);
+    }
+
+    std::vector<input_event>
+    drain() {
+      std::vector<input_event> events;
+      input_event buf[64];
+      ssize_t bytes;
+      while ((bytes = read(fds[0], buf, sizeof(buf))) > 0) {
+        events.insert(events.end(), buf, buf + bytes / sizeof(input_event));
+      }
+      return events;
+    }
+
+    int fds[2];
+  };
+
+  struct event_t {
+    unsigned int type;
+    unsigned int code;
+    int value;
+  };
+
+  // A full gamepad state change, as sent by gamepad_update()
+  const std::vector<event_t> gamepad_report {
+    { EV_ABS, ABS_HAT0Y, -1 },
+    { EV_ABS, ABS_HAT0X, 1 },
+    { EV_KEY, BTN_START, 1 },
+    { EV_KEY, BTN_SELECT, 1 },
+    { EV_KEY, BTN_THUMBL, 1 },
+    { EV_KEY, BTN_THUMBR, 1 },
+    { EV_KEY, BTN_TL, 1 },
+    { EV_KEY, BTN_TR, 1 },
+    { EV_KEY, BTN_MODE, 1 },
+    { EV_KEY, BTN_SOUTH, 1 },
+    { EV_KEY, BTN_EAST, 1 },
+    { EV_KEY, BTN_NORTH, 1 },
+    { EV_KEY, BTN_WEST, 1 },
+    { EV_ABS, ABS_Z, 255 },
+    { EV_ABS, ABS_RZ, 255 },
+    { EV_ABS, ABS_X, 1000 },
+    { EV_ABS, ABS_Y, -1000 },
+    { EV_ABS, ABS_RX, 2000 },
+    { EV_ABS, ABS_RY, -2000 },
+    { EV_SYN, SYN_REPORT, 0 },
+  };
+
+  // One write() per event, like libevdev_uinput_write_event()
+  std::size_t
+  write_unbatched(int fd, const std::vector<event_t> &report) {
+    std::size_t writes = 0;
+    for (auto &e : report) {
+      input_event ev {};
+      ev.type = e.type;
+      ev.code = e.code;
+      ev.value = e.value;
+      EXPECT_EQ(write(fd, &ev, sizeof(ev)), sizeof(ev));
+      ++writes;
+    }
+    return writes;
+  }
+
+  std::size_t
+  write_batched(int fd, const std::vector<event_t> &report) {
+    platf::evdev::batch_t batch { fd };
+    for (auto &e : report) {
+      EXPECT_EQ(batch.write(e.type, e.code, e.value), 0);
+    }
+    return batch.writes();
+  }
+}  // namespace
+
+TEST(EvdevBatchTests, OneWritePerReport) {
+  pipe_t fake_uinput;
+
+  ASSERT_EQ(write_batched(fake_uinput.fds[1], gamepad_report), 1);
+
+  auto events = fake_uinput.drain();
+  ASSERT_EQ(events.size(), gamepad_report.size());
+  for (std::size_t x = 0; x < events.size(); ++x) {
+    EXPECT_EQ(events[x].type, gamepad_report[x].type);
+    EXPECT_EQ(events[x].code, gamepad_report[x].code);
+    EXPECT_EQ(events[x].value, gamepad_report[x].value);
+    EXPECT_EQ(events[x].time.tv_sec, 0);
+    EXPECT_EQ(events[x].time.tv_usec, 0);
+  }
+}
+
+TEST(EvdevBatchTests, FlushesAtEachReport) {
+  pipe_t fake_uinput;
+  platf::evdev::batch_t batch { fake_uinput.fds[1] };
+
+  batch.write(EV_REL, REL_X, 1);
+  batch.write(EV_SYN, SYN_REPORT, 0);
+  ASSERT_EQ(batch.writes(), 1);
+  ASSERT_EQ(fake_uinput.drain().size(), 2);
+
+  // Events of an unterminated report stay pending until flushed
+  batch.write(EV_REL, REL_Y, 1);
+  ASSERT_EQ(fake_uinput.drain().size(), 0);
+  batch.flush();
+  ASSERT_EQ(fake_uinput.drain().size(), 1);
+}
+
+TEST(EvdevBatchTests, FlushesWhenFull) {
+  pipe_t fake_uinput;
+  platf::evdev::batch_t batch { fake_uinput.fds[1] };
+
+  for (std::size_t x = 0; x < platf::evdev::batch_t::max_events + 1; ++x) {
+    batch.write(EV_ABS, ABS_MT_SLOT, x);
+  }
+  ASSERT_EQ(batch.writes(), 1);
+
+  batch.write(EV_SYN, SYN_REPORT, 0);
+  ASSERT_EQ(batch.writes(), 2);
+
+  auto events = fake_uinput.drain();
+  ASSERT_EQ(events.size(), platf::evdev::batch_t::max_events + 2);
+  for (std::size_t x = 0; x <= platf::evdev::batch_t::max_events; ++x) {
+    ASSERT_EQ(events[x].value, x);
+  }
+}
+
+TEST(EvdevBatchTests, DISABLED_SyscallBenchmark) {
+  constexpr int reports = 10000;
+  pipe_t fake_uinput;
+
+  std::size_t unbatched_writes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int x = 0; x < reports; ++x) {
+    unbatched_writes += write_unbatched(fake_uinput.fds[1], gamepad_report);
+    fake_uinput.drain();
+  }
+  auto unbatched_time = std::chrono::steady_clock::now() - start;
+
+  std::size_t batched_writes = 0;
+  start = std::chrono::steady_clock::now();
+  for (int x = 0; x < reports; ++x) {
+    batched_writes += write_batched(fake_uinput.fds[1], gamepad_report);
+    fake_uinput.drain();
+  }
+  auto batched_time = std::chrono::steady_clock::now() - start;
+
+  ASSERT_EQ(unbatched_writes, reports * gamepad_report.size());
+  ASSERT_EQ(batched_writes, reports);
+
+  BOOST_LOG(tests) << "SyscallBenchmark:: "sv << reports << " gamepad reports of "sv << gamepad_report.size() << " events"sv;
+  BOOST_LOG(tests) << "SyscallBenchmark:: per event:  "sv << (double) unbatched_writes / reports << " writes/report, "sv
+                   << std::chrono::duration_cast<std::chrono::microseconds>(unbatched_time).count() << "us"sv;
+  BOOST_LOG(tests) << "SyscallBenchmark:: per report: "sv << (double) batched_writes / reports << " writes/report, "sv
+                   << std::chrono::duration_cast<std::chrono::microseconds>(batched_time).count() << "us"sv;
+}
+#endif
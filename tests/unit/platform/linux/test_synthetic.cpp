@@ -0,0 +1,119 @@
+/**
+ * @file tests/unit/platform/linux/test_synthetic.cpp
+ * @brief Test src/platform/linux/synthetic.*.
+ */
+#ifdef __linux__
+  #include <src/platform/linux/synthetic.h>
+
+  #include <algorithm>
+  #include <filesystem>
+  #include <fstream>
+  #include <vector>
+
+  #include "../../../tests_common.h"
+
+using namespace platf::synthetic;
+
+namespace {
+  constexpr int width = 64;
+  constexpr int height = 40;
+
+  std::vector<std::uint8_t>
+  draw(generator_t &generator, std::uint64_t frame, int row_pitch = width * 4) {
+    std::vector<std::uint8_t> data((std::size_t) row_pitch * height);
+    EXPECT_EQ(generator.draw(data.data(), row_pitch, frame), 0);
+
+    return data;
+  }
+}  // namespace
+
+TEST(SyntheticTest, PatternFromView) {
+  ASSERT_EQ(pattern_from_view("static"), pattern_e::static_image);
+  ASSERT_EQ(pattern_from_view("scroll"), pattern_e::scroll);
+  ASSERT_EQ(pattern_from_view("noise"), pattern_e::noise);
+  ASSERT_EQ(pattern_from_view("file"), pattern_e::file);
+  ASSERT_FALSE(pattern_from_view("x11"));
+}
+
+TEST(SyntheticTest, StaticNeverChanges) {
+  auto generator = make_generator(pattern_e::static_image, width, height, {});
+  ASSERT_TRUE(generator);
+
+  auto first = draw(*generator, 0);
+  ASSERT_EQ(draw(*generator, 1), first);
+  ASSERT_EQ(draw(*generator, 1000), first);
+}
+
+TEST(SyntheticTest, ScrollMovesUp) {
+  auto generator = make_generator(pattern_e::scroll, width, height, {});
+  ASSERT_TRUE(generator);
+
+  auto first = draw(*generator, 0);
+  auto second = draw(*generator, 1);
+  ASSERT_NE(first, second);
+
+  // Every row of the second frame was lower in the first one
+  constexpr auto row_size = width * 4;
+  auto scrolled = height - 4;
+  ASSERT_TRUE(std::equal(second.begin(), second.begin() + scrolled * row_size, first.begin() + 4 * row_size));
+}
+
+TEST(SyntheticTest, NoiseIsRepeatable) {
+  auto generator = make_generator(pattern_e::noise, width, height, {});
+  ASSERT_TRUE(generator);
+
+  auto first = draw(*generator, 7);
+  ASSERT_NE(draw(*generator, 8), first);
+  ASSERT_EQ(draw(*generator, 7), first);
+}
+
+TEST(SyntheticTest, HonorsRowPitch) {
+  constexpr auto row_pitch = width * 4 + 32;
+  auto generator = make_generator(pattern_e::static_image, width, height, {});
+  ASSERT_TRUE(generator);
+
+  auto packed = draw(*generator, 0);
+  auto padded = draw(*generator, 0, row_pitch);
+  for (int y = 0; y < height; ++y) {
+    ASSERT_TRUE(std::equal(packed.begin() + y * width * 4, packed.begin() + (y + 1) * width * 4, padded.begin() + y * row_pitch));
+  }
+}
+
+TEST(SyntheticTest, FileLoops) {
+  constexpr auto frame_size = width * height * 4;
+  auto path = std::filesystem::temp_directory_path() / "sunshine_test_synthetic.bgr0";
+
+  {
+    std::ofstream file { path, std::ios::binary };
+    for (char x = 1; x <= 3; ++x) {
+      std::vector<char> frame(frame_size, x);
+      file.write(frame.data(), frame.size());
+    }
+  }
+
+  auto generator = make_generator(pattern_e::file, width, height, path.string());
+  ASSERT_TRUE(generator);
+
+  ASSERT_EQ(draw(*generator, 0), std::vector<std::uint8_t>(frame_size, 1));
+  ASSERT_EQ(draw(*generator, 2), std::vector<std::uint8_t>(frame_size, 3));
+  ASSERT_EQ(draw(*generator, 4), std::vector<std::uint8_t>(frame_size, 2));
+
+  generator.reset();
+  std::filesystem::remove(path);
+}
+
+TEST(SyntheticTest, FileMustHoldWholeFrames) {
+  auto path = std::filesystem::temp_directory_path() / "sunshine_test_synthetic_partial.bgr0";
+
+  {
+    std::ofstream file { path, std::ios::binary };
+    std::vector<char> frame(width * height * 4 + 1);
+    file.write(frame.data(), frame.size());
+  }
+
+  ASSERT_FALSE(make_generator(pattern_e::file, width, height, path.string()));
+  ASSERT_FALSE(make_generator(pattern_e::file, width, height, path.string() + ".missing"));
+
+  std::filesystem::remove(path);
+}
+#endif
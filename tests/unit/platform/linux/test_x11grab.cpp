@@ -0,0 +1,148 @@
+/**
+ * @file tests/unit/platform/linux/test_x11grab.cpp
+ * @brief Test src/platform/linux/x11grab.cpp.
+ * @note Needs an X server, e.g. `xvfb-run -s "-screen 0 1920x1080x24" ./test_sunshine --gtest_filter=X11GrabTest.*`
+ */
+#if defined(__linux__) && defined(SUNSHINE_BUILD_X11)
+  #include <src/platform/common.h>
+  #include <src/video.h>
+
+  #include <X11/Xlib.h>
+
+  #include <ctime>
+
+  #include "../../../tests_common.h"
+
+namespace platf {
+  std::shared_ptr<display_t>
+  x11_display(mem_type_e hwdevice_type, const std::string &display_name, const video::config_t &config);
+}
+
+namespace {
+  enum class content_e {
+    static_content,  ///< Nothing changes
+    partial,  ///< A small square changes every frame
+    full,  ///< The whole screen changes every frame
+  };
+
+  std::chrono::nanoseconds
+  cpu_time() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return std::chrono::seconds { ts.tv_sec } + std::chrono::nanoseconds { ts.tv_nsec };
+  }
+}  // namespace
+
+struct X11GrabTest: testing::TestWithParam<content_e> {
+  void
+  SetUp() override {
+    if (!std::getenv("DISPLAY")) {
+      GTEST_SKIP() << "No X server, run under Xvfb";
+    }
+
+    xdisplay = XOpenDisplay(nullptr);
+    if (!xdisplay) {
+      GTEST_SKIP() << "Couldn't open the X display";
+    }
+
+    root = DefaultRootWindow(xdisplay);
+    gc = XCreateGC(xdisplay, root, 0, nullptr);
+  }
+
+  void
+  TearDown() override {
+    if (xdisplay) {
+      XFreeGC(xdisplay, gc);
+      XCloseDisplay(xdisplay);
+    }
+  }
+
+  void
+  draw(content_e content, int frame, int width, int height) {
+    XSetForeground(xdisplay, gc, frame % 2 ? 0xFF0000 : 0x0000FF);
+
+    switch (content) {
+      case content_e::static_content:
+        return;
+      case content_e::partial:
+        XFillRectangle(xdisplay, root, gc, 64, 64, 128, 128);
+        break;
+      case content_e::full:
+        XFillRectangle(xdisplay, root, gc, 0, 0, width, height);
+        break;
+    }
+
+    XSync(xdisplay, False);
+  }
+
+  Display *xdisplay {};
+  Window root {};
+  GC gc {};
+};
+
+INSTANTIATE_TEST_SUITE_P(
+  X11Grab,
+  X11GrabTest,
+  testing::Values(content_e::static_content, content_e::partial, content_e::full));
+
+TEST_P(X11GrabTest, CpuPerFrame) {
+  constexpr int frames = 120;
+  auto content = GetParam();
+
+  video::config_t config {};
+  config.width = 1920;
+  config.height = 1080;
+  config.framerate = 120;
+
+  auto disp = platf::x11_display(platf::mem_type_e::system, "", config);
+  ASSERT_TRUE(disp);
+
+  std::vector<std::shared_ptr<platf::img_t>> pool;
+  for (int x = 0; x < 4; ++x) {
+    pool.emplace_back(disp->alloc_img());
+  }
+
+  int iterations = 0;
+  int captured = 0;
+  std::size_t damaged_pixels = 0;
+  std::size_t next_img = 0;
+
+  auto pull_free_image_cb = [&](std::shared_ptr<platf::img_t> &img_out) {
+    img_out = pool[next_img++ % pool.size()];
+    return true;
+  };
+
+  auto push_captured_image_cb = [&](std::shared_ptr<platf::img_t> &&img, bool frame_captured) {
+    if (frame_captured) {
+      ++captured;
+      for (auto &rect : img->damage) {
+        damaged_pixels += rect.width * rect.height;
+      }
+      if (img->damage.empty()) {
+        damaged_pixels += img->width * img->height;
+      }
+    }
+
+    draw(content, iterations, disp->env_width, disp->env_height);
+    return ++iterations < frames;
+  };
+
+  // The first frame is always captured in full
+  bool cursor = false;
+  auto start_cpu = cpu_time();
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(disp->capture(push_captured_image_cb, pull_free_image_cb, &cursor), platf::capture_e::ok);
+  auto cpu = cpu_time() - start_cpu;
+  auto wall = std::chrono::steady_clock::now() - start;
+
+  BOOST_LOG(tests) << "X11Grab::CpuPerFrame ["sv << (int) content << "]: "sv << captured << '/' << iterations << " frames captured, "sv
+                   << std::chrono::duration_cast<std::chrono::microseconds>(cpu).count() / iterations << "us CPU per frame, "sv
+                   << std::chrono::duration_cast<std::chrono::microseconds>(wall).count() / iterations << "us wall per frame, "sv
+                   << damaged_pixels / std::max(captured, 1) << " damaged pixels per captured frame"sv;
+
+  ASSERT_GE(captured, 1);
+  if (content == content_e::full) {
+    ASSERT_GT(captured, frames / 2);
+  }
+}
+#endif
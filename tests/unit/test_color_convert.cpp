@@ -0,0 +1,281 @@
+/**
+ * @file tests/unit/test_color_convert.cpp
+ * @brief Test src/color_convert.*.
+ */
+#include <src/color_convert.h>
+#include <src/video.h>
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
+
+#include "../tests_common.h"
+
+namespace {
+  constexpr video::sunshine_colorspace_t rec709_limited { video::colorspace_e::rec709, false, 8 };
+
+  std::vector<std::uint8_t>
+  random_pixels(std::size_t count, std::uint32_t seed) {
+    std::mt19937 rng { seed };
+    std::uniform_int_distribution<int> byte { 0, 255 };
+
+    std::vector<std::uint8_t> pixels(count * 4);
+    for (auto &x : pixels) {
+      x = (std::uint8_t) byte(rng);
+    }
+
+    return pixels;
+  }
+
+  /**
+   * @brief BGR0 gradients, smooth enough that chroma siting and filtering barely matter.
+   */
+  std::vector<std::uint8_t>
+  gradient(int width, int height) {
+    std::vector<std::uint8_t> pixels((std::size_t) width * height * 4);
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        auto p = &pixels[((std::size_t) y * width + x) * 4];
+        p[0] = (std::uint8_t) (x * 255 / (width - 1));
+        p[1] = (std::uint8_t) (y * 255 / (height - 1));
+        p[2] = (std::uint8_t) (255 - (x + y) * 255 / (width + height - 2));
+        p[3] = 0;
+      }
+    }
+
+    return pixels;
+  }
+
+  struct frame_t {
+    frame_t(AVPixelFormat format, int width, int height) {
+      size = av_image_alloc(data.data(), pitch.data(), width, height, format, 64);
+
+      // So the padding compares equal
+      std::memset(data[0], 0, size);
+    }
+
+    ~frame_t() {
+      av_freep(data.data());
+    }
+
+    std::array<std::uint8_t *, 4> data {};
+    std::array<int, 4> pitch {};
+    int size;
+  };
+
+  video::sws_t
+  make_sws(AVPixelFormat format, const video::sunshine_colorspace_t &colorspace, int width, int height) {
+    video::sws_t sws { sws_getContext(width, height, AV_PIX_FMT_BGR0, width, height, format, SWS_LANCZOS | SWS_ACCURATE_RND, nullptr, nullptr, nullptr) };
+    if (!sws) {
+      return nullptr;
+    }
+
+    // The same setup as the software encode device
+    auto avcodec_colorspace = video::avcodec_colorspace_from_sunshine_colorspace(colorspace);
+    sws_setColorspaceDetails(sws.get(),
+      sws_getCoefficients(SWS_CS_DEFAULT), 0,
+      sws_getCoefficients(avcodec_colorspace.software_format), avcodec_colorspace.range - 1,
+      0, 1 << 16, 1 << 16);
+
+    return sws;
+  }
+
+  void
+  sws_convert(SwsContext *sws, const std::vector<std::uint8_t> &src, int width, int height, frame_t &dst) {
+    const std::uint8_t *src_data[] { src.data() };
+    const int src_pitch[] { width * 4 };
+    sws_scale(sws, src_data, src_pitch, 0, height, dst.data.data(), dst.pitch.data());
+  }
+}  // namespace
+
+TEST(ColorConvertTest, Coefficients) {
+  auto k = color_convert::coefficients(rec709_limited);
+
+  std::uint16_t y, u, v;
+  const std::uint8_t white[] { 255, 255, 255, 0 };
+  const std::uint8_t black[] { 0, 0, 0, 0 };
+
+  color_convert::scalar_kernels.luma(k, white, 1, &y);
+  ASSERT_EQ(y, 235);
+  color_convert::scalar_kernels.luma(k, black, 1, &y);
+  ASSERT_EQ(y, 16);
+
+  color_convert::scalar_kernels.chroma444(k, white, 1, &u, &v);
+  ASSERT_EQ(u, 128);
+  ASSERT_EQ(v, 128);
+
+  auto k10 = color_convert::coefficients({ video::colorspace_e::bt2020, true, 10 });
+  color_convert::scalar_kernels.luma(k10, white, 1, &y);
+  ASSERT_EQ(y, 1023);
+  color_convert::scalar_kernels.chroma420(k10, black, black, 1, &u, &v);
+  ASSERT_EQ(u, 512);
+  ASSERT_EQ(v, 512);
+}
+
+TEST(ColorConvertTest, MatchesFloatingPoint) {
+  constexpr int width = 67;
+  auto row0 = random_pixels(width, 1);
+  auto row1 = random_pixels(width, 2);
+
+  auto colorspace = video::sunshine_colorspace_t { video::colorspace_e::rec601, false, 8 };
+  auto k = color_convert::coefficients(colorspace);
+  auto vectors = video::color_vectors_from_colorspace(colorspace, false);
+
+  auto apply = [](const float (&vec)[4], double b, double g, double r) {
+    return std::floor(vec[0] * r / 255 + vec[1] * g / 255 + vec[2] * b / 255 + vec[3]);
+  };
+
+  std::array<std::uint16_t, width> y, u, v;
+  color_convert::scalar_kernels.luma(k, row0.data(), width, y.data());
+  color_convert::scalar_kernels.chroma420(k, row0.data(), row1.data(), width, u.data(), v.data());
+
+  for (int x = 0; x < width; ++x) {
+    auto p = &row0[x * 4];
+    ASSERT_NEAR(y[x], apply(vectors->color_vec_y, p[0], p[1], p[2]), 1) << "pixel " << x;
+  }
+
+  for (int x = 0; x < width; x += 2) {
+    auto next = std::min(x + 1, width - 1);
+    double bgr[3];
+    for (int c = 0; c < 3; ++c) {
+      bgr[c] = (row0[x * 4 + c] + row0[next * 4 + c] + row1[x * 4 + c] + row1[next * 4 + c]) / 4.0;
+    }
+
+    ASSERT_NEAR(u[x / 2], apply(vectors->color_vec_u, bgr[0], bgr[1], bgr[2]), 1) << "pixel " << x;
+    ASSERT_NEAR(v[x / 2], apply(vectors->color_vec_v, bgr[0], bgr[1], bgr[2]), 1) << "pixel " << x;
+  }
+}
+
+#ifdef SUNSHINE_COLOR_CONVERT_X86
+TEST(ColorConvertTest, Avx2MatchesScalar) {
+  if (!__builtin_cpu_supports("avx2")) {
+    GTEST_SKIP() << "AVX2 not supported by this CPU";
+  }
+
+  auto &scalar = color_convert::scalar_kernels;
+  auto &avx2 = color_convert::avx2_kernels;
+
+  for (auto colorspace : { rec709_limited, video::sunshine_colorspace_t { video::colorspace_e::bt2020, true, 10 } }) {
+    auto k = color_convert::coefficients(colorspace);
+
+    // Every tail length, on both sides of the vector width
+    for (int width = 1; width <= 67; ++width) {
+      auto row0 = random_pixels(width, width);
+      auto row1 = random_pixels(width, width + 1000);
+
+      std::vector<std::uint16_t> expected(width * 2), actual(width * 2);
+      std::vector<std::uint16_t> expected_v(width), actual_v(width);
+
+      scalar.luma(k, row0.data(), width, expected.data());
+      avx2.luma(k, row0.data(), width, actual.data());
+      ASSERT_EQ(std::vector(actual.begin(), actual.begin() + width), std::vector(expected.begin(), expected.begin() + width)) << "luma, width " << width;
+
+      scalar.chroma444(k, row0.data(), width, expected.data(), expected_v.data());
+      avx2.chroma444(k, row0.data(), width, actual.data(), actual_v.data());
+      ASSERT_EQ(std::vector(actual.begin(), actual.begin() + width), std::vector(expected.begin(), expected.begin() + width)) << "chroma444, width " << width;
+      ASSERT_EQ(actual_v, expected_v) << "chroma444, width " << width;
+
+      auto chroma_width = (width + 1) / 2;
+      scalar.chroma420(k, row0.data(), row1.data(), width, expected.data(), expected_v.data());
+      avx2.chroma420(k, row0.data(), row1.data(), width, actual.data(), actual_v.data());
+      ASSERT_EQ(std::vector(actual.begin(), actual.begin() + chroma_width), std::vector(expected.begin(), expected.begin() + chroma_width)) << "chroma420, width " << width;
+      ASSERT_EQ(std::vector(actual_v.begin(), actual_v.begin() + chroma_width), std::vector(expected_v.begin(), expected_v.begin() + chroma_width)) << "chroma420, width " << width;
+    }
+  }
+}
+#endif
+
+TEST(ColorConvertTest, ThreadsDontChangeTheResult) {
+  constexpr int width = 99;
+  constexpr int height = 37;
+  auto src = random_pixels(width * height, 3);
+
+  for (auto format : { AV_PIX_FMT_NV12, AV_PIX_FMT_P010, AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P10, AV_PIX_FMT_YUV444P, AV_PIX_FMT_YUV444P10 }) {
+    ASSERT_TRUE(color_convert::converter_t::supported(format));
+
+    frame_t single { format, width, height };
+    frame_t threaded { format, width, height };
+
+    color_convert::converter_t { format, rec709_limited, width, height, 1 }.convert(src.data(), width * 4, single.data.data(), single.pitch.data());
+    color_convert::converter_t { format, rec709_limited, width, height, 4 }.convert(src.data(), width * 4, threaded.data.data(), threaded.pitch.data());
+
+    ASSERT_EQ(std::memcmp(single.data[0], threaded.data[0], single.size), 0) << av_get_pix_fmt_name(format);
+  }
+
+  ASSERT_FALSE(color_convert::converter_t::supported(AV_PIX_FMT_RGB24));
+}
+
+TEST(ColorConvertTest, CloseToSwscale) {
+  constexpr int width = 256;
+  constexpr int height = 128;
+  auto src = gradient(width, height);
+
+  for (auto format : { AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV444P }) {
+    frame_t expected { format, width, height };
+    frame_t actual { format, width, height };
+
+    auto sws = make_sws(format, rec709_limited, width, height);
+    ASSERT_TRUE(sws);
+    sws_convert(sws.get(), src, width, height, expected);
+    color_convert::converter_t { format, rec709_limited, width, height, 2 }.convert(src.data(), width * 4, actual.data.data(), actual.pitch.data());
+
+    auto chroma_shift = format == AV_PIX_FMT_YUV420P ? 1 : 0;
+    for (int plane = 0; plane < 3; ++plane) {
+      auto plane_width = plane ? width >> chroma_shift : width;
+      auto plane_height = plane ? height >> chroma_shift : height;
+
+      double total_error = 0;
+      for (int y = 0; y < plane_height; ++y) {
+        for (int x = 0; x < plane_width; ++x) {
+          int a = actual.data[plane][y * actual.pitch[plane] + x];
+          int e = expected.data[plane][y * expected.pitch[plane] + x];
+
+          ASSERT_LE(std::abs(a - e), plane ? 3 : 2) << av_get_pix_fmt_name(format) << " plane " << plane << " at " << x << 'x' << y;
+          total_error += std::abs(a - e);
+        }
+      }
+
+      ASSERT_LT(total_error / (plane_width * plane_height), 1.0) << av_get_pix_fmt_name(format) << " plane " << plane;
+    }
+  }
+}
+
+TEST(ColorConvertTest, DISABLED_Benchmark) {
+  constexpr int frames = 10;
+  const std::array<std::pair<int, int>, 3> resolutions { { { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 } } };
+
+  BOOST_LOG(tests) << "Benchmark:: kernels: "sv << color_convert::init();
+
+  for (auto [width, height] : resolutions) {
+    auto src = random_pixels((std::size_t) width * height, 4);
+    frame_t dst { AV_PIX_FMT_NV12, width, height };
+
+    auto time = [&](auto &&convert) {
+      convert();
+
+      auto start = std::chrono::steady_clock::now();
+      for (int x = 0; x < frames; ++x) {
+        convert();
+      }
+
+      return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / frames;
+    };
+
+    color_convert::converter_t single { AV_PIX_FMT_NV12, rec709_limited, width, height, 1 };
+    color_convert::converter_t threaded { AV_PIX_FMT_NV12, rec709_limited, width, height, 4 };
+    auto sws = make_sws(AV_PIX_FMT_NV12, rec709_limited, width, height);
+    ASSERT_TRUE(sws);
+
+    auto single_us = time([&]() { single.convert(src.data(), width * 4, dst.data.data(), dst.pitch.data()); });
+    auto threaded_us = time([&]() { threaded.convert(src.data(), width * 4, dst.data.data(), dst.pitch.data()); });
+    auto sws_us = time([&]() { sws_convert(sws.get(), src, width, height, dst); });
+
+    BOOST_LOG(tests) << "Benchmark:: "sv << width << 'x' << height << " BGR0 to NV12: "sv
+                     << single_us << "us (1 thread), "sv << threaded_us << "us (4 threads), swscale "sv << sws_us << "us"sv;
+  }
+}
@@ -0,0 +1,154 @@
+/**
+ * @file tests/unit/test_cursor_blend.cpp
+ * @brief Test src/cursor_blend.*.
+ */
+#include <src/cursor_blend.h>
+#include <src/platform/common.h>
+
+#include <random>
+
+#include "../tests_common.h"
+
+namespace {
+  struct kernel_t {
+    const char *name;
+    cursor_blend::blend_row_t blend_row;
+    bool supported;
+  };
+
+  std::vector<kernel_t>
+  kernels() {
+    return {
+#ifdef SUNSHINE_CURSOR_BLEND_X86
+      { "sse2", cursor_blend::blend_row_sse2, true },
+      { "avx2", cursor_blend::blend_row_avx2, (bool) __builtin_cpu_supports("avx2") },
+#endif
+    };
+  }
+
+  std::vector<std::uint32_t>
+  random_pixels(std::size_t count, std::uint32_t seed) {
+    std::mt19937 gen { seed };
+    std::vector<std::uint32_t> pixels(count);
+    for (auto &pixel : pixels) {
+      pixel = gen();
+    }
+
+    return pixels;
+  }
+
+  void
+  expect_bit_exact(const kernel_t &kernel, const std::vector<std::uint32_t> &src, const std::vector<std::uint32_t> &dst) {
+    auto expected = dst;
+    auto actual = dst;
+    cursor_blend::blend_row_scalar(expected.data(), src.data(), src.size());
+    kernel.blend_row(actual.data(), src.data(), src.size());
+
+    for (std::size_t x = 0; x < src.size(); ++x) {
+      ASSERT_EQ(actual[x], expected[x]) << kernel.name << ": pixel " << x << " src " << std::hex << src[x] << " dst " << dst[x];
+    }
+  }
+}  // namespace
+
+TEST(CursorBlendTests, InitSelectsKernel) {
+  ASSERT_NE(cursor_blend::init(), nullptr);
+  ASSERT_NE(cursor_blend::blend_row, nullptr);
+}
+
+TEST(CursorBlendTests, ScalarReference) {
+  std::uint32_t dst[] { 0x80FF8000, 0x80FF8000, 0x80FF8000, 0x80FF8000 };
+  std::uint32_t src[] { 0xFF102030, 0x00000000, 0x80404040, 0x00101010 };
+  cursor_blend::blend_row_scalar(dst, src, 4);
+
+  // Opaque: replaced, alpha byte included
+  ASSERT_EQ(dst[0], 0xFF102030);
+  // Transparent: untouched
+  ASSERT_EQ(dst[1], 0x80FF8000);
+  // Half transparent: (255 * 127 + 127) / 255 = 127, (128 * 127 + 127) / 255 = 64, alpha byte untouched
+  ASSERT_EQ(dst[2], 0x80BF8040);
+  // Additive: premultiplied color on a fully transparent pixel wraps around
+  ASSERT_EQ(dst[3], 0x800F9010);
+}
+
+TEST(CursorBlendTests, BitExactForAllAlphaAndColors) {
+  // Every combination of cursor alpha and destination channel value, in every channel
+  std::vector<std::uint32_t> src;
+  std::vector<std::uint32_t> dst;
+  for (std::uint32_t alpha = 0; alpha < 256; ++alpha) {
+    for (std::uint32_t color = 0; color < 256; ++color) {
+      auto premultiplied = (color * alpha / 255) * 0x010101;
+      src.emplace_back(alpha << 24 | premultiplied);
+      dst.emplace_back(color * 0x01010101);
+    }
+  }
+
+  for (auto &kernel : kernels()) {
+    if (!kernel.supported) {
+      continue;
+    }
+
+    expect_bit_exact(kernel, src, dst);
+  }
+}
+
+TEST(CursorBlendTests, BitExactForRandomPixels) {
+  for (auto &kernel : kernels()) {
+    if (!kernel.supported) {
+      continue;
+    }
+
+    // Odd lengths exercise the tails of the vector loops
+    for (std::size_t count : { 1, 3, 7, 8, 15, 33, 64, 1021 }) {
+      auto src = random_pixels(count, count);
+      auto dst = random_pixels(count, count + 1);
+
+      // Cursor images are mostly transparent or opaque
+      for (std::size_t x = 0; x < count; x += 3) {
+        src[x] = x % 2 ? 0 : src[x] | 0xFF000000;
+      }
+
+      expect_bit_exact(kernel, src, dst);
+    }
+  }
+}
+
+TEST(CursorBlendTests, BlendClipsToImage) {
+  constexpr int width = 16;
+  constexpr int height = 8;
+  constexpr int row_pitch = (width + 4) * 4;
+
+  std::vector<std::uint8_t> data(row_pitch * height, 0x00);
+  platf::img_t img;
+  img.data = data.data();
+  img.width = width;
+  img.height = height;
+  img.pixel_pitch = 4;
+  img.row_pitch = row_pitch;
+
+  // A 4x4 opaque cursor with a distinct value per pixel, half off the top-left corner
+  std::vector<std::uint32_t> cursor(16);
+  for (std::uint32_t x = 0; x < cursor.size(); ++x) {
+    cursor[x] = 0xFF000000 | x;
+  }
+  cursor_blend::blend(img, cursor.data(), -2, -2, 4, 4);
+
+  auto pixel = [&](int x, int y) {
+    return *(std::uint32_t *) (data.data() + y * row_pitch + x * 4);
+  };
+  ASSERT_EQ(pixel(0, 0), 0xFF00000A);
+  ASSERT_EQ(pixel(1, 0), 0xFF00000B);
+  ASSERT_EQ(pixel(0, 1), 0xFF00000E);
+  ASSERT_EQ(pixel(1, 1), 0xFF00000F);
+  ASSERT_EQ(pixel(2, 0), 0u);
+  ASSERT_EQ(pixel(0, 2), 0u);
+
+  // Entirely outside of the image
+  cursor_blend::blend(img, cursor.data(), width, 0, 4, 4);
+  cursor_blend::blend(img, cursor.data(), 0, -4, 4, 4);
+  ASSERT_EQ(std::count(std::begin(data), std::end(data), 0xFF), 4);
+
+  // Past the bottom-right corner, the padding at the end of the rows is left alone
+  cursor_blend::blend(img, cursor.data(), width - 1, height - 1, 4, 4);
+  ASSERT_EQ(pixel(width - 1, height - 1), 0xFF000000);
+  ASSERT_EQ(pixel(width, height - 1), 0u);
+}
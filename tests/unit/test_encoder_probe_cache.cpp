@@ -0,0 +1,79 @@
+/**
+ * @file tests/unit/test_encoder_probe_cache.cpp
+ * @brief Test src/encoder_probe_cache.*.
+ */
+#include <src/encoder_probe_cache.h>
+#include <src/video.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+#include "../tests_common.h"
+
+using namespace std::literals;
+
+namespace {
+  const video::probe_result_t result { "nvenc", 0x1ff, 0x0ff, 0, 3, 1 };
+
+  struct EncoderProbeCacheTest: testing::Test {
+    void
+    SetUp() override {
+      path = (std::filesystem::temp_directory_path() / "sunshine_test_encoder_probe.json").string();
+      std::filesystem::remove(path);
+    }
+
+    void
+    TearDown() override {
+      std::filesystem::remove(path);
+    }
+
+    std::string path;
+  };
+}  // namespace
+
+TEST_F(EncoderProbeCacheTest, RoundTrip) {
+  ASSERT_TRUE(video::save_probe_result(path, "key", result));
+
+  auto loaded = video::load_probe_result(path, "key");
+  ASSERT_TRUE(loaded);
+  ASSERT_EQ(*loaded, result);
+}
+
+TEST_F(EncoderProbeCacheTest, OtherKeyIsIgnored) {
+  ASSERT_TRUE(video::save_probe_result(path, "driver 1.0", result));
+  ASSERT_FALSE(video::load_probe_result(path, "driver 1.1"));
+}
+
+TEST_F(EncoderProbeCacheTest, MissingFileIsIgnored) {
+  ASSERT_FALSE(video::load_probe_result(path, "key"));
+}
+
+TEST_F(EncoderProbeCacheTest, CorruptFileIsIgnored) {
+  std::ofstream { path } << R"({ "root": { "key": "key", "encoder": )";
+  ASSERT_FALSE(video::load_probe_result(path, "key"));
+}
+
+struct EncoderProbeCacheBenchmark: PlatformTestSuite {};
+
+TEST_F(EncoderProbeCacheBenchmark, DISABLED_Startup) {
+  auto path = (std::filesystem::temp_directory_path() / "sunshine_bench_encoder_probe.json").string();
+  auto fg = util::fail_guard([&]() {
+    std::filesystem::remove(path);
+  });
+
+  // Without the cache, startup validates the encoder, the software one being the cheapest to validate
+  auto start = std::chrono::steady_clock::now();
+  if (!video::validate_encoder(video::software, false)) {
+    FAIL() << "Software encoder not available";
+  }
+  auto probe_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+  ASSERT_TRUE(video::save_probe_result(path, "key", { video::software.name, video::software.h264.capabilities.to_ulong(), video::software.hevc.capabilities.to_ulong(), video::software.av1.capabilities.to_ulong(), 2, 2 }));
+
+  start = std::chrono::steady_clock::now();
+  ASSERT_TRUE(video::load_probe_result(path, "key"));
+  auto cached_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+  BOOST_LOG(tests) << "Benchmark:: encoder probe: "sv << probe_us << "us validating, "sv << cached_us << "us from the cache"sv;
+}
@@ -0,0 +1,352 @@
+/**
+ * @file tests/unit/test_frame_ring.cpp
+ * @brief Test src/frame_ring.*.
+ */
+#include <src/color_convert.h>
+#include <src/frame_ring.h>
+#include <src/platform/common.h>
+#include <src/thread_safe.h>
+#include <src/video.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../tests_common.h"
+
+using namespace std::literals;
+using video::frame_ring_t;
+
+TEST(FrameRingTest, NeverHandsOutTakenSlots) {
+  frame_ring_t ring;
+  ASSERT_EQ(ring.held(), 0);
+
+  std::mt19937 rng { 1 };
+  for (int x = 0; x < 1000; ++x) {
+    auto slot = ring.acquire();
+    ASSERT_GE(slot, 0);
+    ASSERT_LT(slot, frame_ring_t::slots);
+    ASSERT_NE(slot, ring.held());
+
+    ring.publish(slot, std::nullopt);
+
+    // The encoder doesn't keep up every time
+    if (rng() & 1) {
+      auto entry = ring.take(0ms);
+      ASSERT_TRUE(entry);
+      ASSERT_EQ(entry->slot, slot);
+      ASSERT_EQ(ring.held(), slot);
+    }
+  }
+}
+
+TEST(FrameRingTest, LatestWins) {
+  frame_ring_t ring;
+  auto now = std::chrono::steady_clock::now();
+
+  auto first = ring.acquire();
+  ring.publish(first, now);
+  ASSERT_TRUE(ring.ready());
+
+  auto second = ring.acquire();
+  ASSERT_NE(second, first);
+  ring.publish(second, now + 1ms);
+  ASSERT_EQ(ring.dropped(), 1);
+
+  auto entry = ring.take(0ms);
+  ASSERT_TRUE(entry);
+  ASSERT_EQ(entry->slot, second);
+  ASSERT_EQ(entry->frame_timestamp, now + 1ms);
+  ASSERT_FALSE(ring.ready());
+
+  // Both the dropped slot and the one the encoder held before are free again
+  ASSERT_NE(ring.acquire(), second);
+}
+
+TEST(FrameRingTest, TakeTimesOut) {
+  frame_ring_t ring;
+
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_FALSE(ring.take(10ms));
+  ASSERT_GE(std::chrono::steady_clock::now() - start, 10ms);
+  ASSERT_EQ(ring.held(), 0);
+}
+
+TEST(FrameRingTest, CloseWakesTake) {
+  frame_ring_t ring;
+
+  std::thread closer { [&ring]() {
+    std::this_thread::sleep_for(10ms);
+    ring.close();
+  } };
+
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_FALSE(ring.take(10s));
+  ASSERT_LT(std::chrono::steady_clock::now() - start, 5s);
+  ASSERT_TRUE(ring.closed());
+
+  closer.join();
+}
+
+TEST(FrameRingTest, HeldSlotIsNeverWritten) {
+  frame_ring_t ring;
+  std::array<std::atomic_int, frame_ring_t::slots> contents {};
+
+  constexpr int frames = 2000;
+  std::thread converter { [&]() {
+    for (int x = 1; x <= frames; ++x) {
+      auto slot = ring.acquire();
+      contents[slot] = x;
+      ring.publish(slot, std::nullopt);
+    }
+
+    ring.close();
+  } };
+
+  int last = 0;
+  int taken = 0;
+  while (auto entry = ring.take(1s)) {
+    auto value = contents[entry->slot].load();
+    ASSERT_GT(value, last);
+    last = value;
+    ++taken;
+
+    // Pretend to encode, the converter keeps going meanwhile
+    std::this_thread::yield();
+    ASSERT_EQ(contents[entry->slot], value);
+  }
+
+  converter.join();
+  ASSERT_EQ(last, frames);
+  ASSERT_EQ(taken + ring.dropped(), frames);
+}
+
+namespace {
+  using clock_type = std::chrono::steady_clock;
+
+  constexpr int width = 2560;
+  constexpr int height = 1440;
+  constexpr int fps = 120;
+  constexpr int frames = 2 * fps;
+
+  struct result_t {
+    int encoded;
+    double fps;
+    double latency_ms;
+    double latency_p99_ms;
+  };
+
+  video::avcodec_ctx_t
+  make_encoder() {
+    auto codec = avcodec_find_encoder_by_name("libx264");
+    if (!codec) {
+      return nullptr;
+    }
+
+    video::avcodec_ctx_t ctx { avcodec_alloc_context3(codec) };
+    ctx->width = width;
+    ctx->height = height;
+    ctx->time_base = AVRational { 1, fps };
+    ctx->framerate = AVRational { fps, 1 };
+    ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+    ctx->max_b_frames = 0;
+    ctx->gop_size = INT_MAX;
+    ctx->keyint_min = INT_MAX;
+    ctx->flags |= AV_CODEC_FLAG_CLOSED_GOP | AV_CODEC_FLAG_LOW_DELAY;
+    ctx->thread_count = 2;
+    ctx->bit_rate = 20'000'000;
+
+    AVDictionary *options { nullptr };
+    av_dict_set(&options, "preset", "superfast", 0);
+    av_dict_set(&options, "tune", "zerolatency", 0);
+    auto status = avcodec_open2(ctx.get(), codec, &options);
+    av_dict_free(&options);
+
+    if (status < 0) {
+      return nullptr;
+    }
+
+    return ctx;
+  }
+
+  video::avcodec_frame_t
+  make_frame() {
+    video::avcodec_frame_t frame { av_frame_alloc() };
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = width;
+    frame->height = height;
+    EXPECT_EQ(av_frame_get_buffer(frame.get(), 0), 0);
+
+    return frame;
+  }
+
+  /**
+   * @brief Moving gradients with some texture, so each frame has something to encode.
+   */
+  std::vector<std::vector<std::uint8_t>>
+  make_images() {
+    std::vector<std::vector<std::uint8_t>> images(8);
+    for (std::size_t i = 0; i < images.size(); ++i) {
+      auto &pixels = images[i];
+      pixels.resize((std::size_t) width * height * 4);
+
+      for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+          auto p = &pixels[((std::size_t) y * width + x) * 4];
+          p[0] = (std::uint8_t) (x + i * 8);
+          p[1] = (std::uint8_t) (y + ((x ^ y) & 15));
+          p[2] = (std::uint8_t) ((x + y) / 4 - i * 8);
+          p[3] = 0;
+        }
+      }
+    }
+
+    return images;
+  }
+
+  /**
+   * @brief Raise the images at the benchmark framerate, like a capture thread does.
+   */
+  std::thread
+  capture(safe::event_t<std::shared_ptr<platf::img_t>> &images, std::vector<std::vector<std::uint8_t>> &pixels) {
+    return std::thread { [&images, &pixels]() {
+      auto start = clock_type::now();
+      for (int x = 0; x < frames; ++x) {
+        std::this_thread::sleep_until(start + x * 1s / fps);
+
+        auto img = std::make_shared<platf::img_t>();
+        img->data = pixels[x % pixels.size()].data();
+        img->width = width;
+        img->height = height;
+        img->pixel_pitch = 4;
+        img->row_pitch = width * 4;
+        img->frame_timestamp = clock_type::now();
+        images.raise(std::move(img));
+      }
+
+      // Let the last image through
+      std::this_thread::sleep_for(1s / fps);
+      images.stop();
+    } };
+  }
+
+  /**
+   * @brief Encode a frame and record the latency of its packet since the image was captured.
+   */
+  void
+  encode(AVCodecContext *ctx, AVFrame *frame, std::int64_t pts, clock_type::time_point captured, std::vector<double> &latencies) {
+    frame->pts = pts;
+    ASSERT_EQ(avcodec_send_frame(ctx, frame), 0);
+
+    auto packet = av_packet_alloc();
+    while (avcodec_receive_packet(ctx, packet) == 0) {
+      if (packet->pts == pts) {
+        latencies.push_back(std::chrono::duration<double, std::milli>(clock_type::now() - captured).count());
+      }
+      av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+  }
+
+  result_t
+  summarize(std::vector<double> &latencies, clock_type::duration elapsed) {
+    std::sort(latencies.begin(), latencies.end());
+
+    return {
+      (int) latencies.size(),
+      latencies.size() / std::chrono::duration<double>(elapsed).count(),
+      std::accumulate(latencies.begin(), latencies.end(), 0.0) / std::max<std::size_t>(latencies.size(), 1),
+      latencies.empty() ? 0.0 : latencies[latencies.size() * 99 / 100],
+    };
+  }
+
+  /**
+   * @brief Convert and encode on the same thread, like encode_run() without the pipeline.
+   */
+  result_t
+  run_serial(std::vector<std::vector<std::uint8_t>> &pixels, color_convert::converter_t &converter) {
+    auto ctx = make_encoder();
+    auto frame = make_frame();
+
+    safe::event_t<std::shared_ptr<platf::img_t>> images;
+    std::vector<double> latencies;
+
+    auto start = clock_type::now();
+    auto capture_thread = capture(images, pixels);
+
+    std::int64_t pts = 0;
+    while (auto img = images.pop()) {
+      converter.convert(img->data, img->row_pitch, frame->data, frame->linesize);
+      encode(ctx.get(), frame.get(), pts++, *img->frame_timestamp, latencies);
+    }
+
+    capture_thread.join();
+    return summarize(latencies, clock_type::now() - start);
+  }
+
+  /**
+   * @brief Convert on another thread into a frame_ring_t, like the software encoder pipeline.
+   */
+  result_t
+  run_pipelined(std::vector<std::vector<std::uint8_t>> &pixels, color_convert::converter_t &converter) {
+    auto ctx = make_encoder();
+    std::array<video::avcodec_frame_t, frame_ring_t::slots> ring_frames;
+    for (auto &frame : ring_frames) {
+      frame = make_frame();
+    }
+
+    safe::event_t<std::shared_ptr<platf::img_t>> images;
+    frame_ring_t ring;
+    std::vector<double> latencies;
+
+    auto start = clock_type::now();
+    auto capture_thread = capture(images, pixels);
+
+    std::thread convert_thread { [&]() {
+      while (auto img = images.pop()) {
+        auto slot = ring.acquire();
+        auto &frame = ring_frames[slot];
+        converter.convert(img->data, img->row_pitch, frame->data, frame->linesize);
+        ring.publish(slot, img->frame_timestamp);
+      }
+
+      ring.close();
+    } };
+
+    std::int64_t pts = 0;
+    while (auto entry = ring.take(1s)) {
+      encode(ctx.get(), ring_frames[entry->slot].get(), pts++, *entry->frame_timestamp, latencies);
+    }
+
+    convert_thread.join();
+    capture_thread.join();
+    return summarize(latencies, clock_type::now() - start);
+  }
+}  // namespace
+
+TEST(FrameRingTest, DISABLED_Benchmark) {
+  if (!make_encoder()) {
+    GTEST_SKIP() << "libx264 not available";
+  }
+
+  color_convert::init();
+  auto pixels = make_images();
+  color_convert::converter_t converter { AV_PIX_FMT_YUV420P, { video::colorspace_e::rec709, false, 8 }, width, height, 1 };
+
+  auto serial = run_serial(pixels, converter);
+  auto pipelined = run_pipelined(pixels, converter);
+
+  for (auto [name, result] : { std::pair { "serial"sv, serial }, std::pair { "pipelined"sv, pipelined } }) {
+    BOOST_LOG(tests) << "Benchmark:: "sv << width << 'x' << height << '@' << fps << " libx264 superfast, "sv << name << ": "sv
+                     << result.encoded << '/' << frames << " frames, "sv << result.fps << " fps, latency "sv
+                     << result.latency_ms << "ms (p99 "sv << result.latency_p99_ms << "ms)"sv;
+  }
+
+  ASSERT_GT(serial.encoded, 0);
+  ASSERT_GT(pipelined.encoded, 0);
+}
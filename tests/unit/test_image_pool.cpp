@@ -0,0 +1,206 @@
+/**
+ * @file tests/unit/test_image_pool.cpp
+ * @brief Test src/image_pool.*.
+ */
+#include <src/image_pool.h>
+#include <src/platform/common.h>
+
+#include <atomic>
+#include <thread>
+
+#include "../tests_common.h"
+
+namespace {
+  struct counted_img_t: platf::img_t {
+    explicit counted_img_t(std::atomic<int> &alive):
+        alive { alive } {
+      ++alive;
+    }
+
+    ~counted_img_t() override {
+      --alive;
+    }
+
+    std::atomic<int> &alive;
+  };
+}  // namespace
+
+struct ImagePoolTest: testing::Test {
+  std::shared_ptr<platf::img_t>
+  acquire(video::image_pool_t &pool) {
+    return pool.acquire(alloc, running);
+  }
+
+  std::atomic<int> alive {};
+  std::atomic<int> allocations {};
+  std::atomic<bool> is_running { true };
+
+  video::image_pool_t::alloc_t alloc = [this]() {
+    ++allocations;
+    return std::make_shared<counted_img_t>(alive);
+  };
+  video::image_pool_t::running_t running = [this]() {
+    return is_running.load();
+  };
+};
+
+TEST_F(ImagePoolTest, ReusesReleasedImages) {
+  video::image_pool_t pool { 4, 1h };
+
+  auto img = acquire(pool);
+  ASSERT_TRUE(img);
+  auto raw = img.get();
+  img.reset();
+
+  ASSERT_EQ(pool.free(), 1);
+  img = acquire(pool);
+  ASSERT_EQ(img.get(), raw);
+  ASSERT_EQ(allocations, 1);
+  ASSERT_EQ(pool.free(), 0);
+}
+
+TEST_F(ImagePoolTest, ReleasedWhenLastCopyDropped) {
+  video::image_pool_t pool { 4, 1h };
+
+  auto img = acquire(pool);
+  auto copy = img;
+  img.reset();
+  ASSERT_EQ(pool.free(), 0);
+
+  copy.reset();
+  ASSERT_EQ(pool.free(), 1);
+}
+
+TEST_F(ImagePoolTest, MostRecentlyReleasedFirst) {
+  video::image_pool_t pool { 4, 1h };
+
+  auto a = acquire(pool);
+  auto b = acquire(pool);
+  auto raw_b = b.get();
+
+  a.reset();
+  b.reset();
+
+  ASSERT_EQ(acquire(pool).get(), raw_b);
+}
+
+TEST_F(ImagePoolTest, WaitsForRelease) {
+  video::image_pool_t pool { 2, 1h };
+
+  auto a = acquire(pool);
+  auto b = acquire(pool);
+  auto raw_a = a.get();
+
+  std::thread releaser { [&a]() {
+    std::this_thread::sleep_for(50ms);
+    a.reset();
+  } };
+
+  auto start = std::chrono::steady_clock::now();
+  auto c = acquire(pool);
+  auto waited = std::chrono::steady_clock::now() - start;
+  releaser.join();
+
+  ASSERT_EQ(c.get(), raw_a);
+  ASSERT_EQ(allocations, 2);
+  ASSERT_GE(waited, 40ms);
+}
+
+TEST_F(ImagePoolTest, GivesUpWhenStopped) {
+  video::image_pool_t pool { 1, 1h };
+
+  auto a = acquire(pool);
+  std::thread stopper { [this]() {
+    std::this_thread::sleep_for(20ms);
+    is_running = false;
+  } };
+
+  ASSERT_FALSE(acquire(pool));
+  stopper.join();
+}
+
+TEST_F(ImagePoolTest, AllocationFailure) {
+  video::image_pool_t pool { 2, 1h };
+
+  ASSERT_FALSE(pool.acquire([]() { return nullptr; }, running));
+  ASSERT_EQ(pool.allocated(), 0);
+}
+
+TEST_F(ImagePoolTest, TrimsIdleImages) {
+  video::image_pool_t pool { 4, 50ms };
+
+  auto a = acquire(pool);
+  auto b = acquire(pool);
+  auto c = acquire(pool);
+  a.reset();
+  b.reset();
+  ASSERT_EQ(alive, 3);
+
+  std::this_thread::sleep_for(100ms);
+
+  // One of the idle images is reused, the other one has been idle for too long
+  auto d = acquire(pool);
+  ASSERT_EQ(alive, 2);
+  ASSERT_EQ(pool.allocated(), 2);
+  ASSERT_EQ(pool.free(), 0);
+}
+
+TEST_F(ImagePoolTest, ClearDestroysImagesOnRelease) {
+  video::image_pool_t pool { 4, 1h };
+
+  auto a = acquire(pool);
+  auto b = acquire(pool);
+  b.reset();
+
+  pool.clear();
+  ASSERT_EQ(alive, 1);
+  ASSERT_EQ(pool.allocated(), 0);
+
+  // Images acquired before the pool was cleared don't return to it
+  a.reset();
+  ASSERT_EQ(alive, 0);
+  ASSERT_EQ(pool.free(), 0);
+}
+
+TEST_F(ImagePoolTest, CopiesShareTheLease) {
+  video::image_pool_t pool { 4, 1h };
+
+  auto img = acquire(pool);
+  auto copy = img;
+  ASSERT_EQ(img.use_count(), 2);
+
+  img.reset();
+  ASSERT_EQ(pool.free(), 0);
+  copy.reset();
+  ASSERT_EQ(pool.free(), 1);
+}
+
+TEST_F(ImagePoolTest, SharedFromThisKeepsImageOutOfPool) {
+  video::image_pool_t pool { 1, 1h };
+
+  auto img = acquire(pool);
+  auto escaped = img->shared_from_this();
+  img.reset();
+
+  // The image isn't reused while the reference taken around the lease is alive
+  ASSERT_EQ(pool.free(), 0);
+  ASSERT_EQ(pool.allocated(), 0);
+  img = acquire(pool);
+  ASSERT_NE(img.get(), escaped.get());
+  ASSERT_EQ(allocations, 2);
+
+  escaped.reset();
+  ASSERT_EQ(alive, 1);
+}
+
+TEST_F(ImagePoolTest, OutlivesPool) {
+  std::shared_ptr<platf::img_t> img;
+  {
+    video::image_pool_t pool { 4, 1h };
+    img = acquire(pool);
+  }
+
+  ASSERT_EQ(alive, 1);
+  img.reset();
+  ASSERT_EQ(alive, 0);
+}
@@ -0,0 +1,150 @@
+/**
+ * @file tests/unit/test_input_replay.cpp
+ * @brief Test src/input_replay.*.
+ */
+#include <src/input_replay.h>
+
+// define uint32_t for <moonlight-common-c/src/Input.h>
+#include <cstdint>
+extern "C" {
+#include <moonlight-common-c/src/Input.h>
+#include <moonlight-common-c/src/Limelight.h>
+}
+
+#include <cstdlib>
+#include <filesystem>
+
+#include "../tests_common.h"
+
+namespace {
+  std::vector<std::uint8_t>
+  rel_mouse_move(short dx, short dy) {
+    NV_REL_MOUSE_MOVE_PACKET packet {};
+    packet.header.size = util::endian::big<std::uint32_t>(sizeof(packet) - sizeof(packet.header.size));
+    packet.header.magic = util::endian::little<std::uint32_t>(MOUSE_MOVE_REL_MAGIC_GEN5);
+    packet.deltaX = util::endian::big(dx);
+    packet.deltaY = util::endian::big(dy);
+
+    auto begin = (const std::uint8_t *) &packet;
+    return { begin, begin + sizeof(packet) };
+  }
+
+  std::vector<std::uint8_t>
+  key(short key_code, bool release) {
+    NV_KEYBOARD_PACKET packet {};
+    packet.header.size = util::endian::big<std::uint32_t>(sizeof(packet) - sizeof(packet.header.size));
+    packet.header.magic = util::endian::little<std::uint32_t>(release ? KEY_UP_EVENT_MAGIC : KEY_DOWN_EVENT_MAGIC);
+    packet.keyCode = util::endian::little(key_code);
+
+    auto begin = (const std::uint8_t *) &packet;
+    return { begin, begin + sizeof(packet) };
+  }
+
+  /**
+   * @brief A burst of mouse movement every millisecond, with a key press every 100 packets.
+   */
+  std::vector<input::replay::packet_t>
+  synthetic_session(int count) {
+    std::vector<input::replay::packet_t> packets;
+    for (int x = 0; x < count; ++x) {
+      auto timestamp = std::chrono::nanoseconds { std::chrono::microseconds { x * 250 } };
+      if (x % 100 == 50) {
+        packets.push_back({ timestamp, key(0x41, (x / 100) % 2) });
+      }
+      else {
+        packets.push_back({ timestamp, rel_mouse_move(1, -1) });
+      }
+    }
+
+    return packets;
+  }
+}  // namespace
+
+struct InputReplayTest: testing::Test {
+  static void
+  SetUpTestSuite() {
+    task_pool.start(1);
+  }
+
+  static void
+  TearDownTestSuite() {
+    task_pool.stop();
+    task_pool.join();
+  }
+};
+
+TEST_F(InputReplayTest, RecordAndLoad) {
+  auto path = (std::filesystem::temp_directory_path() / "sunshine_test_input.rec").string();
+  auto packets = synthetic_session(300);
+
+  {
+    auto recorder = input::replay::recorder_t::open(path);
+    ASSERT_TRUE(recorder);
+    for (auto &packet : packets) {
+      recorder->record(packet.timestamp, packet.data);
+    }
+  }
+
+  auto loaded = input::replay::load(path);
+  std::filesystem::remove(path);
+
+  ASSERT_TRUE(loaded);
+  ASSERT_EQ(loaded->size(), packets.size());
+  for (std::size_t x = 0; x < packets.size(); ++x) {
+    ASSERT_EQ((*loaded)[x].timestamp, packets[x].timestamp);
+    ASSERT_EQ((*loaded)[x].data, packets[x].data);
+  }
+}
+
+TEST_F(InputReplayTest, SessionPathAppendsNumber) {
+  auto path = (std::filesystem::path { "recordings" } / "input.rec").string();
+  ASSERT_EQ(input::replay::session_path(path, 2), (std::filesystem::path { "recordings" } / "input-2.rec").string());
+  ASSERT_EQ(input::replay::session_path("input", 1), "input-1");
+}
+
+TEST_F(InputReplayTest, RejectsMalformedRecording) {
+  auto path = (std::filesystem::temp_directory_path() / "sunshine_test_input_bad.rec").string();
+  {
+    std::ofstream file { path, std::ios::binary };
+    file << "not a recording";
+  }
+
+  auto loaded = input::replay::load(path);
+  std::filesystem::remove(path);
+
+  ASSERT_FALSE(loaded);
+}
+
+TEST_F(InputReplayTest, ReplayBatchesMouseMovement) {
+  auto packets = synthetic_session(2000);
+  auto report = input::replay::run(packets, 0);
+  input::replay::log(report);
+
+  ASSERT_EQ(report.packets, packets.size());
+  ASSERT_GT(report.messages, 0);
+  ASSERT_LE(report.messages, report.packets);
+
+  // Key presses terminate a batch, so each of them is a message of its own
+  ASSERT_GE(report.messages, packets.size() / 100);
+  ASSERT_GE(report.batching_ratio, 1.0);
+  ASSERT_LE(report.latency_p50, report.latency_p99);
+  ASSERT_LE(report.latency_p99, report.latency_max);
+}
+
+TEST_F(InputReplayTest, ReplayRecordedSession) {
+  // Replay a real recording made with the input_record_file option
+  auto path = std::getenv("SUNSHINE_INPUT_REPLAY");
+  if (!path) {
+    GTEST_SKIP() << "SUNSHINE_INPUT_REPLAY is not set";
+  }
+
+  auto speed = std::getenv("SUNSHINE_INPUT_REPLAY_SPEED");
+
+  auto packets = input::replay::load(path);
+  ASSERT_TRUE(packets);
+
+  auto report = input::replay::run(*packets, speed ? std::atof(speed) : 1.0);
+  input::replay::log(report);
+
+  ASSERT_EQ(report.packets, packets->size());
+}
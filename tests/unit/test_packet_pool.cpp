@@ -0,0 +1,117 @@
+/**
+ * @file tests/unit/test_packet_pool.cpp
+ * @brief Test src/packet_pool.*.
+ */
+#include <src/packet_pool.h>
+#include <src/video.h>
+
+#include <cstring>
+#include <thread>
+
+#include "../tests_common.h"
+
+TEST(PacketPoolTest, AvcodecPacketsAreRecycled) {
+  video::packet_pool_t pool;
+
+  auto packet = pool.make_avcodec();
+  ASSERT_TRUE(packet);
+  auto av_packet = packet->av_packet;
+
+  // Released on another thread, like the packets sent by the broadcast thread
+  std::thread { [packet = std::move(packet)]() mutable {
+    packet.reset();
+  } }.join();
+
+  packet = pool.make_avcodec();
+  ASSERT_EQ(packet->av_packet, av_packet);
+  ASSERT_EQ(packet->data_size(), 0);
+}
+
+TEST(PacketPoolTest, GenericBuffersKeepTheirCapacity) {
+  video::packet_pool_t pool;
+
+  auto frame_data = pool.acquire_buffer();
+  frame_data.resize(100000);
+  auto data = frame_data.data();
+
+  auto packet = pool.make_generic(std::move(frame_data), 1, true);
+  ASSERT_EQ(packet->data(), data);
+  ASSERT_EQ(packet->frame_index(), 1);
+  ASSERT_TRUE(packet->is_idr());
+  packet.reset();
+
+  frame_data = pool.acquire_buffer();
+  ASSERT_TRUE(frame_data.empty());
+  ASSERT_GE(frame_data.capacity(), 100000);
+  ASSERT_EQ(frame_data.data(), data);
+
+  auto stats = pool.stats();
+  ASSERT_EQ(stats.packets, 2);
+  ASSERT_EQ(stats.allocations, 1);
+}
+
+TEST(PacketPoolTest, UnusedBuffersAreReturned) {
+  video::packet_pool_t pool;
+
+  auto frame_data = pool.acquire_buffer();
+  frame_data.reserve(100000);
+  auto data = frame_data.data();
+
+  // Like an encoder that failed before writing the frame
+  pool.release_buffer(std::move(frame_data));
+
+  frame_data = pool.acquire_buffer();
+  ASSERT_EQ(frame_data.data(), data);
+  ASSERT_EQ(pool.stats().allocations, 1);
+}
+
+TEST(PacketPoolTest, PacketsOutliveThePool) {
+  std::unique_ptr<video::packet_raw_generic> packet;
+  {
+    video::packet_pool_t pool;
+    packet = pool.make_generic(pool.acquire_buffer(), 1, false);
+  }
+
+  packet.reset();
+}
+
+TEST(PacketPoolTest, EncoderWritesIntoThePool) {
+  constexpr int frames = 20;
+
+  auto codec = avcodec_find_encoder(AV_CODEC_ID_RAWVIDEO);
+  if (!codec || !(codec->capabilities & AV_CODEC_CAP_DR1)) {
+    GTEST_SKIP() << "rawvideo encoder with AV_CODEC_CAP_DR1 not available";
+  }
+
+  video::packet_pool_t pool;
+  video::avcodec_ctx_t ctx { avcodec_alloc_context3(codec) };
+  ctx->width = 64;
+  ctx->height = 64;
+  ctx->pix_fmt = AV_PIX_FMT_GRAY8;
+  ctx->time_base = AVRational { 1, 60 };
+  pool.attach(ctx.get());
+  ASSERT_EQ(avcodec_open2(ctx.get(), codec, nullptr), 0);
+
+  video::avcodec_frame_t frame { av_frame_alloc() };
+  frame->format = ctx->pix_fmt;
+  frame->width = ctx->width;
+  frame->height = ctx->height;
+  ASSERT_EQ(av_frame_get_buffer(frame.get(), 0), 0);
+
+  for (int x = 0; x < frames; ++x) {
+    std::memset(frame->data[0], x, frame->linesize[0] * frame->height);
+    frame->pts = x;
+    ASSERT_EQ(avcodec_send_frame(ctx.get(), frame.get()), 0);
+
+    auto packet = pool.make_avcodec();
+    ASSERT_EQ(avcodec_receive_packet(ctx.get(), packet->av_packet), 0);
+    ASSERT_EQ(packet->data_size(), 64 * 64);
+    ASSERT_EQ(packet->data()[0], x);
+  }
+
+  // Each packet was released before the next one, so one buffer served them all
+  auto stats = pool.stats();
+  ASSERT_EQ(stats.packets, frames);
+  ASSERT_EQ(stats.allocations, 1);
+  ASSERT_GE(stats.buffer_size, 64 * 64);
+}
@@ -0,0 +1,218 @@
+/**
+ * @file tests/unit/test_shared_convert.cpp
+ * @brief Test src/shared_convert.*.
+ */
+#include <src/platform/common.h>
+#include <src/shared_convert.h>
+#include <src/video.h>
+
+#include <array>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include <libavutil/mastering_display_metadata.h>
+}
+
+#include "../tests_common.h"
+
+using namespace std::literals;
+
+namespace {
+  constexpr video::sunshine_colorspace_t rec709_limited { video::colorspace_e::rec709, false, 8 };
+
+  struct test_img_t: platf::img_t {
+    test_img_t(int width, int height, std::uint32_t seed) {
+      pixels.resize((std::size_t) width * height * 4);
+
+      std::mt19937 rng { seed };
+      for (auto &x : pixels) {
+        x = (std::uint8_t) rng();
+      }
+
+      data = pixels.data();
+      this->width = width;
+      this->height = height;
+      pixel_pitch = 4;
+      row_pitch = width * 4;
+      frame_timestamp = std::chrono::steady_clock::now();
+    }
+
+    std::vector<std::uint8_t> pixels;
+  };
+
+  /**
+   * @brief A session frame, allocated like the software encode device does.
+   */
+  video::avcodec_frame_t
+  make_frame(int width, int height) {
+    video::avcodec_frame_t frame { av_frame_alloc() };
+    frame->format = AV_PIX_FMT_NV12;
+    frame->width = width;
+    frame->height = height;
+    frame->color_range = AVCOL_RANGE_MPEG;
+    if (av_frame_get_buffer(frame.get(), 0) < 0) {
+      return nullptr;
+    }
+
+    return frame;
+  }
+}  // namespace
+
+TEST(SharedConvertTest, SameStageForSameSettings) {
+  auto first = video::shared_convert_t::get(AV_PIX_FMT_NV12, rec709_limited, 1920, 1080);
+  auto second = video::shared_convert_t::get(AV_PIX_FMT_NV12, rec709_limited, 1920, 1080);
+  ASSERT_TRUE(first);
+  ASSERT_EQ(first, second);
+
+  video::sunshine_colorspace_t rec709_full { video::colorspace_e::rec709, true, 8 };
+  ASSERT_NE(video::shared_convert_t::get(AV_PIX_FMT_NV12, rec709_full, 1920, 1080), first);
+
+  // Another display
+  ASSERT_NE(video::shared_convert_t::get(AV_PIX_FMT_NV12, rec709_limited, 2560, 1440), first);
+}
+
+TEST(SharedConvertTest, ConvertsOncePerImage) {
+  video::shared_convert_t stage { AV_PIX_FMT_NV12, rec709_limited };
+  test_img_t img { 256, 128, 1 };
+
+  auto first = make_frame(256, 128);
+  auto second = make_frame(256, 128);
+  ASSERT_TRUE(first && second);
+
+  second->pict_type = AV_PICTURE_TYPE_I;
+
+  ASSERT_EQ(stage.convert(img, first.get()), 0);
+  ASSERT_EQ(stage.convert(img, second.get()), 0);
+  ASSERT_EQ(stage.conversions(), 1);
+
+  // Both sessions reference the same conversion, and keep the picture type they asked for
+  ASSERT_EQ(first->data[0], second->data[0]);
+  ASSERT_EQ(first->pict_type, AV_PICTURE_TYPE_NONE);
+  ASSERT_EQ(second->pict_type, AV_PICTURE_TYPE_I);
+
+  // A new capture is converted again
+  img.frame_timestamp = *img.frame_timestamp + 1ms;
+  ASSERT_EQ(stage.convert(img, first.get()), 0);
+  ASSERT_EQ(stage.conversions(), 2);
+
+  // Without a capture time, an image can't be told apart from the previous one
+  img.frame_timestamp = std::nullopt;
+  ASSERT_EQ(stage.convert(img, first.get()), 0);
+  ASSERT_EQ(stage.convert(img, second.get()), 0);
+  ASSERT_EQ(stage.conversions(), 4);
+}
+
+TEST(SharedConvertTest, KeepsSessionProperties) {
+  video::shared_convert_t stage { AV_PIX_FMT_NV12, rec709_limited };
+  test_img_t img { 256, 128, 6 };
+
+  auto first = make_frame(256, 128);
+  auto second = make_frame(256, 128);
+  ASSERT_TRUE(first && second);
+
+  first->pts = 7;
+  ASSERT_TRUE(av_frame_new_side_data(first.get(), AV_FRAME_DATA_MASTERING_DISPLAY_METADATA, sizeof(AVMasteringDisplayMetadata)));
+
+  ASSERT_EQ(stage.convert(img, first.get()), 0);
+  ASSERT_EQ(stage.convert(img, second.get()), 0);
+  ASSERT_EQ(first->data[0], second->data[0]);
+
+  // The HDR metadata of a session stays with it
+  ASSERT_EQ(first->pts, 7);
+  ASSERT_TRUE(av_frame_get_side_data(first.get(), AV_FRAME_DATA_MASTERING_DISPLAY_METADATA));
+  ASSERT_FALSE(av_frame_get_side_data(second.get(), AV_FRAME_DATA_MASTERING_DISPLAY_METADATA));
+}
+
+TEST(SharedConvertTest, ScaledTierKeepsAspectRatio) {
+  video::shared_convert_t stage { AV_PIX_FMT_NV12, rec709_limited };
+  test_img_t img { 256, 128, 2 };
+
+  // Twice as tall as the image, relative to its width
+  auto frame = make_frame(128, 128);
+  ASSERT_TRUE(frame);
+
+  ASSERT_EQ(stage.convert(img, frame.get()), 0);
+  ASSERT_EQ(frame->width, 128);
+  ASSERT_EQ(frame->height, 128);
+
+  // The image fills rows 32 to 96, the borders are black
+  for (int y : { 0, 31, 96, 127 }) {
+    for (int x = 0; x < 128; ++x) {
+      ASSERT_EQ(frame->data[0][y * frame->linesize[0] + x], 16) << "at " << x << 'x' << y;
+    }
+  }
+  for (int y : { 0, 15, 48, 63 }) {
+    for (int x = 0; x < 128; ++x) {
+      ASSERT_EQ(frame->data[1][y * frame->linesize[1] + x], 128) << "at " << x << 'x' << y;
+    }
+  }
+}
+
+TEST(SharedConvertTest, ReferencedFramesAreNotOverwritten) {
+  video::shared_convert_t stage { AV_PIX_FMT_NV12, rec709_limited };
+  test_img_t img { 256, 128, 3 };
+
+  auto held = make_frame(128, 64);
+  auto frame = make_frame(128, 64);
+  ASSERT_TRUE(held && frame);
+
+  ASSERT_EQ(stage.convert(img, held.get()), 0);
+  std::vector<std::uint8_t> luma(held->data[0], held->data[0] + held->linesize[0] * held->height);
+
+  // An encoder may still reference the previous frame while the next one is converted
+  test_img_t next { 256, 128, 4 };
+  next.frame_timestamp = *img.frame_timestamp + 1ms;
+  ASSERT_EQ(stage.convert(next, frame.get()), 0);
+
+  ASSERT_NE(held->data[0], frame->data[0]);
+  ASSERT_TRUE(std::equal(std::begin(luma), std::end(luma), held->data[0]));
+}
+
+TEST(SharedConvertTest, DISABLED_Benchmark) {
+  constexpr int frames = 10;
+  constexpr int sessions = 4;
+  constexpr int width = 1920;
+  constexpr int height = 1080;
+
+  test_img_t img { width, height, 5 };
+
+  // Half of the sessions stream at a lower resolution
+  std::array<video::avcodec_frame_t, sessions> session_frames;
+  for (int x = 0; x < sessions; ++x) {
+    session_frames[x] = x & 1 ? make_frame(1280, 720) : make_frame(width, height);
+    ASSERT_TRUE(session_frames[x]);
+  }
+
+  auto time = [&](auto &&convert) {
+    auto start = std::chrono::steady_clock::now();
+    for (int x = 0; x < frames; ++x) {
+      img.frame_timestamp = *img.frame_timestamp + 1ms;
+      convert();
+    }
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / frames;
+  };
+
+  // Each session with a stage of its own, i.e. converting by itself
+  std::array<std::unique_ptr<video::shared_convert_t>, sessions> stages;
+  for (auto &stage : stages) {
+    stage = std::make_unique<video::shared_convert_t>(AV_PIX_FMT_NV12, rec709_limited);
+  }
+
+  auto independent_us = time([&]() {
+    for (int x = 0; x < sessions; ++x) {
+      stages[x]->convert(img, session_frames[x].get());
+    }
+  });
+
+  video::shared_convert_t shared { AV_PIX_FMT_NV12, rec709_limited };
+  auto shared_us = time([&]() {
+    for (auto &frame : session_frames) {
+      shared.convert(img, frame.get());
+    }
+  });
+
+  BOOST_LOG(tests) << "Benchmark:: "sv << sessions << " sessions at "sv << width << 'x' << height << " and 1280x720: "sv
+                   << independent_us << "us independently, "sv << shared_us << "us shared"sv;
+}
@@ -11,6 +11,8 @@
 namespace stream {
   std::vector<uint8_t>
   concat_and_insert(uint64_t insert_size, uint64_t slice_size, const std::string_view &data1, const std::string_view &data2);
+  std::vector<uint8_t>
+  concat_and_insert(uint64_t insert_size, uint64_t slice_size, const std::vector<std::string_view> &buffers);
 }
 
 #include "../tests_common.h"
@@ -38,3 +40,18 @@ TEST(ConcatAndInsertTests, ConcatSmallStrideTest) {
   auto expected = std::vector<uint8_t> { 0, 'a', 0, 'b', 0, 'c', 0, 'd', 0, 'e' };
   ASSERT_EQ(res, expected);
 }
+
+TEST(ConcatAndInsertTests, ConcatGatherListTest) {
+  char b1[] = { 'a', 'b' };
+  char b2[] = { 'c' };
+  char b3[] = { 'd', 'e', 'f', 'g' };
+  std::vector<std::string_view> buffers {
+    std::string_view { b1, sizeof(b1) },
+    std::string_view {},
+    std::string_view { b2, sizeof(b2) },
+    std::string_view { b3, sizeof(b3) },
+  };
+  auto res = stream::concat_and_insert(1, 3, buffers);
+  auto expected = std::vector<uint8_t> { 0, 'a', 'b', 'c', 0, 'd', 'e', 'f', 0, 'g' };
+  ASSERT_EQ(res, expected);
+}
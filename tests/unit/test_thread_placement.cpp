@@ -0,0 +1,38 @@
+/**
+ * @file tests/unit/test_thread_placement.cpp
+ * @brief Test src/thread_placement.*
+ */
+#include <src/thread_placement.h>
+
+#include "../tests_common.h"
+
+using namespace thread_placement;
+
+TEST(ThreadPlacementTests, ParseCpuList) {
+  ASSERT_EQ(parse_cpu_list("0-3,8,10-11"), (std::vector<int> { 0, 1, 2, 3, 8, 10, 11 }));
+  ASSERT_EQ(parse_cpu_list(" 6 , 2-3 "), (std::vector<int> { 2, 3, 6 }));
+  ASSERT_EQ(parse_cpu_list("1,1,0-1"), (std::vector<int> { 0, 1 }));
+  ASSERT_EQ(parse_cpu_list(""), std::vector<int> {});
+}
+
+TEST(ThreadPlacementTests, ParseCpuListClampsToMaxCpus) {
+  auto cpus = parse_cpu_list("0-99999999");
+  ASSERT_TRUE(cpus);
+  ASSERT_EQ(cpus->size(), (std::size_t) max_cpus);
+  ASSERT_EQ(cpus->back(), max_cpus - 1);
+
+  ASSERT_EQ(parse_cpu_list("2,5000"), (std::vector<int> { 2 }));
+}
+
+TEST(ThreadPlacementTests, ParseMalformedCpuList) {
+  ASSERT_FALSE(parse_cpu_list("3-1"));
+  ASSERT_FALSE(parse_cpu_list("a"));
+  ASSERT_FALSE(parse_cpu_list("1-"));
+  ASSERT_FALSE(parse_cpu_list("-1"));
+}
+
+TEST(ThreadPlacementTests, FormatCpuList) {
+  ASSERT_EQ(to_cpu_list({ 0, 1, 2, 3, 8, 10, 11 }), "0-3,8,10-11");
+  ASSERT_EQ(to_cpu_list({ 5 }), "5");
+  ASSERT_EQ(to_cpu_list({}), "");
+}
@@ -0,0 +1,147 @@
+/**
+ * @file tests/unit/test_thread_pool.cpp
+ * @brief Test src/thread_pool.*
+ */
+#include <src/thread_pool.h>
+
+#include "../tests_common.h"
+
+using namespace thread_pool_util;
+
+TEST(WorkStealingPoolTests, PushReturnsFuture) {
+  WorkStealingPool pool(4);
+
+  std::vector<std::future<int>> futures;
+  for (int x = 0; x < 1000; ++x) {
+    futures.emplace_back(pool.push([](int y) { return y * 2; }, x));
+  }
+
+  for (int x = 0; x < 1000; ++x) {
+    ASSERT_EQ(futures[x].get(), x * 2);
+  }
+}
+
+TEST(WorkStealingPoolTests, CriticalLaneRunsFirst) {
+  WorkStealingPool pool(1);
+
+  // Block the only worker, so the queue fills up behind it
+  std::promise<void> gate;
+  auto blocker = pool.push([f = gate.get_future().share()]() { f.wait(); });
+
+  std::mutex lock;
+  std::vector<task_priority_e> order;
+  auto record = [&](task_priority_e priority) {
+    std::lock_guard lg(lock);
+    order.emplace_back(priority);
+  };
+
+  auto background = pool.push(task_priority_e::background, record, task_priority_e::background);
+  auto critical = pool.push(task_priority_e::critical, record, task_priority_e::critical);
+
+  gate.set_value();
+  background.get();
+  critical.get();
+
+  ASSERT_EQ(order.size(), 2);
+  ASSERT_EQ(order[0], task_priority_e::critical);
+  ASSERT_EQ(order[1], task_priority_e::background);
+}
+
+TEST(WorkStealingPoolTests, DelayedTaskCanBeCancelled) {
+  WorkStealingPool pool(2);
+
+  auto start = std::chrono::steady_clock::now();
+  auto delayed = pool.pushDelayed([]() { return std::chrono::steady_clock::now(); }, 20ms);
+  auto cancelled = pool.pushDelayed([]() { return 1; }, 10ms);
+
+  ASSERT_TRUE(pool.cancel(cancelled.task_id));
+  ASSERT_GE(delayed.future.get() - start, 20ms);
+
+  // The cancelled task is destroyed without running
+  ASSERT_THROW(cancelled.future.get(), std::future_error);
+}
+
+TEST(WorkStealingPoolTests, UnstartedPoolRunsInline) {
+  WorkStealingPool pool;
+
+  auto future = pool.push([]() { return std::this_thread::get_id(); });
+  ASSERT_EQ(future.wait_for(0ms), std::future_status::ready);
+  ASSERT_EQ(future.get(), std::this_thread::get_id());
+}
+
+TEST(WorkStealingPoolTests, DestroyAfterStopWithoutJoin) {
+  WorkStealingPool pool(2);
+  pool.push([]() {}).get();
+
+  // The destructor still joins the workers
+  pool.stop();
+}
+
+TEST(WorkStealingPoolTests, IdleWorkersSteal) {
+  std::atomic_int initialized { 0 };
+  WorkStealingPool pool(4, [&](std::size_t) { ++initialized; });
+
+  // All tasks pushed from a worker land on that worker's deque, the others have to steal them
+  auto fanout = pool.push([&pool]() {
+    std::vector<std::future<void>> futures;
+    for (int x = 0; x < 64; ++x) {
+      futures.emplace_back(pool.push([]() { std::this_thread::sleep_for(1ms); }));
+    }
+    return futures;
+  });
+
+  for (auto &future : fanout.get()) {
+    future.get();
+  }
+
+  ASSERT_EQ(initialized, 4);
+  ASSERT_GT(pool.stolen(), 0);
+}
+
+namespace {
+  template <class Pool>
+  std::chrono::nanoseconds
+  run_contention(Pool &pool, int producers, int tasks_per_producer) {
+    std::atomic_int done { 0 };
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int x = 0; x < producers; ++x) {
+      threads.emplace_back([&]() {
+        for (int y = 0; y < tasks_per_producer; ++y) {
+          pool.push([&done]() { ++done; });
+        }
+      });
+    }
+
+    for (auto &t : threads) {
+      t.join();
+    }
+
+    while (done < producers * tasks_per_producer) {
+      std::this_thread::yield();
+    }
+
+    return std::chrono::steady_clock::now() - start;
+  }
+}  // namespace
+
+TEST(WorkStealingPoolTests, DISABLED_ContentionBenchmark) {
+  constexpr int workers = 4;
+  constexpr int producers = 8;
+  constexpr int tasks_per_producer = 20000;
+
+  ThreadPool thread_pool(workers);
+  auto thread_pool_time = run_contention(thread_pool, producers, tasks_per_producer);
+  thread_pool.stop();
+  thread_pool.join();
+
+  WorkStealingPool work_stealing_pool(workers);
+  auto work_stealing_time = run_contention(work_stealing_pool, producers, tasks_per_producer);
+
+  BOOST_LOG(tests) << "ContentionBenchmark:: "sv << producers * tasks_per_producer << " tasks, "sv
+                   << producers << " producers, "sv << workers << " workers"sv;
+  BOOST_LOG(tests) << "ContentionBenchmark:: ThreadPool:       "sv << std::chrono::duration_cast<std::chrono::microseconds>(thread_pool_time).count() << "us"sv;
+  BOOST_LOG(tests) << "ContentionBenchmark:: WorkStealingPool: "sv << std::chrono::duration_cast<std::chrono::microseconds>(work_stealing_time).count() << "us"sv
+                   << " ("sv << work_stealing_pool.stolen() << " stolen)"sv;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file tests/unit/test_thread_safe.cpp
+ * @brief Test src/thread_safe.*
+ */
+#include <src/thread_safe.h>
+
+#include "../tests_common.h"
+
+using namespace safe;
+
+TEST(RingQueueTests, PopsInOrder) {
+  ring_queue_t<int> queue(4);
+
+  for (int x = 0; x < 3; ++x) {
+    ASSERT_TRUE(queue.raise(x));
+  }
+
+  for (int x = 0; x < 3; ++x) {
+    ASSERT_EQ(*queue.pop(0ms), x);
+  }
+
+  ASSERT_FALSE(queue.peek());
+  ASSERT_EQ(queue.stats().high_water, 3);
+}
+
+TEST(RingQueueTests, WrapsAround) {
+  ring_queue_t<int> queue(3);
+
+  for (int x = 0; x < 10; ++x) {
+    ASSERT_TRUE(queue.raise(x));
+    ASSERT_EQ(*queue.pop(0ms), x);
+  }
+
+  ASSERT_EQ(queue.stats().dropped, 0);
+}
+
+TEST(RingQueueTests, ZeroCapacityHoldsOne) {
+  ring_queue_t<int> queue(0);
+
+  ASSERT_TRUE(queue.raise(1));
+  ASSERT_TRUE(queue.raise(2));
+  ASSERT_EQ(*queue.pop(0ms), 2);
+  ASSERT_EQ(queue.stats().capacity, 1);
+}
+
+TEST(RingQueueTests, DropOldest) {
+  ring_queue_t<int> queue(3, overflow_e::drop_oldest);
+
+  for (int x = 0; x < 5; ++x) {
+    ASSERT_TRUE(queue.raise(x));
+  }
+
+  ASSERT_EQ(*queue.pop(0ms), 2);
+  ASSERT_EQ(*queue.pop(0ms), 3);
+  ASSERT_EQ(*queue.pop(0ms), 4);
+  ASSERT_EQ(queue.stats().dropped, 2);
+}
+
+TEST(RingQueueTests, DropNewest) {
+  ring_queue_t<int> queue(3, overflow_e::drop_newest);
+
+  for (int x = 0; x < 5; ++x) {
+    ASSERT_EQ(queue.raise(x), x < 3);
+  }
+
+  ASSERT_EQ(*queue.pop(0ms), 0);
+  ASSERT_EQ(queue.stats().dropped, 2);
+}
+
+TEST(RingQueueTests, Clear) {
+  ring_queue_t<int> queue(3, overflow_e::clear);
+
+  for (int x = 0; x < 4; ++x) {
+    ASSERT_TRUE(queue.raise(x));
+  }
+
+  ASSERT_EQ(*queue.pop(0ms), 3);
+  ASSERT_FALSE(queue.peek());
+  ASSERT_EQ(queue.stats().dropped, 3);
+}
+
+TEST(RingQueueTests, BlockUntilPopped) {
+  ring_queue_t<int> queue(1, overflow_e::block, 1s);
+  ASSERT_TRUE(queue.raise(0));
+
+  std::thread consumer([&queue]() {
+    std::this_thread::sleep_for(10ms);
+    queue.pop();
+  });
+
+  ASSERT_TRUE(queue.raise(1));
+  consumer.join();
+
+  ASSERT_EQ(*queue.pop(0ms), 1);
+  ASSERT_EQ(queue.stats().dropped, 0);
+}
+
+TEST(RingQueueTests, BlockTimesOut) {
+  ring_queue_t<int> queue(1, overflow_e::block, 10ms);
+
+  ASSERT_TRUE(queue.raise(0));
+  ASSERT_FALSE(queue.raise(1));
+  ASSERT_EQ(queue.stats().dropped, 1);
+}
+
+TEST(RingQueueTests, StopWakesConsumer) {
+  ring_queue_t<int> queue(2);
+
+  std::thread stopper([&queue]() {
+    std::this_thread::sleep_for(10ms);
+    queue.stop();
+  });
+
+  ASSERT_FALSE(queue.pop());
+  stopper.join();
+}
+
+TEST(MailTests, QueueStatsByName) {
+  auto mail = std::make_shared<mail_raw_t>();
+
+  auto plain = mail->queue<int>("plain"sv);
+  auto ring = mail->ring_queue<int>("ring"sv, 2, overflow_e::drop_oldest);
+
+  for (int x = 0; x < 40; ++x) {
+    plain->raise(x);
+    ring->raise(x);
+  }
+
+  auto plain_stats = mail->queue_stats("plain"sv);
+  ASSERT_TRUE(plain_stats);
+  ASSERT_EQ(plain_stats->capacity, 32);
+  ASSERT_EQ(plain_stats->high_water, 32);
+  ASSERT_EQ(plain_stats->dropped, 32);
+  ASSERT_EQ(plain_stats->depth, 8);
+
+  auto ring_stats = mail->queue_stats("ring"sv);
+  ASSERT_TRUE(ring_stats);
+  ASSERT_EQ(ring_stats->depth, 2);
+  ASSERT_EQ(ring_stats->dropped, 38);
+
+  ASSERT_FALSE(mail->queue_stats("missing"sv));
+  ASSERT_EQ(mail->queue_stats().size(), 2);
+}
@@ -0,0 +1,231 @@
+/**
+ * @file tests/unit/test_tile_hash.cpp
+ * @brief Test src/tile_hash.*.
+ */
+#include <src/tile_hash.h>
+#include <src/video.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+#include "../tests_common.h"
+
+using namespace std::literals;
+
+namespace {
+  struct kernel_t {
+    const char *name;
+    tile_hash::crc_runs_t crc_runs;
+    bool supported;
+  };
+
+  std::vector<kernel_t>
+  kernels() {
+    return {
+#ifdef SUNSHINE_TILE_HASH_X86
+      { "sse4.2", tile_hash::crc_runs_sse42, (bool) __builtin_cpu_supports("sse4.2") },
+#endif
+    };
+  }
+
+  std::vector<std::uint8_t>
+  random_bytes(std::size_t count, std::uint32_t seed) {
+    std::mt19937 gen { seed };
+    std::vector<std::uint8_t> bytes(count);
+    for (auto &byte : bytes) {
+      byte = (std::uint8_t) gen();
+    }
+
+    return bytes;
+  }
+
+  /**
+   * @brief A BGRX image of random pixels, its rows padded like those of the capture backends.
+   */
+  struct test_img_t: platf::img_t {
+    test_img_t(int width, int height) {
+      this->width = width;
+      this->height = height;
+      pixel_pitch = 4;
+      row_pitch = (width + 8) * 4;
+
+      pixels = random_bytes((std::size_t) row_pitch * height, width);
+      data = pixels.data();
+    }
+
+    void
+    flip(int x, int y) {
+      data[y * row_pitch + x * pixel_pitch] ^= 1;
+    }
+
+    std::vector<std::uint8_t> pixels;
+  };
+}  // namespace
+
+TEST(TileHashTests, InitSelectsKernel) {
+  ASSERT_NE(tile_hash::init(), nullptr);
+  ASSERT_NE(tile_hash::crc_runs, nullptr);
+}
+
+TEST(TileHashTests, ScalarReference) {
+  // The check value of CRC32C
+  constexpr auto check = "123456789"sv;
+  std::uint32_t crc = ~0u;
+  tile_hash::crc_runs_scalar(&crc, (const std::uint8_t *) check.data(), check.size(), 1);
+  ASSERT_EQ(~crc, 0xE3069283u);
+}
+
+TEST(TileHashTests, BitExactForRandomRuns) {
+  auto bytes = random_bytes(8192, 1);
+
+  for (auto &kernel : kernels()) {
+    if (!kernel.supported) {
+      continue;
+    }
+
+    // Odd sizes and counts exercise the tails of the kernels
+    for (std::size_t size : { 0, 1, 7, 8, 9, 63, 256, 1021 }) {
+      for (std::size_t count : { 1, 3, 4, 5, 8 }) {
+        std::vector<std::uint32_t> expected(count, 0x12345678);
+        std::vector<std::uint32_t> actual(count, 0x12345678);
+        tile_hash::crc_runs_scalar(expected.data(), bytes.data(), size, count);
+        kernel.crc_runs(actual.data(), bytes.data(), size, count);
+
+        ASSERT_EQ(actual, expected) << kernel.name << ": " << count << " runs of " << size << " bytes";
+      }
+    }
+  }
+}
+
+TEST(TileHashTests, ReportsChangedTiles) {
+  // Partial tiles on the right and bottom edges
+  test_img_t img { 200, 150 };
+
+  tile_hash::tracker_t tiles;
+  ASSERT_EQ(tiles.update(img), 12);
+  ASSERT_EQ(tiles.columns(), 4);
+  ASSERT_EQ(tiles.rows(), 3);
+
+  ASSERT_EQ(tiles.update(img), 0);
+  ASSERT_TRUE(tiles.damage().empty());
+
+  // The padding at the end of the rows isn't part of the image
+  img.flip(200, 0);
+  ASSERT_EQ(tiles.update(img), 0);
+
+  // Two adjacent tiles of the first row and the bottom-right one
+  img.flip(63, 10);
+  img.flip(64, 63);
+  img.flip(199, 149);
+  ASSERT_EQ(tiles.update(img), 3);
+
+  auto &changed = tiles.changed();
+  ASSERT_EQ(std::count_if(std::begin(changed), std::end(changed), [](auto tile) { return tile != 0; }), 3);
+  ASSERT_TRUE(changed[0] && changed[1] && changed[11]);
+
+  auto damage = tiles.damage();
+  ASSERT_EQ(damage.size(), 2);
+  ASSERT_EQ(damage[0].x, 0);
+  ASSERT_EQ(damage[0].y, 0);
+  ASSERT_EQ(damage[0].width, 128);
+  ASSERT_EQ(damage[0].height, 64);
+  ASSERT_EQ(damage[1].x, 192);
+  ASSERT_EQ(damage[1].y, 128);
+  ASSERT_EQ(damage[1].width, 8);
+  ASSERT_EQ(damage[1].height, 22);
+
+  tiles.reset();
+  ASSERT_EQ(tiles.update(img), 12);
+}
+
+TEST(TileHashTests, NewSizeChangesEverything) {
+  test_img_t img { 128, 128 };
+  tile_hash::tracker_t tiles;
+  tiles.update(img);
+
+  img.height = 64;
+  ASSERT_EQ(tiles.update(img), 2);
+  ASSERT_EQ(tiles.update(img), 0);
+}
+
+TEST(TileHashTests, DISABLED_Benchmark) {
+  constexpr int frames = 30;
+
+  tile_hash::init();
+
+  test_img_t img { 3840, 2160 };
+  tile_hash::tracker_t tiles;
+  tiles.update(img);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int x = 0; x < frames; ++x) {
+    ASSERT_EQ(tiles.update(img), 0);
+  }
+  auto hash_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / frames;
+
+  auto crc_runs = tile_hash::crc_runs;
+  auto fg = util::fail_guard([crc_runs]() {
+    tile_hash::crc_runs = crc_runs;
+  });
+  tile_hash::crc_runs = tile_hash::crc_runs_scalar;
+
+  start = std::chrono::steady_clock::now();
+  ASSERT_EQ(tiles.update(img), 0);
+  auto scalar_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+  BOOST_LOG(tests) << "Benchmark:: 4K tile hashing: "sv << hash_us << "us per frame, "sv << scalar_us << "us with the scalar kernel"sv;
+}
+
+struct TileHashBenchmark: PlatformTestSuite {};
+
+TEST_F(TileHashBenchmark, DISABLED_IdleDesktop) {
+  constexpr int frames = 60;
+
+  auto &encoder = video::software;
+  if (!video::validate_encoder(encoder, false)) {
+    FAIL() << "Software encoder not available";
+  }
+
+  const video::config_t config { 1920, 1080, 60, 10000, 1, 1, 0, 0, 0, 0, 0 };
+  auto disp = platf::display(encoder.platform_formats->dev_type, config::video.output_name, config);
+  if (!disp) {
+    GTEST_SKIP() << "No display to capture";
+  }
+
+  auto img = disp->alloc_img();
+  ASSERT_TRUE(img);
+  ASSERT_EQ(disp->dummy_img(img.get()), 0);
+  if (!img->data) {
+    GTEST_SKIP() << "Display doesn't capture into main memory";
+  }
+
+  auto session = video::make_scaled_encode_session(*disp, encoder, config, 100);
+  ASSERT_TRUE(session);
+
+  auto test_mail = std::make_shared<safe::mail_raw_t>();
+  auto packets = test_mail->queue<video::packet_t>(mail::video_packets);
+
+  // An idle desktop captures the same image over and over, which is converted and encoded each time
+  auto start = std::chrono::steady_clock::now();
+  for (int x = 0; x < frames; ++x) {
+    ASSERT_EQ(session->convert(*img), 0);
+    ASSERT_EQ(video::encode(x, *session, packets, nullptr, {}), 0);
+    while (packets->peek()) {
+      packets->pop();
+    }
+  }
+  auto encode_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / frames;
+
+  // Or hashed, and dropped as it didn't change
+  tile_hash::tracker_t tiles;
+  tiles.update(*img);
+  start = std::chrono::steady_clock::now();
+  for (int x = 0; x < frames; ++x) {
+    ASSERT_EQ(tiles.update(*img), 0);
+  }
+  auto hash_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / frames;
+
+  BOOST_LOG(tests) << "Benchmark:: idle 1080p desktop: "sv << encode_us << "us per frame converting and encoding, "sv
+                   << hash_us << "us per frame detecting it didn't change"sv;
+}
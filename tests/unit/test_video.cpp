@@ -2,10 +2,29 @@
  * @file tests/unit/test_video.cpp
  * @brief Test src/video.*.
  */
+#include <src/config.h>
 #include <src/video.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
 #include "../tests_common.h"
 
+using namespace std::literals;
+
 struct EncoderTest: PlatformTestSuite, testing::WithParamInterface<video::encoder_t *> {
   void
   SetUp() override {
@@ -46,3 +65,650 @@ INSTANTIATE_TEST_SUITE_P(
 TEST_P(EncoderTest, ValidateEncoder) {
   // todo:: test something besides fixture setup
 }
+
+struct EncoderProbeTest: PlatformTestSuite {};
+
+TEST_F(EncoderProbeTest, BaselineThenExtendedMatchesFullValidation) {
+  auto &encoder = video::software;
+  ASSERT_TRUE(video::validate_encoder(encoder, false));
+  auto h264 = encoder.h264.capabilities;
+  auto hevc = encoder.hevc.capabilities;
+  auto av1 = encoder.av1.capabilities;
+
+  video::encoder_probe_t probe { &encoder };
+  ASSERT_TRUE(video::probe_baseline(probe, false));
+
+  // Only H.264 without 4:4:4 is claimed in between
+  ASSERT_TRUE(encoder.h264[video::encoder_t::PASSED]);
+  ASSERT_FALSE(encoder.h264[video::encoder_t::YUV444]);
+  ASSERT_FALSE(encoder.hevc[video::encoder_t::PASSED]);
+  ASSERT_FALSE(encoder.av1[video::encoder_t::PASSED]);
+
+  ASSERT_TRUE(video::probe_extended(probe));
+  ASSERT_EQ(encoder.h264.capabilities, h264);
+  ASSERT_EQ(encoder.hevc.capabilities, hevc);
+  ASSERT_EQ(encoder.av1.capabilities, av1);
+}
+
+TEST_F(EncoderProbeTest, DISABLED_Benchmark) {
+  auto &encoder = video::software;
+
+  // Require every codec, so there is more than H.264 to test
+  auto fg = util::fail_guard([hevc_mode = config::video.hevc_mode, av1_mode = config::video.av1_mode]() {
+    config::video.hevc_mode = hevc_mode;
+    config::video.av1_mode = av1_mode;
+  });
+  config::video.hevc_mode = 2;
+  config::video.av1_mode = 2;
+
+  auto probe_ms = [&](bool parallel, std::int64_t &ready_ms) {
+    auto start = std::chrono::steady_clock::now();
+
+    video::encoder_probe_t probe { &encoder };
+    EXPECT_TRUE(video::probe_baseline(probe, false));
+    ready_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    probe.parallel = parallel;
+    EXPECT_TRUE(video::probe_extended(probe));
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  std::int64_t sequential_ready_ms, parallel_ready_ms;
+  auto sequential_ms = probe_ms(false, sequential_ready_ms);
+  auto parallel_ms = probe_ms(true, parallel_ready_ms);
+
+  // Without the lazy probe, the encoder is ready once every test completed
+  BOOST_LOG(tests) << "Benchmark:: software encoder ready after "sv << sequential_ms << "ms probing everything, "sv
+                   << sequential_ready_ms << "ms probing H.264 only; all codecs probed in "sv
+                   << sequential_ms << "ms sequentially, "sv << parallel_ms << "ms concurrently"sv;
+}
+
+TEST(ScaledConfigTest, KeepsEvenDimensions) {
+  const video::config_t config { 1920, 1080, 60, 1000, 1, 1, 0, 0, 0, 0, 0 };
+
+  auto scaled = video::scaled_config(config, 50);
+  ASSERT_EQ(scaled.width, 960);
+  ASSERT_EQ(scaled.height, 540);
+  ASSERT_EQ(scaled.bitrate, config.bitrate);
+  ASSERT_EQ(scaled.framerate, config.framerate);
+
+  scaled = video::scaled_config(config, 33);
+  ASSERT_EQ(scaled.width, 632);
+  ASSERT_EQ(scaled.height, 356);
+
+  ASSERT_EQ(video::scaled_config(config, 100), config);
+  ASSERT_EQ(video::scaled_config(config, 200), config);
+  ASSERT_EQ(video::scaled_config(config, 0).width, 480);
+}
+
+struct ResolutionScaleTest: PlatformTestSuite {};
+
+TEST_F(ResolutionScaleTest, RepeatedSwitchesStartWithIdr) {
+  constexpr int switches = 40;
+  constexpr int frames_per_scale = 5;
+  constexpr std::array scales { 100, 50, 75, 25, 100, 33 };
+
+  auto &encoder = video::software;
+  if (!video::validate_encoder(encoder, false)) {
+    FAIL() << "Software encoder not available";
+  }
+
+  const video::config_t config { 1920, 1080, 60, 10000, 1, 1, 0, 0, 0, 0, 0 };
+  auto disp = platf::display(encoder.platform_formats->dev_type, config::video.output_name, config);
+  if (!disp) {
+    GTEST_SKIP() << "No display to capture";
+  }
+
+  auto img = disp->alloc_img();
+  ASSERT_TRUE(img);
+  ASSERT_EQ(disp->dummy_img(img.get()), 0);
+
+  auto test_mail = std::make_shared<safe::mail_raw_t>();
+  auto packets = test_mail->queue<video::packet_t>(mail::video_packets);
+
+  // The capture keeps the display and its images, only the session is rebuilt
+  int frame_nr = 1;
+  for (int x = 0; x < switches; ++x) {
+    auto session = video::make_scaled_encode_session(*disp, encoder, config, scales[x % scales.size()]);
+    ASSERT_TRUE(session);
+    ASSERT_EQ(session->convert(*img), 0);
+
+    session->request_idr_frame();
+    for (int frame = 0; frame < frames_per_scale; ++frame) {
+      ASSERT_EQ(video::encode(frame_nr++, *session, packets, nullptr, {}), 0);
+      session->request_normal_frame();
+    }
+
+    ASSERT_TRUE(packets->peek());
+    ASSERT_TRUE(packets->pop()->is_idr());
+    while (packets->peek()) {
+      packets->pop();
+    }
+  }
+}
+
+TEST_F(ResolutionScaleTest, EncodeRunRebuildsThePipeline) {
+  constexpr int frames_per_step = 20;
+
+  auto &encoder = video::software;
+  if (!video::validate_encoder(encoder, false)) {
+    GTEST_SKIP() << "Software encoder not available";
+  }
+
+  const video::config_t config { 1280, 720, 60, 20000, 1, 1, 0, 0, 0, 0, 0 };
+  auto disp = platf::display(encoder.platform_formats->dev_type, config::video.output_name, config);
+  if (!disp) {
+    GTEST_SKIP() << "No display to capture";
+  }
+
+  auto img = disp->alloc_img();
+  ASSERT_TRUE(img);
+  ASSERT_EQ(disp->dummy_img(img.get()), 0);
+  if (!img->data) {
+    GTEST_SKIP() << "Display doesn't capture into main memory";
+  }
+
+  // Convert ahead of the encoder, so the switch has a pipeline to tear down
+  auto sw_pipeline = config::video.sw.sw_pipeline;
+  auto fg = util::fail_guard([sw_pipeline]() {
+    config::video.sw.sw_pipeline = sw_pipeline;
+  });
+  config::video.sw.sw_pipeline = true;
+
+  auto session = video::make_scaled_encode_session(*disp, encoder, config, 100);
+  ASSERT_TRUE(session);
+
+  auto test_mail = std::make_shared<safe::mail_raw_t>();
+  auto packets = test_mail->queue<video::packet_t>(mail::video_packets);
+  auto dynamic_params = test_mail->event<video::dynamic_param_t>(mail::dynamic_param_change);
+  auto shutdown_event = test_mail->event<bool>(mail::shutdown);
+  auto images = std::make_shared<safe::event_t<std::shared_ptr<platf::img_t>>>();
+  safe::signal_t reinit_event;
+
+  int frame_nr = 1;
+  std::thread encode_thread { [&, session = std::move(session)]() mutable {
+    video::encode_run(frame_nr, test_mail, images, packets, config, disp, std::move(session), reinit_event, encoder, nullptr, dynamic_params);
+  } };
+  auto stop = util::fail_guard([&]() {
+    shutdown_event->raise(true);
+    images->stop();
+    encode_thread.join();
+  });
+
+  // The decoder tells the resolution each packet was encoded at
+  video::avcodec_ctx_t decoder { avcodec_alloc_context3(avcodec_find_decoder(AV_CODEC_ID_H264)) };
+  ASSERT_TRUE(decoder);
+  decoder->thread_count = 1;
+  decoder->flags |= AV_CODEC_FLAG_LOW_DELAY;
+  ASSERT_EQ(avcodec_open2(decoder.get(), decoder->codec, nullptr), 0);
+  video::avcodec_frame_t decoded { av_frame_alloc() };
+
+  struct frame_t {
+    bool idr;
+    std::size_t size;
+    int width;
+    int height;
+  };
+
+  // Noise can't be compressed, each frame takes what the bitrate allows.
+  // The images are never written to once raised, the pipeline converts them on its own thread.
+  std::minstd_rand rand;
+  std::array<std::shared_ptr<platf::img_t>, 4> noise;
+  for (auto &img : noise) {
+    img = disp->alloc_img();
+    ASSERT_TRUE(img);
+    ASSERT_EQ(disp->dummy_img(img.get()), 0);
+    for (int y = 0; y < img->height; ++y) {
+      std::generate_n(img->data + y * img->row_pitch, img->width * img->pixel_pitch, [&]() {
+        return (std::uint8_t) rand();
+      });
+    }
+  }
+
+  auto decode = [&](video::packet_t &packet, std::vector<frame_t> &frames) {
+    AVPacket *av_packet = av_packet_alloc();
+    av_packet->data = packet->data();
+    av_packet->size = (int) packet->data_size();
+    auto status = avcodec_send_packet(decoder.get(), av_packet);
+    av_packet_free(&av_packet);
+    ASSERT_EQ(status, 0);
+    ASSERT_EQ(avcodec_receive_frame(decoder.get(), decoded.get()), 0);
+
+    frames.emplace_back(frame_t { packet->is_idr(), packet->data_size(), decoded->width, decoded->height });
+  };
+
+  int image_nr = 0;
+  auto stream = [&](std::vector<frame_t> &frames) {
+    for (int x = 0; x < frames_per_step; ++x) {
+      images->raise(noise[image_nr++ % noise.size()]);
+
+      auto packet = packets->pop(1s);
+      ASSERT_TRUE(packet);
+      ASSERT_NO_FATAL_FAILURE(decode(packet, frames));
+
+      // Frames repeated while waiting for the image
+      while (packets->peek()) {
+        packet = packets->pop();
+        ASSERT_NO_FATAL_FAILURE(decode(packet, frames));
+      }
+    }
+  };
+
+  auto mean_size = [](auto begin, auto end) {
+    std::size_t size = 0, count = 0;
+    for (auto it = begin; it != end; ++it) {
+      if (!it->idr) {
+        size += it->size;
+        ++count;
+      }
+    }
+    return count ? size / count : 0;
+  };
+
+  std::vector<frame_t> full, lowered, scaled;
+  ASSERT_NO_FATAL_FAILURE(stream(full));
+  ASSERT_TRUE(full.front().idr);
+  ASSERT_EQ(full.back().width, config.width);
+  ASSERT_EQ(full.back().height, config.height);
+
+  // Applied to the current session, and replayed on the one built for the new resolution
+  dynamic_params->raise(video::dynamic_param_t { video::dynamic_param_type_e::BITRATE, { .int_value = config.bitrate / 40 }, true });
+  ASSERT_NO_FATAL_FAILURE(stream(lowered));
+
+  dynamic_params->raise(video::dynamic_param_t { video::dynamic_param_type_e::RESOLUTION_SCALE, { .int_value = 50 }, true });
+  ASSERT_NO_FATAL_FAILURE(stream(scaled));
+
+  // The first frame at the new resolution is an IDR, and the stream stays at that resolution
+  auto expected = video::scaled_config(config, 50);
+  auto first = std::find_if(std::begin(scaled), std::end(scaled), [&](auto &frame) {
+    return frame.width == expected.width;
+  });
+  ASSERT_NE(first, std::end(scaled));
+  ASSERT_TRUE(first->idr);
+  for (auto it = first; it != std::end(scaled); ++it) {
+    ASSERT_EQ(it->width, expected.width);
+    ASSERT_EQ(it->height, expected.height);
+    ASSERT_EQ(it->idr, it == first);
+  }
+
+  // The new session kept the lowered bitrate, at the configured one the noise would fill frames as large as before
+  ASSERT_LT(mean_size(std::next(first), std::end(scaled)) * 4, mean_size(std::begin(full), std::end(full)));
+}
+
+struct IntraRefreshTest: PlatformTestSuite {
+  enum class event_e {
+    loss,  ///< The client reports lost frames
+    idr_request,  ///< The client asks for an IDR frame, e.g. after a decoder reset
+  };
+
+  struct frame_t {
+    bool idr;
+    bool intra_refresh;
+    bool after_ref_frame_invalidation;
+  };
+
+  /**
+   * @brief Encode a bar moving across the display with the software encoder.
+   * @param events The requests of the client, by the frame they precede.
+   */
+  void
+  encode(int video_format, int refresh, const std::map<int, event_e> &events, int frames, std::vector<frame_t> &encoded) {
+    auto &encoder = video::software;
+    if (!video::validate_encoder(encoder, false)) {
+      GTEST_SKIP() << "Software encoder not available";
+    }
+    if (video_format == 1 && !encoder.hevc[video::encoder_t::PASSED]) {
+      GTEST_SKIP() << "Software encoder doesn't support HEVC";
+    }
+
+    const video::config_t config { 1920, 1080, 60, 10000, 1, 1, 0, video_format, 0, 0, 0 };
+    auto disp = platf::display(encoder.platform_formats->dev_type, config::video.output_name, config);
+    if (!disp) {
+      GTEST_SKIP() << "No display to capture";
+    }
+
+    auto img = disp->alloc_img();
+    ASSERT_TRUE(img);
+    ASSERT_EQ(disp->dummy_img(img.get()), 0);
+    if (!img->data) {
+      GTEST_SKIP() << "Display doesn't capture into main memory";
+    }
+
+    auto period = config::video.sw.sw_intra_refresh;
+    auto fg = util::fail_guard([period]() {
+      config::video.sw.sw_intra_refresh = period;
+    });
+    config::video.sw.sw_intra_refresh = refresh;
+
+    auto test_mail = std::make_shared<safe::mail_raw_t>();
+    auto packets = test_mail->queue<video::packet_t>(mail::video_packets);
+
+    auto session = video::make_scaled_encode_session(*disp, encoder, config, 100);
+    ASSERT_TRUE(session);
+
+    for (int frame_nr = 0; frame_nr < frames; ++frame_nr) {
+      // A bar moving across the screen, so that every frame has something to encode
+      std::memset(img->data, 0x20, (std::size_t) img->row_pitch * img->height);
+      auto bar = frame_nr * 16 % img->width;
+      for (int y = 0; y < img->height; ++y) {
+        std::memset(img->data + y * img->row_pitch + bar * img->pixel_pitch, 0xE0, std::min(64, img->width - bar) * img->pixel_pitch);
+      }
+      ASSERT_EQ(session->convert(*img), 0);
+
+      if (auto event = events.find(frame_nr); event != std::end(events)) {
+        if (event->second == event_e::loss) {
+          session->invalidate_ref_frames(frame_nr - 2, frame_nr - 1);
+        }
+        else {
+          session->request_idr_frame();
+        }
+      }
+
+      ASSERT_EQ(video::encode(frame_nr, *session, packets, nullptr, {}), 0);
+      session->request_normal_frame();
+
+      // One packet per frame, without lookahead
+      ASSERT_TRUE(packets->peek());
+      auto packet = packets->pop();
+      encoded.emplace_back(frame_t { packet->is_idr(), packet->intra_refresh, packet->after_ref_frame_invalidation });
+      ASSERT_FALSE(packets->peek());
+    }
+  }
+};
+
+TEST_F(IntraRefreshTest, RepairsLossesWithRefreshCycles) {
+  constexpr int refresh = 30;
+
+  // A second loss within two cycles, and an IDR frame the client asked for
+  const std::map<int, event_e> events {
+    { 90, event_e::loss },
+    { 100, event_e::loss },
+    { 150, event_e::idr_request },
+    { 200, event_e::loss },
+  };
+
+  std::vector<frame_t> encoded;
+  ASSERT_NO_FATAL_FAILURE(encode(0, refresh, events, 240, encoded));
+  if (IsSkipped()) {
+    return;
+  }
+
+  int last_key = 0;
+  for (int frame_nr = 0; frame_nr < (int) encoded.size(); ++frame_nr) {
+    auto &frame = encoded[frame_nr];
+    ASSERT_EQ(frame.idr, frame_nr == 0 || frame_nr == 100 || frame_nr == 150) << "frame "sv << frame_nr;
+
+    // The client resumes decoding with the frame following a loss left to the refresh
+    ASSERT_EQ(frame.after_ref_frame_invalidation, frame_nr == 90 || frame_nr == 200) << "frame "sv << frame_nr;
+
+    // A refresh cycle starts every period, counted from the last IDR frame
+    ASSERT_EQ(frame.intra_refresh, !frame.idr && frame_nr - last_key == refresh) << "frame "sv << frame_nr;
+    if (frame.idr || frame.intra_refresh) {
+      last_key = frame_nr;
+    }
+  }
+}
+
+TEST_F(IntraRefreshTest, HevcSendsIdrOnLoss) {
+  // libx265 flags only IRAP pictures as key frames, the refresh is limited to libx264
+  std::vector<frame_t> encoded;
+  ASSERT_NO_FATAL_FAILURE(encode(1, 30, { { 45, event_e::loss } }, 90, encoded));
+  if (IsSkipped()) {
+    return;
+  }
+
+  for (int frame_nr = 0; frame_nr < (int) encoded.size(); ++frame_nr) {
+    auto &frame = encoded[frame_nr];
+    ASSERT_EQ(frame.idr, frame_nr == 0 || frame_nr == 45) << "frame "sv << frame_nr;
+    ASSERT_FALSE(frame.intra_refresh);
+    ASSERT_FALSE(frame.after_ref_frame_invalidation);
+  }
+}
+
+TEST_F(IntraRefreshTest, DisabledSendsIdrOnLoss) {
+  std::vector<frame_t> encoded;
+  ASSERT_NO_FATAL_FAILURE(encode(0, 0, { { 45, event_e::loss } }, 90, encoded));
+  if (IsSkipped()) {
+    return;
+  }
+
+  for (int frame_nr = 0; frame_nr < (int) encoded.size(); ++frame_nr) {
+    auto &frame = encoded[frame_nr];
+    ASSERT_EQ(frame.idr, frame_nr == 0 || frame_nr == 45) << "frame "sv << frame_nr;
+    ASSERT_FALSE(frame.intra_refresh);
+    ASSERT_FALSE(frame.after_ref_frame_invalidation);
+  }
+}
+
+namespace {
+  /**
+   * @brief A padded frame, with black borders, to scale an image into.
+   */
+  video::avcodec_frame_t
+  make_padded_frame(AVPixelFormat format, int width, int height) {
+    video::avcodec_frame_t frame { av_frame_alloc() };
+    frame->format = format;
+    frame->width = width;
+    frame->height = height;
+    EXPECT_EQ(av_frame_get_buffer(frame.get(), 0), 0);
+
+    ptrdiff_t linesize[4] = { frame->linesize[0], frame->linesize[1], frame->linesize[2], frame->linesize[3] };
+    av_image_fill_black(frame->data, linesize, format, AVCOL_RANGE_MPEG, width, height);
+
+    return frame;
+  }
+
+  video::sws_t
+  make_sws(int in_width, int in_height, AVPixelFormat format, int out_width, int out_height) {
+    return video::sws_t {
+      sws_getContext(in_width, in_height, AV_PIX_FMT_BGR0, out_width, out_height, format, SWS_LANCZOS | SWS_ACCURATE_RND, nullptr, nullptr, nullptr)
+    };
+  }
+
+  bool
+  same_planes(const AVFrame *a, const AVFrame *b) {
+    auto fmt_desc = av_pix_fmt_desc_get((AVPixelFormat) a->format);
+    for (int plane = 0; plane < av_pix_fmt_count_planes((AVPixelFormat) a->format); plane++) {
+      auto shift_h = plane == 0 ? 0 : fmt_desc->log2_chroma_h;
+      auto shift_w = plane == 0 ? 0 : fmt_desc->log2_chroma_w;
+      auto row_size = (std::size_t) AV_CEIL_RSHIFT(a->width, shift_w) * fmt_desc->comp[plane].step;
+
+      for (int line = 0; line < AV_CEIL_RSHIFT(a->height, shift_h); line++) {
+        if (std::memcmp(a->data[plane] + line * a->linesize[plane], b->data[plane] + line * b->linesize[plane], row_size)) {
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+}  // namespace
+
+struct FrameViewTest: testing::TestWithParam<AVPixelFormat> {};
+
+INSTANTIATE_TEST_SUITE_P(
+  Formats,
+  FrameViewTest,
+  testing::Values(AV_PIX_FMT_NV12, AV_PIX_FMT_P010, AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV444P10),
+  [](const auto &info) { return std::string(av_get_pix_fmt_name(info.param)); });
+
+TEST_P(FrameViewTest, PointsIntoFrame) {
+  auto format = GetParam();
+  auto frame = make_padded_frame(format, 64, 48);
+  video::avcodec_frame_t view { av_frame_alloc() };
+
+  ASSERT_EQ(video::frame_view(view.get(), frame.get(), 8, 4, 48, 40), 0);
+  ASSERT_EQ(view->format, format);
+  ASSERT_EQ(view->width, 48);
+  ASSERT_EQ(view->height, 40);
+  ASSERT_TRUE(view->buf[0]);
+
+  auto fmt_desc = av_pix_fmt_desc_get(format);
+  for (int plane = 0; plane < av_pix_fmt_count_planes(format); plane++) {
+    auto shift_h = plane == 0 ? 0 : fmt_desc->log2_chroma_h;
+    auto shift_w = plane == 0 ? 0 : fmt_desc->log2_chroma_w;
+
+    ASSERT_EQ(view->linesize[plane], frame->linesize[plane]);
+    ASSERT_EQ(view->data[plane], frame->data[plane] + (8 >> shift_w) * fmt_desc->comp[plane].step + (4 >> shift_h) * frame->linesize[plane]);
+  }
+}
+
+TEST_P(FrameViewTest, RequiresBuffers) {
+  video::avcodec_frame_t frame { av_frame_alloc() };
+  video::avcodec_frame_t view { av_frame_alloc() };
+
+  ASSERT_LT(video::frame_view(view.get(), frame.get(), 0, 0, 16, 16), 0);
+}
+
+/**
+ * Scaling into a view of the padded frame must produce the same bytes as
+ * scaling into an intermediate frame and copying it into the padded frame.
+ */
+TEST_P(FrameViewTest, ScalesLikeIntermediateCopy) {
+  auto format = GetParam();
+  auto fmt_desc = av_pix_fmt_desc_get(format);
+
+  // 4:3 into 16:9, pillarboxed, with an odd offset, and 16:9 into 4:3, letterboxed
+  for (auto [in_width, in_height, width, height] : { std::array { 160, 120, 210, 120 }, std::array { 192, 108, 96, 72 } }) {
+    auto scalar = std::fminf((float) width / in_width, (float) height / in_height);
+    int out_width = in_width * scalar;
+    int out_height = in_height * scalar;
+    auto offsetW = (width - out_width) / 2;
+    auto offsetH = (height - out_height) / 2;
+
+    std::vector<std::uint8_t> image((std::size_t) in_width * in_height * 4);
+    for (std::size_t x = 0; x < image.size(); ++x) {
+      image[x] = (std::uint8_t) (x * 2654435761u >> 13);
+    }
+
+    video::avcodec_frame_t input { av_frame_alloc() };
+    input->format = AV_PIX_FMT_BGR0;
+    input->width = in_width;
+    input->height = in_height;
+    input->data[0] = image.data();
+    input->linesize[0] = in_width * 4;
+
+    // The previous path, scaled into an intermediate frame and copied line by line
+    auto expected = make_padded_frame(format, width, height);
+    {
+      video::avcodec_frame_t intermediate { av_frame_alloc() };
+      intermediate->format = format;
+      intermediate->width = out_width;
+      intermediate->height = out_height;
+
+      auto sws = make_sws(in_width, in_height, format, out_width, out_height);
+      ASSERT_GE(sws_scale_frame(sws.get(), intermediate.get(), input.get()), 0);
+
+      for (int plane = 0; plane < av_pix_fmt_count_planes(format); plane++) {
+        auto shift_h = plane == 0 ? 0 : fmt_desc->log2_chroma_h;
+        auto shift_w = plane == 0 ? 0 : fmt_desc->log2_chroma_w;
+        auto offset = ((offsetW >> shift_w) * fmt_desc->comp[plane].step) + (offsetH >> shift_h) * expected->linesize[plane];
+
+        for (int line = 0; line < intermediate->height >> shift_h; line++) {
+          std::memcpy(expected->data[plane] + offset + (line * expected->linesize[plane]),
+            intermediate->data[plane] + (line * intermediate->linesize[plane]),
+            (size_t) (intermediate->width >> shift_w) * fmt_desc->comp[plane].step);
+        }
+      }
+    }
+
+    // Scaled in place
+    auto actual = make_padded_frame(format, width, height);
+    {
+      video::avcodec_frame_t view { av_frame_alloc() };
+      ASSERT_EQ(video::frame_view(view.get(), actual.get(), offsetW, offsetH, out_width, out_height), 0);
+
+      auto data = view->data[0];
+      auto sws = make_sws(in_width, in_height, format, out_width, out_height);
+      ASSERT_GE(sws_scale_frame(sws.get(), view.get(), input.get()), 0);
+
+      // Nothing was allocated behind our back
+      ASSERT_EQ(view->data[0], data);
+    }
+
+    ASSERT_TRUE(same_planes(expected.get(), actual.get())) << in_width << 'x' << in_height << " into " << width << 'x' << height;
+  }
+}
+
+namespace {
+  /**
+   * @brief The search and copy the video thread used to do on every IDR frame.
+   */
+  std::string
+  search_and_replace(std::string original, const std::vector<video::packet_raw_t::replace_t> &replacements) {
+    for (auto &replacement : replacements) {
+      auto pos = original.find(replacement.old);
+      if (pos != std::string::npos) {
+        original.replace(pos, replacement.old.size(), replacement._new);
+      }
+    }
+
+    return original;
+  }
+
+  std::string
+  join(const std::vector<std::string_view> &pieces) {
+    std::string joined;
+    for (auto &piece : pieces) {
+      joined += piece;
+    }
+
+    return joined;
+  }
+}  // namespace
+
+TEST(GatherReplacementsTest, H264MatchesSearchAndReplace) {
+  auto aud = "\0\0\0\1\x09\xF0"s;
+  auto sps = "\0\0\0\1\x67\x64\x00\x1F\xAC\xD9\x40\x50"s;
+  auto pps = "\0\0\0\1\x68\xEB\xE3\xCB\x22\xC0"s;
+  auto slice = "\0\0\1\x65\x88\x84\x00\x33\xFF\x67\x64\x00\x1F"s;
+  auto new_sps = "\0\0\0\1\x67\x64\x00\x1F\xAC\xD9\x40\x50\x05\xBB\x01\x10"s;
+
+  std::vector<video::packet_raw_t::replace_t> replacements;
+  replacements.emplace_back(sps, new_sps);
+
+  auto idr = aud + sps + pps + slice;
+  auto pieces = video::gather_replacements(idr, replacements, false);
+
+  ASSERT_EQ(join(pieces), aud + new_sps + pps + slice);
+  ASSERT_EQ(join(pieces), search_and_replace(idr, replacements));
+
+  // The slice data is passed through, not copied
+  ASSERT_EQ(pieces.back().data() + pieces.back().size(), idr.data() + idr.size());
+  ASSERT_GE(pieces.back().size(), slice.size());
+}
+
+TEST(GatherReplacementsTest, HevcMatchesSearchAndReplace) {
+  auto vps = "\0\0\0\1\x40\x01\x0C\x01\xFF\xFF"s;
+  auto sps = "\0\0\0\1\x42\x01\x01\x01\x60\x00"s;
+  auto pps = "\0\0\0\1\x44\x01\xC1\x73"s;
+  auto slice = "\0\0\1\x26\x01\xAF\x06\xB8"s;
+  auto new_vps = "\0\0\0\1\x40\x01\x0C\x01\xFF\xFF\x01\x60"s;
+  auto new_sps = "\0\0\0\1\x42\x01\x01\x01\x60\x00\x00\x03\x00\xB0"s;
+
+  // In the order the encode session records them
+  std::vector<video::packet_raw_t::replace_t> replacements;
+  replacements.emplace_back(vps, new_vps);
+  replacements.emplace_back(sps, new_sps);
+
+  auto idr = vps + sps + pps + slice;
+  ASSERT_EQ(join(video::gather_replacements(idr, replacements, true)), new_vps + new_sps + pps + slice);
+  ASSERT_EQ(join(video::gather_replacements(idr, replacements, true)), search_and_replace(idr, replacements));
+
+  // Three byte start codes in the frame, four in the replacements
+  auto short_start_codes = vps.substr(1) + sps.substr(1) + pps + slice;
+  ASSERT_EQ(join(video::gather_replacements(short_start_codes, replacements, true)), search_and_replace(short_start_codes, replacements));
+}
+
+TEST(GatherReplacementsTest, NothingToReplace) {
+  auto idr = "\0\0\0\1\x67\x42\0\0\1\x65\x88"s;
+
+  std::vector<video::packet_raw_t::replace_t> replacements;
+  replacements.emplace_back("\0\0\0\1\x67\x64"sv, "\0\0\0\1\x67\x65"sv);
+
+  auto pieces = video::gather_replacements(idr, replacements, false);
+  ASSERT_EQ(pieces.size(), 1);
+  ASSERT_EQ(pieces.front().data(), idr.data());
+  ASSERT_EQ(pieces.front().size(), idr.size());
+}
@@ -0,0 +1,132 @@
+/**
+ * @file tests/unit/test_video_broadcast.cpp
+ * @brief Test src/video_broadcast.*.
+ */
+#include <src/video_broadcast.h>
+
+#include "../tests_common.h"
+
+using video::broadcast_hub_t;
+
+namespace {
+  int session_a;
+  int session_b;
+
+  video::packet_t
+  make_packet(int64_t frame_index, bool idr) {
+    return std::make_unique<video::packet_raw_generic>(std::vector<uint8_t> { (uint8_t) frame_index }, frame_index, idr);
+  }
+
+  /**
+   * @brief The frame indexes of the packets sent to a session.
+   */
+  std::vector<int64_t>
+  frames_of(std::vector<video::packet_t> &packets, void *channel_data) {
+    std::vector<int64_t> frames;
+    for (auto &packet : packets) {
+      if (packet->channel_data == channel_data) {
+        frames.push_back(packet->frame_index());
+      }
+    }
+
+    return frames;
+  }
+}  // namespace
+
+TEST(BroadcastHubTest, SharesTheData) {
+  broadcast_hub_t hub { 4 };
+  std::vector<video::packet_t> replay;
+  ASSERT_TRUE(hub.subscribe(&session_a, replay));
+  ASSERT_TRUE(hub.subscribe(&session_b, replay));
+  ASSERT_TRUE(replay.empty());
+
+  auto packets = hub.publish(make_packet(10, true));
+  ASSERT_EQ(packets.size(), 2);
+  ASSERT_EQ(packets[0]->data(), packets[1]->data());
+  ASSERT_EQ(packets[0]->data_size(), 1);
+  ASSERT_TRUE(packets[0]->is_idr());
+  ASSERT_NE(packets[0]->channel_data, packets[1]->channel_data);
+}
+
+TEST(BroadcastHubTest, SessionsStartAtAnIdrFrame) {
+  broadcast_hub_t hub { 4 };
+  std::vector<video::packet_t> replay;
+  ASSERT_TRUE(hub.subscribe(&session_a, replay));
+
+  // Nothing to decode before the IDR frame
+  ASSERT_TRUE(hub.publish(make_packet(7, false)).empty());
+
+  std::vector<video::packet_t> packets;
+  for (int64_t frame = 8; frame < 11; ++frame) {
+    for (auto &packet : hub.publish(make_packet(frame, frame == 8))) {
+      packets.emplace_back(std::move(packet));
+    }
+  }
+
+  // Numbered from 1 in the session
+  ASSERT_EQ(frames_of(packets, &session_a), (std::vector<int64_t> { 1, 2, 3 }));
+  ASSERT_EQ(hub.encoder_frame_index(&session_a, 2), 9);
+}
+
+TEST(BroadcastHubTest, LateJoinerReplaysSinceIdr) {
+  broadcast_hub_t hub { 4 };
+  std::vector<video::packet_t> replay;
+  ASSERT_TRUE(hub.subscribe(&session_a, replay));
+
+  hub.publish(make_packet(20, true));
+  hub.publish(make_packet(21, false));
+
+  ASSERT_FALSE(hub.subscribe(&session_b, replay));
+  ASSERT_EQ(frames_of(replay, &session_b), (std::vector<int64_t> { 1, 2 }));
+  ASSERT_TRUE(replay[0]->is_idr());
+
+  // Then carries on with the stream
+  auto packets = hub.publish(make_packet(22, false));
+  ASSERT_EQ(frames_of(packets, &session_a), (std::vector<int64_t> { 3 }));
+  ASSERT_EQ(frames_of(packets, &session_b), (std::vector<int64_t> { 3 }));
+}
+
+TEST(BroadcastHubTest, LateJoinerWaitsForIdrPastMaxReplay) {
+  broadcast_hub_t hub { 2 };
+  std::vector<video::packet_t> replay;
+  ASSERT_TRUE(hub.subscribe(&session_a, replay));
+
+  hub.publish(make_packet(1, true));
+  hub.publish(make_packet(2, false));
+  hub.publish(make_packet(3, false));
+
+  ASSERT_TRUE(hub.subscribe(&session_b, replay));
+  ASSERT_TRUE(replay.empty());
+  ASSERT_FALSE(hub.encoder_frame_index(&session_b, 1));
+
+  // The IDR frame it triggers starts both the session and a new replay
+  auto packets = hub.publish(make_packet(4, true));
+  ASSERT_EQ(frames_of(packets, &session_a), (std::vector<int64_t> { 4 }));
+  ASSERT_EQ(frames_of(packets, &session_b), (std::vector<int64_t> { 1 }));
+}
+
+TEST(BroadcastHubTest, ResetForgetsTheReplay) {
+  broadcast_hub_t hub { 4 };
+  std::vector<video::packet_t> replay;
+  hub.subscribe(&session_a, replay);
+  hub.publish(make_packet(1, true));
+
+  hub.reset();
+  ASSERT_TRUE(hub.subscribe(&session_b, replay));
+  ASSERT_TRUE(replay.empty());
+}
+
+TEST(BroadcastHubTest, Unsubscribe) {
+  broadcast_hub_t hub { 4 };
+  std::vector<video::packet_t> replay;
+  hub.subscribe(&session_a, replay);
+  hub.subscribe(&session_b, replay);
+  ASSERT_EQ(hub.subscribers(), 2);
+
+  hub.unsubscribe(&session_a);
+  ASSERT_EQ(hub.subscribers(), 1);
+
+  auto packets = hub.publish(make_packet(1, true));
+  ASSERT_EQ(packets.size(), 1);
+  ASSERT_EQ(packets[0]->channel_data, &session_b);
+}